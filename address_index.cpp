@@ -0,0 +1,228 @@
+#include "address_index.hpp"
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace windbg_agent
+{
+
+void AddressRangeTable::Add(uint64_t start, uint64_t end, uint32_t value)
+{
+    if (end <= start)
+        return;
+    starts_.push_back(start);
+    ends_.push_back(end);
+    values_.push_back(value);
+}
+
+void AddressRangeTable::Finish()
+{
+    std::vector<size_t> order(starts_.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [this](size_t a, size_t b) { return starts_[a] < starts_[b]; });
+
+    std::vector<uint64_t> starts, ends;
+    std::vector<uint32_t> values;
+    starts.reserve(order.size());
+    ends.reserve(order.size());
+    values.reserve(order.size());
+    auto emit = [&](uint64_t from, uint64_t to, uint32_t value)
+    {
+        if (from >= to)
+            return;
+        starts.push_back(from);
+        ends.push_back(to);
+        values.push_back(value);
+    };
+
+    // Sweep in start order. open holds the intervals covering pos, latest start on top;
+    // when the top one ends, the one below it (if still open) takes over again.
+    std::vector<size_t> open;
+    uint64_t pos = 0;
+    auto close_top = [&]()
+    {
+        size_t top = open.back();
+        open.pop_back();
+        emit(pos, ends_[top], values_[top]);
+        pos = std::max(pos, ends_[top]);
+    };
+    for (size_t i : order)
+    {
+        while (!open.empty() && ends_[open.back()] <= starts_[i])
+            close_top();
+        if (!open.empty())
+            emit(pos, starts_[i], values_[open.back()]);
+        pos = starts_[i];
+        open.push_back(i);
+    }
+    while (!open.empty())
+        close_top();
+    starts_ = std::move(starts);
+    ends_ = std::move(ends);
+    values_ = std::move(values);
+}
+
+uint32_t AddressRangeTable::Find(uint64_t address) const
+{
+    size_t count = starts_.size();
+    if (count == 0)
+        return npos;
+
+    // Last start <= address (or the first entry); the loop body compiles to a cmov
+    const uint64_t* base = starts_.data();
+    while (count > 1)
+    {
+        size_t half = count / 2;
+        base = base[half] <= address ? base + half : base;
+        count -= half;
+    }
+
+    size_t i = static_cast<size_t>(base - starts_.data());
+    return *base <= address && address < ends_[i] ? values_[i] : npos;
+}
+
+void AddressRangeTable::clear()
+{
+    starts_.clear();
+    ends_.clear();
+    values_.clear();
+}
+
+std::vector<SymbolizeResult> AddressIndex::Resolve(IDebuggerBackend& backend,
+                                                   const std::vector<uint64_t>& addresses,
+                                                   bool symbols)
+{
+    std::vector<SymbolizeResult> results(addresses.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The target may have run (loading or unloading modules) since the index was built
+    uint64_t epoch = GetResultCache().epoch();
+    uint32_t process_id = backend.GetProcessId();
+    if (epoch != epoch_ || process_id != process_id_)
+    {
+        Clear();
+        epoch_ = epoch;
+        process_id_ = process_id;
+    }
+    if (!built_)
+        Build(backend);
+    stats_.lookups += addresses.size();
+
+    for (size_t i = 0; i < addresses.size(); i++)
+    {
+        SymbolizeResult& result = results[i];
+        result.address = addresses[i];
+
+        uint32_t module = module_table_.Find(addresses[i]);
+        if (module != AddressRangeTable::npos)
+        {
+            result.module = modules_[module].name;
+            result.module_base = modules_[module].base;
+        }
+
+        uint32_t region = region_table_.Find(addresses[i]);
+        if (region != AddressRangeTable::npos)
+        {
+            const MemoryRegionInfo& info = regions_[region];
+            result.region_base = info.base;
+            result.region_size = info.size;
+            result.region_state = info.state;
+            result.region_protect = info.protect;
+            result.region_type = info.type;
+        }
+
+        if (!symbols || symbols_unsupported_)
+            continue;
+
+        auto it = symbols_.find(addresses[i]);
+        if (it != symbols_.end())
+        {
+            stats_.symbol_hits++;
+        }
+        else
+        {
+            Symbol symbol;
+            long status = backend.GetSymbol(addresses[i], &symbol.name, &symbol.displacement);
+            stats_.symbol_misses++;
+            if (status == kStatusNotImpl)
+            {
+                symbols_unsupported_ = true;
+                continue;
+            }
+            if (!StatusSucceeded(status))
+                symbol = Symbol();
+
+            if (symbols_.size() >= kMaxSymbols)
+                symbols_.clear();
+            it = symbols_.emplace(addresses[i], std::move(symbol)).first;
+        }
+        result.symbol = it->second.name;
+        result.displacement = it->second.displacement;
+    }
+    return results;
+}
+
+void AddressIndex::Build(IDebuggerBackend& backend)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // A backend that cannot list modules or regions leaves that table empty
+    if (!StatusSucceeded(backend.GetModules(&modules_)))
+        modules_.clear();
+    if (!StatusSucceeded(backend.GetMemoryRegions(&regions_)))
+        regions_.clear();
+
+    for (size_t i = 0; i < modules_.size(); i++)
+        module_table_.Add(modules_[i].base, modules_[i].base + modules_[i].size,
+                          static_cast<uint32_t>(i));
+    module_table_.Finish();
+
+    for (size_t i = 0; i < regions_.size(); i++)
+        region_table_.Add(regions_[i].base, regions_[i].base + regions_[i].size,
+                          static_cast<uint32_t>(i));
+    region_table_.Finish();
+
+    built_ = true;
+    stats_.builds++;
+    stats_.build_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AddressIndex::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clear();
+}
+
+void AddressIndex::Clear()
+{
+    built_ = false;
+    modules_.clear();
+    regions_.clear();
+    module_table_.clear();
+    region_table_.clear();
+    symbols_.clear();
+    symbols_unsupported_ = false;
+}
+
+AddressIndexStats AddressIndex::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    AddressIndexStats stats = stats_;
+    stats.modules = module_table_.size();
+    stats.regions = region_table_.size();
+    stats.symbols = symbols_.size();
+    return stats;
+}
+
+AddressIndex& GetAddressIndex()
+{
+    static AddressIndex index;
+    return index;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "command_types.hpp"
+#include "debugger_backend.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Sorted, non-overlapping [start, end) intervals kept in flat arrays, so a lookup is a
+// branchless binary search over one contiguous array of starts
+class AddressRangeTable
+{
+  public:
+    static constexpr uint32_t npos = ~uint32_t(0);
+
+    // Add the interval [start, end) carrying value; call Finish before looking anything up
+    void Add(uint64_t start, uint64_t end, uint32_t value);
+
+    // Sort the intervals; where two overlap, the one starting later wins from its start on.
+    // An interval nested in another only covers its own range; the outer one resumes after it.
+    void Finish();
+
+    // Value of the interval containing address, or npos
+    uint32_t Find(uint64_t address) const;
+
+    size_t size() const { return starts_.size(); }
+    void clear();
+
+  private:
+    std::vector<uint64_t> starts_;
+    std::vector<uint64_t> ends_;
+    std::vector<uint32_t> values_;
+};
+
+// Snapshot of address index counters
+struct AddressIndexStats
+{
+    uint64_t builds = 0;      // Times the index was (re)built
+    double build_ms = 0.0;    // Duration of the last build
+    uint64_t lookups = 0;     // Addresses resolved
+    uint64_t symbol_hits = 0; // Symbol names served from the cache
+    uint64_t symbol_misses = 0;
+    size_t modules = 0;
+    size_t regions = 0;
+    size_t symbols = 0; // Cached symbol names
+};
+
+// Address -> module, memory region and symbol, built once per debugger state from the
+// module list and the address space layout instead of an lm/!address/ln round trip per
+// pointer. Symbol names are looked up on demand and cached by address. Everything is
+// dropped when the debugger state epoch (see ResultCache) or the current process changes,
+// which covers module loads and unloads: they only happen while the target runs.
+class AddressIndex
+{
+  public:
+    static constexpr size_t kMaxSymbols = 65536;
+
+    // Resolve each address; results are in request order. Call on the engine thread.
+    std::vector<SymbolizeResult> Resolve(IDebuggerBackend& backend,
+                                         const std::vector<uint64_t>& addresses, bool symbols);
+
+    // Drop the index; the next Resolve rebuilds it
+    void Invalidate();
+
+    AddressIndexStats GetStats() const;
+
+  private:
+    struct Symbol
+    {
+        std::string name; // Empty if no symbol covers the address
+        uint64_t displacement = 0;
+    };
+
+    void Build(IDebuggerBackend& backend); // mutex_ held
+    void Clear();                          // mutex_ held
+
+    mutable std::mutex mutex_;
+    bool built_ = false;
+    std::vector<ModuleInfo> modules_;
+    std::vector<MemoryRegionInfo> regions_;
+    AddressRangeTable module_table_;
+    AddressRangeTable region_table_;
+    std::unordered_map<uint64_t, Symbol> symbols_;
+    bool symbols_unsupported_ = false; // The backend has no symbol lookup
+
+    // State the index belongs to
+    uint64_t epoch_ = 0;
+    uint32_t process_id_ = 0;
+
+    AddressIndexStats stats_;
+};
+
+// Global address index shared by every WinDbgClient in this debugger session
+AddressIndex& GetAddressIndex();
+
+} // namespace windbg_agent
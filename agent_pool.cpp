@@ -0,0 +1,168 @@
+#include "agent_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace windbg_agent
+{
+
+AgentPool::AgentPool(Factory factory) : factory_(std::move(factory))
+{
+}
+
+AgentPool::~AgentPool()
+{
+    Shutdown();
+}
+
+std::string AgentPool::KeyOf(const Settings& settings)
+{
+    std::string key = libagents::provider_type_name(settings.default_provider);
+    const auto* byok = settings.get_byok();
+    if (byok && byok->is_usable())
+    {
+        key += '\n' + byok->api_key + '\n' + byok->base_url + '\n' + byok->model + '\n' +
+               byok->provider_type + '\n' + std::to_string(byok->timeout_ms);
+    }
+    return key;
+}
+
+void AgentPool::Warm(const Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key = KeyOf(settings);
+    if (!Find(key))
+        StartLocked(settings, std::move(key));
+}
+
+bool AgentPool::IsReady(const Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* slot = Find(KeyOf(settings));
+    return slot &&
+           slot->pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::unique_ptr<libagents::IAgent> AgentPool::Take(const Settings& settings, bool refill,
+                                                   std::string* error)
+{
+    std::future<Warmed> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string key = KeyOf(settings);
+        if (!Find(key))
+            StartLocked(settings, key);
+
+        auto it = std::find_if(slots_.begin(), slots_.end(),
+                               [&](const Slot& s) { return s.key == key; });
+        pending = std::move(it->pending);
+        slots_.erase(it);
+    }
+
+    // Wait outside the lock so other configurations can still be warmed or taken
+    Warmed warmed = pending.get();
+    if (!warmed.agent)
+    {
+        if (error)
+            *error = warmed.error;
+        return nullptr;
+    }
+
+    // Only refill after a success; a failing provider is not retried in the background
+    if (refill)
+        Warm(settings);
+    return std::move(warmed.agent);
+}
+
+void AgentPool::Retire(std::unique_ptr<libagents::IAgent> agent)
+{
+    if (!agent)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Forget finished shutdowns
+    retiring_.erase(std::remove_if(retiring_.begin(), retiring_.end(),
+                                   [](std::future<void>& f) {
+                                       return f.wait_for(std::chrono::seconds(0)) ==
+                                              std::future_status::ready;
+                                   }),
+                    retiring_.end());
+
+    std::shared_ptr<libagents::IAgent> retired(std::move(agent));
+    retiring_.push_back(std::async(std::launch::async, [retired]() { retired->shutdown(); }));
+}
+
+void AgentPool::Shutdown()
+{
+    std::vector<Slot> slots;
+    std::vector<std::future<void>> retiring;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots.swap(slots_);
+        retiring.swap(retiring_);
+    }
+
+    for (auto& slot : slots)
+    {
+        Warmed warmed = slot.pending.get();
+        if (warmed.agent)
+            warmed.agent->shutdown();
+    }
+    for (auto& shutdown : retiring)
+        shutdown.wait();
+}
+
+AgentPool::Slot* AgentPool::Find(const std::string& key)
+{
+    for (auto& slot : slots_)
+    {
+        if (slot.key == key)
+            return &slot;
+    }
+    return nullptr;
+}
+
+void AgentPool::StartLocked(const Settings& settings, std::string key)
+{
+    if (slots_.size() >= kMaxSlots)
+    {
+        RetireLocked(std::move(slots_.front().pending));
+        slots_.erase(slots_.begin());
+    }
+
+    Factory factory = factory_;
+    Slot slot;
+    slot.key = std::move(key);
+    slot.pending = std::async(std::launch::async,
+                              [factory, settings]()
+                              {
+                                  Warmed warmed;
+                                  try
+                                  {
+                                      warmed.agent = factory(settings, &warmed.error);
+                                  }
+                                  catch (const std::exception& e)
+                                  {
+                                      warmed.error = e.what();
+                                  }
+                                  if (!warmed.agent && warmed.error.empty())
+                                      warmed.error = "Failed to create agent";
+                                  return warmed;
+                              });
+    slots_.push_back(std::move(slot));
+}
+
+void AgentPool::RetireLocked(std::future<Warmed> pending)
+{
+    // The evicted agent may still be initializing: wait for it off this thread
+    auto shared = std::make_shared<std::future<Warmed>>(std::move(pending));
+    retiring_.push_back(std::async(std::launch::async,
+                                   [shared]()
+                                   {
+                                       Warmed warmed = shared->get();
+                                       if (warmed.agent)
+                                           warmed.agent->shutdown();
+                                   }));
+}
+
+} // namespace windbg_agent
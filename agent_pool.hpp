@@ -0,0 +1,75 @@
+#pragma once
+
+#include "settings.hpp"
+#include <libagents/agent.hpp>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Agents created and initialized off the debugger thread, so that the first ask,
+// provider switches and !agent clear do not wait for a provider process and handshake.
+// One spare agent is kept per configuration (provider + BYOK settings).
+class AgentPool
+{
+  public:
+    // Create, configure and initialize an agent (runs on a background thread).
+    // Returns nullptr and sets *error on failure.
+    using Factory = std::function<std::unique_ptr<libagents::IAgent>(const Settings& settings,
+                                                                     std::string* error)>;
+
+    // Configurations kept warm at once; the oldest spare is retired first
+    static constexpr size_t kMaxSlots = 2;
+
+    explicit AgentPool(Factory factory);
+    ~AgentPool();
+
+    // Start initializing an agent for these settings unless one is ready or warming
+    void Warm(const Settings& settings);
+
+    // True if an agent for these settings finished initializing (successfully or not)
+    bool IsReady(const Settings& settings);
+
+    // Take the agent for these settings, waiting for its warm-up (and starting one if none
+    // is pending). With refill, a replacement starts warming right away.
+    std::unique_ptr<libagents::IAgent> Take(const Settings& settings, bool refill,
+                                            std::string* error);
+
+    // Shut an agent down in the background
+    void Retire(std::unique_ptr<libagents::IAgent> agent);
+
+    // Wait for warm-ups and retirements, then shut down every spare agent
+    void Shutdown();
+
+  private:
+    struct Warmed
+    {
+        std::unique_ptr<libagents::IAgent> agent;
+        std::string error;
+    };
+
+    struct Slot
+    {
+        std::string key;
+        std::future<Warmed> pending;
+    };
+
+    // Configuration fingerprint: agents are interchangeable only with identical keys
+    static std::string KeyOf(const Settings& settings);
+
+    Slot* Find(const std::string& key); // mutex_ held
+    void StartLocked(const Settings& settings, std::string key);
+    void RetireLocked(std::future<Warmed> pending);
+
+    Factory factory_;
+    std::mutex mutex_;
+    std::vector<Slot> slots_;                  // Oldest first
+    std::vector<std::future<void>> retiring_;  // Background shutdowns
+};
+
+} // namespace windbg_agent
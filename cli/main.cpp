@@ -6,6 +6,7 @@
 #include <nlohmann/json.hpp>
 
 #include "../settings.hpp"
+#include "triage.hpp"
 
 // TODO: Evolve windbg_agent.exe into a standalone headless debugger.
 //
@@ -53,6 +54,17 @@ void print_usage() {
     std::cerr << "  config byok type <type>     Set BYOK type (openai, anthropic, azure)\n";
     std::cerr << "  config byok enable       Enable BYOK\n";
     std::cerr << "  config byok disable      Disable BYOK\n\n";
+    std::cerr << "Batch triage (no server required):\n";
+    std::cerr << "  triage [options] <dump|dir|manifest>...\n";
+    std::cerr << "      Open each dump in its own engine process, run the triage script and\n";
+    std::cerr << "      write one JSON result per dump. Re-running resumes where it stopped.\n";
+    std::cerr << "    --out=DIR          Result directory (default: triage)\n";
+    std::cerr << "    --script=FILE      Debugger commands, one per line (default: !analyze -v, kn, ...)\n";
+    std::cerr << "    --jobs=N           Concurrent workers (default: cores, bounded by memory)\n";
+    std::cerr << "    --memory-mb=N      Memory cap per worker (default: 4096)\n";
+    std::cerr << "    --timeout=SEC      Time limit per dump (default: 900)\n";
+    std::cerr << "    --ai               Add an AI summary to each result\n";
+    std::cerr << "    --retry-failed     Re-run dumps whose previous result failed\n\n";
     std::cerr << "Environment:\n";
     std::cerr << "  WINDBG_AGENT_URL     HTTP server URL (default: http://127.0.0.1:9999)\n";
 }
@@ -86,53 +98,85 @@ public:
     }
 
     std::string exec(const std::string& cmd) {
-        nlohmann::json body = {{"command", cmd}};
-        auto res = client_->Post("/exec", body.dump(), "application/json");
+        return run_job({{"type", "exec"}, {"command", cmd}}, "/exec", "output");
+    }
+
+    std::string ask(const std::string& query) {
+        return run_job({{"type", "ask"}, {"query", query}}, "/ask", "response");
+    }
 
+    std::string status() {
+        auto res = client_->Get("/status");
         if (!res) {
             throw std::runtime_error("Connection failed - is HTTP server running?");
         }
-        if (res->status != 200) {
-            auto json = nlohmann::json::parse(res->body);
-            throw std::runtime_error(json.value("error", "Request failed"));
-        }
-
-        auto json = nlohmann::json::parse(res->body);
-        return json.value("output", "");
+        return res->body;
     }
 
-    std::string ask(const std::string& query) {
-        nlohmann::json body = {{"query", query}};
-        auto res = client_->Post("/ask", body.dump(), "application/json");
+    void shutdown() {
+        auto res = client_->Post("/shutdown", "", "application/json");
+        if (!res) {
+            throw std::runtime_error("Connection failed - is HTTP server running?");
+        }
+    }
 
+private:
+    // Submit a job and long-poll it, so slow commands and agent queries are not bound by
+    // the read timeout. Falls back to the blocking endpoint on servers without /jobs.
+    std::string run_job(nlohmann::json body, const char* fallback_path, const char* field) {
+        auto res = client_->Post("/jobs", body.dump(), "application/json");
         if (!res) {
             throw std::runtime_error("Connection failed - is HTTP server running?");
         }
-        if (res->status != 200) {
-            auto json = nlohmann::json::parse(res->body);
+        if (res->status == 404) {
+            body.erase("type");
+            return post_and_wait(fallback_path, body, field);
+        }
+        auto json = nlohmann::json::parse(res->body);
+        if (res->status != 202) {
             throw std::runtime_error(json.value("error", "Request failed"));
         }
 
-        auto json = nlohmann::json::parse(res->body);
-        return json.value("response", "");
-    }
+        std::string path = "/jobs/" + json.value("id", "") + "?wait=30";
+        while (true) {
+            res = client_->Get(path);
+            if (!res) {
+                throw std::runtime_error("Connection lost while waiting for job");
+            }
+            json = nlohmann::json::parse(res->body);
+            if (res->status != 200) {
+                throw std::runtime_error(json.value("error", "Request failed"));
+            }
 
-    std::string status() {
-        auto res = client_->Get("/status");
-        if (!res) {
-            throw std::runtime_error("Connection failed - is HTTP server running?");
+            std::string state = json.value("state", "");
+            if (state == "succeeded") {
+                return json.value(field, "");
+            }
+            if (state == "failed" || state == "cancelled") {
+                std::string output = json.value(field, "");
+                if (!output.empty()) {
+                    return output;
+                }
+                throw std::runtime_error(json.value("error", "Job " + state));
+            }
         }
-        return res->body;
     }
 
-    void shutdown() {
-        auto res = client_->Post("/shutdown", "", "application/json");
+    std::string post_and_wait(const char* path, const nlohmann::json& body, const char* field) {
+        auto res = client_->Post(path, body.dump(), "application/json");
+
         if (!res) {
             throw std::runtime_error("Connection failed - is HTTP server running?");
         }
+        if (res->status != 200) {
+            auto json = nlohmann::json::parse(res->body);
+            throw std::runtime_error(json.value("error", "Request failed"));
+        }
+
+        auto json = nlohmann::json::parse(res->body);
+        return json.value(field, "");
     }
 
-private:
     std::string url_;
     std::unique_ptr<httplib::Client> client_;
 };
@@ -326,6 +370,23 @@ int main(int argc, char* argv[]) {
         return run_config(argc, argv, cmd_idx);
     }
 
+    // Triage runs its own engines; no server connection either
+    if (command == "triage" || command == "triage-worker") {
+        std::vector<std::string> triage_args(argv + cmd_idx + 1, argv + argc);
+        if (command == "triage-worker") {
+            return run_triage_worker(triage_args);
+        }
+
+        TriageOptions options;
+        std::string error;
+        if (!parse_triage_args(triage_args, options, error)) {
+            std::cerr << "Error: " << error << "\n";
+            print_usage();
+            return 1;
+        }
+        return run_triage(options);
+    }
+
     try {
         HttpClient client(url);
 
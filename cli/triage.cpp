@@ -0,0 +1,791 @@
+#include "triage.hpp"
+
+#include <windows.h>
+#include <dbgeng.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <libagents/agent.hpp>
+#include <libagents/tool_builder.hpp>
+#include <nlohmann/json.hpp>
+
+#include "../minidump_backend.hpp"
+#include "../output_shaper.hpp"
+#include "../settings.hpp"
+#include "../system_prompt.hpp"
+#include "../windbg_client.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+using Microsoft::WRL::ComPtr;
+
+namespace {
+
+// One WaitForMultipleObjects call covers every running worker
+constexpr int kMaxWorkers = MAXIMUM_WAIT_OBJECTS;
+
+// Worker exit codes
+constexpr int kWorkerOk = 0;
+constexpr int kWorkerFailed = 1;
+constexpr int kWorkerOpenFailed = 2;
+
+// Appended to the system prompt when a worker asks for a summary
+constexpr const char* kTriagePrompt =
+    "## Batch Triage\n"
+    "You are triaging one crash dump from a batch; nobody will answer follow-up questions. "
+    "The triage script output is below. Run more commands with dbg_exec only if they are "
+    "needed to identify the cause. Reply with:\n"
+    "1. A one-line root-cause hypothesis\n"
+    "2. The faulting module and function\n"
+    "3. Your confidence (low, medium, high) and what would confirm it\n";
+
+std::atomic<bool> g_stop{false};
+
+BOOL WINAPI on_console_ctrl(DWORD) {
+    g_stop = true;
+    return TRUE;
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+bool is_dump_file(const fs::path& path) {
+    std::string ext = lower(path.extension().string());
+    return ext == ".dmp" || ext == ".mdmp" || ext == ".hdmp";
+}
+
+bool is_manifest(const fs::path& path) {
+    std::string ext = lower(path.extension().string());
+    return ext == ".txt" || ext == ".lst";
+}
+
+// Match "--name=value"
+bool take_option(const std::string& arg, const char* name, std::string& value) {
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.rfind(prefix, 0) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// Result file name: dump name plus a hash of its full path (same names, different folders)
+std::string result_path_for(const std::string& out_dir, const fs::path& dump) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : lower(dump.string())) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%08x.json", hash);
+    return (fs::path(out_dir) / (dump.stem().string() + suffix)).string();
+}
+
+bool collect_dumps(const std::vector<std::string>& inputs, std::vector<fs::path>& dumps,
+                   std::string& error) {
+    for (const auto& input : inputs) {
+        fs::path path(input);
+        std::error_code ec;
+
+        if (fs::is_directory(path, ec)) {
+            fs::recursive_directory_iterator it(
+                path, fs::directory_options::skip_permission_denied, ec);
+            for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                if (it->is_regular_file(ec) && is_dump_file(it->path())) {
+                    dumps.push_back(it->path());
+                }
+            }
+        }
+        else if (is_manifest(path)) {
+            // One dump per line; relative paths are relative to the manifest
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                error = "cannot open manifest " + input;
+                return false;
+            }
+            std::string line;
+            while (std::getline(file, line)) {
+                line = trim(line);
+                if (line.empty() || line[0] == '#') continue;
+                fs::path dump(line);
+                if (dump.is_relative()) dump = path.parent_path() / dump;
+                dumps.push_back(dump);
+            }
+        }
+        else if (fs::is_regular_file(path, ec)) {
+            dumps.push_back(path);
+        }
+        else {
+            error = "not found: " + input;
+            return false;
+        }
+    }
+
+    for (auto& dump : dumps) {
+        std::error_code ec;
+        fs::path absolute = fs::absolute(dump, ec);
+        if (!ec) dump = absolute.lexically_normal();
+    }
+    std::sort(dumps.begin(), dumps.end());
+    dumps.erase(std::unique(dumps.begin(), dumps.end()), dumps.end());
+    return true;
+}
+
+bool load_script(const std::string& path, std::vector<std::string>& commands,
+                 std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open script " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        commands.push_back(line);
+    }
+    if (commands.empty()) {
+        error = "script " + path + " has no commands";
+        return false;
+    }
+    return true;
+}
+
+bool read_json(const std::string& path, json& value) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    try {
+        file >> value;
+        return value.is_object();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Write via a temporary file and rename, so readers never see a partial result
+bool write_json_atomic(const std::string& path, const json& value) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        // Debugger output is not guaranteed to be valid UTF-8
+        file << value.dump(2, ' ', false, json::error_handler_t::replace);
+        if (!file.good()) return false;
+    }
+    return MoveFileExA(tmp.c_str(), path.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+std::string format_hr(long hr) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%08lx", static_cast<unsigned long>(hr));
+    return buf;
+}
+
+// "FAILURE_BUCKET_ID:  NULL_CLASS_PTR_READ_c0000005_app.dll!Foo" -> the bucket
+std::string find_bucket(const std::string& output) {
+    const std::string key = "FAILURE_BUCKET_ID:";
+    size_t pos = output.find(key);
+    if (pos == std::string::npos) return "";
+    size_t end = output.find('\n', pos);
+    return trim(output.substr(pos + key.size(),
+                              end == std::string::npos ? std::string::npos
+                                                       : end - pos - key.size()));
+}
+
+// Quote one argument for CreateProcess (MSVC command line rules)
+std::wstring quote_arg(const std::wstring& arg) {
+    if (!arg.empty() && arg.find_first_of(L" \t\"") == std::wstring::npos) return arg;
+
+    std::wstring quoted = L"\"";
+    size_t backslashes = 0;
+    for (wchar_t c : arg) {
+        if (c == L'\\') {
+            backslashes++;
+            continue;
+        }
+        quoted.append(c == L'"' ? backslashes * 2 + 1 : backslashes, L'\\');
+        backslashes = 0;
+        quoted += c;
+    }
+    quoted.append(backslashes * 2, L'\\');
+    quoted += L'"';
+    return quoted;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Coordinator
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct Worker {
+    fs::path dump;
+    std::string result_path;
+    HANDLE process = nullptr;
+    HANDLE job = nullptr;
+    std::chrono::steady_clock::time_point started;
+    bool timed_out = false;
+};
+
+struct Totals {
+    size_t total = 0;
+    size_t done = 0;
+    size_t ok = 0;
+    size_t failed = 0;
+};
+
+// Workers that fit both the cores and the physical memory at the per-worker cap
+int choose_jobs(const TriageOptions& options) {
+    int jobs = options.jobs;
+    if (jobs <= 0) {
+        jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        MEMORYSTATUSEX memory{};
+        memory.dwLength = sizeof(memory);
+        if (options.memory_limit_mb > 0 && GlobalMemoryStatusEx(&memory)) {
+            uint64_t fit = memory.ullTotalPhys / (uint64_t(options.memory_limit_mb) << 20);
+            jobs = static_cast<int>(std::min<uint64_t>(jobs, std::max<uint64_t>(1, fit)));
+        }
+    }
+    return std::min(jobs, kMaxWorkers);
+}
+
+// Path of this executable, which doubles as the worker
+std::wstring self_path() {
+    std::wstring path(MAX_PATH, L'\0');
+    for (;;) {
+        DWORD length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()));
+        if (length < path.size()) {
+            path.resize(length);
+            return path;
+        }
+        path.resize(path.size() * 2);
+    }
+}
+
+bool start_worker(Worker& worker, const TriageOptions& options, std::string& error) {
+    std::wstring command_line = quote_arg(self_path()) + L" triage-worker " +
+                                quote_arg(L"--dump=" + worker.dump.wstring()) + L" " +
+                                quote_arg(L"--out=" + fs::path(worker.result_path).wstring());
+    if (!options.script_path.empty()) {
+        command_line += L" " + quote_arg(L"--script=" + fs::path(options.script_path).wstring());
+    }
+    if (options.ai_summary) command_line += L" --ai";
+
+    // Worker stdout/stderr go to a log next to the result
+    SECURITY_ATTRIBUTES inherit{sizeof(inherit), nullptr, TRUE};
+    std::wstring log_path = fs::path(worker.result_path + ".log").wstring();
+    HANDLE log = CreateFileW(log_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &inherit,
+                             CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (log == INVALID_HANDLE_VALUE) {
+        error = "cannot create worker log (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    // The job object enforces the memory cap and kills the worker if we go away
+    HANDLE job = CreateJobObjectW(nullptr, nullptr);
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+    limits.BasicLimitInformation.LimitFlags =
+        JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE | JOB_OBJECT_LIMIT_DIE_ON_UNHANDLED_EXCEPTION;
+    if (options.memory_limit_mb > 0) {
+        limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+        limits.ProcessMemoryLimit = static_cast<SIZE_T>(options.memory_limit_mb) << 20;
+    }
+    if (!job || !SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits,
+                                         sizeof(limits))) {
+        error = "cannot create job object (error " + std::to_string(GetLastError()) + ")";
+        if (job) CloseHandle(job);
+        CloseHandle(log);
+        return false;
+    }
+
+    STARTUPINFOW startup{};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdOutput = log;
+    startup.hStdError = log;
+    PROCESS_INFORMATION process{};
+
+    // Started suspended so the process is in the job before it allocates anything
+    BOOL created = CreateProcessW(nullptr, command_line.data(), nullptr, nullptr, TRUE,
+                                  CREATE_SUSPENDED | CREATE_NO_WINDOW, nullptr, nullptr,
+                                  &startup, &process);
+    DWORD create_error = GetLastError();
+    CloseHandle(log);
+    if (!created) {
+        error = "cannot start worker (error " + std::to_string(create_error) + ")";
+        CloseHandle(job);
+        return false;
+    }
+    if (!AssignProcessToJobObject(job, process.hProcess)) {
+        error = "cannot assign worker to job (error " + std::to_string(GetLastError()) + ")";
+        TerminateProcess(process.hProcess, kWorkerFailed);
+        CloseHandle(process.hThread);
+        CloseHandle(process.hProcess);
+        CloseHandle(job);
+        return false;
+    }
+    ResumeThread(process.hThread);
+    CloseHandle(process.hThread);
+
+    worker.process = process.hProcess;
+    worker.job = job;
+    worker.started = std::chrono::steady_clock::now();
+    return true;
+}
+
+// Record the outcome of a dump (writing a failure result if the worker wrote none)
+void record_result(const fs::path& dump, const std::string& result_path, json result,
+                   double elapsed_ms, double peak_mb, std::ofstream& index, Totals& totals) {
+    std::string status = result.value("status", "failed");
+    totals.done++;
+    if (status == "ok") {
+        totals.ok++;
+    }
+    else {
+        totals.failed++;
+    }
+
+    json line = {{"dump", dump.string()},
+                 {"result", result_path},
+                 {"status", status},
+                 {"bucket", result.value("bucket", "")},
+                 {"elapsed_ms", elapsed_ms},
+                 {"peak_memory_mb", peak_mb}};
+    index << line.dump(-1, ' ', false, json::error_handler_t::replace) << "\n";
+    index.flush();
+
+    std::string detail = status == "ok" ? result.value("bucket", "") : result.value("error", "");
+    std::printf("[%zu/%zu] %-12s %s (%.1f s)%s%s\n", totals.done, totals.total, status.c_str(),
+                dump.filename().string().c_str(), elapsed_ms / 1000.0,
+                detail.empty() ? "" : "  ", detail.c_str());
+    std::fflush(stdout);
+}
+
+void finish_worker(Worker& worker, const TriageOptions& options, std::ofstream& index,
+                   Totals& totals) {
+    DWORD exit_code = 0;
+    GetExitCodeProcess(worker.process, &exit_code);
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION info{};
+    QueryInformationJobObject(worker.job, JobObjectExtendedLimitInformation, &info, sizeof(info),
+                              nullptr);
+    double peak_mb = static_cast<double>(info.PeakProcessMemoryUsed) / (1024.0 * 1024.0);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - worker.started)
+                            .count();
+
+    json result;
+    if (worker.timed_out || !read_json(worker.result_path, result)) {
+        // Near the cap counts as hitting it: the failing allocation is never committed
+        bool memory_limit = options.memory_limit_mb > 0 &&
+                            peak_mb + 16.0 >= static_cast<double>(options.memory_limit_mb);
+        std::string status = worker.timed_out ? "timeout"
+                             : memory_limit   ? "memory_limit"
+                                              : "crashed";
+        char error[96];
+        std::snprintf(error, sizeof(error), "worker %s (exit code 0x%08lx, peak %.0f MB)",
+                      status.c_str(), static_cast<unsigned long>(exit_code), peak_mb);
+        result = {{"dump", worker.dump.string()},
+                  {"status", status},
+                  {"error", error},
+                  {"log", worker.result_path + ".log"}};
+        write_json_atomic(worker.result_path, result);
+    }
+
+    record_result(worker.dump, worker.result_path, std::move(result), elapsed_ms, peak_mb,
+                  index, totals);
+
+    CloseHandle(worker.process);
+    CloseHandle(worker.job);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Worker
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Facts read straight from a user-mode minidump, without the engine: available even when
+// the engine cannot open the dump, and in microseconds rather than seconds
+json minidump_summary(const windbg_agent::MinidumpBackend& reader) {
+    const auto& dump = reader.dump();
+    json summary = {{"architecture", reader.GetTargetArchitecture()},
+                    {"pid", reader.GetProcessId()},
+                    {"timestamp", dump.timestamp()},
+                    {"threads", dump.threads().size()},
+                    {"modules", dump.modules().size()},
+                    {"memory_bytes", dump.memory_bytes()}};
+
+    if (const auto* exception = dump.exception()) {
+        char code[16], address[24];
+        std::snprintf(code, sizeof(code), "0x%08x", exception->code);
+        std::snprintf(address, sizeof(address), "0x%llx",
+                      static_cast<unsigned long long>(exception->address));
+        json entry = {{"code", code}, {"address", address}, {"thread", exception->thread_id}};
+        if (const auto* module = dump.ModuleAt(exception->address)) {
+            char offset[24];
+            std::snprintf(offset, sizeof(offset), "+0x%llx",
+                          static_cast<unsigned long long>(exception->address - module->base));
+            entry["module"] = windbg_agent::ModuleNameFromPath(module->path) + offset;
+        }
+        summary["exception"] = std::move(entry);
+    }
+    return summary;
+}
+
+// Ask the configured provider for a summary, letting it run further commands
+std::string summarize(windbg_agent::WinDbgClient& dbg, const json& commands, std::string& error) {
+    auto settings = windbg_agent::LoadSettings();
+    auto agent = libagents::create_agent(settings.default_provider);
+    if (!agent) {
+        error = "Failed to create agent";
+        return "";
+    }
+
+    agent->register_tool(libagents::make_tool(
+        "dbg_exec",
+        "Execute a WinDbg/CDB debugger command and return its output. "
+        "Use this to inspect the target process, memory, threads, exceptions, etc.",
+        [&dbg, &settings](std::string command) -> std::string {
+            return windbg_agent::ShapeOutput(dbg.ExecuteCommand(command),
+                                             settings.output_shaping)
+                .text;
+        },
+        {"command"}));
+    agent->register_tool(libagents::make_tool(
+        "dbg_output_page",
+        "Fetch one page of a large dbg_exec output that was shortened. "
+        "Use the output_id and page range given in the shortened result.",
+        [](int output_id, int page) -> std::string {
+            if (output_id <= 0 || page <= 0) return "Error: output_id and page must be positive";
+            return windbg_agent::FormatOutputPage(static_cast<uint64_t>(output_id),
+                                                  static_cast<size_t>(page));
+        },
+        {"output_id", "page"}));
+
+    const auto* byok = settings.get_byok();
+    if (byok && byok->is_usable()) agent->set_byok(byok->to_config());
+    if (settings.response_timeout_ms > 0) {
+        agent->set_response_timeout(std::chrono::milliseconds(settings.response_timeout_ms));
+    }
+
+    if (!agent->initialize()) {
+        error = "Failed to initialize: " + agent->provider_name();
+        std::string last_error = agent->get_last_error();
+        if (!last_error.empty()) error += " - " + last_error;
+        return "";
+    }
+
+    windbg_agent::RuntimeContext ctx;
+    ctx.target_name = dbg.GetTargetName();
+    ctx.target_arch = dbg.GetTargetArchitecture();
+    ctx.debugger_type = dbg.GetDebuggerType();
+    ctx.platform = "Windows";
+
+    std::string message = windbg_agent::BuildPromptVersion(settings.custom_prompt, ctx).body;
+    message += "\n\n";
+    message += kTriagePrompt;
+    for (const auto& entry : commands) {
+        message += "\n> " + entry.value("command", "") + "\n";
+        message += windbg_agent::ShapeOutput(entry.value("output", ""), settings.output_shaping)
+                       .text;
+    }
+
+    // Nobody is watching: no streaming, no interruption
+    libagents::HostContext host;
+    host.should_abort = []() { return false; };
+    host.on_event = [](const libagents::Event&) {};
+
+    std::string response;
+    try {
+        response = agent->query_hosted(message, host);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    agent->shutdown();
+    return response;
+}
+
+} // namespace
+
+std::vector<std::string> default_triage_script() {
+    return {".lastevent", "!analyze -v", ".ecxr", "kn 64", "r", "~", "lm"};
+}
+
+bool parse_triage_args(const std::vector<std::string>& args, TriageOptions& options,
+                       std::string& error) {
+    for (const auto& arg : args) {
+        std::string value;
+        try {
+            if (take_option(arg, "out", value)) {
+                options.out_dir = value;
+            }
+            else if (take_option(arg, "script", value)) {
+                options.script_path = value;
+            }
+            else if (take_option(arg, "jobs", value)) {
+                options.jobs = std::stoi(value);
+            }
+            else if (take_option(arg, "memory-mb", value)) {
+                options.memory_limit_mb = static_cast<size_t>(std::stoull(value));
+            }
+            else if (take_option(arg, "timeout", value)) {
+                options.timeout_s = std::stoi(value);
+            }
+            else if (arg == "--ai") {
+                options.ai_summary = true;
+            }
+            else if (arg == "--retry-failed") {
+                options.retry_failed = true;
+            }
+            else if (arg.rfind("--", 0) == 0) {
+                error = "unknown option " + arg;
+                return false;
+            }
+            else {
+                options.inputs.push_back(arg);
+            }
+        }
+        catch (const std::exception&) {
+            error = "invalid value in " + arg;
+            return false;
+        }
+    }
+
+    if (options.inputs.empty()) {
+        error = "triage requires at least one dump, directory or manifest";
+        return false;
+    }
+    return true;
+}
+
+int run_triage(const TriageOptions& options) {
+    std::string error;
+    std::vector<fs::path> dumps;
+    if (!collect_dumps(options.inputs, dumps, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    if (!options.script_path.empty()) {
+        std::vector<std::string> script;
+        if (!load_script(options.script_path, script, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    fs::create_directories(options.out_dir, ec);
+    if (ec) {
+        std::cerr << "Error: cannot create " << options.out_dir << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    // Resume: skip dumps that already have a result (failed ones too, unless retrying)
+    std::vector<Worker> pending;
+    size_t skipped = 0;
+    for (const auto& dump : dumps) {
+        Worker worker;
+        worker.dump = dump;
+        worker.result_path = result_path_for(options.out_dir, dump);
+        json previous;
+        if (read_json(worker.result_path, previous) &&
+            (!options.retry_failed || previous.value("status", "") == "ok")) {
+            skipped++;
+            continue;
+        }
+        pending.push_back(std::move(worker));
+    }
+
+    int jobs = choose_jobs(options);
+    std::printf("Triage: %zu dumps (%zu already done), %d workers, %zu MB per worker -> %s\n",
+                dumps.size(), skipped, jobs, options.memory_limit_mb, options.out_dir.c_str());
+    std::fflush(stdout);
+
+    std::ofstream index(fs::path(options.out_dir) / "triage.jsonl", std::ios::app);
+    SetConsoleCtrlHandler(on_console_ctrl, TRUE);
+
+    Totals totals;
+    totals.total = pending.size();
+    auto run_started = std::chrono::steady_clock::now();
+    auto timeout = std::chrono::seconds(options.timeout_s);
+    std::vector<Worker> running;
+    size_t next = 0;
+
+    while (!g_stop) {
+        while (static_cast<int>(running.size()) < jobs && next < pending.size()) {
+            Worker worker = std::move(pending[next++]);
+            if (start_worker(worker, options, error)) {
+                running.push_back(std::move(worker));
+            }
+            else {
+                json result = {{"dump", worker.dump.string()},
+                               {"status", "spawn_failed"},
+                               {"error", error}};
+                write_json_atomic(worker.result_path, result);
+                record_result(worker.dump, worker.result_path, std::move(result), 0.0, 0.0,
+                              index, totals);
+            }
+        }
+        if (running.empty()) break;
+
+        std::vector<HANDLE> handles;
+        for (const auto& worker : running) handles.push_back(worker.process);
+        DWORD wait = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(),
+                                            FALSE, 500);
+        if (wait < WAIT_OBJECT_0 + handles.size()) {
+            size_t i = wait - WAIT_OBJECT_0;
+            finish_worker(running[i], options, index, totals);
+            running.erase(running.begin() + i);
+        }
+
+        // Timed-out workers are killed here and recorded once their process has exited
+        auto now = std::chrono::steady_clock::now();
+        for (auto& worker : running) {
+            if (options.timeout_s > 0 && !worker.timed_out && now - worker.started > timeout) {
+                worker.timed_out = true;
+                TerminateJobObject(worker.job, WAIT_TIMEOUT);
+            }
+        }
+    }
+
+    // Interrupted: in-flight dumps get no result, so the next run picks them up again
+    for (auto& worker : running) {
+        TerminateJobObject(worker.job, ERROR_CANCELLED);
+        WaitForSingleObject(worker.process, 5000);
+        CloseHandle(worker.process);
+        CloseHandle(worker.job);
+        DeleteFileA((worker.result_path + ".tmp").c_str());
+    }
+    SetConsoleCtrlHandler(on_console_ctrl, FALSE);
+
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                     run_started)
+                           .count();
+    std::printf("\n%zu ok, %zu failed in %.1f s", totals.ok, totals.failed, elapsed_s);
+    if (totals.done < totals.total) {
+        std::printf("; interrupted with %zu left (run again to resume)",
+                    totals.total - totals.done);
+    }
+    std::printf("\nResults: %s\n", (fs::path(options.out_dir) / "triage.jsonl").string().c_str());
+
+    return totals.failed == 0 && totals.done == totals.total ? 0 : 1;
+}
+
+int run_triage_worker(const std::vector<std::string>& args) {
+    std::string dump, out, script_path;
+    bool ai = false;
+    for (const auto& arg : args) {
+        if (take_option(arg, "dump", dump) || take_option(arg, "out", out) ||
+            take_option(arg, "script", script_path)) {
+            continue;
+        }
+        if (arg == "--ai") ai = true;
+    }
+    if (dump.empty() || out.empty()) {
+        std::cerr << "Error: triage-worker requires --dump and --out\n";
+        return kWorkerFailed;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    json result = {{"dump", dump}};
+    auto finish = [&](const std::string& status, int exit_code) {
+        result["status"] = status;
+        result["elapsed_ms"] = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - started)
+                                   .count();
+        return write_json_atomic(out, result) ? exit_code : kWorkerFailed;
+    };
+
+    std::vector<std::string> script = default_triage_script();
+    if (!script_path.empty()) {
+        std::string error;
+        script.clear();
+        if (!load_script(script_path, script, error)) {
+            result["error"] = error;
+            return finish("failed", kWorkerFailed);
+        }
+    }
+
+    // Header facts first; kernel dumps and other non-MDMP files simply have none
+    {
+        std::string error;
+        if (auto reader = windbg_agent::MinidumpBackend::Open(dump, &error)) {
+            result["minidump"] = minidump_summary(*reader);
+        }
+    }
+
+    // A private engine per process: dbgeng keeps global state, so one dump per worker
+    ComPtr<IDebugClient> client;
+    ComPtr<IDebugControl> control;
+    HRESULT hr = DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf()));
+    if (SUCCEEDED(hr)) hr = client.As(&control);
+    if (FAILED(hr)) {
+        result["error"] = "DebugCreate failed: hr=" + format_hr(hr);
+        return finish("failed", kWorkerFailed);
+    }
+
+    hr = client->OpenDumpFile(dump.c_str());
+    if (SUCCEEDED(hr)) hr = control->WaitForEvent(DEBUG_WAIT_DEFAULT, INFINITE);
+    if (FAILED(hr)) {
+        result["error"] = "OpenDumpFile failed: hr=" + format_hr(hr);
+        return finish("open_failed", kWorkerOpenFailed);
+    }
+
+    {
+        windbg_agent::WinDbgClient dbg(client.Get());
+        dbg.SetEchoOutput(false);
+        dbg.SetSource("triage");
+
+        result["target"] = {{"name", dbg.GetTargetName()},
+                            {"architecture", dbg.GetTargetArchitecture()},
+                            {"debugger", dbg.GetDebuggerType()},
+                            {"pid", dbg.GetProcessId()}};
+
+        json commands = json::array();
+        std::string bucket;
+        for (const auto& command : script) {
+            long status = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::string output = dbg.ExecuteCommand(command, &status);
+            double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count();
+            if (bucket.empty()) bucket = find_bucket(output);
+            commands.push_back({{"command", command},
+                                {"status", status},
+                                {"elapsed_ms", elapsed_ms},
+                                {"output", std::move(output)}});
+        }
+        result["bucket"] = bucket;
+
+        if (ai) {
+            std::string error;
+            std::string summary = summarize(dbg, commands, error);
+            result["summary"] = summary;
+            if (!error.empty()) result["summary_error"] = error;
+        }
+        result["commands"] = std::move(commands);
+    }
+
+    int exit_code = finish("ok", kWorkerOk);
+    client->EndSession(DEBUG_END_PASSIVE);
+    return exit_code;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Batch crash-dump triage.
+//
+// The coordinator expands its inputs (dump files, directories scanned for *.dmp/*.mdmp/
+// *.hdmp, or manifests listing one dump path per line) and runs each dump in its own
+// worker process:
+//
+//   windbg_agent.exe triage-worker --dump=<path> --out=<result.json> [--script=F] [--ai]
+//
+// Each worker hosts its own dbgeng engine (DebugCreate + OpenDumpFile), runs the triage
+// script, optionally asks the AI for a summary, and writes one JSON result. Workers run
+// inside a job object with a memory cap and a timeout, so a corrupt or huge dump only
+// takes down its own process.
+//
+// The output directory doubles as the work queue: a dump whose result file exists is
+// skipped, so an interrupted run resumes where it stopped. Results are written to a
+// temporary file and renamed, so a result is never half-written. Every finished dump
+// is also appended to <out>/triage.jsonl.
+
+struct TriageOptions {
+    std::vector<std::string> inputs;   // Dumps, directories or manifests
+    std::string out_dir = "triage";    // One <dump>_<hash>.json per dump
+    std::string script_path;           // Debugger commands, one per line (default script if empty)
+    int jobs = 0;                      // Concurrent workers (0 = cores, bounded by memory)
+    size_t memory_limit_mb = 4096;     // Per-worker commit limit
+    int timeout_s = 900;               // Per-dump wall clock limit
+    bool ai_summary = false;           // Ask the AI for a summary in each worker
+    bool retry_failed = false;         // Re-run dumps whose previous result was not "ok"
+};
+
+// Parse "triage" arguments; returns false and sets error on bad usage
+bool parse_triage_args(const std::vector<std::string>& args, TriageOptions& options,
+                       std::string& error);
+
+// Run the coordinator; returns 0 if every dump produced an "ok" result
+int run_triage(const TriageOptions& options);
+
+// Run one worker (the "triage-worker" command); returns 0 if a result was written
+int run_triage_worker(const std::vector<std::string>& args);
+
+// Commands run when no --script is given
+std::vector<std::string> default_triage_script();
@@ -0,0 +1,226 @@
+#include "command_broker.hpp"
+
+#include <algorithm>
+
+namespace windbg_agent
+{
+
+CommandBroker& GetCommandBroker()
+{
+    static CommandBroker broker;
+    return broker;
+}
+
+CommandBroker::SourceId CommandBroker::Attach(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // First source of a new serving session: start counters from zero
+    if (sources_.empty())
+    {
+        max_queue_depth_ = 0;
+        executed_ = 0;
+        total_wait_ms_ = 0.0;
+        max_wait_ms_ = 0.0;
+        interrupt_checks_ = 0;
+        recent_count_ = 0;
+    }
+
+    Source source;
+    source.id = next_id_++;
+    source.name = name;
+    sources_.push_back(std::move(source));
+    return sources_.back().id;
+}
+
+void CommandBroker::Detach(SourceId source)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(sources_.begin(), sources_.end(),
+                               [source](const Source& s) { return s.id == source; });
+        if (it == sources_.end())
+            return;
+
+        for (Item* item : it->queue)
+            item->completed = true; // ran stays false
+        size_t index = static_cast<size_t>(it - sources_.begin());
+        sources_.erase(it);
+        if (next_source_ > index)
+            next_source_--;
+        if (next_source_ >= sources_.size())
+            next_source_ = 0;
+    }
+    queue_cv_.notify_all();
+    done_cv_.notify_all();
+}
+
+bool CommandBroker::Dispatch(SourceId source, Work work)
+{
+    Item item;
+    item.work = std::move(work);
+    item.enqueued = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = std::find_if(sources_.begin(), sources_.end(),
+                           [source](const Source& s) { return s.id == source; });
+    if (it == sources_.end())
+        return false;
+
+    it->queue.push_back(&item);
+    max_queue_depth_ = std::max(max_queue_depth_, QueuedItems());
+    queue_cv_.notify_one();
+
+    done_cv_.wait(lock, [&]() { return item.completed; });
+    return item.ran;
+}
+
+bool CommandBroker::Run(const std::function<bool()>& interrupt_check)
+{
+    auto poll = kMinPoll;
+
+    while (HasSources())
+    {
+        if (interrupt_check)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                interrupt_checks_++;
+            }
+            if (interrupt_check())
+                return true;
+        }
+
+        Item* item = nullptr;
+        Source* source = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_cv_.wait_for(lock, poll,
+                               [this]() { return QueuedItems() > 0 || sources_.empty(); });
+            item = NextItem(&source);
+            if (item)
+            {
+                RecordWait(*source, std::chrono::duration<double, std::milli>(
+                                        std::chrono::steady_clock::now() - item->enqueued)
+                                        .count());
+            }
+        }
+
+        if (!item)
+        {
+            // Idle: back off interrupt polling
+            poll = std::min(poll * 2, std::chrono::milliseconds(kMaxPoll));
+            continue;
+        }
+        poll = kMinPoll;
+
+        try
+        {
+            item->work();
+        }
+        catch (...)
+        {
+            // Work items report their own errors; never let one escape into the debugger
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            item->ran = true;
+            item->completed = true;
+            executed_++;
+        }
+        done_cv_.notify_all();
+    }
+
+    return false;
+}
+
+bool CommandBroker::HasSources() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !sources_.empty();
+}
+
+CommandBroker::Item* CommandBroker::NextItem(Source** source)
+{
+    for (size_t i = 0; i < sources_.size(); i++)
+    {
+        size_t index = (next_source_ + i) % sources_.size();
+        Source& candidate = sources_[index];
+        if (candidate.queue.empty())
+            continue;
+
+        Item* item = candidate.queue.front();
+        candidate.queue.pop_front();
+        candidate.executed++;
+        next_source_ = (index + 1) % sources_.size();
+        *source = &candidate;
+        return item;
+    }
+    return nullptr;
+}
+
+size_t CommandBroker::QueuedItems() const
+{
+    size_t count = 0;
+    for (const auto& source : sources_)
+        count += source.queue.size();
+    return count;
+}
+
+void CommandBroker::RecordWait(Source& source, double wait_ms)
+{
+    source.total_wait_ms += wait_ms;
+    source.max_wait_ms = std::max(source.max_wait_ms, wait_ms);
+    total_wait_ms_ += wait_ms;
+    max_wait_ms_ = std::max(max_wait_ms_, wait_ms);
+    recent_wait_ms_[recent_count_ % kLatencySamples] = static_cast<float>(wait_ms);
+    recent_count_++;
+}
+
+BrokerStats CommandBroker::GetStats() const
+{
+    BrokerStats stats;
+    std::vector<float> samples;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.queue_depth = QueuedItems();
+        stats.max_queue_depth = max_queue_depth_;
+        stats.executed = executed_;
+        stats.max_wait_ms = max_wait_ms_;
+        stats.interrupt_checks = interrupt_checks_;
+        if (executed_ > 0)
+            stats.avg_wait_ms = total_wait_ms_ / static_cast<double>(executed_);
+        size_t count = std::min(recent_count_, kLatencySamples);
+        samples.assign(recent_wait_ms_.begin(), recent_wait_ms_.begin() + count);
+
+        for (const auto& source : sources_)
+        {
+            BrokerSourceStats source_stats;
+            source_stats.name = source.name;
+            source_stats.queue_depth = source.queue.size();
+            source_stats.executed = source.executed;
+            source_stats.max_wait_ms = source.max_wait_ms;
+            if (source.executed > 0)
+                source_stats.avg_wait_ms =
+                    source.total_wait_ms / static_cast<double>(source.executed);
+            stats.sources.push_back(std::move(source_stats));
+        }
+    }
+
+    if (!samples.empty())
+    {
+        auto percentile = [&samples](double p)
+        {
+            size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+            std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+            return static_cast<double>(samples[index]);
+        };
+        stats.p50_wait_ms = percentile(0.50);
+        stats.p99_wait_ms = percentile(0.99);
+    }
+
+    return stats;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Counters for one attached transport
+struct BrokerSourceStats
+{
+    std::string name;
+    size_t queue_depth = 0;
+    uint64_t executed = 0;
+    double avg_wait_ms = 0.0;
+    double max_wait_ms = 0.0;
+};
+
+// Snapshot of broker counters
+struct BrokerStats
+{
+    size_t queue_depth = 0;     // Work items waiting right now (all sources)
+    size_t max_queue_depth = 0; // High-water mark since the first source attached
+    uint64_t executed = 0;      // Work items run on the main thread
+    double avg_wait_ms = 0.0;   // Mean enqueue-to-execute latency
+    double p50_wait_ms = 0.0;   // Over the most recent kLatencySamples items
+    double p99_wait_ms = 0.0;
+    double max_wait_ms = 0.0;
+    uint64_t interrupt_checks = 0; // Times the interrupt callback was polled
+    std::vector<BrokerSourceStats> sources;
+};
+
+// Owns the debugger main-thread queue shared by all transports (HTTP, MCP, ...).
+// Transports attach as sources and submit work from their own threads; Run() executes
+// it on the main thread, taking one item per source in round-robin order so a noisy
+// client cannot starve another. Run() sleeps until work arrives; the interrupt check is
+// polled on an adaptive cadence (fast right after activity, backing off while idle)
+// because dbgeng only exposes interrupts through polling.
+class CommandBroker
+{
+  public:
+    using SourceId = uint32_t;
+    using Work = std::function<void()>;
+
+    // Number of recent wait times kept for percentile reporting
+    static constexpr size_t kLatencySamples = 1024;
+
+    // Attach a transport; Run() keeps serving while at least one source is attached
+    SourceId Attach(const std::string& name);
+
+    // Detach a transport, failing its pending work. Run() returns after the last detach.
+    void Detach(SourceId source);
+
+    // Queue work for the main thread and block until it has run
+    // Returns false if the source detached before the work ran
+    bool Dispatch(SourceId source, Work work);
+
+    // Process work on the calling thread until no source is attached or
+    // interrupt_check() returns true. Returns true if stopped because of an interrupt.
+    bool Run(const std::function<bool()>& interrupt_check);
+
+    // True while at least one source is attached
+    bool HasSources() const;
+
+    BrokerStats GetStats() const;
+
+  private:
+    struct Item
+    {
+        Work work;
+        std::chrono::steady_clock::time_point enqueued;
+        bool completed = false;
+        bool ran = false;
+    };
+
+    struct Source
+    {
+        SourceId id = 0;
+        std::string name;
+        std::deque<Item*> queue;
+        uint64_t executed = 0;
+        double total_wait_ms = 0.0;
+        double max_wait_ms = 0.0;
+    };
+
+    // Pop the next item, rotating across sources (mutex_ held)
+    Item* NextItem(Source** source);
+
+    size_t QueuedItems() const;
+    void RecordWait(Source& source, double wait_ms);
+
+    static constexpr auto kMinPoll = std::chrono::milliseconds(10);
+    static constexpr auto kMaxPoll = std::chrono::milliseconds(100); // Idle polling interval
+
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_; // Signals Run(): work arrived or a source detached
+    std::condition_variable done_cv_;  // Signals Dispatch(): an item completed
+    std::vector<Source> sources_;
+    size_t next_source_ = 0; // Round-robin cursor into sources_
+    SourceId next_id_ = 1;
+
+    // Counters (guarded by mutex_)
+    size_t max_queue_depth_ = 0;
+    uint64_t executed_ = 0;
+    double total_wait_ms_ = 0.0;
+    double max_wait_ms_ = 0.0;
+    uint64_t interrupt_checks_ = 0;
+    std::array<float, kLatencySamples> recent_wait_ms_{};
+    size_t recent_count_ = 0;
+};
+
+// Global broker shared by all transports in this debugger session
+CommandBroker& GetCommandBroker();
+
+} // namespace windbg_agent
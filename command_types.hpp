@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Callbacks for handling requests (called on the main thread)
+using ExecCallback = std::function<std::string(const std::string& command)>;
+
+// Returns the agent's response; throws std::exception when the query could not be answered
+// (agent setup failed, provider error), so the servers report it as a failure. The query
+// aborts once cancel (when given) is set.
+using AskCallback =
+    std::function<std::string(const std::string& query, const std::atomic<bool>* cancel)>;
+
+// Result of a single command executed as part of a batch
+struct ExecResult
+{
+    std::string command;
+    std::string output;
+    long status = 0;         // HRESULT returned by IDebugControl::Execute
+    double elapsed_ms = 0.0; // Wall-clock execution time on the main thread
+
+    bool succeeded() const { return status >= 0; }
+};
+
+// Run an ordered list of commands back-to-back in a single main-thread slot
+using ExecBatchCallback =
+    std::function<std::vector<ExecResult>(const std::vector<std::string>& commands)>;
+
+// Receives captured output chunks as they arrive; return false to stop receiving
+using OutputChunkHandler = std::function<bool(const char* text, size_t length)>;
+
+// Execute a command, forwarding output chunks instead of buffering the whole output
+// (the returned ExecResult carries status and timing, its output is left empty)
+using ExecStreamCallback =
+    std::function<ExecResult(const std::string& command, const OutputChunkHandler& on_chunk)>;
+
+// A structured query answered from engine state instead of command text
+struct QueryRequest
+{
+    std::string kind;      // "stack", "registers", "modules", "threads", "memory", "unique_stacks"
+    std::string address;   // memory: address expression ("0x1000", "@rsp", "ntdll!foo")
+    size_t size = 0;       // memory: bytes to read
+    size_t max_frames = 0; // stack: frames to return (0 = default)
+};
+
+// Run a structured query; returns compact JSON
+using QueryCallback = std::function<std::string(const QueryRequest& request)>;
+
+// One range of a binary memory read
+struct MemoryRangeRequest
+{
+    std::string address; // Address expression ("0x1000", "@rsp", "ntdll!foo")
+    size_t size = 0;
+};
+
+// Bytes read for one range. data holds the readable prefix of the range: a read that
+// runs into unreadable memory stops there and keeps the failing status.
+struct MemoryRangeResult
+{
+    uint64_t address = 0; // Evaluated start address
+    std::string data;     // Raw bytes
+    long status = 0;
+    std::string error; // Set when the address could not be evaluated
+
+    bool succeeded() const { return status >= 0; }
+};
+
+// Read memory ranges in one main-thread slot; overlapping and adjacent ranges are read
+// together and served through the page cache
+using MemoryReadCallback = std::function<std::vector<MemoryRangeResult>(
+    const std::vector<MemoryRangeRequest>& ranges)>;
+
+// Limits of one binary memory request
+constexpr size_t kMaxMemoryRanges = 1024;
+constexpr size_t kMaxMemoryRangeBytes = 16 * 1024 * 1024;
+constexpr size_t kMaxMemoryBatchBytes = 64 * 1024 * 1024;
+
+// Addresses to resolve to module, symbol and memory region
+struct SymbolizeRequest
+{
+    std::vector<std::string> addresses; // Address expressions ("0x7ffb1c2d0000", "@rip")
+    bool symbols = true;                // Also look up the nearest symbol name
+};
+
+// What is known about one address. Fields stay empty/zero when the address lies outside
+// every module or region.
+struct SymbolizeResult
+{
+    uint64_t address = 0;
+    std::string module; // Containing module name
+    uint64_t module_base = 0;
+    std::string symbol;        // Nearest symbol ("ntdll!RtlUserThreadStart")
+    uint64_t displacement = 0; // Offset of address from symbol
+    uint64_t region_base = 0;  // Containing memory region (region_size 0 if none)
+    uint64_t region_size = 0;
+    uint32_t region_state = 0; // MEM_* / PAGE_* / MEM_* values of the region
+    uint32_t region_protect = 0;
+    uint32_t region_type = 0;
+    std::string error; // Set when the address could not be evaluated
+};
+
+// Resolve many addresses in one main-thread slot through the address index
+using SymbolizeCallback =
+    std::function<std::vector<SymbolizeResult>(const SymbolizeRequest& request)>;
+
+// Maximum number of addresses accepted in one symbolize request
+constexpr size_t kMaxSymbolizeAddresses = 65536;
+
+// One search pattern for a memory scan: bytes[i] must match where mask[i] is set (mask
+// bits clear are wildcards); bytes are stored pre-masked
+struct ScanPattern
+{
+    std::string bytes;
+    std::string mask;
+};
+
+// Search target memory for any of several patterns
+struct MemoryScanRequest
+{
+    std::vector<ScanPattern> patterns;
+    std::string address; // Start of the range to search (empty = whole address space)
+    uint64_t size = 0;   // Length of the range (0 = to the end of the address space)
+    size_t max_hits = 0; // 0 = kDefaultScanHits
+};
+
+// A match: pattern is the index into MemoryScanRequest::patterns
+struct ScanHit
+{
+    uint64_t address = 0;
+    uint32_t pattern = 0;
+};
+
+// Receives hits in batches as the scan finds them (in no particular order); return false to
+// stop the scan
+using ScanHitHandler = std::function<bool(const std::vector<ScanHit>& hits)>;
+
+// Outcome of a memory scan
+struct MemoryScanResult
+{
+    long status = 0;
+    std::string error;
+    uint64_t bytes_scanned = 0;
+    uint64_t regions = 0; // Regions searched
+    uint64_t hits = 0;
+    bool truncated = false; // Stopped at max_hits, by the handler or by an interrupt
+    double elapsed_ms = 0.0;
+    std::string isa; // Matcher in use: "avx2", "sse2" or "scalar"
+
+    bool succeeded() const { return status >= 0; }
+};
+
+// Run a memory scan in one main-thread slot, delivering hits through on_hits as they are found
+using MemoryScanCallback = std::function<MemoryScanResult(const MemoryScanRequest& request,
+                                                          const ScanHitHandler& on_hits)>;
+
+// Limits of one memory scan
+constexpr size_t kMaxScanPatterns = 64;
+constexpr size_t kMaxScanPatternBytes = 256;
+constexpr size_t kDefaultScanHits = 1000;
+constexpr size_t kMaxScanHits = 1000000;
+
+// Maximum number of commands accepted in one batch request
+constexpr size_t kMaxBatchCommands = 256;
+
+// Format an HRESULT as 0xXXXXXXXX
+inline std::string FormatHResult(long status)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%08lX", static_cast<unsigned long>(status) & 0xFFFFFFFFul);
+    return buf;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,773 @@
+#include "dbgeng_backend.hpp"
+#include "output_capture.hpp"
+#include "windbg_client.hpp"
+#include <cctype>
+#include <wrl/client.h>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+// Room for the largest target CONTEXT record (x64 is 1232 bytes, ARM64 912)
+constexpr size_t kMaxScopeContextBytes = 4096;
+
+const char* SymbolTypeName(ULONG type)
+{
+    switch (type)
+    {
+    case DEBUG_SYMTYPE_NONE:
+        return "none";
+    case DEBUG_SYMTYPE_COFF:
+        return "coff";
+    case DEBUG_SYMTYPE_CODEVIEW:
+        return "codeview";
+    case DEBUG_SYMTYPE_PDB:
+        return "pdb";
+    case DEBUG_SYMTYPE_EXPORT:
+        return "export";
+    case DEBUG_SYMTYPE_DEFERRED:
+        return "deferred";
+    case DEBUG_SYMTYPE_SYM:
+        return "sym";
+    case DEBUG_SYMTYPE_DIA:
+        return "dia";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace
+
+WinDbgClient::WinDbgClient(IDebugClient* client)
+    : WinDbgClient(std::make_unique<DbgEngBackend>(client))
+{
+}
+
+DbgEngBackend::DbgEngBackend(IDebugClient* client) : client_(client), control_(nullptr)
+{
+    if (client_)
+    {
+        client_->QueryInterface(__uuidof(IDebugControl), (void**)&control_);
+        if (control_)
+            dml_ = std::make_unique<DmlOutput>(control_);
+    }
+}
+
+DbgEngBackend::~DbgEngBackend()
+{
+    if (control_)
+    {
+        control_->Release();
+        control_ = nullptr;
+    }
+    if (owns_client_ && client_)
+        client_->Release();
+}
+
+std::unique_ptr<DbgEngBackend> DbgEngBackend::CreateForThread()
+{
+    // Connects to the engine already running in this process
+    IDebugClient* client = nullptr;
+    if (FAILED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(&client))))
+        return nullptr;
+
+    auto backend = std::make_unique<DbgEngBackend>(client);
+    backend->owns_client_ = true;
+    return backend;
+}
+
+bool DbgEngBackend::IsAvailable() const
+{
+    return client_ && control_;
+}
+
+long DbgEngBackend::Execute(const std::string& command, bool echo, OutputView* output)
+{
+    // Capture through the client's persistent output hub
+    OutputCapture capture(client_, echo);
+
+    HRESULT hr =
+        control_->Execute(DEBUG_OUTCTL_THIS_CLIENT, command.c_str(), DEBUG_EXECUTE_DEFAULT);
+
+    if (!capture.Take(output) && SUCCEEDED(hr))
+        return kStatusOutputLost;
+    return hr;
+}
+
+long DbgEngBackend::ExecuteStreaming(const std::string& command, bool echo,
+                                     const OutputChunkHandler& on_chunk)
+{
+    // Forward chunks instead of accumulating them
+    OutputCapture capture(client_, echo, on_chunk);
+
+    return control_->Execute(DEBUG_OUTCTL_THIS_CLIENT, command.c_str(), DEBUG_EXECUTE_DEFAULT);
+}
+
+void DbgEngBackend::Display(DisplayStyle style, const std::string& text)
+{
+    if (!control_)
+        return;
+
+    if (style == DisplayStyle::Raw)
+    {
+        control_->Output(DEBUG_OUTPUT_NORMAL, "%s", text.c_str());
+        return;
+    }
+
+    if (dml_)
+    {
+        switch (style)
+        {
+        case DisplayStyle::Error:
+            dml_->OutputError(text.c_str());
+            return;
+        case DisplayStyle::Warning:
+            dml_->OutputWarning(text.c_str());
+            return;
+        case DisplayStyle::Command:
+            dml_->OutputCommand(text.c_str());
+            return;
+        case DisplayStyle::CommandResult:
+            dml_->OutputCommandResult(text.c_str());
+            return;
+        case DisplayStyle::Thinking:
+            dml_->OutputAgentThinking(text.c_str());
+            return;
+        case DisplayStyle::Response:
+            dml_->OutputAgentResponse(text.c_str());
+            return;
+        default:
+            break;
+        }
+    }
+
+    switch (style)
+    {
+    case DisplayStyle::Error:
+        control_->Output(DEBUG_OUTPUT_ERROR, "%s\n", text.c_str());
+        break;
+    case DisplayStyle::Warning:
+        control_->Output(DEBUG_OUTPUT_WARNING, "%s\n", text.c_str());
+        break;
+    case DisplayStyle::Command:
+        control_->Output(DEBUG_OUTPUT_NORMAL, "$ %s\n", text.c_str());
+        break;
+    default:
+        control_->Output(DEBUG_OUTPUT_NORMAL, "%s\n", text.c_str());
+        break;
+    }
+}
+
+bool DbgEngBackend::SupportsColor() const
+{
+    return dml_ && dml_->IsDmlSupported();
+}
+
+std::string DbgEngBackend::GetTargetName() const
+{
+    if (!client_)
+        return "";
+
+    // Try to get dump file name first
+    char dump_file[MAX_PATH] = {0};
+    ULONG dump_file_size = 0;
+
+    Microsoft::WRL::ComPtr<IDebugClient4> client4;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugClient4),
+                                          reinterpret_cast<void**>(client4.GetAddressOf()))))
+    {
+        // GetDumpFile returns the dump file name if debugging a dump
+        // Note: Handle and Type must not be nullptr - the API writes to them
+        ULONG64 handle = 0;
+        ULONG type = 0;
+        HRESULT hr =
+            client4->GetDumpFile(0, dump_file, sizeof(dump_file), &dump_file_size, &handle, &type);
+
+        if (SUCCEEDED(hr) && dump_file[0] != '\0')
+            return dump_file;
+    }
+
+    // Fall back to getting process name via system objects
+    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSystemObjects),
+                                          reinterpret_cast<void**>(sys.GetAddressOf()))))
+    {
+        char exe_name[MAX_PATH] = {0};
+        ULONG exe_size = 0;
+        HRESULT hr = sys->GetCurrentProcessExecutableName(exe_name, sizeof(exe_name), &exe_size);
+        if (SUCCEEDED(hr) && exe_name[0] != '\0')
+            return exe_name;
+    }
+
+    return "";
+}
+
+std::string DbgEngBackend::GetTargetArchitecture() const
+{
+    if (!control_)
+        return "";
+
+    ULONG proc_type = 0;
+    if (SUCCEEDED(control_->GetActualProcessorType(&proc_type)))
+    {
+        switch (proc_type)
+        {
+        case IMAGE_FILE_MACHINE_I386:
+            return "x86";
+        case IMAGE_FILE_MACHINE_AMD64:
+            return "x64";
+        case IMAGE_FILE_MACHINE_ARM64:
+            return "ARM64";
+        case IMAGE_FILE_MACHINE_ARM:
+        case IMAGE_FILE_MACHINE_ARMNT:
+            return "ARM";
+        default:
+            return "Unknown (" + std::to_string(proc_type) + ")";
+        }
+    }
+    return "";
+}
+
+std::string DbgEngBackend::GetDebuggerType() const
+{
+    // Detect debugger by examining host process name
+    char module_path[MAX_PATH] = {0};
+    if (GetModuleFileNameA(nullptr, module_path, MAX_PATH))
+    {
+        std::string path = module_path;
+        // Convert to lowercase for comparison
+        for (auto& c : path)
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+        if (path.find("dbgx") != std::string::npos || path.find("windbg") != std::string::npos)
+            return "WinDbg";
+        if (path.find("cdb") != std::string::npos)
+            return "CDB";
+        if (path.find("ntsd") != std::string::npos)
+            return "NTSD";
+        if (path.find("kd") != std::string::npos)
+            return "KD";
+    }
+    return "Windows Debugger";
+}
+
+bool DbgEngBackend::IsInterrupted() const
+{
+    if (!control_)
+        return false;
+
+    // Check if user pressed Ctrl+C or Ctrl+Break
+    HRESULT hr = control_->GetInterrupt();
+    return hr == S_OK;
+}
+
+std::string DbgEngBackend::GetTargetState() const
+{
+    if (!control_)
+        return "Unknown";
+
+    ULONG status = 0;
+    HRESULT hr = control_->GetExecutionStatus(&status);
+    if (FAILED(hr))
+        return "Unknown";
+
+    switch (status)
+    {
+    case DEBUG_STATUS_NO_DEBUGGEE:
+        return "No target";
+    case DEBUG_STATUS_STEP_INTO:
+    case DEBUG_STATUS_STEP_OVER:
+    case DEBUG_STATUS_STEP_BRANCH:
+        return "Stepping";
+    case DEBUG_STATUS_GO:
+    case DEBUG_STATUS_GO_HANDLED:
+    case DEBUG_STATUS_GO_NOT_HANDLED:
+        return "Running";
+    case DEBUG_STATUS_BREAK:
+        return "Break";
+    case DEBUG_STATUS_OUT_OF_SYNC:
+        return "Out of sync";
+    case DEBUG_STATUS_WAIT_INPUT:
+        return "Waiting for input";
+    case DEBUG_STATUS_TIMEOUT:
+        return "Timeout";
+    default:
+        return "Unknown";
+    }
+}
+
+uint32_t DbgEngBackend::GetProcessId() const
+{
+    if (!client_)
+        return 0;
+
+    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSystemObjects),
+                                          reinterpret_cast<void**>(sys.GetAddressOf()))))
+    {
+        ULONG pid = 0;
+        if (SUCCEEDED(sys->GetCurrentProcessSystemId(&pid)))
+            return pid;
+    }
+    return 0;
+}
+
+std::string DbgEngBackend::GetContextKey() const
+{
+    // Everything besides the command text that a read-only command's output depends on
+    ULONG system_id = 0, process_id = 0, thread_id = 0, frame = 0, processor = 0;
+
+    Microsoft::WRL::ComPtr<IDebugSystemObjects3> sys;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSystemObjects3),
+                                          reinterpret_cast<void**>(sys.GetAddressOf()))))
+    {
+        sys->GetCurrentSystemId(&system_id);
+        sys->GetCurrentProcessId(&process_id);
+        sys->GetCurrentThreadId(&thread_id);
+    }
+
+    Microsoft::WRL::ComPtr<IDebugSymbols3> symbols;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSymbols3),
+                                          reinterpret_cast<void**>(symbols.GetAddressOf()))))
+    {
+        symbols->GetCurrentScopeFrameIndex(&frame);
+    }
+
+    control_->GetEffectiveProcessorType(&processor);
+
+    return GetTargetName() + "|" + std::to_string(system_id) + ":" + std::to_string(process_id) +
+           ":" + std::to_string(thread_id) + ":" + std::to_string(frame) + ":" +
+           std::to_string(processor);
+}
+
+long DbgEngBackend::GetStack(size_t max_frames, std::vector<StackFrameInfo>* frames)
+{
+    frames->clear();
+    if (!control_)
+        return E_FAIL;
+
+    std::vector<DEBUG_STACK_FRAME> raw(max_frames);
+    ULONG filled = 0;
+    HRESULT hr = control_->GetStackTrace(0, 0, 0, raw.data(), static_cast<ULONG>(raw.size()),
+                                         &filled);
+    if (FAILED(hr))
+        return hr;
+
+    Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+    client_->QueryInterface(__uuidof(IDebugSymbols),
+                            reinterpret_cast<void**>(symbols.GetAddressOf()));
+
+    frames->reserve(filled);
+    for (ULONG i = 0; i < filled; i++)
+    {
+        StackFrameInfo frame;
+        frame.number = raw[i].FrameNumber;
+        frame.instruction = raw[i].InstructionOffset;
+        frame.return_address = raw[i].ReturnOffset;
+        frame.frame_pointer = raw[i].FrameOffset;
+        frame.stack_pointer = raw[i].StackOffset;
+
+        char name[512] = {0};
+        ULONG64 displacement = 0;
+        if (symbols && SUCCEEDED(symbols->GetNameByOffset(frame.instruction, name, sizeof(name),
+                                                          nullptr, &displacement)))
+        {
+            frame.symbol = name;
+            frame.displacement = displacement;
+        }
+        frames->push_back(std::move(frame));
+    }
+    return S_OK;
+}
+
+long DbgEngBackend::GetThreadStacks(size_t max_frames, std::vector<ThreadStack>* stacks)
+{
+    stacks->clear();
+    if (!control_)
+        return E_FAIL;
+
+    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugSystemObjects),
+                                         reinterpret_cast<void**>(sys.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    ULONG count = 0;
+    hr = sys->GetNumberThreads(&count);
+    if (FAILED(hr) || count == 0)
+        return hr;
+
+    std::vector<ULONG> ids(count), system_ids(count);
+    hr = sys->GetThreadIdsByIndex(0, count, ids.data(), system_ids.data());
+    if (FAILED(hr))
+        return hr;
+
+    ULONG current = 0;
+    if (FAILED(sys->GetCurrentThreadId(&current)))
+        return E_FAIL;
+
+    // Switching threads resets the scope, which drops a frame selected with .frame and a
+    // context set with .ecxr/.cxr; save it to put back along with the thread. The buffer
+    // only has to hold the target's CONTEXT record.
+    Microsoft::WRL::ComPtr<IDebugSymbols3> symbols;
+    ULONG64 scope_offset = 0;
+    DEBUG_STACK_FRAME scope_frame = {};
+    std::vector<uint8_t> scope_context(kMaxScopeContextBytes);
+    bool scope_saved =
+        SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSymbols3),
+                                          reinterpret_cast<void**>(symbols.GetAddressOf()))) &&
+        SUCCEEDED(symbols->GetScope(&scope_offset, &scope_frame, scope_context.data(),
+                                    static_cast<ULONG>(scope_context.size())));
+
+    // GetStackTrace walks the current thread, so visit each one and switch back at the end
+    std::vector<DEBUG_STACK_FRAME> raw(max_frames);
+    stacks->reserve(count);
+    for (ULONG i = 0; i < count && !IsInterrupted(); i++)
+    {
+        if (FAILED(sys->SetCurrentThreadId(ids[i])))
+            continue;
+
+        ULONG filled = 0;
+        if (FAILED(control_->GetStackTrace(0, 0, 0, raw.data(), static_cast<ULONG>(raw.size()),
+                                           &filled)))
+            continue;
+
+        ThreadStack stack;
+        stack.id = ids[i];
+        stack.system_id = system_ids[i];
+        stack.frames.reserve(filled);
+        for (ULONG f = 0; f < filled; f++)
+            stack.frames.push_back(raw[f].InstructionOffset);
+        stacks->push_back(std::move(stack));
+    }
+    sys->SetCurrentThreadId(current);
+    if (scope_saved)
+        symbols->SetScope(scope_offset, &scope_frame, scope_context.data(),
+                          static_cast<ULONG>(scope_context.size()));
+    return S_OK;
+}
+
+long DbgEngBackend::GetEventStackOffsets(size_t max_frames, std::vector<uint64_t>* offsets)
+{
+    offsets->clear();
+    if (!control_)
+        return E_FAIL;
+
+    std::vector<DEBUG_STACK_FRAME> raw(max_frames);
+    ULONG filled = 0;
+    HRESULT hr = E_FAIL;
+
+    // A dump's stored event context (the one .ecxr uses) walks the faulting stack without
+    // making its thread current
+    Microsoft::WRL::ComPtr<IDebugControl4> control4;
+    std::vector<uint8_t> context(kMaxScopeContextBytes);
+    ULONG type = 0, process_id = 0, thread_id = 0, context_used = 0;
+    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugControl4),
+                                          reinterpret_cast<void**>(control4.GetAddressOf()))) &&
+        SUCCEEDED(control4->GetStoredEventInformation(
+            &type, &process_id, &thread_id, context.data(), static_cast<ULONG>(context.size()),
+            &context_used, nullptr, 0, nullptr)) &&
+        context_used > 0)
+    {
+        hr = control4->GetContextStackTrace(context.data(), context_used, raw.data(),
+                                            static_cast<ULONG>(raw.size()), nullptr, 0, 0,
+                                            &filled);
+    }
+
+    // Otherwise walk the current thread, if it is the one that raised the last event
+    // (switching threads would move the user's current thread too)
+    if (FAILED(hr))
+    {
+        Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
+        ULONG event_thread = 0, current_thread = 0;
+        hr = client_->QueryInterface(__uuidof(IDebugSystemObjects),
+                                     reinterpret_cast<void**>(sys.GetAddressOf()));
+        if (FAILED(hr))
+            return hr;
+        if (FAILED(sys->GetEventThread(&event_thread)) ||
+            FAILED(sys->GetCurrentThreadId(&current_thread)) || event_thread != current_thread)
+            return kStatusNotFound;
+        hr = control_->GetStackTrace(0, 0, 0, raw.data(), static_cast<ULONG>(raw.size()),
+                                     &filled);
+    }
+    if (FAILED(hr))
+        return hr;
+
+    offsets->reserve(filled);
+    for (ULONG i = 0; i < filled; i++)
+        offsets->push_back(raw[i].InstructionOffset);
+    return S_OK;
+}
+
+long DbgEngBackend::GetExceptionAddress(uint64_t* address)
+{
+    if (!control_)
+        return E_FAIL;
+
+    ULONG type = 0, process_id = 0, thread_id = 0;
+    DEBUG_LAST_EVENT_INFO_EXCEPTION info = {};
+    HRESULT hr = control_->GetLastEventInformation(&type, &process_id, &thread_id, &info,
+                                                   sizeof(info), nullptr, nullptr, 0, nullptr);
+    if (FAILED(hr))
+        return hr;
+    if (type != DEBUG_EVENT_EXCEPTION)
+        return kStatusNotFound;
+
+    *address = info.ExceptionRecord.ExceptionAddress;
+    return S_OK;
+}
+
+long DbgEngBackend::GetRegisters(std::vector<RegisterInfo>* registers)
+{
+    registers->clear();
+
+    Microsoft::WRL::ComPtr<IDebugRegisters> regs;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugRegisters),
+                                         reinterpret_cast<void**>(regs.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    ULONG count = 0;
+    hr = regs->GetNumberRegisters(&count);
+    if (FAILED(hr))
+        return hr;
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        char name[64] = {0};
+        DEBUG_REGISTER_DESCRIPTION description = {};
+        if (FAILED(regs->GetDescription(i, name, sizeof(name), nullptr, &description)) ||
+            (description.Flags & DEBUG_REGISTER_SUB_REGISTER))
+            continue;
+
+        DEBUG_VALUE value = {};
+        if (FAILED(regs->GetValue(i, &value)))
+            continue;
+
+        RegisterInfo info;
+        info.name = name;
+        switch (value.Type)
+        {
+        case DEBUG_VALUE_INT8:
+            info.value = value.I8;
+            break;
+        case DEBUG_VALUE_INT16:
+            info.value = value.I16;
+            break;
+        case DEBUG_VALUE_INT32:
+            info.value = value.I32;
+            break;
+        case DEBUG_VALUE_INT64:
+            info.value = value.I64;
+            break;
+        default:
+            continue; // Floating point and vector registers stay with the r command
+        }
+        registers->push_back(std::move(info));
+    }
+    return S_OK;
+}
+
+long DbgEngBackend::GetModules(std::vector<ModuleInfo>* modules)
+{
+    modules->clear();
+
+    Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugSymbols),
+                                         reinterpret_cast<void**>(symbols.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    ULONG loaded = 0, unloaded = 0;
+    hr = symbols->GetNumberModules(&loaded, &unloaded);
+    if (FAILED(hr) || loaded == 0)
+        return hr;
+
+    std::vector<DEBUG_MODULE_PARAMETERS> params(loaded);
+    hr = symbols->GetModuleParameters(loaded, nullptr, 0, params.data());
+    if (FAILED(hr))
+        return hr;
+
+    modules->reserve(loaded);
+    for (ULONG i = 0; i < loaded; i++)
+    {
+        if (params[i].Base == DEBUG_INVALID_OFFSET)
+            continue;
+
+        char image[MAX_PATH] = {0};
+        char name[256] = {0};
+        symbols->GetModuleNames(i, 0, image, sizeof(image), nullptr, name, sizeof(name), nullptr,
+                                nullptr, 0, nullptr);
+
+        ModuleInfo module;
+        module.name = name;
+        module.image = image;
+        module.base = params[i].Base;
+        module.size = params[i].Size;
+        module.timestamp = params[i].TimeDateStamp;
+        module.checksum = params[i].Checksum;
+        module.symbols = SymbolTypeName(params[i].SymbolType);
+        modules->push_back(std::move(module));
+    }
+    return S_OK;
+}
+
+long DbgEngBackend::LoadSymbols(const std::string& module)
+{
+    if (!control_)
+        return E_FAIL;
+
+    // Output goes nowhere: this runs on background clients while the user works
+    std::string command = "ld " + module;
+    HRESULT hr = control_->Execute(DEBUG_OUTCTL_IGNORE, command.c_str(),
+                                   DEBUG_EXECUTE_NOT_LOGGED | DEBUG_EXECUTE_NO_REPEAT);
+    if (FAILED(hr))
+        return hr;
+
+    // ld succeeds even when no symbols were found; the module's symbol type tells
+    Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+    hr = client_->QueryInterface(__uuidof(IDebugSymbols),
+                                 reinterpret_cast<void**>(symbols.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    ULONG index = 0;
+    ULONG64 base = 0;
+    hr = symbols->GetModuleByModuleName(module.c_str(), 0, &index, &base);
+    if (FAILED(hr))
+        return hr;
+
+    DEBUG_MODULE_PARAMETERS params = {};
+    hr = symbols->GetModuleParameters(1, &base, 0, &params);
+    if (FAILED(hr))
+        return hr;
+    if (params.SymbolType == DEBUG_SYMTYPE_NONE || params.SymbolType == DEBUG_SYMTYPE_DEFERRED)
+        return kStatusNotFound;
+    return S_OK;
+}
+
+long DbgEngBackend::GetThreads(std::vector<ThreadInfo>* threads)
+{
+    threads->clear();
+
+    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugSystemObjects),
+                                         reinterpret_cast<void**>(sys.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    ULONG count = 0;
+    hr = sys->GetNumberThreads(&count);
+    if (FAILED(hr) || count == 0)
+        return hr;
+
+    std::vector<ULONG> ids(count), system_ids(count);
+    hr = sys->GetThreadIdsByIndex(0, count, ids.data(), system_ids.data());
+    if (FAILED(hr))
+        return hr;
+
+    ULONG current = 0;
+    bool has_current = SUCCEEDED(sys->GetCurrentThreadId(&current));
+
+    threads->reserve(count);
+    for (ULONG i = 0; i < count; i++)
+    {
+        ThreadInfo thread;
+        thread.id = ids[i];
+        thread.system_id = system_ids[i];
+        thread.current = has_current && ids[i] == current;
+        threads->push_back(thread);
+    }
+    return S_OK;
+}
+
+long DbgEngBackend::Evaluate(const std::string& expression, uint64_t* value)
+{
+    if (!control_)
+        return E_FAIL;
+
+    DEBUG_VALUE result = {};
+    HRESULT hr = control_->Evaluate(expression.c_str(), DEBUG_VALUE_INT64, &result, nullptr);
+    if (SUCCEEDED(hr))
+        *value = result.I64;
+    return hr;
+}
+
+long DbgEngBackend::GetMemoryRegions(std::vector<MemoryRegionInfo>* regions)
+{
+    regions->clear();
+
+    Microsoft::WRL::ComPtr<IDebugDataSpaces2> spaces;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugDataSpaces2),
+                                         reinterpret_cast<void**>(spaces.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    // Walk the address space region by region; QueryVirtual fails past the last one (and
+    // for targets without address space information, such as kernel sessions)
+    ULONG64 address = 0;
+    for (;;)
+    {
+        MEMORY_BASIC_INFORMATION64 info = {};
+        hr = spaces->QueryVirtual(address, &info);
+        if (FAILED(hr) || info.RegionSize == 0)
+            break;
+
+        if (info.State != MEM_FREE)
+        {
+            MemoryRegionInfo region;
+            region.base = info.BaseAddress;
+            region.size = info.RegionSize;
+            region.state = info.State;
+            region.protect = info.Protect;
+            region.type = info.Type;
+            regions->push_back(region);
+        }
+
+        ULONG64 next = info.BaseAddress + info.RegionSize;
+        if (next <= address)
+            break;
+        address = next;
+    }
+    return regions->empty() && FAILED(hr) ? hr : S_OK;
+}
+
+long DbgEngBackend::GetSymbol(uint64_t address, std::string* name, uint64_t* displacement)
+{
+    Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugSymbols),
+                                         reinterpret_cast<void**>(symbols.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    char buffer[512] = {0};
+    ULONG64 offset = 0;
+    hr = symbols->GetNameByOffset(address, buffer, sizeof(buffer), nullptr, &offset);
+    if (SUCCEEDED(hr))
+    {
+        *name = buffer;
+        *displacement = offset;
+    }
+    return hr;
+}
+
+long DbgEngBackend::ReadMemory(uint64_t address, void* buffer, size_t size, size_t* bytes_read)
+{
+    *bytes_read = 0;
+
+    Microsoft::WRL::ComPtr<IDebugDataSpaces> spaces;
+    HRESULT hr = client_->QueryInterface(__uuidof(IDebugDataSpaces),
+                                         reinterpret_cast<void**>(spaces.GetAddressOf()));
+    if (FAILED(hr))
+        return hr;
+
+    // ReadVirtual stops at the first unreadable page and reports the prefix it read
+    ULONG read = 0;
+    hr = spaces->ReadVirtual(address, buffer, static_cast<ULONG>(size), &read);
+    *bytes_read = read;
+    return hr;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "debugger_backend.hpp"
+#include "dml_output.hpp"
+#include <dbgeng.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+namespace windbg_agent
+{
+
+// Backend for a live WinDbg/CDB session using dbgeng interfaces and DML for colored output
+class DbgEngBackend : public IDebuggerBackend
+{
+  public:
+    // Construct with an IDebugClient (typically from extension callback)
+    explicit DbgEngBackend(IDebugClient* client);
+    ~DbgEngBackend() override;
+
+    // Backend on a new engine client (DebugCreate) for use on the calling thread only, e.g.
+    // a background worker; the client is released with the backend. nullptr on failure.
+    static std::unique_ptr<DbgEngBackend> CreateForThread();
+
+    bool IsAvailable() const override;
+    long Execute(const std::string& command, bool echo, OutputView* output) override;
+    long ExecuteStreaming(const std::string& command, bool echo,
+                          const OutputChunkHandler& on_chunk) override;
+
+    void Display(DisplayStyle style, const std::string& text) override;
+    bool SupportsColor() const override;
+
+    std::string GetTargetName() const override;
+    std::string GetTargetArchitecture() const override;
+    std::string GetDebuggerType() const override;
+    std::string GetTargetState() const override;
+    uint32_t GetProcessId() const override;
+    std::string GetContextKey() const override;
+    bool IsInterrupted() const override;
+
+    long GetStack(size_t max_frames, std::vector<StackFrameInfo>* frames) override;
+    long GetThreadStacks(size_t max_frames, std::vector<ThreadStack>* stacks) override;
+    long GetEventStackOffsets(size_t max_frames, std::vector<uint64_t>* offsets) override;
+    long GetExceptionAddress(uint64_t* address) override;
+    long GetRegisters(std::vector<RegisterInfo>* registers) override;
+    long GetModules(std::vector<ModuleInfo>* modules) override;
+    long LoadSymbols(const std::string& module) override;
+    long GetThreads(std::vector<ThreadInfo>* threads) override;
+    long Evaluate(const std::string& expression, uint64_t* value) override;
+    long GetMemoryRegions(std::vector<MemoryRegionInfo>* regions) override;
+    long GetSymbol(uint64_t address, std::string* name, uint64_t* displacement) override;
+    long ReadMemory(uint64_t address, void* buffer, size_t size, size_t* bytes_read) override;
+
+  private:
+    IDebugClient* client_;
+    IDebugControl* control_;
+    bool owns_client_ = false;
+    std::unique_ptr<DmlOutput> dml_;
+};
+
+} // namespace windbg_agent
@@ -0,0 +1,554 @@
+#include "debug_query.hpp"
+#include "address_index.hpp"
+#include "memory_scan.hpp"
+#include "stack_dedup.hpp"
+#include "windbg_client.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace windbg_agent
+{
+
+using Json = nlohmann::json;
+
+namespace
+{
+
+std::string Hex(uint64_t value)
+{
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(value));
+    return buf;
+}
+
+std::string Failure(const std::string& error, long status)
+{
+    Json json = {{"error", error}, {"hresult", FormatHResult(status)}, {"success", false}};
+    return json.dump(-1, ' ', false, Json::error_handler_t::replace);
+}
+
+std::string Success(Json json)
+{
+    json["success"] = true;
+    return json.dump(-1, ' ', false, Json::error_handler_t::replace);
+}
+
+// Region attributes in the terms !address uses
+const char* RegionStateName(uint32_t state)
+{
+    switch (state)
+    {
+    case 0x1000:
+        return "commit";
+    case 0x2000:
+        return "reserve";
+    case 0x10000:
+        return "free";
+    default:
+        return "unknown";
+    }
+}
+
+const char* RegionTypeName(uint32_t type)
+{
+    switch (type)
+    {
+    case 0x1000000:
+        return "image";
+    case 0x40000:
+        return "mapped";
+    case 0x20000:
+        return "private";
+    default:
+        return "unknown";
+    }
+}
+
+// PAGE_* protection as "rwx" flags, with "+guard" / "+nocache" modifiers
+std::string RegionProtectName(uint32_t protect)
+{
+    std::string name;
+    switch (protect & 0xFF)
+    {
+    case 0x01:
+        name = "---";
+        break;
+    case 0x02:
+        name = "r--";
+        break;
+    case 0x04:
+        name = "rw-";
+        break;
+    case 0x08:
+        name = "rw-(cow)";
+        break;
+    case 0x10:
+        name = "--x";
+        break;
+    case 0x20:
+        name = "r-x";
+        break;
+    case 0x40:
+        name = "rwx";
+        break;
+    case 0x80:
+        name = "rwx(cow)";
+        break;
+    default:
+        return protect ? Hex(protect) : "";
+    }
+    if (protect & 0x100)
+        name += "+guard";
+    if (protect & 0x200)
+        name += "+nocache";
+    return name;
+}
+
+} // namespace
+
+std::string EncodeHex(const std::string& data)
+{
+    static const char kDigits[] = "0123456789abcdef";
+    std::string text(data.size() * 2, '0');
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        auto byte = static_cast<unsigned char>(data[i]);
+        text[2 * i] = kDigits[byte >> 4];
+        text[2 * i + 1] = kDigits[byte & 0xF];
+    }
+    return text;
+}
+
+std::string EncodeBase64(const std::string& data)
+{
+    static const char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    text.reserve((data.size() + 2) / 3 * 4);
+
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3)
+    {
+        uint32_t group = static_cast<unsigned char>(data[i]) << 16 |
+                         static_cast<unsigned char>(data[i + 1]) << 8 |
+                         static_cast<unsigned char>(data[i + 2]);
+        text += kAlphabet[group >> 18];
+        text += kAlphabet[(group >> 12) & 0x3F];
+        text += kAlphabet[(group >> 6) & 0x3F];
+        text += kAlphabet[group & 0x3F];
+    }
+    if (i < data.size())
+    {
+        uint32_t group = static_cast<unsigned char>(data[i]) << 16;
+        if (i + 1 < data.size())
+            group |= static_cast<unsigned char>(data[i + 1]) << 8;
+        text += kAlphabet[group >> 18];
+        text += kAlphabet[(group >> 12) & 0x3F];
+        text += i + 1 < data.size() ? kAlphabet[(group >> 6) & 0x3F] : '=';
+        text += '=';
+    }
+    return text;
+}
+
+bool ParseMemoryRanges(const Json& args, std::vector<MemoryRangeRequest>* ranges,
+                       std::string* error)
+{
+    ranges->clear();
+
+    // Either {"ranges": [{"address", "size"}, ...]} or a single {"address", "size"}
+    Json single = Json::array({args});
+    const Json& items = args.contains("ranges") ? args["ranges"] : single;
+    if (!items.is_array() || items.empty() || items.size() > kMaxMemoryRanges)
+    {
+        *error = "ranges must be a non-empty array of up to " +
+                 std::to_string(kMaxMemoryRanges) + " {address, size} objects";
+        return false;
+    }
+
+    size_t total = 0;
+    for (const auto& item : items)
+    {
+        if (!item.is_object())
+        {
+            *error = "each range must be an {address, size} object";
+            return false;
+        }
+        QueryRequest parsed = QueryRequestFromJson("memory", item);
+        if (parsed.address.empty() || parsed.size == 0 || parsed.size > kMaxMemoryRangeBytes)
+        {
+            *error = "each range needs an address and a size of 1.." +
+                     std::to_string(kMaxMemoryRangeBytes) + " bytes";
+            return false;
+        }
+        total += parsed.size;
+        if (total > kMaxMemoryBatchBytes)
+        {
+            *error = "ranges exceed " + std::to_string(kMaxMemoryBatchBytes) + " bytes in total";
+            return false;
+        }
+        ranges->push_back({parsed.address, parsed.size});
+    }
+    return true;
+}
+
+Json MemoryResultsJson(const std::vector<MemoryRangeResult>& results, const std::string& encoding)
+{
+    bool hex = encoding == "hex";
+    Json list = Json::array();
+    for (const auto& result : results)
+    {
+        Json entry = {{"address", Hex(result.address)},
+                      {"size", result.data.size()},
+                      {"data", hex ? EncodeHex(result.data) : EncodeBase64(result.data)},
+                      {"hresult", FormatHResult(result.status)},
+                      {"success", result.succeeded()}};
+        if (!result.error.empty())
+            entry["error"] = result.error;
+        list.push_back(std::move(entry));
+    }
+    return {{"ranges", std::move(list)}, {"encoding", hex ? "hex" : "base64"}, {"success", true}};
+}
+
+bool ParseSymbolizeRequest(const Json& args, SymbolizeRequest* request, std::string* error)
+{
+    request->addresses.clear();
+    request->symbols = args.value("symbols", true);
+
+    auto items = args.find("addresses");
+    if (items == args.end() || !items->is_array() || items->empty() ||
+        items->size() > kMaxSymbolizeAddresses)
+    {
+        *error = "addresses must be a non-empty array of up to " +
+                 std::to_string(kMaxSymbolizeAddresses) + " numbers or expressions";
+        return false;
+    }
+
+    request->addresses.reserve(items->size());
+    for (const auto& item : *items)
+    {
+        if (item.is_string() && !item.get_ref<const std::string&>().empty())
+            request->addresses.push_back(item.get<std::string>());
+        else if (item.is_number_unsigned() ||
+                 (item.is_number_integer() && item.get<int64_t>() >= 0))
+            request->addresses.push_back(Hex(item.get<uint64_t>()));
+        else
+        {
+            *error = "each address must be a non-negative number or an expression string";
+            return false;
+        }
+    }
+    return true;
+}
+
+Json SymbolizeResultsJson(const std::vector<SymbolizeResult>& results)
+{
+    Json list = Json::array();
+    for (const auto& result : results)
+    {
+        Json entry = {{"address", Hex(result.address)}};
+        if (!result.error.empty())
+        {
+            entry["error"] = result.error;
+            list.push_back(std::move(entry));
+            continue;
+        }
+        if (!result.module.empty())
+        {
+            entry["module"] = result.module;
+            entry["offset"] = Hex(result.address - result.module_base);
+        }
+        if (!result.symbol.empty())
+        {
+            entry["symbol"] = result.displacement
+                                  ? result.symbol + "+" + Hex(result.displacement)
+                                  : result.symbol;
+        }
+        if (result.region_size)
+        {
+            Json region = {{"base", Hex(result.region_base)},
+                           {"size", Hex(result.region_size)},
+                           {"state", RegionStateName(result.region_state)}};
+            std::string protect = RegionProtectName(result.region_protect);
+            if (!protect.empty())
+                region["protect"] = protect;
+            if (result.region_type)
+                region["type"] = RegionTypeName(result.region_type);
+            entry["region"] = std::move(region);
+        }
+        list.push_back(std::move(entry));
+    }
+    return {{"results", std::move(list)}, {"success", true}};
+}
+
+bool ParseScanRequest(const Json& args, MemoryScanRequest* request, std::string* error)
+{
+    static const char* const kKinds[] = {"bytes", "ascii", "utf16", "word", "dword", "qword"};
+
+    *request = MemoryScanRequest();
+
+    // {"patterns": [...]} or a single pattern given inline
+    Json single = Json::array({args});
+    const Json& items = args.contains("patterns") ? args["patterns"] : single;
+    if (!items.is_array() || items.empty() || items.size() > kMaxScanPatterns)
+    {
+        *error = "patterns must be a non-empty array of up to " +
+                 std::to_string(kMaxScanPatterns) + " pattern objects";
+        return false;
+    }
+
+    for (const auto& item : items)
+    {
+        const char* kind = nullptr;
+        for (const char* candidate : kKinds)
+        {
+            if (item.is_object() && item.contains(candidate))
+                kind = candidate;
+        }
+        if (!kind)
+        {
+            *error = "each pattern needs one of bytes, ascii, utf16, word, dword or qword";
+            return false;
+        }
+
+        // Integers are accepted for word/dword/qword as well as strings
+        const Json& value = item[kind];
+        std::string text;
+        if (value.is_string())
+            text = value.get<std::string>();
+        else if (value.is_number_unsigned() ||
+                 (value.is_number_integer() && value.get<int64_t>() >= 0))
+            text = Hex(value.get<uint64_t>());
+        else
+        {
+            *error = std::string(kind) + " pattern must be a string";
+            return false;
+        }
+
+        ScanPattern pattern;
+        if (!ParseScanPattern(kind, text, &pattern, error))
+            return false;
+        request->patterns.push_back(std::move(pattern));
+    }
+
+    QueryRequest range = QueryRequestFromJson("memory", args);
+    request->address = range.address;
+    request->size = range.size;
+    auto max_hits = args.find("max_hits");
+    if (max_hits != args.end() && max_hits->is_number_integer() &&
+        (max_hits->is_number_unsigned() || max_hits->get<int64_t>() > 0))
+        request->max_hits = std::min<size_t>(max_hits->get<uint64_t>(), kMaxScanHits);
+    return true;
+}
+
+Json ScanHitsJson(const std::vector<ScanHit>& hits)
+{
+    Json list = Json::array();
+    for (const auto& hit : hits)
+        list.push_back({{"address", Hex(hit.address)}, {"pattern", hit.pattern}});
+    return list;
+}
+
+Json ScanResultJson(const MemoryScanResult& result)
+{
+    Json json = {{"bytes_scanned", result.bytes_scanned},
+                 {"regions", result.regions},
+                 {"hits", result.hits},
+                 {"truncated", result.truncated},
+                 {"elapsed_ms", result.elapsed_ms},
+                 {"isa", result.isa},
+                 {"success", result.succeeded()}};
+    if (!result.succeeded())
+    {
+        json["error"] = result.error;
+        json["hresult"] = FormatHResult(result.status);
+    }
+    return json;
+}
+
+bool IsQueryKind(const std::string& kind)
+{
+    return kind == "stack" || kind == "registers" || kind == "modules" || kind == "threads" ||
+           kind == "memory" || kind == "unique_stacks";
+}
+
+QueryRequest QueryRequestFromJson(const std::string& kind, const Json& args)
+{
+    // Numbers may arrive signed (from a Json literal) or unsigned (parsed); negatives are
+    // ignored so size/max_frames fall back to their defaults
+    auto count = [&args](const char* key) -> uint64_t
+    {
+        auto it = args.find(key);
+        if (it == args.end() || !it->is_number_integer())
+            return 0;
+        return it->is_number_unsigned() || it->get<int64_t>() >= 0 ? it->get<uint64_t>() : 0;
+    };
+
+    QueryRequest request;
+    request.kind = kind;
+    auto address = args.find("address");
+    if (address != args.end() && address->is_string())
+        request.address = address->get<std::string>();
+    else if (address != args.end() && address->is_number_integer())
+        request.address = Hex(address->get<uint64_t>());
+    request.size = static_cast<size_t>(count("size"));
+    request.max_frames = static_cast<size_t>(count("max_frames"));
+    return request;
+}
+
+std::string RunQuery(WinDbgClient& client, const QueryRequest& request)
+{
+    auto& backend = client.backend();
+
+    if (request.kind == "stack")
+    {
+        size_t max_frames = request.max_frames ? request.max_frames : kDefaultStackFrames;
+        std::vector<StackFrameInfo> frames;
+        long status = backend.GetStack(std::min(max_frames, kMaxStackFrames), &frames);
+        if (!StatusSucceeded(status))
+            return Failure("stack unavailable", status);
+
+        Json list = Json::array();
+        for (const auto& frame : frames)
+        {
+            Json entry = {{"n", frame.number},
+                          {"ip", Hex(frame.instruction)},
+                          {"ret", Hex(frame.return_address)},
+                          {"sp", Hex(frame.stack_pointer)},
+                          {"fp", Hex(frame.frame_pointer)}};
+            if (!frame.symbol.empty())
+            {
+                entry["symbol"] = frame.displacement
+                                      ? frame.symbol + "+" + Hex(frame.displacement)
+                                      : frame.symbol;
+            }
+            list.push_back(std::move(entry));
+        }
+        return Success({{"frames", std::move(list)}});
+    }
+
+    if (request.kind == "registers")
+    {
+        std::vector<RegisterInfo> registers;
+        long status = backend.GetRegisters(&registers);
+        if (!StatusSucceeded(status))
+            return Failure("registers unavailable", status);
+
+        Json values = Json::object();
+        for (const auto& reg : registers)
+            values[reg.name] = Hex(reg.value);
+        return Success({{"registers", std::move(values)}});
+    }
+
+    if (request.kind == "modules")
+    {
+        std::vector<ModuleInfo> modules;
+        long status = backend.GetModules(&modules);
+        if (!StatusSucceeded(status))
+            return Failure("modules unavailable", status);
+
+        Json list = Json::array();
+        for (const auto& module : modules)
+        {
+            list.push_back({{"name", module.name},
+                            {"base", Hex(module.base)},
+                            {"size", Hex(module.size)},
+                            {"image", module.image},
+                            {"timestamp", module.timestamp},
+                            {"symbols", module.symbols}});
+        }
+        return Success({{"modules", std::move(list)}});
+    }
+
+    if (request.kind == "threads")
+    {
+        std::vector<ThreadInfo> threads;
+        long status = backend.GetThreads(&threads);
+        if (!StatusSucceeded(status))
+            return Failure("threads unavailable", status);
+
+        Json list = Json::array();
+        for (const auto& thread : threads)
+        {
+            Json entry = {{"id", thread.id}, {"tid", Hex(thread.system_id)}};
+            if (thread.current)
+                entry["current"] = true;
+            list.push_back(std::move(entry));
+        }
+        return Success({{"threads", std::move(list)}});
+    }
+
+    if (request.kind == "unique_stacks")
+    {
+        size_t max_frames = request.max_frames ? request.max_frames : kDefaultStackFrames;
+        std::vector<ThreadStack> stacks;
+        long status = backend.GetThreadStacks(std::min(max_frames, kMaxStackFrames), &stacks);
+        if (!StatusSucceeded(status))
+            return Failure("thread stacks unavailable", status);
+
+        std::vector<StackGroup> groups = GroupStacks(stacks);
+
+        // Symbolize each distinct frame once, through the address index
+        std::vector<uint64_t> addresses;
+        for (const auto& group : groups)
+            addresses.insert(addresses.end(), group.frames.begin(), group.frames.end());
+        std::sort(addresses.begin(), addresses.end());
+        addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+        std::vector<SymbolizeResult> symbols = GetAddressIndex().Resolve(backend, addresses, true);
+
+        auto frame_name = [&](uint64_t address) -> std::string
+        {
+            auto it = std::lower_bound(addresses.begin(), addresses.end(), address);
+            const SymbolizeResult& symbol = symbols[it - addresses.begin()];
+            if (!symbol.symbol.empty())
+                return symbol.displacement ? symbol.symbol + "+" + Hex(symbol.displacement)
+                                           : symbol.symbol;
+            if (!symbol.module.empty())
+                return symbol.module + "+" + Hex(address - symbol.module_base);
+            return Hex(address);
+        };
+
+        Json list = Json::array();
+        for (const auto& group : groups)
+        {
+            Json ids = Json::array();
+            for (size_t t = 0; t < group.threads.size() && t < kMaxThreadsPerGroup; t++)
+                ids.push_back(stacks[group.threads[t]].id);
+            Json frames = Json::array();
+            for (uint64_t frame : group.frames)
+                frames.push_back(frame_name(frame));
+            list.push_back({{"count", group.threads.size()},
+                            {"threads", std::move(ids)},
+                            {"frames", std::move(frames)}});
+        }
+        return Success(
+            {{"threads", stacks.size()}, {"unique", groups.size()}, {"groups", std::move(list)}});
+    }
+
+    if (request.kind == "memory")
+    {
+        if (request.address.empty())
+            return Failure("missing address", kStatusFail);
+        if (request.size == 0 || request.size > kMaxQueryMemory)
+            return Failure("size must be 1.." + std::to_string(kMaxQueryMemory), kStatusFail);
+
+        MemoryRangeRequest range;
+        range.address = request.address;
+        range.size = request.size;
+        MemoryRangeResult read = std::move(client.ReadMemory({range})[0]);
+        if (!read.error.empty())
+            return Failure(read.error, read.status);
+        if (read.data.empty() && !read.succeeded())
+            return Failure("memory not readable at " + Hex(read.address), read.status);
+
+        return Success({{"address", Hex(read.address)},
+                        {"size", read.data.size()},
+                        {"hex", EncodeHex(read.data)}});
+    }
+
+    return Failure("unknown query: " + request.kind +
+                       " (expected stack, registers, modules, threads, memory or unique_stacks)",
+                   kStatusFail);
+}
+
+} // namespace windbg_agent
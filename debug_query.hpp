@@ -0,0 +1,66 @@
+#pragma once
+
+#include "command_types.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+class WinDbgClient;
+
+constexpr size_t kDefaultStackFrames = 64;
+constexpr size_t kMaxStackFrames = 1024;
+constexpr size_t kMaxThreadsPerGroup = 64; // unique_stacks: thread ids listed per group
+constexpr size_t kMaxQueryMemory = 64 * 1024;
+
+// True for the query kinds RunQuery answers: stack, registers, modules, threads, memory,
+// unique_stacks
+bool IsQueryKind(const std::string& kind);
+
+// Build a request from tool/endpoint arguments: "address" (number or expression string),
+// "size", "max_frames"
+QueryRequest QueryRequestFromJson(const std::string& kind, const nlohmann::json& args);
+
+// Byte encodings for JSON transports
+std::string EncodeHex(const std::string& data);
+std::string EncodeBase64(const std::string& data);
+
+// Parse {"ranges": [{"address", "size"}, ...]} (or a single {"address", "size"}) for a
+// binary memory read, enforcing the kMaxMemory* limits; false with *error on bad input
+bool ParseMemoryRanges(const nlohmann::json& args, std::vector<MemoryRangeRequest>* ranges,
+                       std::string* error);
+
+// JSON for memory read results: {"ranges": [{"address", "size", "data", "hresult",
+// "success"}], "encoding", "success"}; encoding is "base64" (default) or "hex"
+nlohmann::json MemoryResultsJson(const std::vector<MemoryRangeResult>& results,
+                                 const std::string& encoding);
+
+// Parse {"addresses": [...], "symbols": bool} for /symbolize; addresses may be numbers or
+// expression strings. False with *error on bad input.
+bool ParseSymbolizeRequest(const nlohmann::json& args, SymbolizeRequest* request,
+                           std::string* error);
+
+// JSON for symbolize results: {"results": [{"address", "module", "offset", "symbol",
+// "region": {"base", "size", "state", "protect", "type"}}], "success"}; fields that do not
+// apply are left out
+nlohmann::json SymbolizeResultsJson(const std::vector<SymbolizeResult>& results);
+
+// Parse a memory search: {"patterns": [{"bytes": "48 8b ?? 24"}, {"ascii": "..."}, ...],
+// "address", "size", "max_hits"}; each pattern object has one kind (see ParseScanPattern).
+// A single pattern may also be given inline ({"ascii": "password"}). False with *error.
+bool ParseScanRequest(const nlohmann::json& args, MemoryScanRequest* request, std::string* error);
+
+// [{"address", "pattern"}, ...] for a batch of hits
+nlohmann::json ScanHitsJson(const std::vector<ScanHit>& hits);
+
+// Summary of a finished scan: {"bytes_scanned", "regions", "hits", "truncated",
+// "elapsed_ms", "isa", "success"} (plus "error" and "hresult" on failure)
+nlohmann::json ScanResultJson(const MemoryScanResult& result);
+
+// Answer a structured query from engine state (no command output to parse). Returns
+// compact JSON with "success"; addresses are hex strings so 64-bit values survive.
+std::string RunQuery(WinDbgClient& client, const QueryRequest& request);
+
+} // namespace windbg_agent
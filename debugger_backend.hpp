@@ -0,0 +1,191 @@
+#pragma once
+
+#include "command_types.hpp"
+#include "output_sink.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Status codes shared by all backends (same values as the matching HRESULTs, which are
+// 32-bit signed even where long is 64-bit)
+constexpr long ToStatus(uint32_t hresult)
+{
+    return static_cast<int32_t>(hresult);
+}
+constexpr long kStatusOk = 0;                              // S_OK
+constexpr long kStatusFail = ToStatus(0x80004005u);        // E_FAIL
+constexpr long kStatusNotFound = ToStatus(0x80070490u);    // HRESULT_FROM_WIN32(ERROR_NOT_FOUND)
+constexpr long kStatusPartialCopy = ToStatus(0x8007012Bu); // HRESULT_FROM_WIN32(ERROR_PARTIAL_COPY)
+constexpr long kStatusNotImpl = ToStatus(0x80004001u);     // E_NOTIMPL
+constexpr long kStatusOutputLost = ToStatus(0x8007001Du);  // HRESULT_FROM_WIN32(ERROR_WRITE_FAULT)
+
+inline bool StatusSucceeded(long status)
+{
+    return status >= 0;
+}
+
+// How a message shown to the user should be styled
+enum class DisplayStyle
+{
+    Raw,           // Plain text, no newline appended
+    Error,
+    Warning,
+    Command,       // Command being run
+    CommandResult, // Command output
+    Thinking,      // Agent status
+    Response       // Agent response
+};
+
+// Engine state returned by structured queries (see IDebuggerBackend::GetStack, ...)
+struct StackFrameInfo
+{
+    uint32_t number = 0;
+    uint64_t instruction = 0;
+    uint64_t return_address = 0;
+    uint64_t frame_pointer = 0;
+    uint64_t stack_pointer = 0;
+    std::string symbol; // module!function, empty if unknown
+    uint64_t displacement = 0;
+};
+
+struct RegisterInfo
+{
+    std::string name;
+    uint64_t value = 0;
+};
+
+struct ModuleInfo
+{
+    std::string name;
+    std::string image;
+    uint64_t base = 0;
+    uint32_t size = 0;
+    uint32_t timestamp = 0;
+    uint32_t checksum = 0;
+    std::string symbols; // Symbol state: "pdb", "export", "deferred", "none", ...
+};
+
+struct ThreadInfo
+{
+    uint32_t id = 0;        // Engine thread id (as in ~)
+    uint32_t system_id = 0; // OS thread id
+    bool current = false;
+};
+
+// Call stack of one thread: instruction offsets, innermost frame first
+struct ThreadStack
+{
+    uint32_t id = 0;        // Engine thread id
+    uint32_t system_id = 0; // OS thread id
+    std::vector<uint64_t> frames;
+};
+
+// A region of the target address space; state, protect and type hold the Windows MEM_* and
+// PAGE_* values (as in MEMORY_BASIC_INFORMATION)
+struct MemoryRegionInfo
+{
+    uint64_t base = 0;
+    uint64_t size = 0;
+    uint32_t state = 0;
+    uint32_t protect = 0;
+    uint32_t type = 0;
+};
+
+// The debugger engine underneath WinDbgClient. The dbgeng backend drives a live WinDbg/CDB
+// session; other backends (e.g. replay) let the client, caches and servers run without one.
+class IDebuggerBackend
+{
+  public:
+    virtual ~IDebuggerBackend() = default;
+
+    // False if the backend has no engine to talk to
+    virtual bool IsAvailable() const = 0;
+
+    // Run a command, capturing its output into *output; echo mirrors it to the console.
+    // kStatusOutputLost means the command ran but its output could not be kept.
+    virtual long Execute(const std::string& command, bool echo, OutputView* output) = 0;
+
+    // Run a command, forwarding output chunks as they arrive instead of capturing them
+    virtual long ExecuteStreaming(const std::string& command, bool echo,
+                                  const OutputChunkHandler& on_chunk) = 0;
+
+    // Show a message to the user
+    virtual void Display(DisplayStyle style, const std::string& text) = 0;
+    virtual bool SupportsColor() const = 0;
+
+    // Target information
+    virtual std::string GetTargetName() const = 0;
+    virtual std::string GetTargetArchitecture() const = 0;
+    virtual std::string GetDebuggerType() const = 0;
+    virtual std::string GetTargetState() const = 0;
+    virtual uint32_t GetProcessId() const = 0;
+
+    // Engine context a read-only command's output depends on (target, process, thread,
+    // frame, ...), used to key cached results
+    virtual std::string GetContextKey() const = 0;
+
+    // True if the user requested an interrupt (e.g., Ctrl+C)
+    virtual bool IsInterrupted() const = 0;
+
+    // Structured queries that read engine state directly instead of parsing command output.
+    // Backends without engine access keep these defaults and return kStatusNotImpl.
+    virtual long GetStack(size_t /*max_frames*/, std::vector<StackFrameInfo>* /*frames*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Integer registers of the current thread (sub-registers such as eax are left out)
+    virtual long GetRegisters(std::vector<RegisterInfo>* /*registers*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Stacks of every thread in the current process. The current thread and scope (frame
+    // and register context, including one set by .ecxr or .cxr) are left unchanged.
+    virtual long GetThreadStacks(size_t /*max_frames*/, std::vector<ThreadStack>* /*stacks*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Instruction offsets of the stack of the thread that raised the last event, innermost
+    // first, whichever thread is current; kStatusNotFound if that stack cannot be walked
+    // without switching threads. Unlike GetStack this looks up no symbols, so it never has
+    // to load them.
+    virtual long GetEventStackOffsets(size_t /*max_frames*/, std::vector<uint64_t>* /*offsets*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Faulting address of the last event; kStatusNotFound if that was not an exception
+    virtual long GetExceptionAddress(uint64_t* /*address*/) { return kStatusNotImpl; }
+    virtual long GetModules(std::vector<ModuleInfo>* /*modules*/) { return kStatusNotImpl; }
+    // Load the symbols of a module (by module name, as in lm) now instead of on first use;
+    // kStatusNotFound if the module still has no symbols afterwards
+    virtual long LoadSymbols(const std::string& /*module*/) { return kStatusNotImpl; }
+    virtual long GetThreads(std::vector<ThreadInfo>* /*threads*/) { return kStatusNotImpl; }
+    // Evaluate an address expression ("0x1000", "@rsp", "ntdll!LdrpInitialize+0x10")
+    virtual long Evaluate(const std::string& /*expression*/, uint64_t* /*value*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Allocated regions of the target address space (free regions are left out)
+    virtual long GetMemoryRegions(std::vector<MemoryRegionInfo>* /*regions*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Nearest symbol at or below address ("module!function") and the offset from it
+    virtual long GetSymbol(uint64_t /*address*/, std::string* /*name*/,
+                           uint64_t* /*displacement*/)
+    {
+        return kStatusNotImpl;
+    }
+    // Read target virtual memory into buffer; *bytes_read receives the length of the
+    // readable prefix (a read that hits unreadable memory fails but may be partial)
+    virtual long ReadMemory(uint64_t /*address*/, void* /*buffer*/, size_t /*size*/,
+                            size_t* bytes_read)
+    {
+        *bytes_read = 0;
+        return kStatusNotImpl;
+    }
+};
+
+} // namespace windbg_agent
@@ -0,0 +1,124 @@
+#include "event_bus.hpp"
+
+#include <algorithm>
+
+namespace windbg_agent
+{
+
+const char* AgentEventTypeName(AgentEventType type)
+{
+    switch (type)
+    {
+    case AgentEventType::QueryStarted:
+        return "query_started";
+    case AgentEventType::ContentDelta:
+        return "delta";
+    case AgentEventType::ToolStarted:
+        return "tool_started";
+    case AgentEventType::ToolFinished:
+        return "tool_finished";
+    case AgentEventType::ContentComplete:
+        return "complete";
+    case AgentEventType::Error:
+        return "error";
+    }
+    return "unknown";
+}
+
+EventBus& GetEventBus()
+{
+    static EventBus bus;
+    return bus;
+}
+
+EventBus::SubscriptionId EventBus::Subscribe(size_t queue_limit)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Subscriber subscriber;
+    subscriber.id = next_id_++;
+    subscriber.limit = std::max<size_t>(queue_limit, 1);
+    subscribers_.push_back(std::move(subscriber));
+    return subscribers_.back().id;
+}
+
+void EventBus::Unsubscribe(SubscriptionId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                          [id](const Subscriber& s) { return s.id == id; }),
+                           subscribers_.end());
+    }
+    cv_.notify_all();
+}
+
+bool EventBus::HasSubscribers() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !subscribers_.empty();
+}
+
+uint64_t EventBus::Publish(AgentEvent event)
+{
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seq = ++seq_;
+        event.seq = seq;
+        for (auto& subscriber : subscribers_)
+        {
+            if (subscriber.queue.size() >= subscriber.limit)
+            {
+                subscriber.queue.pop_front();
+                subscriber.dropped++;
+            }
+            subscriber.queue.push_back(event);
+        }
+    }
+    cv_.notify_all();
+    return seq;
+}
+
+uint64_t EventBus::last_seq() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seq_;
+}
+
+bool EventBus::Poll(SubscriptionId id, std::chrono::milliseconds timeout,
+                    std::vector<AgentEvent>* events, uint64_t* dropped)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, timeout,
+                 [&]()
+                 {
+                     Subscriber* subscriber = Find(id);
+                     return !subscriber || !subscriber->queue.empty();
+                 });
+
+    Subscriber* subscriber = Find(id);
+    if (!subscriber)
+        return false;
+
+    events->clear();
+    events->reserve(subscriber->queue.size());
+    for (auto& event : subscriber->queue)
+        events->push_back(std::move(event));
+    subscriber->queue.clear();
+    if (dropped)
+        *dropped = subscriber->dropped;
+    subscriber->dropped = 0;
+    return true;
+}
+
+EventBus::Subscriber* EventBus::Find(SubscriptionId id)
+{
+    for (auto& subscriber : subscribers_)
+    {
+        if (subscriber.id == id)
+            return &subscriber;
+    }
+    return nullptr;
+}
+
+} // namespace windbg_agent
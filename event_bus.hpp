@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+enum class AgentEventType
+{
+    QueryStarted,    // text = query
+    ContentDelta,    // text = streamed response text
+    ToolStarted,     // tool, command
+    ToolFinished,    // tool, command, elapsed_ms, bytes
+    ContentComplete, // text = final response, elapsed_ms = whole query
+    Error            // text = message
+};
+
+const char* AgentEventTypeName(AgentEventType type);
+
+// Progress of an agent query, as published to remote observers
+struct AgentEvent
+{
+    uint64_t seq = 0; // Assigned by EventBus::Publish, increasing
+    AgentEventType type = AgentEventType::ContentDelta;
+    std::string text;
+    std::string tool;
+    std::string command;
+    double elapsed_ms = 0.0;
+    size_t bytes = 0;
+    std::string source; // Who asked: "console", "http", "mcp"
+};
+
+// Fans agent events out to any number of subscribers (HTTP SSE streams, ...).
+// Publish never blocks: each subscriber has a bounded queue, and one that falls behind
+// loses its oldest events (counted, so it can tell the client).
+class EventBus
+{
+  public:
+    using SubscriptionId = uint64_t;
+
+    static constexpr size_t kDefaultQueueLimit = 4096;
+
+    SubscriptionId Subscribe(size_t queue_limit = kDefaultQueueLimit);
+    void Unsubscribe(SubscriptionId id);
+
+    // Cheap check so publishers can skip building events nobody receives
+    bool HasSubscribers() const;
+
+    // Assign the next sequence number and deliver to every subscriber; returns the seq
+    uint64_t Publish(AgentEvent event);
+
+    // Sequence number of the most recent event (0 if none)
+    uint64_t last_seq() const;
+
+    // Wait up to timeout for events, then move all queued ones into *events.
+    // *dropped receives the number lost to overflow since the last poll.
+    // Returns false if the subscription does not exist (or was removed while waiting).
+    bool Poll(SubscriptionId id, std::chrono::milliseconds timeout,
+              std::vector<AgentEvent>* events, uint64_t* dropped);
+
+  private:
+    struct Subscriber
+    {
+        SubscriptionId id = 0;
+        size_t limit = kDefaultQueueLimit;
+        std::deque<AgentEvent> queue;
+        uint64_t dropped = 0;
+    };
+
+    Subscriber* Find(SubscriptionId id); // mutex_ held
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Subscriber> subscribers_;
+    SubscriptionId next_id_ = 1;
+    uint64_t seq_ = 0;
+};
+
+// Global bus for agent events in this debugger session
+EventBus& GetEventBus();
+
+} // namespace windbg_agent
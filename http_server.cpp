@@ -1,4 +1,7 @@
 #include "http_server.hpp"
+#include "debug_query.hpp"
+#include "event_bus.hpp"
+#include "output_ring.hpp"
 
 #include <httplib.h>
 #include <nlohmann/json.hpp>
@@ -6,13 +9,266 @@
 #include <WinSock2.h>
 #include <WS2tcpip.h>
 #include <Windows.h>
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <memory>
 #include <sstream>
 
 #pragma comment(lib, "ws2_32.lib")
 
 namespace windbg_agent {
 
+namespace {
+
+// Upper bound on output buffered between the debugger thread and a slow streaming client.
+// When reached, the debugger thread waits for the client to catch up.
+constexpr size_t kMaxStreamBufferBytes = 4 * 1024 * 1024;
+
+// Interval for SSE keep-alive comments while a command produces no output
+constexpr auto kStreamKeepAlive = std::chrono::seconds(15);
+
+// Text handed from the main thread (producer) to an SSE response (consumer). A helper
+// thread waits for the main-thread slot and records the outcome in result.
+template <typename Result>
+struct SseStream {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::string> pending;
+    size_t buffered_bytes = 0;
+    size_t total_bytes = 0;
+    bool done = false;
+    bool client_gone = false;
+    QueueResult queue_result{false, ""};
+    Result result;
+    std::thread worker;
+
+    // Called on the main thread; blocks while the client is too far behind. False once the
+    // client has gone or the server is stopping.
+    bool push(std::string text, const std::atomic<bool>& running) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() {
+            return buffered_bytes < kMaxStreamBufferBytes || client_gone || !running.load();
+        });
+        if (client_gone || !running.load()) {
+            return false;
+        }
+        buffered_bytes += text.size();
+        total_bytes += text.size();
+        pending.push_back(std::move(text));
+        lock.unlock();
+        cv.notify_all();
+        return true;
+    }
+
+    void finish(const QueueResult& queue, Result outcome) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue_result = queue;
+            result = std::move(outcome);
+            done = true;
+        }
+        cv.notify_all();
+    }
+};
+
+std::string sse_frame(const char* event, const nlohmann::json& data) {
+    return std::string("event: ") + event + "\ndata: " +
+           data.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n\n";
+}
+
+// Serve a stream as SSE: everything pushed since the last write goes out as frame(text),
+// keep-alive comments fill silences, and done_status(stream) becomes the final "done" frame.
+// A disconnect releases a blocked producer; the worker is joined when the response ends.
+template <typename Result, typename Frame, typename DoneStatus>
+void serve_sse_stream(httplib::Response& res, std::shared_ptr<SseStream<Result>> stream,
+                      Frame frame, DoneStatus done_status) {
+    res.set_chunked_content_provider(
+        "text/event-stream",
+        [stream, frame, done_status](size_t /*offset*/, httplib::DataSink& sink) {
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            if (!stream->cv.wait_for(lock, kStreamKeepAlive, [&]() {
+                    return !stream->pending.empty() || stream->done;
+                })) {
+                lock.unlock();
+                static const char kKeepAlive[] = ": keep-alive\n\n";
+                return sink.write(kKeepAlive, sizeof(kKeepAlive) - 1);
+            }
+
+            // Coalesce everything buffered so far
+            std::string text;
+            text.reserve(stream->buffered_bytes);
+            for (const auto& item : stream->pending) {
+                text += item;
+            }
+            stream->pending.clear();
+            stream->buffered_bytes = 0;
+            bool done = stream->done;
+            lock.unlock();
+            stream->cv.notify_all();
+
+            if (!text.empty()) {
+                std::string framed = frame(std::move(text));
+                if (!sink.write(framed.data(), framed.size())) {
+                    return false;
+                }
+            }
+
+            if (done) {
+                std::string framed = sse_frame("done", done_status(*stream));
+                sink.write(framed.data(), framed.size());
+                sink.done();
+            }
+            return true;
+        },
+        [stream](bool /*success*/) {
+            {
+                std::lock_guard<std::mutex> lock(stream->mutex);
+                stream->client_gone = true;
+            }
+            stream->cv.notify_all();
+            if (stream->worker.joinable()) {
+                stream->worker.join();
+            }
+        });
+}
+
+std::string dump_json(const nlohmann::json& value) {
+    return value.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+// 503 when the command never reached the main thread, 500 when its handler failed
+int failure_status(const QueueResult& result) {
+    return result.ran ? 500 : 503;
+}
+
+// How often agent event streams check for completion and server shutdown
+constexpr auto kEventPollInterval = std::chrono::milliseconds(250);
+
+// How often /output checks the output ring when it has nothing to send
+constexpr auto kOutputPollInterval = std::chrono::milliseconds(100);
+
+// Ring slots coalesced into one /output frame (about 240 KB)
+constexpr size_t kMaxOutputFrameSlots = 512;
+
+// Agent query streamed over /ask_stream
+struct AskStream {
+    EventBus::SubscriptionId subscription = 0;
+    // Window of bus sequence numbers published while this query held the main thread
+    std::atomic<uint64_t> first_seq{0};
+    std::atomic<uint64_t> last_seq{0};
+    std::atomic<bool> done{false};
+    QueueResult result{false, ""};
+    std::chrono::steady_clock::time_point last_write = std::chrono::steady_clock::now();
+    std::thread worker;
+};
+
+nlohmann::json agent_event_json(const AgentEvent& event) {
+    nlohmann::json json = {{"seq", event.seq}, {"source", event.source}};
+    switch (event.type) {
+    case AgentEventType::QueryStarted:
+        json["query"] = event.text;
+        break;
+    case AgentEventType::ContentDelta:
+        json["text"] = event.text;
+        break;
+    case AgentEventType::ToolStarted:
+        json["tool"] = event.tool;
+        json["command"] = event.command;
+        break;
+    case AgentEventType::ToolFinished:
+        json["tool"] = event.tool;
+        json["command"] = event.command;
+        json["elapsed_ms"] = event.elapsed_ms;
+        json["bytes"] = event.bytes;
+        break;
+    case AgentEventType::ContentComplete:
+        json["response"] = event.text;
+        json["elapsed_ms"] = event.elapsed_ms;
+        break;
+    case AgentEventType::Error:
+        json["error"] = event.text;
+        break;
+    }
+    return json;
+}
+
+// Write events as SSE frames; false if the client went away
+bool write_agent_events(httplib::DataSink& sink, const std::vector<AgentEvent>& events) {
+    for (const auto& event : events) {
+        std::string frame = sse_frame(AgentEventTypeName(event.type), agent_event_json(event));
+        if (!sink.write(frame.data(), frame.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Send an SSE comment when nothing was written for a while; false if the client went away
+bool write_keep_alive(httplib::DataSink& sink, std::chrono::steady_clock::time_point* last_write) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - *last_write < kStreamKeepAlive) {
+        return true;
+    }
+    *last_write = now;
+    static const char kKeepAlive[] = ": keep-alive\n\n";
+    return sink.write(kKeepAlive, sizeof(kKeepAlive) - 1);
+}
+
+// Longest a GET /jobs/{id}?wait= long-poll may block
+constexpr int kMaxJobWaitSeconds = 60;
+
+nlohmann::json batch_results_json(const std::vector<ExecResult>& results, double* total_ms) {
+    nlohmann::json results_json = nlohmann::json::array();
+    *total_ms = 0.0;
+    for (const auto& r : results) {
+        results_json.push_back({{"command", r.command},
+                                {"output", r.output},
+                                {"hresult", FormatHResult(r.status)},
+                                {"elapsed_ms", r.elapsed_ms},
+                                {"success", r.succeeded()}});
+        *total_ms += r.elapsed_ms;
+    }
+    return results_json;
+}
+
+// Job description; with_result adds the output/response/results
+nlohmann::json job_json(const JobSnapshot& job, bool with_result) {
+    nlohmann::json json = {{"id", job.id},
+                           {"type", JobKindName(job.kind)},
+                           {"state", JobStateName(job.state)},
+                           {"queued_ms", job.queued_ms},
+                           {"elapsed_ms", job.elapsed_ms},
+                           {"last_seq", job.last_seq}};
+    if (job.kind == JobKind::Exec && JobFinished(job.state)) {
+        json["hresult"] = FormatHResult(job.status);
+    }
+    if (!job.error.empty()) {
+        json["error"] = job.error;
+    }
+    if (with_result) {
+        if (job.kind == JobKind::Exec) {
+            json["output"] = job.result;
+        } else if (job.kind == JobKind::Ask) {
+            json["response"] = job.result;
+        } else {
+            double total_ms = 0.0;
+            json["results"] = batch_results_json(job.batch_results, &total_ms);
+        }
+        if (job.truncated) {
+            json["truncated"] = true;
+        }
+    }
+    json["success"] = job.state != JobState::Failed;
+    return json;
+}
+
+} // namespace
+
 class HttpServer::Impl {
 public:
     httplib::Server server;
@@ -25,39 +281,178 @@ HttpServer::~HttpServer() {
 }
 
 QueueResult HttpServer::queue_and_wait(PendingCommand::Type type, const std::string& input) {
+    PendingCommand cmd;
+    cmd.type = type;
+    cmd.input = input;
+    return enqueue_and_wait(cmd);
+}
+
+QueueResult HttpServer::queue_batch_and_wait(const std::vector<std::string>& commands,
+                                             std::vector<ExecResult>& results) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::ExecBatch;
+    cmd.batch_input = commands;
+    QueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.batch_result);
+    return result;
+}
+
+QueueResult HttpServer::queue_stream_and_wait(const std::string& command,
+                                              OutputChunkHandler on_chunk, ExecResult& result) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::ExecStream;
+    cmd.input = command;
+    cmd.on_chunk = std::move(on_chunk);
+    QueueResult queue_result = enqueue_and_wait(cmd);
+    result = std::move(cmd.stream_result);
+    return queue_result;
+}
+
+QueueResult HttpServer::queue_query_and_wait(const QueryRequest& request) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::Query;
+    cmd.query = request;
+    return enqueue_and_wait(cmd);
+}
+
+QueueResult HttpServer::queue_memory_and_wait(const std::vector<MemoryRangeRequest>& ranges,
+                                              std::vector<MemoryRangeResult>& results) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::Memory;
+    cmd.memory_input = ranges;
+    QueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.memory_result);
+    return result;
+}
+
+QueueResult HttpServer::queue_symbolize_and_wait(const SymbolizeRequest& request,
+                                                 std::vector<SymbolizeResult>& results) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::Symbolize;
+    cmd.symbolize_input = request;
+    QueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.symbolize_result);
+    return result;
+}
+
+QueueResult HttpServer::queue_scan_and_wait(const MemoryScanRequest& request,
+                                            ScanHitHandler on_hits, MemoryScanResult& result) {
+    PendingCommand cmd;
+    cmd.type = PendingCommand::Type::Scan;
+    cmd.scan_input = request;
+    cmd.on_hits = std::move(on_hits);
+    QueueResult queue_result = enqueue_and_wait(cmd);
+    result = std::move(cmd.scan_result);
+    return queue_result;
+}
+
+QueueResult HttpServer::enqueue_and_wait(PendingCommand& cmd) {
     if (!running_.load()) {
         return {false, "Error: HTTP server is not running"};
     }
 
-    PendingCommand cmd;
-    cmd.type = type;
-    cmd.input = input;
-    cmd.completed = false;
+    if (!broker_->Dispatch(source_.load(), [this, &cmd]() { execute_command(cmd); })) {
+        return {false, "Error: HTTP server stopped"};
+    }
 
-    std::mutex done_mutex;
-    std::condition_variable done_cv;
-    cmd.done_mutex = &done_mutex;
-    cmd.done_cv = &done_cv;
+    return {!cmd.failed, cmd.result, true};
+}
 
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        pending_commands_.push(&cmd);
+void HttpServer::run_job(const JobWork& work) {
+    PendingCommand cmd;
+    cmd.input = work.input;
+    if (work.kind == JobKind::Exec) {
+        // Output goes into the job's event log as it is produced
+        cmd.type = PendingCommand::Type::ExecStream;
+        std::string id = work.id;
+        cmd.on_chunk = [this, id](const char* text, size_t length) {
+            return jobs_.AppendOutput(id, text, length);
+        };
+    } else if (work.kind == JobKind::ExecBatch) {
+        cmd.type = PendingCommand::Type::ExecBatch;
+    } else {
+        // The job's own token aborts the query, not whatever query holds the main thread
+        cmd.type = PendingCommand::Type::Ask;
+        cmd.cancel = work.cancel.get();
     }
-    queue_cv_.notify_one();
 
-    {
-        std::unique_lock<std::mutex> lock(done_mutex);
-        done_cv.wait(lock, [&]() { return cmd.completed || !running_.load(); });
+    // The job is Running only once its handler holds the main thread; a job cancelled while
+    // it waited for the broker is not run at all
+    bool started = false;
+    bool dispatched = broker_->Dispatch(job_source_.load(), [this, &cmd, &work, &started]() {
+        started = jobs_.Start(work.id);
+        if (!started) {
+            return;
+        }
+        if (work.kind != JobKind::ExecBatch) {
+            execute_command(cmd);
+            return;
+        }
+        // One command at a time, so a cancelled batch stops between commands
+        std::vector<ExecResult> results;
+        for (const auto& command : work.batch) {
+            if (work.cancel->load()) {
+                break;
+            }
+            cmd.batch_input.assign(1, command);
+            execute_command(cmd);
+            if (cmd.failed) {
+                break;
+            }
+            std::move(cmd.batch_result.begin(), cmd.batch_result.end(),
+                      std::back_inserter(results));
+        }
+        cmd.batch_result = std::move(results);
+    });
+    if (!dispatched) {
+        jobs_.Finish(work.id, false, "", 0, "server stopped");
+        return;
+    }
+    if (!started) {
+        return;
     }
 
-    if (!cmd.completed) {
-        return {false, "Error: HTTP server stopped"};
+    // A failed handler's message is in cmd.result
+    if (work.kind == JobKind::Exec) {
+        jobs_.FinishExec(work.id, cmd.failed, std::move(cmd.result), cmd.stream_result);
+    } else if (work.kind == JobKind::ExecBatch) {
+        jobs_.FinishBatch(work.id, cmd.failed, std::move(cmd.result),
+                          std::move(cmd.batch_result));
+    } else {
+        jobs_.FinishAsk(work.id, cmd.failed, std::move(cmd.result));
     }
+}
 
-    return {true, cmd.result};
+void HttpServer::execute_command(PendingCommand& cmd) {
+    try {
+        if (cmd.type == PendingCommand::Type::Exec && exec_cb_) {
+            cmd.result = exec_cb_(cmd.input);
+        } else if (cmd.type == PendingCommand::Type::ExecBatch && exec_batch_cb_) {
+            cmd.batch_result = exec_batch_cb_(cmd.batch_input);
+        } else if (cmd.type == PendingCommand::Type::ExecStream && exec_stream_cb_) {
+            cmd.stream_result = exec_stream_cb_(cmd.input, cmd.on_chunk);
+        } else if (cmd.type == PendingCommand::Type::Ask && ask_cb_) {
+            cmd.result = ask_cb_(cmd.input, cmd.cancel);
+        } else if (cmd.type == PendingCommand::Type::Query && query_cb_) {
+            cmd.result = query_cb_(cmd.query);
+        } else if (cmd.type == PendingCommand::Type::Memory && memory_cb_) {
+            cmd.memory_result = memory_cb_(cmd.memory_input);
+        } else if (cmd.type == PendingCommand::Type::Symbolize && symbolize_cb_) {
+            cmd.symbolize_result = symbolize_cb_(cmd.symbolize_input);
+        } else if (cmd.type == PendingCommand::Type::Scan && scan_cb_) {
+            cmd.scan_result = scan_cb_(cmd.scan_input, cmd.on_hits);
+        } else {
+            cmd.result = "Error: No handler for command type";
+            cmd.failed = true;
+        }
+    } catch (const std::exception& e) {
+        cmd.result = std::string("Error: ") + e.what();
+        cmd.failed = true;
+    }
 }
 
-int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
+int HttpServer::start(CommandBroker& broker, ExecCallback exec_cb, AskCallback ask_cb,
+                      ExecBatchCallback exec_batch_cb, ExecStreamCallback exec_stream_cb,
                       const std::string& bind_addr) {
     if (running_.load()) {
         return port_;
@@ -65,6 +460,8 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
 
     exec_cb_ = exec_cb;
     ask_cb_ = ask_cb;
+    exec_batch_cb_ = exec_batch_cb;
+    exec_stream_cb_ = exec_stream_cb;
     bind_addr_ = bind_addr;
 
     impl_ = std::make_unique<Impl>();
@@ -90,7 +487,7 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
             auto result = queue_and_wait(PendingCommand::Type::Exec, command);
             nlohmann::json response = {{"output", result.payload}, {"success", result.success}};
             if (!result.success) {
-                res.status = 503;
+                res.status = failure_status(result);
             }
             res.set_content(response.dump(), "application/json");
         } catch (const std::exception& e) {
@@ -100,6 +497,308 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
         }
     });
 
+    impl_->server.Post("/exec_batch", [this](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            auto commands_json = json.value("commands", nlohmann::json::array());
+
+            std::vector<std::string> commands;
+            if (commands_json.is_array()) {
+                for (const auto& item : commands_json) {
+                    if (item.is_string() && !item.get<std::string>().empty()) {
+                        commands.push_back(item.get<std::string>());
+                    }
+                }
+            }
+
+            if (commands.empty() || commands.size() != commands_json.size()) {
+                res.status = 400;
+                res.set_content(R"({"error":"commands must be a non-empty array of strings","success":false})",
+                                "application/json");
+                return;
+            }
+            if (commands.size() > kMaxBatchCommands) {
+                res.status = 400;
+                nlohmann::json response = {
+                    {"error", "too many commands (max " + std::to_string(kMaxBatchCommands) + ")"},
+                    {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            std::vector<ExecResult> results;
+            auto result = queue_batch_and_wait(commands, results);
+            if (!result.success) {
+                res.status = failure_status(result);
+                nlohmann::json response = {{"error", result.payload}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            double total_ms = 0.0;
+            nlohmann::json results_json = batch_results_json(results, &total_ms);
+            nlohmann::json response = {
+                {"results", results_json}, {"elapsed_ms", total_ms}, {"success", true}};
+            res.set_content(response.dump(), "application/json");
+        } catch (const std::exception& e) {
+            res.status = 500;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+
+    // Structured queries answered from engine state instead of parsed command text
+    impl_->server.Post("/query", [this](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            std::string kind = json.value("query", "");
+            if (!IsQueryKind(kind)) {
+                res.status = 400;
+                res.set_content(
+                    R"({"error":"query must be stack, registers, modules, threads, memory or unique_stacks","success":false})",
+                    "application/json");
+                return;
+            }
+
+            auto result = queue_query_and_wait(QueryRequestFromJson(kind, json));
+            if (!result.success || result.payload.empty() || result.payload[0] != '{') {
+                res.status = failure_status(result);
+                nlohmann::json response = {{"error", result.payload}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+            res.set_content(result.payload, "application/json");
+        } catch (const std::exception& e) {
+            res.status = 500;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+
+    // Binary memory read of one range: raw bytes of the readable prefix
+    impl_->server.Get("/memory", [this](const httplib::Request& req, httplib::Response& res) {
+        MemoryRangeRequest range;
+        range.address = req.get_param_value("address");
+        range.size = std::strtoull(req.get_param_value("size").c_str(), nullptr, 0);
+        if (range.address.empty() || range.size == 0 || range.size > kMaxMemoryRangeBytes) {
+            res.status = 400;
+            nlohmann::json response = {
+                {"error", "address and size (1.." + std::to_string(kMaxMemoryRangeBytes) +
+                              ") are required"},
+                {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        std::vector<MemoryRangeResult> results;
+        auto result = queue_memory_and_wait({range}, results);
+        if (!result.success || results.size() != 1) {
+            res.status = failure_status(result);
+            nlohmann::json response = {
+                {"error", result.payload.empty() ? "no result" : result.payload},
+                {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        const MemoryRangeResult& read = results[0];
+        if (!read.error.empty()) {
+            res.status = 400;
+            nlohmann::json response = {{"error", read.error}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        char address[24];
+        std::snprintf(address, sizeof(address), "0x%llx",
+                      static_cast<unsigned long long>(read.address));
+        res.set_header("X-Memory-Address", address);
+        res.set_header("X-Memory-Status", FormatHResult(read.status));
+        res.set_content(read.data, "application/octet-stream");
+    });
+
+    // Batched memory read: overlapping and adjacent ranges are fetched together
+    impl_->server.Post("/memory", [this](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            std::vector<MemoryRangeRequest> ranges;
+            std::string error;
+            if (!ParseMemoryRanges(json, &ranges, &error)) {
+                res.status = 400;
+                nlohmann::json response = {{"error", error}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            std::vector<MemoryRangeResult> results;
+            auto result = queue_memory_and_wait(ranges, results);
+            if (!result.success || results.size() != ranges.size()) {
+                res.status = failure_status(result);
+                nlohmann::json response = {
+                    {"error", result.payload.empty() ? "no result" : result.payload},
+                    {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            res.set_content(dump_json(MemoryResultsJson(results, json.value("encoding", ""))),
+                            "application/json");
+        } catch (const std::exception& e) {
+            res.status = 500;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+
+    // Module, symbol and memory region for many addresses, from the address index
+    impl_->server.Post("/symbolize", [this](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            SymbolizeRequest request;
+            std::string error;
+            if (!ParseSymbolizeRequest(json, &request, &error)) {
+                res.status = 400;
+                nlohmann::json response = {{"error", error}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            std::vector<SymbolizeResult> results;
+            auto result = queue_symbolize_and_wait(request, results);
+            if (!result.success || results.size() != request.addresses.size()) {
+                res.status = failure_status(result);
+                nlohmann::json response = {
+                    {"error", result.payload.empty() ? "no result" : result.payload},
+                    {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            res.set_content(dump_json(SymbolizeResultsJson(results)), "application/json");
+        } catch (const std::exception& e) {
+            res.status = 500;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+
+    // Pattern search over target memory. Hits are collected into one JSON answer, or with
+    // "stream": true sent as SSE "hits" frames while the scan runs, then a "done" frame.
+    impl_->server.Post("/search_memory", [this](const httplib::Request& req, httplib::Response& res) {
+        MemoryScanRequest request;
+        bool stream_hits = false;
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            std::string error;
+            if (!ParseScanRequest(json, &request, &error)) {
+                res.status = 400;
+                nlohmann::json response = {{"error", error}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+            stream_hits = json.value("stream", false);
+        } catch (const std::exception& e) {
+            res.status = 400;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        if (!stream_hits) {
+            std::vector<ScanHit> hits;
+            ScanHitHandler collect = [&hits](const std::vector<ScanHit>& batch) {
+                hits.insert(hits.end(), batch.begin(), batch.end());
+                return true;
+            };
+            MemoryScanResult scan;
+            auto result = queue_scan_and_wait(request, collect, scan);
+            if (!result.success) {
+                res.status = failure_status(result);
+                nlohmann::json response = {{"error", result.payload}, {"success", false}};
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+
+            std::sort(hits.begin(), hits.end(), [](const ScanHit& a, const ScanHit& b) {
+                return a.address < b.address || (a.address == b.address && a.pattern < b.pattern);
+            });
+            nlohmann::json response = ScanResultJson(scan);
+            response["matches"] = ScanHitsJson(hits);
+            if (!scan.succeeded()) {
+                res.status = 400;
+            }
+            res.set_content(dump_json(response), "application/json");
+            return;
+        }
+
+        // Hits are pushed as ready-made frames
+        auto stream = std::make_shared<SseStream<MemoryScanResult>>();
+        ScanHitHandler on_hits = [this, stream](const std::vector<ScanHit>& batch) {
+            return stream->push(sse_frame("hits", {{"matches", ScanHitsJson(batch)}}), running_);
+        };
+
+        stream->worker = std::thread([this, stream, request, on_hits]() {
+            MemoryScanResult scan;
+            QueueResult queue_result = queue_scan_and_wait(request, on_hits, scan);
+            stream->finish(queue_result, std::move(scan));
+        });
+
+        serve_sse_stream(
+            res, stream, [](std::string frames) { return frames; },
+            [](const SseStream<MemoryScanResult>& done) {
+                return done.queue_result.success
+                           ? ScanResultJson(done.result)
+                           : nlohmann::json{{"error", done.queue_result.payload}, {"success", false}};
+            });
+    });
+
+    // Streaming exec: output is sent as SSE "output" frames while the command runs,
+    // followed by a final "done" frame with HRESULT and timing.
+    impl_->server.Post("/exec_stream", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string command;
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            command = json.value("command", "");
+        } catch (const std::exception& e) {
+            res.status = 400;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        if (command.empty()) {
+            res.status = 400;
+            res.set_content(R"({"error":"missing command","success":false})", "application/json");
+            return;
+        }
+
+        auto stream = std::make_shared<SseStream<ExecResult>>();
+        OutputChunkHandler on_chunk = [this, stream](const char* text, size_t length) {
+            return stream->push(std::string(text, length), running_);
+        };
+
+        stream->worker = std::thread([this, stream, command, on_chunk]() {
+            ExecResult result;
+            QueueResult queue_result = queue_stream_and_wait(command, on_chunk, result);
+            stream->finish(queue_result, std::move(result));
+        });
+
+        serve_sse_stream(
+            res, stream, [](std::string text) { return sse_frame("output", {{"text", text}}); },
+            [](const SseStream<ExecResult>& done) {
+                nlohmann::json status = {{"success", done.queue_result.success}};
+                if (done.queue_result.success) {
+                    status["hresult"] = FormatHResult(done.result.status);
+                    status["elapsed_ms"] = done.result.elapsed_ms;
+                    status["bytes"] = done.total_bytes;
+                    status["success"] = done.result.succeeded();
+                } else {
+                    status["error"] = done.queue_result.payload;
+                }
+                return status;
+            });
+    });
+
     impl_->server.Post("/ask", [this](const httplib::Request& req, httplib::Response& res) {
         try {
             auto json = nlohmann::json::parse(req.body);
@@ -114,7 +813,7 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
             auto result = queue_and_wait(PendingCommand::Type::Ask, query);
             nlohmann::json response = {{"response", result.payload}, {"success", result.success}};
             if (!result.success) {
-                res.status = 503;
+                res.status = failure_status(result);
             }
             res.set_content(response.dump(), "application/json");
         } catch (const std::exception& e) {
@@ -124,8 +823,353 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
         }
     });
 
-    impl_->server.Get("/status", [](const httplib::Request&, httplib::Response& res) {
-        nlohmann::json response = {{"status", "ready"}, {"success", true}};
+    // Streaming ask: the agent's progress is sent as SSE while the query runs
+    // ("query_started", "delta", "tool_started", "tool_finished", "complete", "error"),
+    // followed by a final "done" frame with the response.
+    impl_->server.Post("/ask_stream", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string query;
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            query = json.value("query", "");
+        } catch (const std::exception& e) {
+            res.status = 400;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+
+        if (query.empty()) {
+            res.status = 400;
+            res.set_content(R"({"error":"missing query","success":false})", "application/json");
+            return;
+        }
+
+        // Subscribe before queueing so no event of this query can be missed
+        auto stream = std::make_shared<AskStream>();
+        stream->subscription = GetEventBus().Subscribe();
+
+        // Queries run one at a time on the main thread, so the events published while ours
+        // holds it are exactly its events
+        stream->worker = std::thread([this, stream, query]() {
+            PendingCommand cmd;
+            cmd.type = PendingCommand::Type::Ask;
+            cmd.input = query;
+            bool dispatched = running_.load() &&
+                              broker_->Dispatch(source_.load(), [this, stream, &cmd]() {
+                                  stream->first_seq.store(GetEventBus().last_seq() + 1);
+                                  execute_command(cmd);
+                                  stream->last_seq.store(GetEventBus().last_seq());
+                              });
+            stream->result = dispatched ? QueueResult{!cmd.failed, cmd.result, true}
+                                        : QueueResult{false, "Error: HTTP server stopped"};
+            stream->done.store(true);
+        });
+
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [this, stream](size_t /*offset*/, httplib::DataSink& sink) {
+                // Read done before polling: once set, this poll drains every event of the query
+                bool done = stream->done.load();
+                std::vector<AgentEvent> events;
+                if (!GetEventBus().Poll(stream->subscription, done ? std::chrono::milliseconds(0)
+                                                                   : kEventPollInterval,
+                                        &events, nullptr) ||
+                    !running_.load()) {
+                    return false;
+                }
+
+                // Drop events of other queries (before ours started, or after it finished)
+                uint64_t first = stream->first_seq.load();
+                uint64_t last = done ? stream->last_seq.load() : UINT64_MAX;
+                events.erase(std::remove_if(events.begin(), events.end(),
+                                            [&](const AgentEvent& e) {
+                                                return first == 0 || e.seq < first ||
+                                                       e.seq > last;
+                                            }),
+                             events.end());
+
+                if (!events.empty()) {
+                    stream->last_write = std::chrono::steady_clock::now();
+                    if (!write_agent_events(sink, events)) {
+                        return false;
+                    }
+                } else if (!done && !write_keep_alive(sink, &stream->last_write)) {
+                    return false;
+                }
+
+                if (done) {
+                    nlohmann::json status = {{"success", stream->result.success}};
+                    status[stream->result.success ? "response" : "error"] = stream->result.payload;
+                    std::string frame = sse_frame("done", status);
+                    sink.write(frame.data(), frame.size());
+                    sink.done();
+                }
+                return true;
+            },
+            [stream](bool /*success*/) {
+                // A client that disconnects does not cancel the query; it runs to completion
+                if (stream->worker.joinable()) {
+                    stream->worker.join();
+                }
+                GetEventBus().Unsubscribe(stream->subscription);
+            });
+    });
+
+    // Every agent event of this session as SSE, whoever asked (console, HTTP or MCP).
+    // A "dropped" frame reports events lost because this client fell behind.
+    impl_->server.Get("/events", [this](const httplib::Request&, httplib::Response& res) {
+        auto subscription = GetEventBus().Subscribe();
+        auto last_write = std::make_shared<std::chrono::steady_clock::time_point>(
+            std::chrono::steady_clock::now());
+
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [this, subscription, last_write](size_t /*offset*/, httplib::DataSink& sink) {
+                std::vector<AgentEvent> events;
+                uint64_t dropped = 0;
+                if (!GetEventBus().Poll(subscription, kEventPollInterval, &events, &dropped) ||
+                    !running_.load()) {
+                    return false;
+                }
+
+                if (dropped > 0) {
+                    std::string frame = sse_frame("dropped", {{"count", dropped}});
+                    if (!sink.write(frame.data(), frame.size())) {
+                        return false;
+                    }
+                }
+                if (events.empty() && dropped == 0) {
+                    return write_keep_alive(sink, last_write.get());
+                }
+                *last_write = std::chrono::steady_clock::now();
+                return write_agent_events(sink, events);
+            },
+            [subscription](bool /*success*/) { GetEventBus().Unsubscribe(subscription); });
+    });
+
+    // Live debugger output as SSE "output" frames: everything the engine prints, including
+    // commands typed at the console. Read from the output ring at this client's pace; a
+    // "dropped" frame reports bytes lost because the client fell more than a ring behind.
+    impl_->server.Get("/output", [this](const httplib::Request&, httplib::Response& res) {
+        auto cursor = std::make_shared<OutputRing::Cursor>(GetOutputRing().Tail());
+        auto last_write = std::make_shared<std::chrono::steady_clock::time_point>(
+            std::chrono::steady_clock::now());
+
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [this, cursor, last_write](size_t /*offset*/, httplib::DataSink& sink) {
+                if (!running_.load()) {
+                    return false;
+                }
+
+                std::string text;
+                uint64_t dropped = 0;
+                GetOutputRing().Read(
+                    cursor.get(),
+                    [&text](uint32_t /*mask*/, const char* chunk, size_t length) {
+                        text.append(chunk, length);
+                    },
+                    &dropped, kMaxOutputFrameSlots);
+
+                if (dropped > 0) {
+                    std::string frame = sse_frame("dropped", {{"bytes", dropped}});
+                    if (!sink.write(frame.data(), frame.size())) {
+                        return false;
+                    }
+                }
+                if (text.empty()) {
+                    std::this_thread::sleep_for(kOutputPollInterval);
+                    return write_keep_alive(sink, last_write.get());
+                }
+
+                *last_write = std::chrono::steady_clock::now();
+                std::string frame = sse_frame("output", {{"text", text}});
+                return sink.write(frame.data(), frame.size());
+            });
+    });
+
+    // Asynchronous jobs: POST returns an id at once; the job runs in the background and is
+    // polled (GET /jobs/{id}?wait=N), streamed (GET /jobs/{id}/events) or cancelled (DELETE)
+    impl_->server.Post("/jobs", [this](const httplib::Request& req, httplib::Response& res) {
+        nlohmann::json error_json;
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            std::string type = json.value("type", "exec");
+            std::string id;
+
+            if (type == "exec" || type == "ask") {
+                std::string input = json.value(type == "exec" ? "command" : "query", "");
+                if (input.empty()) {
+                    error_json = {{"error", type == "exec" ? "missing command" : "missing query"}};
+                } else {
+                    id = jobs_.Create(type == "exec" ? JobKind::Exec : JobKind::Ask, input);
+                }
+            } else if (type == "exec_batch") {
+                auto commands_json = json.value("commands", nlohmann::json::array());
+                std::vector<std::string> commands;
+                if (commands_json.is_array()) {
+                    for (const auto& item : commands_json) {
+                        if (item.is_string() && !item.get<std::string>().empty()) {
+                            commands.push_back(item.get<std::string>());
+                        }
+                    }
+                }
+                if (commands.empty() || commands.size() != commands_json.size() ||
+                    commands.size() > kMaxBatchCommands) {
+                    error_json = {{"error", "commands must be a non-empty array of at most " +
+                                                std::to_string(kMaxBatchCommands) + " strings"}};
+                } else {
+                    id = jobs_.Create(JobKind::ExecBatch, "", std::move(commands));
+                }
+            } else {
+                error_json = {{"error", "type must be exec, exec_batch or ask"}};
+            }
+
+            if (!error_json.is_null()) {
+                res.status = 400;
+                error_json["success"] = false;
+                res.set_content(error_json.dump(), "application/json");
+                return;
+            }
+            if (id.empty()) {
+                res.status = 429;
+                res.set_content(R"({"error":"too many unfinished jobs","success":false})",
+                                "application/json");
+                return;
+            }
+
+            res.status = 202;
+            nlohmann::json response = {{"id", id}, {"state", "queued"}, {"success", true}};
+            res.set_content(response.dump(), "application/json");
+        } catch (const std::exception& e) {
+            res.status = 400;
+            nlohmann::json response = {{"error", e.what()}, {"success", false}};
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+
+    impl_->server.Get("/jobs", [this](const httplib::Request&, httplib::Response& res) {
+        nlohmann::json list = nlohmann::json::array();
+        for (const auto& job : jobs_.List()) {
+            list.push_back(job_json(job, false));
+        }
+        nlohmann::json response = {{"jobs", list}, {"success", true}};
+        res.set_content(dump_json(response), "application/json");
+    });
+
+    impl_->server.Get(R"(/jobs/([^/]+))", [this](const httplib::Request& req,
+                                                 httplib::Response& res) {
+        std::string id = req.matches[1];
+        int wait_s = 0;
+        if (req.has_param("wait")) {
+            wait_s = std::clamp(std::atoi(req.get_param_value("wait").c_str()), 0,
+                                kMaxJobWaitSeconds);
+        }
+
+        // Long-poll: only a finished job (not new output) ends the wait early
+        JobSnapshot job;
+        if (!jobs_.Wait(id, UINT64_MAX, std::chrono::seconds(wait_s), &job, nullptr)) {
+            res.status = 404;
+            res.set_content(R"({"error":"unknown job","success":false})", "application/json");
+            return;
+        }
+        res.set_content(dump_json(job_json(job, true)), "application/json");
+    });
+
+    // Job progress as SSE: "state" and "output" frames (each with its seq), then "done".
+    // ?after=N resumes after event N; output older than the retained window is skipped.
+    impl_->server.Get(R"(/jobs/([^/]+)/events)", [this](const httplib::Request& req,
+                                                        httplib::Response& res) {
+        std::string id = req.matches[1];
+        auto after = std::make_shared<uint64_t>(0);
+        if (req.has_param("after")) {
+            *after = std::strtoull(req.get_param_value("after").c_str(), nullptr, 10);
+        }
+
+        JobSnapshot job;
+        if (!jobs_.Get(id, &job)) {
+            res.status = 404;
+            res.set_content(R"({"error":"unknown job","success":false})", "application/json");
+            return;
+        }
+
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [this, id, after](size_t /*offset*/, httplib::DataSink& sink) {
+                JobSnapshot job;
+                std::vector<JobEvent> events;
+                if (!jobs_.Wait(id, *after, kStreamKeepAlive, &job, &events)) {
+                    std::string frame = sse_frame("done", {{"error", "job evicted"},
+                                                           {"success", false}});
+                    sink.write(frame.data(), frame.size());
+                    sink.done();
+                    return true;
+                }
+                if (!running_.load()) {
+                    return false;
+                }
+                if (events.empty() && !JobFinished(job.state)) {
+                    static const char kKeepAlive[] = ": keep-alive\n\n";
+                    return sink.write(kKeepAlive, sizeof(kKeepAlive) - 1);
+                }
+
+                for (const auto& event : events) {
+                    nlohmann::json data = {{"seq", event.seq}};
+                    data[event.type == "state" ? "state" : "text"] = event.text;
+                    std::string frame = sse_frame(event.type.c_str(), data);
+                    if (!sink.write(frame.data(), frame.size())) {
+                        return false;
+                    }
+                    *after = event.seq;
+                }
+
+                if (JobFinished(job.state)) {
+                    std::string frame = sse_frame("done", job_json(job, job.kind != JobKind::Exec));
+                    sink.write(frame.data(), frame.size());
+                    sink.done();
+                }
+                return true;
+            });
+    });
+
+    impl_->server.Delete(R"(/jobs/([^/]+))", [this](const httplib::Request& req,
+                                                    httplib::Response& res) {
+        std::string id = req.matches[1];
+        // A running agent query aborts and a running batch stops before its next command;
+        // a running single command cannot be interrupted, its output just stops
+        JobState previous = JobState::Queued;
+        if (!jobs_.Cancel(id, &previous)) {
+            res.status = 404;
+            res.set_content(R"({"error":"unknown job","success":false})", "application/json");
+            return;
+        }
+
+        const char* outcome = previous == JobState::Queued    ? "cancelled"
+                              : previous == JobState::Running ? "cancelling"
+                                                              : "deleted";
+        nlohmann::json response = {{"id", id}, {"state", outcome}, {"success", true}};
+        res.set_content(response.dump(), "application/json");
+    });
+
+    impl_->server.Get("/status", [this](const httplib::Request&, httplib::Response& res) {
+        BrokerStats stats = broker_->GetStats();
+        nlohmann::json sources = nlohmann::json::array();
+        for (const auto& source : stats.sources) {
+            sources.push_back({{"name", source.name},
+                               {"queue_depth", source.queue_depth},
+                               {"executed", source.executed},
+                               {"avg_wait_ms", source.avg_wait_ms},
+                               {"max_wait_ms", source.max_wait_ms}});
+        }
+        nlohmann::json broker = {{"queue_depth", stats.queue_depth},
+                                 {"max_queue_depth", stats.max_queue_depth},
+                                 {"executed", stats.executed},
+                                 {"avg_wait_ms", stats.avg_wait_ms},
+                                 {"p50_wait_ms", stats.p50_wait_ms},
+                                 {"p99_wait_ms", stats.p99_wait_ms},
+                                 {"max_wait_ms", stats.max_wait_ms},
+                                 {"sources", sources}};
+        nlohmann::json response = {{"status", "ready"}, {"broker", broker}, {"success", true}};
         res.set_content(response.dump(), "application/json");
     });
 
@@ -140,104 +1184,50 @@ int HttpServer::start(ExecCallback exec_cb, AskCallback ask_cb,
     });
 
     port_ = assigned_port;
+    broker_ = &broker;
+    source_.store(broker.Attach("http"));
+    job_source_.store(broker.Attach("http-jobs"));
     running_.store(true);
 
+    jobs_.Open();
+    job_runner_ = std::thread([this]() {
+        JobWork work;
+        while (jobs_.Take(&work)) {
+            run_job(work);
+        }
+    });
+
     server_thread_ = std::thread([this]() {
         impl_->server.listen_after_bind();
         running_.store(false);
-        queue_cv_.notify_all();
-        complete_pending_commands("Error: HTTP server stopped");
+        detach_from_broker();
     });
 
     return port_;
 }
 
-void HttpServer::set_interrupt_check(std::function<bool()> check) {
-    interrupt_check_ = check;
-}
-
-void HttpServer::wait() {
-    while (running_.load()) {
-        if (interrupt_check_ && interrupt_check_()) {
-            stop();
-            break;
-        }
-
-        PendingCommand* cmd = nullptr;
-
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (queue_cv_.wait_for(lock, std::chrono::milliseconds(100),
-                                   [this]() { return !pending_commands_.empty() || !running_.load(); })) {
-                if (!pending_commands_.empty()) {
-                    cmd = pending_commands_.front();
-                    pending_commands_.pop();
-                }
-            }
-        }
-
-        if (cmd) {
-            try {
-                if (cmd->type == PendingCommand::Type::Exec && exec_cb_) {
-                    cmd->result = exec_cb_(cmd->input);
-                } else if (cmd->type == PendingCommand::Type::Ask && ask_cb_) {
-                    cmd->result = ask_cb_(cmd->input);
-                } else {
-                    cmd->result = "Error: No handler for command type";
-                }
-            } catch (const std::exception& e) {
-                cmd->result = std::string("Error: ") + e.what();
-            }
-
-            if (cmd->done_mutex && cmd->done_cv) {
-                {
-                    std::lock_guard<std::mutex> lock(*cmd->done_mutex);
-                    cmd->completed = true;
-                }
-                cmd->done_cv->notify_one();
-            }
-        }
-    }
-
-    if (server_thread_.joinable()) {
-        server_thread_.join();
-    }
-}
-
 void HttpServer::stop() {
     if (impl_) {
         impl_->server.stop();
     }
     running_.store(false);
-    queue_cv_.notify_all();
-    complete_pending_commands("Error: HTTP server stopped");
+    jobs_.Close();
+    detach_from_broker();
     if (server_thread_.joinable()) {
         server_thread_.join();
     }
-}
-
-void HttpServer::complete_pending_commands(const std::string& result) {
-    std::queue<PendingCommand*> pending;
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        std::swap(pending, pending_commands_);
+    if (job_runner_.joinable()) {
+        job_runner_.join();
     }
+}
 
-    while (!pending.empty()) {
-        PendingCommand* cmd = pending.front();
-        pending.pop();
-        if (!cmd || !cmd->done_mutex || !cmd->done_cv) {
-            continue;
+void HttpServer::detach_from_broker() {
+    // Fails commands still queued by this server; the last detach ends CommandBroker::Run()
+    for (auto* slot : {&source_, &job_source_}) {
+        CommandBroker::SourceId source = slot->exchange(0);
+        if (broker_ && source != 0) {
+            broker_->Detach(source);
         }
-
-        {
-            std::lock_guard<std::mutex> lock(*cmd->done_mutex);
-            if (!cmd->completed) {
-                cmd->result = result;
-                cmd->completed = true;
-            }
-        }
-        cmd->done_cv->notify_one();
     }
 }
 
@@ -277,7 +1267,21 @@ std::string format_http_info(
 
     ss << "HTTP API ENDPOINTS:\n";
     ss << "  POST " << url << "/exec   - Execute raw debugger command\n";
+    ss << "  POST " << url << "/exec_batch - Execute a list of commands in one round trip\n";
+    ss << "  POST " << url << "/exec_stream - Execute a command, streaming output as SSE\n";
     ss << "  POST " << url << "/ask    - AI-assisted query (natural language)\n";
+    ss << "  POST " << url << "/ask_stream - AI query, streaming progress as SSE\n";
+    ss << "  GET  " << url << "/events - All agent progress events as SSE\n";
+    ss << "  GET  " << url << "/output - Live debugger output as SSE\n";
+    ss << "  POST " << url << "/query  - Stack, registers, modules, threads or memory as JSON\n";
+    ss << "  GET  " << url << "/memory?address=..&size=.. - Raw memory bytes (octet-stream)\n";
+    ss << "  POST " << url << "/memory - Read many memory ranges in one call (base64 or hex)\n";
+    ss << "  POST " << url << "/symbolize - Module, symbol and region for many addresses\n";
+    ss << "  POST " << url << "/search_memory - Find bytes, strings or pointers in memory\n";
+    ss << "  POST " << url << "/jobs   - Start an exec, exec_batch or ask job (returns an id)\n";
+    ss << "  GET  " << url << "/jobs/{id}?wait=30 - Job state and result (long-poll)\n";
+    ss << "  GET  " << url << "/jobs/{id}/events - Job progress as SSE\n";
+    ss << "  DELETE " << url << "/jobs/{id} - Cancel a job (or delete a finished one)\n";
     ss << "  GET  " << url << "/status - Server status\n";
     ss << "  POST " << url << "/shutdown - Stop server\n\n";
 
@@ -287,11 +1291,51 @@ std::string format_http_info(
     ss << "    -H \"Content-Type: application/json\" \\\n";
     ss << "    -d '{\"command\": \"kb\"}'\n\n";
 
+    ss << "  # Execute several commands in one request (per-command output, hresult, timing)\n";
+    ss << "  curl -X POST " << url << "/exec_batch \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"commands\": [\"k\", \"r\", \"lm\"]}'\n\n";
+
+    ss << "  # Stream a large command's output as it is produced (SSE: output frames, then done)\n";
+    ss << "  curl -N -X POST " << url << "/exec_stream \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"command\": \"lm v\"}'\n\n";
+
+    ss << "  # Structured state as JSON (query: stack, registers, modules, threads, memory,\n";
+    ss << "  # unique_stacks)\n";
+    ss << "  curl -X POST " << url << "/query \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"query\": \"memory\", \"address\": \"@rsp\", \"size\": 64}'\n\n";
+
+    ss << "  # Raw memory for scanners; POST /memory batches ranges ({\"ranges\": [...]})\n";
+    ss << "  curl -o page.bin \"" << url << "/memory?address=0x7ff6a0001000&size=4096\"\n\n";
+
+    ss << "  # Resolve a batch of pointers (symbols: false skips symbol names)\n";
+    ss << "  curl -X POST " << url << "/symbolize \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"addresses\": [\"0x7ffb1c2d1234\", \"@rip\"]}'\n\n";
+
+    ss << "  # Search all committed memory ('?' is a wildcard nibble; add \"stream\": true for SSE)\n";
+    ss << "  curl -X POST " << url << "/search_memory \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"patterns\": [{\"bytes\": \"48 8b 05 ?? ?? ?? ??\"}, {\"utf16\": \"password\"}]}'\n\n";
+
     ss << "  # AI query (natural language, returns explanation)\n";
     ss << "  curl -X POST " << url << "/ask \\\n";
     ss << "    -H \"Content-Type: application/json\" \\\n";
     ss << "    -d '{\"query\": \"what is the value of RAX?\"}'\n\n";
 
+    ss << "  # Watch the agent think and call tools while it answers\n";
+    ss << "  curl -N -X POST " << url << "/ask_stream \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"query\": \"explain this crash\"}'\n\n";
+
+    ss << "  # Long-running work without holding a connection open\n";
+    ss << "  curl -X POST " << url << "/jobs \\\n";
+    ss << "    -H \"Content-Type: application/json\" \\\n";
+    ss << "    -d '{\"type\": \"exec\", \"command\": \"!analyze -v\"}'\n";
+    ss << "  curl \"" << url << "/jobs/job-1?wait=30\"\n\n";
+
     ss << "  # More examples\n";
     ss << "  curl -X POST " << url << "/exec -H \"Content-Type: application/json\" -d '{\"command\": \"r rax\"}'\n";
     ss << "  curl -X POST " << url << "/exec -H \"Content-Type: application/json\" -d '{\"command\": \"!analyze -v\"}'\n";
@@ -309,7 +1353,12 @@ std::string format_http_info(
 
     ss << "RESPONSE FORMAT:\n";
     ss << "  /exec returns: {\"output\": \"...\", \"success\": true}\n";
-    ss << "  /ask returns:  {\"response\": \"...\", \"success\": true}\n\n";
+    ss << "  /exec_batch returns: {\"results\": [{\"command\": \"k\", \"output\": \"...\", "
+          "\"hresult\": \"0x00000000\", \"elapsed_ms\": 1.5, \"success\": true}, ...], "
+          "\"success\": true}\n";
+    ss << "  /ask returns:  {\"response\": \"...\", \"success\": true}\n";
+    ss << "  /jobs/{id} returns: {\"id\": \"job-1\", \"state\": \"succeeded\", "
+          "\"output\": \"...\", ...}\n\n";
 
     ss << "CLI TOOL:\n";
     ss << "  windbg_agent.exe --url=" << url << " exec \"kb\"\n";
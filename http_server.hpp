@@ -5,30 +5,42 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 #include <optional>
+#include <memory>
+#include <vector>
 
-namespace windbg_agent {
+#include "command_types.hpp"
+#include "command_broker.hpp"
+#include "job_table.hpp"
 
-// Callbacks for handling requests
-using ExecCallback = std::function<std::string(const std::string& command)>;
-using AskCallback = std::function<std::string(const std::string& query)>;
+namespace windbg_agent {
 
 // Internal command structure for cross-thread execution
 struct PendingCommand {
-    enum class Type { Exec, Ask };
+    enum class Type { Exec, Ask, ExecBatch, ExecStream, Query, Memory, Symbolize, Scan };
     Type type;
     std::string input;
     std::string result;
-    bool completed = false;
-    std::mutex* done_mutex = nullptr;
-    std::condition_variable* done_cv = nullptr;
+    std::vector<std::string> batch_input;
+    std::vector<ExecResult> batch_result;
+    OutputChunkHandler on_chunk;
+    ExecResult stream_result;
+    QueryRequest query;
+    std::vector<MemoryRangeRequest> memory_input;
+    std::vector<MemoryRangeResult> memory_result;
+    SymbolizeRequest symbolize_input;
+    std::vector<SymbolizeResult> symbolize_result;
+    MemoryScanRequest scan_input;
+    ScanHitHandler on_hits;
+    MemoryScanResult scan_result;
+    const std::atomic<bool>* cancel = nullptr; // Ask: aborts the query once set (jobs)
+    bool failed = false; // The handler threw (result holds the message) or there was none
 };
 
 struct QueueResult {
     bool success;
     std::string payload;
+    bool ran = false; // Reached the main thread, so a failure is the handler's
 };
 
 class HttpServer {
@@ -42,14 +54,32 @@ public:
 
     // Start server with OS-assigned port
     // Returns actual port used
-    // Callbacks will be called on the main thread (in wait())
+    // The server attaches to broker as a source; callbacks are called on the main thread
+    // while it runs CommandBroker::Run()
     // bind_addr: "127.0.0.1" for localhost only, "0.0.0.0" for all interfaces
-    int start(ExecCallback exec_cb, AskCallback ask_cb,
+    int start(CommandBroker& broker, ExecCallback exec_cb, AskCallback ask_cb,
+              ExecBatchCallback exec_batch_cb, ExecStreamCallback exec_stream_cb,
               const std::string& bind_addr = "127.0.0.1");
 
-    // Block until server stops, processing commands on the calling thread
-    // This is where exec_cb and ask_cb get called
-    void wait();
+    // Answers POST /query with JSON on the main thread. Set before start().
+    void set_query_callback(QueryCallback query_cb) {
+        query_cb_ = std::move(query_cb);
+    }
+
+    // Answers /memory on the main thread. Set before start().
+    void set_memory_callback(MemoryReadCallback memory_cb) {
+        memory_cb_ = std::move(memory_cb);
+    }
+
+    // Answers POST /symbolize on the main thread. Set before start().
+    void set_symbolize_callback(SymbolizeCallback symbolize_cb) {
+        symbolize_cb_ = std::move(symbolize_cb);
+    }
+
+    // Answers POST /search_memory on the main thread. Set before start().
+    void set_scan_callback(MemoryScanCallback scan_cb) {
+        scan_cb_ = std::move(scan_cb);
+    }
 
     // Stop the server
     void stop();
@@ -66,30 +96,63 @@ public:
     // Queue a command for execution on the main thread (called by HTTP handlers)
     QueueResult queue_and_wait(PendingCommand::Type type, const std::string& input);
 
-    // Set interrupt check function (called during wait loop)
-    void set_interrupt_check(std::function<bool()> check);
+    // Queue an ordered batch of commands to run back-to-back in one main-thread slot
+    QueueResult queue_batch_and_wait(const std::vector<std::string>& commands,
+                                     std::vector<ExecResult>& results);
+
+    // Queue a command whose output is forwarded chunk by chunk while it runs
+    QueueResult queue_stream_and_wait(const std::string& command, OutputChunkHandler on_chunk,
+                                      ExecResult& result);
+
+    // Queue a structured query; payload is its JSON answer
+    QueueResult queue_query_and_wait(const QueryRequest& request);
+
+    // Queue a binary memory read of several ranges in one main-thread slot
+    QueueResult queue_memory_and_wait(const std::vector<MemoryRangeRequest>& ranges,
+                                      std::vector<MemoryRangeResult>& results);
+
+    // Queue an address batch for the address index in one main-thread slot
+    QueueResult queue_symbolize_and_wait(const SymbolizeRequest& request,
+                                         std::vector<SymbolizeResult>& results);
+
+    // Queue a memory search; hits are passed to on_hits (on the main thread) as they are found
+    QueueResult queue_scan_and_wait(const MemoryScanRequest& request, ScanHitHandler on_hits,
+                                    MemoryScanResult& result);
 
 private:
-    std::function<bool()> interrupt_check_;
     std::thread server_thread_;
     std::atomic<bool> running_{false};
     int port_{0};
     std::string bind_addr_{"127.0.0.1"};
 
-    // Command queue for cross-thread execution
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
-    std::queue<PendingCommand*> pending_commands_;
+    // Main-thread queue shared with other transports
+    CommandBroker* broker_ = nullptr;
+    std::atomic<CommandBroker::SourceId> source_{0};
 
     // Callbacks stored for main thread execution
     ExecCallback exec_cb_;
     AskCallback ask_cb_;
+    ExecBatchCallback exec_batch_cb_;
+    ExecStreamCallback exec_stream_cb_;
+    QueryCallback query_cb_;
+    MemoryReadCallback memory_cb_;
+    SymbolizeCallback symbolize_cb_;
+    MemoryScanCallback scan_cb_;
+
+    // Asynchronous jobs (/jobs), run one at a time by job_runner_ through their own
+    // broker source so they share the main thread fairly with synchronous requests
+    JobTable jobs_;
+    std::thread job_runner_;
+    std::atomic<CommandBroker::SourceId> job_source_{0};
 
     // Forward declaration - impl hides httplib
     class Impl;
     std::unique_ptr<Impl> impl_;
 
-    void complete_pending_commands(const std::string& result);
+    QueueResult enqueue_and_wait(PendingCommand& cmd);
+    void execute_command(PendingCommand& cmd);
+    void run_job(const JobWork& work);
+    void detach_from_broker();
 };
 
 // Copy text to Windows clipboard
@@ -0,0 +1,378 @@
+#include "job_table.hpp"
+
+#include <algorithm>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+double MsBetween(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+const char* JobKindName(JobKind kind)
+{
+    switch (kind)
+    {
+    case JobKind::Exec:
+        return "exec";
+    case JobKind::ExecBatch:
+        return "exec_batch";
+    case JobKind::Ask:
+        return "ask";
+    }
+    return "unknown";
+}
+
+const char* JobStateName(JobState state)
+{
+    switch (state)
+    {
+    case JobState::Queued:
+        return "queued";
+    case JobState::Running:
+        return "running";
+    case JobState::Succeeded:
+        return "succeeded";
+    case JobState::Failed:
+        return "failed";
+    case JobState::Cancelled:
+        return "cancelled";
+    }
+    return "unknown";
+}
+
+JobTable::JobTable(size_t max_jobs, std::chrono::seconds ttl) : max_jobs_(max_jobs), ttl_(ttl)
+{
+}
+
+std::string JobTable::Create(JobKind kind, std::string input, std::vector<std::string> batch)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_)
+            return "";
+
+        Evict(now);
+        if (jobs_.size() >= max_jobs_)
+            return "";
+
+        auto job = std::make_unique<Job>();
+        id = "job-" + std::to_string(next_id_++);
+        job->info.id = id;
+        job->info.kind = kind;
+        job->info.input = std::move(input);
+        job->info.batch = std::move(batch);
+        job->created = now;
+        PushEvent(*job, "state", JobStateName(JobState::Queued));
+
+        jobs_[id] = std::move(job);
+        order_.push_back(id);
+        queued_.push_back(id);
+    }
+    queue_cv_.notify_one();
+    return id;
+}
+
+bool JobTable::Get(const std::string& id, JobSnapshot* snapshot)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Evict(std::chrono::steady_clock::now());
+    auto it = jobs_.find(id);
+    if (it == jobs_.end())
+        return false;
+    *snapshot = it->second->info;
+    return true;
+}
+
+std::vector<JobSnapshot> JobTable::List()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Evict(std::chrono::steady_clock::now());
+    std::vector<JobSnapshot> result;
+    result.reserve(order_.size());
+    for (const auto& id : order_)
+    {
+        JobSnapshot snapshot = jobs_[id]->info;
+        // Listings stay small: results are fetched per job
+        snapshot.result.clear();
+        snapshot.batch_results.clear();
+        result.push_back(std::move(snapshot));
+    }
+    return result;
+}
+
+bool JobTable::Wait(const std::string& id, uint64_t after_seq, std::chrono::milliseconds timeout,
+                    JobSnapshot* snapshot, std::vector<JobEvent>* events)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [&]()
+    {
+        auto it = jobs_.find(id);
+        return it == jobs_.end() || closed_ || JobFinished(it->second->info.state) ||
+               it->second->info.last_seq > after_seq;
+    };
+    change_cv_.wait_for(lock, timeout, ready);
+
+    auto it = jobs_.find(id);
+    if (it == jobs_.end())
+        return false;
+
+    const Job& job = *it->second;
+    if (snapshot)
+        *snapshot = job.info;
+    if (events)
+    {
+        events->clear();
+        for (const auto& event : job.events)
+        {
+            if (event.seq > after_seq)
+                events->push_back(event);
+        }
+    }
+    return true;
+}
+
+bool JobTable::Cancel(const std::string& id, JobState* state)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end())
+            return false;
+
+        Job& job = *it->second;
+        if (state)
+            *state = job.info.state;
+
+        switch (job.info.state)
+        {
+        case JobState::Queued:
+            // Taken jobs are also Queued until they start; Start() then refuses them
+            queued_.erase(std::remove(queued_.begin(), queued_.end(), id), queued_.end());
+            job.info.cancel_requested = true;
+            job.cancel->store(true);
+            job.finished = std::chrono::steady_clock::now();
+            SetState(job, JobState::Cancelled);
+            break;
+        case JobState::Running:
+            // The runner stops it where it can and finishes it as cancelled
+            job.info.cancel_requested = true;
+            job.cancel->store(true);
+            break;
+        default:
+            // Finished: the client is done with it
+            jobs_.erase(it);
+            order_.erase(std::remove(order_.begin(), order_.end(), id), order_.end());
+            break;
+        }
+    }
+    change_cv_.notify_all();
+    return true;
+}
+
+bool JobTable::Take(JobWork* work)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_cv_.wait(lock, [&]() { return closed_ || !queued_.empty(); });
+    if (closed_)
+        return false;
+
+    std::string id = queued_.front();
+    queued_.pop_front();
+    const Job& job = *jobs_[id];
+    work->id = id;
+    work->kind = job.info.kind;
+    work->input = job.info.input;
+    work->batch = job.info.batch;
+    work->cancel = job.cancel;
+    return true;
+}
+
+bool JobTable::Start(const std::string& id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || it->second->info.state != JobState::Queued ||
+            it->second->info.cancel_requested)
+            return false;
+
+        Job& job = *it->second;
+        job.started = std::chrono::steady_clock::now();
+        job.info.queued_ms = MsBetween(job.created, job.started);
+        SetState(job, JobState::Running);
+    }
+    change_cv_.notify_all();
+    return true;
+}
+
+bool JobTable::AppendOutput(const std::string& id, const char* text, size_t length)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || it->second->info.cancel_requested)
+            return false;
+
+        Job& job = *it->second;
+        size_t room = kMaxResultBytes - std::min(job.info.result.size(), kMaxResultBytes);
+        if (length > room)
+            job.info.truncated = true;
+        job.info.result.append(text, std::min(length, room));
+        PushEvent(job, "output", std::string(text, length));
+    }
+    change_cv_.notify_all();
+    return true;
+}
+
+void JobTable::Finish(const std::string& id, bool succeeded, std::string result, long status,
+                      std::string error, std::vector<ExecResult> batch_results)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || JobFinished(it->second->info.state))
+            return;
+
+        Job& job = *it->second;
+        job.finished = std::chrono::steady_clock::now();
+        job.info.elapsed_ms = MsBetween(job.started, job.finished);
+        // Streamed output was accumulated by AppendOutput
+        if (!result.empty())
+        {
+            job.info.truncated = result.size() > kMaxResultBytes;
+            if (job.info.truncated)
+                result.resize(kMaxResultBytes);
+            job.info.result = std::move(result);
+        }
+        job.info.batch_results = std::move(batch_results);
+        job.info.status = status;
+        job.info.error = std::move(error);
+
+        JobState state = job.info.cancel_requested ? JobState::Cancelled
+                         : succeeded               ? JobState::Succeeded
+                                                   : JobState::Failed;
+        SetState(job, state);
+    }
+    change_cv_.notify_all();
+}
+
+void JobTable::FinishExec(const std::string& id, bool handler_failed, std::string message,
+                          const ExecResult& result)
+{
+    bool succeeded = !handler_failed && result.succeeded();
+    std::string error = handler_failed ? std::move(message)
+                        : succeeded    ? ""
+                                       : "command failed: hr=" + FormatHResult(result.status);
+    Finish(id, succeeded, "", result.status, std::move(error));
+}
+
+void JobTable::FinishBatch(const std::string& id, bool handler_failed, std::string message,
+                           std::vector<ExecResult> results)
+{
+    // The first failing command names the error and gives the status
+    auto failed = std::find_if(results.begin(), results.end(),
+                               [](const ExecResult& r) { return !r.succeeded(); });
+    bool succeeded = !handler_failed && failed == results.end();
+    long status = succeeded || handler_failed ? 0 : failed->status;
+    std::string error = handler_failed ? std::move(message)
+                        : succeeded    ? ""
+                                       : "command failed: " + failed->command +
+                                             ": hr=" + FormatHResult(failed->status);
+    Finish(id, succeeded, "", status, std::move(error), std::move(results));
+}
+
+void JobTable::FinishAsk(const std::string& id, bool handler_failed, std::string message)
+{
+    if (handler_failed)
+        Finish(id, false, "", 0, std::move(message));
+    else
+        Finish(id, true, std::move(message), 0, "");
+}
+
+void JobTable::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& id : queued_)
+        {
+            Job& job = *jobs_[id];
+            job.info.error = "server stopped";
+            job.finished = now;
+            SetState(job, JobState::Failed);
+        }
+        queued_.clear();
+    }
+    queue_cv_.notify_all();
+    change_cv_.notify_all();
+}
+
+void JobTable::Open()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = false;
+}
+
+void JobTable::Evict(std::chrono::steady_clock::time_point now)
+{
+    auto expired = [&](const std::string& id)
+    {
+        const Job& job = *jobs_[id];
+        return JobFinished(job.info.state) && now - job.finished >= ttl_;
+    };
+    auto erase_at = [&](std::deque<std::string>::iterator it)
+    {
+        jobs_.erase(*it);
+        return order_.erase(it);
+    };
+
+    for (auto it = order_.begin(); it != order_.end();)
+        it = expired(*it) ? erase_at(it) : std::next(it);
+
+    if (jobs_.size() < max_jobs_)
+        return;
+    auto oldest = std::find_if(order_.begin(), order_.end(), [&](const std::string& id)
+                               { return JobFinished(jobs_[id]->info.state); });
+    if (oldest != order_.end())
+        erase_at(oldest);
+}
+
+void JobTable::PushEvent(Job& job, const char* type, std::string text)
+{
+    JobEvent event;
+    event.seq = ++job.info.last_seq;
+    event.type = type;
+    event.text = std::move(text);
+    job.event_bytes += event.text.size();
+    job.events.push_back(std::move(event));
+
+    // Keep state events (they are tiny); drop the oldest output beyond the byte budget
+    while (job.event_bytes > kMaxEventBytes)
+    {
+        auto output = std::find_if(job.events.begin(), job.events.end(),
+                                   [](const JobEvent& e) { return e.type == "output"; });
+        if (output == job.events.end() || &*output == &job.events.back())
+            break;
+        job.event_bytes -= output->text.size();
+        job.events.erase(output);
+    }
+}
+
+void JobTable::SetState(Job& job, JobState state)
+{
+    job.info.state = state;
+    PushEvent(job, "state", JobStateName(state));
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "command_types.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace windbg_agent
+{
+
+enum class JobKind
+{
+    Exec,
+    ExecBatch,
+    Ask
+};
+
+enum class JobState
+{
+    Queued,
+    Running,
+    Succeeded,
+    Failed,
+    Cancelled
+};
+
+const char* JobKindName(JobKind kind);
+const char* JobStateName(JobState state);
+
+inline bool JobFinished(JobState state)
+{
+    return state == JobState::Succeeded || state == JobState::Failed ||
+           state == JobState::Cancelled;
+}
+
+// Progress reported by a job: "state" (text = new state name) or "output" (text = chunk)
+struct JobEvent
+{
+    uint64_t seq = 0;
+    std::string type;
+    std::string text;
+};
+
+// Point-in-time copy of a job
+struct JobSnapshot
+{
+    std::string id;
+    JobKind kind = JobKind::Exec;
+    JobState state = JobState::Queued;
+    std::string input;                 // Command or query
+    std::vector<std::string> batch;    // Commands of an ExecBatch job
+    std::string result;                // Output or response
+    bool truncated = false;            // result was cut at JobTable::kMaxResultBytes
+    std::vector<ExecResult> batch_results;
+    long status = 0;                   // Exec: command status
+    std::string error;
+    double queued_ms = 0.0;            // Time spent waiting for the runner
+    double elapsed_ms = 0.0;           // Time spent running
+    uint64_t last_seq = 0;             // Sequence number of the newest event
+    bool cancel_requested = false;
+};
+
+// What the runner needs to execute a job
+struct JobWork
+{
+    std::string id;
+    JobKind kind = JobKind::Exec;
+    std::string input;
+    std::vector<std::string> batch;
+    std::shared_ptr<const std::atomic<bool>> cancel; // Set once cancellation is requested
+};
+
+// Bounded table of asynchronous jobs submitted by HTTP clients.
+// Clients create jobs and poll, long-poll or stream their events; a runner takes queued
+// jobs in submission order. Finished jobs are evicted after a TTL (or earlier, oldest
+// first, when the table is full); unfinished jobs are never evicted.
+class JobTable
+{
+  public:
+    static constexpr size_t kDefaultMaxJobs = 256;
+    static constexpr std::chrono::seconds kDefaultTtl{600};
+
+    // Output events retained per job; older output events are dropped first
+    static constexpr size_t kMaxEventBytes = 1024 * 1024;
+
+    // Output or response kept as a job's result; the rest is dropped and the result
+    // marked truncated (the events still carry all of it while the client keeps up)
+    static constexpr size_t kMaxResultBytes = 1024 * 1024;
+
+    explicit JobTable(size_t max_jobs = kDefaultMaxJobs,
+                      std::chrono::seconds ttl = kDefaultTtl);
+
+    // Queue a job; returns an empty id if the table is full of unfinished jobs or closed
+    std::string Create(JobKind kind, std::string input, std::vector<std::string> batch = {});
+
+    // Copy a job; false if unknown (or evicted)
+    bool Get(const std::string& id, JobSnapshot* snapshot);
+
+    // Snapshots of all jobs, oldest first
+    std::vector<JobSnapshot> List();
+
+    // Block until the job has events newer than after_seq or has finished, or timeout
+    // elapses. Fills *events with retained events newer than after_seq. False if unknown.
+    bool Wait(const std::string& id, uint64_t after_seq, std::chrono::milliseconds timeout,
+              JobSnapshot* snapshot, std::vector<JobEvent>* events);
+
+    // Cancel a queued job, request cancellation of a running one, or delete a finished
+    // one. *state receives the state before the call. False if unknown.
+    bool Cancel(const std::string& id, JobState* state);
+
+    // Runner side: block until a job is queued (returns true) or the table is closed. The
+    // job stays Queued, and can still be cancelled, until Start().
+    bool Take(JobWork* work);
+
+    // Runner side, on the main thread: mark the job Running as its handler starts. False if
+    // it was cancelled (or evicted) meanwhile; the handler must not run then.
+    bool Start(const std::string& id);
+
+    // Runner side: report progress. AppendOutput returns false once cancellation was
+    // requested, so streaming can stop early.
+    bool AppendOutput(const std::string& id, const char* text, size_t length);
+    void Finish(const std::string& id, bool succeeded, std::string result, long status,
+                std::string error, std::vector<ExecResult> batch_results = {});
+
+    // Runner side: finish from a handler's outcome. handler_failed means the handler itself
+    // failed (threw, or there was none) and message holds why; otherwise an Exec or
+    // ExecBatch job succeeds when its commands did, and an Ask job with message as response.
+    void FinishExec(const std::string& id, bool handler_failed, std::string message,
+                    const ExecResult& result);
+    void FinishBatch(const std::string& id, bool handler_failed, std::string message,
+                     std::vector<ExecResult> results);
+    void FinishAsk(const std::string& id, bool handler_failed, std::string message);
+
+    // Fail queued jobs and wake the runner and all waiters; Create fails afterwards
+    void Close();
+
+    // Accept jobs again after Close()
+    void Open();
+
+  private:
+    struct Job
+    {
+        JobSnapshot info;
+        std::chrono::steady_clock::time_point created;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point finished;
+        std::deque<JobEvent> events;
+        size_t event_bytes = 0;
+        std::shared_ptr<std::atomic<bool>> cancel = std::make_shared<std::atomic<bool>>(false);
+    };
+
+    // Drop expired finished jobs; when still full, drop the oldest finished one (mutex_ held)
+    void Evict(std::chrono::steady_clock::time_point now);
+
+    void PushEvent(Job& job, const char* type, std::string text); // mutex_ held
+    void SetState(Job& job, JobState state);                      // mutex_ held
+
+    size_t max_jobs_;
+    std::chrono::seconds ttl_;
+
+    std::mutex mutex_;
+    std::condition_variable queue_cv_;  // Signals Take(): job queued or table closed
+    std::condition_variable change_cv_; // Signals Wait(): new event or state change
+    std::unordered_map<std::string, std::unique_ptr<Job>> jobs_;
+    std::deque<std::string> order_;     // Job ids, oldest first
+    std::deque<std::string> queued_;    // Ids waiting for the runner
+    uint64_t next_id_ = 1;
+    bool closed_ = false;
+};
+
+} // namespace windbg_agent
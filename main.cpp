@@ -1,17 +1,36 @@
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <ctime>
 #include <dbgeng.h>
+#include <filesystem>
+#include <future>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 #include <windows.h>
 
+#include "address_index.hpp"
+#include "agent_pool.hpp"
+#include "dbgeng_backend.hpp"
+#include "debug_query.hpp"
+#include "event_bus.hpp"
 #include "http_server.hpp"
 #include "mcp_server.hpp"
+#include "memory_cache.hpp"
+#include "opening_book.hpp"
+#include "output_capture.hpp"
+#include "output_ring.hpp"
+#include "output_shaper.hpp"
+#include "result_cache.hpp"
 #include "session_store.hpp"
 #include "settings.hpp"
+#include "state_watcher.hpp"
+#include "symbol_prefetch.hpp"
 #include "system_prompt.hpp"
+#include "transcript.hpp"
 #include "version.h"
 #include "windbg_client.hpp"
 
@@ -57,6 +76,18 @@ static std::string FormatDuration(int ms)
     return result;
 }
 
+// Summarize main-thread queue counters for display when servers stop
+static std::string FormatBrokerStats(const windbg_agent::BrokerStats& stats)
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "%llu commands, queue wait p50 %.2f ms / p99 %.2f ms / max %.2f ms, "
+                  "max depth %zu",
+                  static_cast<unsigned long long>(stats.executed), stats.p50_wait_ms,
+                  stats.p99_wait_ms, stats.max_wait_ms, stats.max_queue_depth);
+    return buf;
+}
+
 // Gather runtime context from the debugger session
 static windbg_agent::RuntimeContext GatherRuntimeContext(windbg_agent::WinDbgClient& dbg_client)
 {
@@ -94,13 +125,22 @@ struct AgentSession
     std::string provider_name;
     std::string target;
     std::string session_id;
-    std::string system_prompt;
+    std::string system_prompt;   // Stable prompt body (kSystemPrompt + context + custom)
+    uint64_t prompt_fingerprint = 0;
+    std::string runtime_context; // Latest volatile context (cwd, time)
+    std::string runtime_key;     // runtime_context without the time
+    std::string sent_key;        // runtime_key of the context the agent has already seen
+    std::string opening_context; // Opening book results, sent with the next prime message
+    std::string opening_target;  // Target the opening book last ran on
     bool primed = false;
     bool initialized = false;
     bool host_ready = false;
     std::atomic<bool> aborted{false};
+    const std::atomic<bool>* cancel = nullptr; // Abort token of the current remote query
     windbg_agent::WinDbgClient* dbg = nullptr;
     libagents::HostContext host;
+    std::string source = "console"; // Who asked the current query (for published events)
+    std::chrono::steady_clock::time_point query_started;
 };
 
 // Helper to get IDebugControl for output
@@ -117,22 +157,163 @@ static AgentSession& GetAgentSession()
     return session;
 }
 
+static windbg_agent::AgentPool& GetAgentPool();
+
 static void ResetAgentSession(AgentSession& session)
 {
-    if (session.agent)
-    {
-        session.agent->shutdown();
-        session.agent.reset();
-    }
+    // Shut down in the background so provider switches and resets return at once
+    GetAgentPool().Retire(std::move(session.agent));
     session.initialized = false;
     session.host_ready = false;
     session.provider_name.clear();
     session.session_id.clear();
     session.system_prompt.clear();
+    session.prompt_fingerprint = 0;
+    session.runtime_context.clear();
+    session.runtime_key.clear();
+    session.sent_key.clear();
+    session.opening_context.clear();
+    session.opening_target.clear();
     session.target.clear();
     session.primed = false;
 }
 
+// Build the message for the next turn. The full prompt body is only prepended when the
+// session is not primed; afterwards only a changed volatile context is sent as a delta.
+static std::string ComposeMessage(const AgentSession& session, const std::string& query)
+{
+    if (!session.primed && !session.system_prompt.empty())
+    {
+        std::string message = session.system_prompt;
+        if (!session.runtime_context.empty())
+            message += "\n" + session.runtime_context;
+        if (!session.opening_context.empty())
+            message += "\n" + session.opening_context;
+        return message + "\n\n---\n\n" + query;
+    }
+
+    // Judged without the time, which would otherwise differ on nearly every turn
+    if (!session.runtime_key.empty() && session.runtime_key != session.sent_key)
+        return "[Session context update]\n" + session.runtime_context + "\n---\n\n" + query;
+
+    return query;
+}
+
+// Record that the agent has received the current prompt body and volatile context
+static void MarkPrimed(AgentSession& session)
+{
+    session.primed = true;
+    session.sent_key = session.runtime_key;
+    session.opening_context.clear(); // Stale after the first turn
+}
+
+// Publish an agent event to remote observers (skipped when nobody is subscribed)
+static void PublishEvent(const AgentSession& session, windbg_agent::AgentEvent event)
+{
+    auto& bus = windbg_agent::GetEventBus();
+    if (!bus.HasSubscribers())
+        return;
+    event.source = session.source;
+    bus.Publish(std::move(event));
+}
+
+// Mark the start of a query; its events are published with this source
+static void BeginQuery(AgentSession& session, const std::string& query, const char* source)
+{
+    session.source = source;
+    session.query_started = std::chrono::steady_clock::now();
+
+    windbg_agent::AgentEvent event;
+    event.type = windbg_agent::AgentEventType::QueryStarted;
+    event.text = query;
+    PublishEvent(session, std::move(event));
+}
+
+// Run a list of commands back-to-back, recording output, HRESULT and timing for each
+static std::vector<windbg_agent::ExecResult> ExecuteBatch(windbg_agent::WinDbgClient& dbg_client,
+                                                          const std::vector<std::string>& commands)
+{
+    std::vector<windbg_agent::ExecResult> results;
+    results.reserve(commands.size());
+
+    for (const auto& command : commands)
+    {
+        windbg_agent::ExecResult result;
+        result.command = command;
+
+        HRESULT hr = S_OK;
+        auto start = std::chrono::steady_clock::now();
+        result.output = dbg_client.ExecuteCommand(command, &hr);
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+        result.status = hr;
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+// Run a command, forwarding its output to on_chunk as it is produced
+static windbg_agent::ExecResult ExecuteStreaming(windbg_agent::WinDbgClient& dbg_client,
+                                                 const std::string& command,
+                                                 const windbg_agent::OutputChunkHandler& on_chunk)
+{
+    windbg_agent::ExecResult result;
+    result.command = command;
+
+    auto start = std::chrono::steady_clock::now();
+    result.status = dbg_client.ExecuteCommandStreaming(command, on_chunk);
+    result.elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+// Start or stop transcript recording to match settings; a new transcript is started
+// whenever the target changes
+static void SyncTranscript(windbg_agent::WinDbgClient& dbg_client,
+                           const windbg_agent::Settings& settings)
+{
+    auto& recorder = windbg_agent::GetTranscriptRecorder();
+    if (!settings.record_transcript)
+    {
+        recorder.Stop();
+        return;
+    }
+
+    windbg_agent::TranscriptHeader header;
+    header.target = dbg_client.GetTargetName();
+    header.architecture = dbg_client.GetTargetArchitecture();
+    header.debugger = dbg_client.GetDebuggerType();
+    header.pid = dbg_client.GetProcessId();
+    if (recorder.IsRecording() && recorder.header().target == header.target &&
+        recorder.header().pid == header.pid)
+        return;
+
+    std::time_t t = std::time(nullptr);
+    header.started_ms = static_cast<int64_t>(t) * 1000;
+    std::tm local_tm{};
+    localtime_s(&local_tm, &t);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_tm);
+
+    std::string dir = windbg_agent::GetSettingsDir() + "\\transcripts";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    std::string path = dir + "\\" + stamp + "_" + std::to_string(GetCurrentProcessId());
+
+    std::string error;
+    if (!recorder.Start(path, header, settings.transcript_compress, &error))
+        dbg_client.OutputWarning("Transcript recording disabled: " + error);
+}
+
+// The current query was interrupted, or cancelled through its own token (a job's)
+static bool QueryAborted(const AgentSession& session)
+{
+    return session.aborted.load() || (session.cancel && session.cancel->load());
+}
+
 static libagents::Tool BuildDebuggerTool(AgentSession& session)
 {
     return libagents::make_tool(
@@ -141,17 +322,52 @@ static libagents::Tool BuildDebuggerTool(AgentSession& session)
         "Use this to inspect the target process, memory, threads, exceptions, etc.",
         [&session](std::string command) -> std::string
         {
-            if (session.aborted.load())
+            if (QueryAborted(session))
                 return "(Aborted)";
 
             if (!session.dbg)
                 return "Error: No debugger client available";
 
-            return session.dbg->ExecuteCommand(command);
+            windbg_agent::AgentEvent event;
+            event.type = windbg_agent::AgentEventType::ToolStarted;
+            event.tool = "dbg_exec";
+            event.command = command;
+            PublishEvent(session, event);
+
+            auto start = std::chrono::steady_clock::now();
+            session.dbg->SetSource("ai");
+            std::string output = session.dbg->ExecuteCommand(command);
+
+            event.type = windbg_agent::AgentEventType::ToolFinished;
+            event.elapsed_ms = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+            event.bytes = output.size();
+            PublishEvent(session, std::move(event));
+
+            // Shape large output; the full text stays pageable via dbg_output_page
+            auto settings = windbg_agent::GetSettingsStore().Get();
+            return windbg_agent::ShapeOutput(std::move(output), settings->output_shaping).text;
         },
         {"command"});
 }
 
+static libagents::Tool BuildOutputPageTool()
+{
+    return libagents::make_tool(
+        "dbg_output_page",
+        "Fetch one page of a large dbg_exec output that was shortened. "
+        "Use the output_id and page range given in the shortened result.",
+        [](int output_id, int page) -> std::string
+        {
+            if (output_id <= 0 || page <= 0)
+                return "Error: output_id and page must be positive";
+            return windbg_agent::FormatOutputPage(static_cast<uint64_t>(output_id),
+                                                  static_cast<size_t>(page));
+        },
+        {"output_id", "page"});
+}
+
 static void ConfigureHost(AgentSession& session)
 {
     if (session.host_ready)
@@ -161,7 +377,7 @@ static void ConfigureHost(AgentSession& session)
     {
         if (session.dbg && session.dbg->IsInterrupted())
             session.aborted = true;
-        return session.aborted.load();
+        return QueryAborted(session);
     };
 
     session.host.on_event = [&session](const libagents::Event& event)
@@ -169,22 +385,32 @@ static void ConfigureHost(AgentSession& session)
         if (!session.dbg)
             return;
 
+        windbg_agent::AgentEvent published;
         switch (event.type)
         {
         case libagents::EventType::ContentDelta:
             session.dbg->OutputThinking(event.content);
+            published.type = windbg_agent::AgentEventType::ContentDelta;
+            published.text = event.content;
+            PublishEvent(session, std::move(published));
             break;
         case libagents::EventType::ContentComplete:
             session.dbg->Output("\n");
             session.dbg->OutputResponse(event.content.empty() ? "(No output)" : event.content);
+            published.type = windbg_agent::AgentEventType::ContentComplete;
+            published.text = event.content;
+            published.elapsed_ms = std::chrono::duration<double, std::milli>(
+                                       std::chrono::steady_clock::now() - session.query_started)
+                                       .count();
+            PublishEvent(session, std::move(published));
             break;
         case libagents::EventType::Error:
-            if (!event.error_message.empty())
-                session.dbg->OutputError(event.error_message);
-            else if (!event.content.empty())
-                session.dbg->OutputError(event.content);
-            else
-                session.dbg->OutputError("Error");
+            published.type = windbg_agent::AgentEventType::Error;
+            published.text = !event.error_message.empty() ? event.error_message
+                             : !event.content.empty()     ? event.content
+                                                          : "Error";
+            session.dbg->OutputError(published.text);
+            PublishEvent(session, std::move(published));
             break;
         default:
             break;
@@ -194,6 +420,81 @@ static void ConfigureHost(AgentSession& session)
     session.host_ready = true;
 }
 
+// Create, configure and initialize an agent. Runs on an AgentPool thread, so it must not
+// touch the debugger; the tools only reach it once the agent is queried.
+static std::unique_ptr<libagents::IAgent> CreateAgent(const windbg_agent::Settings& settings,
+                                                      std::string* error)
+{
+    auto agent = libagents::create_agent(settings.default_provider);
+    if (!agent)
+    {
+        *error = "Failed to create agent";
+        return nullptr;
+    }
+
+    agent->register_tool(BuildDebuggerTool(GetAgentSession()));
+    agent->register_tool(BuildOutputPageTool());
+
+    // Apply BYOK settings if enabled
+    const auto* byok = settings.get_byok();
+    if (byok && byok->is_usable())
+        agent->set_byok(byok->to_config());
+
+    // Apply response timeout setting
+    if (settings.response_timeout_ms > 0)
+        agent->set_response_timeout(std::chrono::milliseconds(settings.response_timeout_ms));
+
+    if (!agent->initialize())
+    {
+        *error = "Failed to initialize: " + agent->provider_name();
+        std::string last_error = agent->get_last_error();
+        if (!last_error.empty())
+            *error += " - " + last_error;
+        agent->shutdown();
+        return nullptr;
+    }
+    return agent;
+}
+
+static windbg_agent::AgentPool& GetAgentPool()
+{
+    static windbg_agent::AgentPool pool(CreateAgent);
+    return pool;
+}
+
+// Run the opening book once per target, so the first prime message already carries what
+// the agent would otherwise ask for one model round trip at a time
+static void PrefetchOpeningBook(AgentSession& session, windbg_agent::WinDbgClient& dbg_client,
+                                const windbg_agent::Settings& settings, const std::string& target)
+{
+    if (session.opening_target == target)
+        return;
+    session.opening_target = target;
+    session.opening_context.clear();
+    if (settings.opening_book.empty())
+        return;
+
+    dbg_client.SetSource("prefetch");
+    session.opening_context = windbg_agent::RunOpeningBook(dbg_client, settings.opening_book).text;
+}
+
+// Load module symbols on background engine clients, so the agent's first stack walk or
+// !analyze does not stall on symbol downloads (a no-op once this target is warming)
+static void StartSymbolPrefetch(windbg_agent::WinDbgClient& dbg_client,
+                                const windbg_agent::Settings& settings)
+{
+    if (settings.symbol_prefetch <= 0)
+        return;
+
+    std::string target =
+        dbg_client.GetTargetName() + "|" + std::to_string(dbg_client.GetProcessId());
+    windbg_agent::GetSymbolPrefetcher().Start(
+        target,
+        []() -> std::unique_ptr<windbg_agent::IDebuggerBackend>
+        { return windbg_agent::DbgEngBackend::CreateForThread(); },
+        static_cast<size_t>(settings.symbol_prefetch));
+}
+
 static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_client,
                         const windbg_agent::Settings& settings, const std::string& target,
                         const windbg_agent::RuntimeContext& runtime_ctx, std::string* error,
@@ -203,6 +504,7 @@ static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_c
         *created = false;
 
     session.dbg = &dbg_client;
+    StartSymbolPrefetch(dbg_client, settings);
 
     if (session.agent && session.provider != settings.default_provider)
         ResetAgentSession(session);
@@ -211,33 +513,28 @@ static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_c
     {
         session.provider = settings.default_provider;
         session.provider_name = libagents::provider_type_name(session.provider);
-        session.agent = libagents::create_agent(session.provider);
+
+        // Usually warmed already (at load or when the previous agent was taken); otherwise
+        // its start-up overlaps the opening book, which has to run here on the debugger thread
+        auto& pool = GetAgentPool();
+        pool.Warm(settings);
+        PrefetchOpeningBook(session, dbg_client, settings, target);
+        session.agent = pool.Take(settings, settings.agent_prewarm, error);
         if (!session.agent)
         {
-            if (error)
-                *error = "Failed to create agent";
-
+            ResetAgentSession(session);
             return false;
         }
-
-        session.agent->register_tool(BuildDebuggerTool(session));
-
-        session.system_prompt =
-            windbg_agent::GetFullSystemPrompt(settings.custom_prompt, runtime_ctx);
         session.primed = false; // will prepend on first user query instead of system_prompt
 
-        // Apply BYOK settings if enabled
-        const auto* byok = settings.get_byok();
-        if (byok && byok->is_usable())
-            session.agent->set_byok(byok->to_config());
-
-        // Apply response timeout setting
+        // The timeout can change after the agent was warmed
         if (settings.response_timeout_ms > 0)
             session.agent->set_response_timeout(
                 std::chrono::milliseconds(settings.response_timeout_ms));
 
 #if !WINDBG_AGENT_DISABLE_SESSIONS
         // Skip session resume when BYOK is enabled (not supported by BYOK providers)
+        const auto* byok = settings.get_byok();
         if (!(byok && byok->is_usable()))
         {
             session.session_id =
@@ -247,20 +544,6 @@ static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_c
         }
 #endif
 
-        if (!session.agent->initialize())
-        {
-            if (error)
-            {
-                *error = "Failed to initialize: " + session.agent->provider_name();
-                std::string last_error = session.agent->get_last_error();
-                if (!last_error.empty())
-                    *error += " - " + last_error;
-            }
-
-            ResetAgentSession(session);
-            return false;
-        }
-
         ConfigureHost(session);
         session.initialized = true;
 
@@ -268,13 +551,16 @@ static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_c
             *created = true;
     }
 
-    std::string updated_prompt =
-        windbg_agent::GetFullSystemPrompt(settings.custom_prompt, runtime_ctx);
-    if (updated_prompt != session.system_prompt)
+    // Only the stable prompt body is fingerprinted; volatile fields travel as a delta
+    auto prompt = windbg_agent::BuildPromptVersion(settings.custom_prompt, runtime_ctx);
+    if (prompt.fingerprint != session.prompt_fingerprint)
     {
-        session.system_prompt = updated_prompt;
+        session.system_prompt = std::move(prompt.body);
+        session.prompt_fingerprint = prompt.fingerprint;
         session.primed = false; // re-prime next turn with new prompt
     }
+    session.runtime_context = std::move(prompt.volatile_context);
+    session.runtime_key = std::move(prompt.volatile_key);
 
     if (session.target != target)
     {
@@ -301,9 +587,64 @@ static bool EnsureAgent(AgentSession& session, windbg_agent::WinDbgClient& dbg_c
         session.primed = false; // new target -> re-prime on next ask
     }
 
+    if (!session.primed)
+        PrefetchOpeningBook(session, dbg_client, settings, target);
+
     session.aborted = false;
     return true;
 }
+// Ask callback for the HTTP/MCP servers - routes through the same AI path as !agent ask.
+// Throws when the agent cannot be started or the query fails.
+static windbg_agent::AskCallback MakeAskCallback(AgentSession& session,
+                                                 windbg_agent::WinDbgClient& dbg_client,
+                                                 const windbg_agent::Settings& settings,
+                                                 const std::string& target, const char* source)
+{
+    return [&session, &dbg_client, &settings, &target,
+            source](const std::string& query, const std::atomic<bool>* cancel) -> std::string
+    {
+        auto runtime_ctx = GatherRuntimeContext(dbg_client);
+        std::string error;
+        bool created = false;
+        if (!EnsureAgent(session, dbg_client, settings, target, runtime_ctx, &error, &created))
+            throw std::runtime_error(error.empty() ? "Failed to initialize agent" : error);
+
+        std::string message = ComposeMessage(session, query);
+
+        BeginQuery(session, query, source);
+        session.cancel = cancel;
+        std::string response;
+        try
+        {
+            response = session.agent->query_hosted(message, session.host);
+        }
+        catch (...)
+        {
+            session.cancel = nullptr;
+            throw;
+        }
+        session.cancel = nullptr;
+        MarkPrimed(session);
+
+#if !WINDBG_AGENT_DISABLE_SESSIONS
+        const auto* byok_save = settings.get_byok();
+        if (!(byok_save && byok_save->is_usable()))
+        {
+            std::string new_session_id = session.agent->get_session_id();
+            std::string provider_name = libagents::provider_type_name(settings.default_provider);
+            if (!new_session_id.empty() && new_session_id != session.session_id)
+            {
+                windbg_agent::GetSessionStore().SetSessionId(target, provider_name,
+                                                               new_session_id);
+                session.session_id = new_session_id;
+                // Server runs for a long time - persist the new session id now
+                windbg_agent::GetSettingsStore().Flush();
+            }
+        }
+#endif
+        return response;
+    };
+}
 } // namespace
 
 // Extension entry point
@@ -311,19 +652,36 @@ extern "C" HRESULT CALLBACK DebugExtensionInitialize(PULONG Version, PULONG Flag
 {
     *Version = DEBUG_EXTENSION_VERSION(WINDBG_AGENT_VERSION_MAJOR, WINDBG_AGENT_VERSION_MINOR);
     *Flags = 0;
+
+    // Bring the provider up while the user is still getting oriented in the debugger
+    auto settings = windbg_agent::GetSettingsStore().Get();
+    if (settings->agent_prewarm)
+        GetAgentPool().Warm(*settings);
     return S_OK;
 }
 
 // Extension cleanup
 extern "C" void CALLBACK DebugExtensionUninitialize()
 {
+    windbg_agent::GetSymbolPrefetcher().Stop();
     ResetAgentSession(GetAgentSession());
+    GetAgentPool().Shutdown();
+    windbg_agent::OutputHub::DetachAll();
+    windbg_agent::StateWatcher::Uninstall();
+    windbg_agent::GetTranscriptRecorder().Stop();
+    windbg_agent::GetSettingsStore().Flush();
 }
 
 // Extension notification
 extern "C" void CALLBACK DebugExtensionNotify(ULONG Notify, ULONG64 Argument)
 {
-    // Could handle session changes here if needed
+    // Every notification (session active/inactive, target accessible/inaccessible) marks a
+    // change in debugger state, so cached command results may be stale
+    windbg_agent::GetResultCache().Invalidate();
+
+    // Symbol loads cannot make progress while the target runs or is gone
+    if (Notify == DEBUG_NOTIFY_SESSION_INACTIVE || Notify == DEBUG_NOTIFY_SESSION_INACCESSIBLE)
+        windbg_agent::GetSymbolPrefetcher().Cancel("target not accessible");
 }
 
 // Implementation
@@ -333,6 +691,23 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
     if (!control)
         return E_FAIL;
 
+    // From now on, state changes made outside the agent (commands typed in the debugger,
+    // module loads) also invalidate cached results
+    windbg_agent::StateWatcher::Install(Client);
+
+    // Coalesce all settings changes made by this command into one write on exit
+    struct SettingsFlush
+    {
+        ~SettingsFlush() { windbg_agent::GetSettingsStore().Flush(); }
+    } settings_flush;
+
+    // First use: start the provider now if it is not already warming (no-op otherwise)
+    {
+        auto settings = windbg_agent::GetSettingsStore().Get();
+        if (settings->agent_prewarm && !GetAgentSession().agent)
+            GetAgentPool().Warm(*settings);
+    }
+
     // Parse subcommand
     std::string args_str = Args ? Args : "";
 
@@ -362,7 +737,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
     // Handle subcommands
     if (subcmd.empty() || subcmd == "help")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
         const auto* byok = settings.get_byok();
         control->Output(
             DEBUG_OUTPUT_NORMAL,
@@ -386,6 +761,10 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
             "  timeout <ms>          Set response timeout (e.g., 120000 = 2 min)\n"
             "  http [bind_addr]      Start HTTP server for external tools (port auto-assigned)\n"
             "  mcp [bind_addr]       Start MCP server for MCP-compatible clients\n"
+            "  serve [bind_addr]     Start HTTP and MCP servers together on this session\n"
+            "  status                Show agent and symbol warm-up status\n"
+            "  stats                 Show command result cache statistics\n"
+            "  transcript [on|off]   Show or toggle recording of executed commands\n"
             "  byok                  Show BYOK (Bring Your Own Key) status\n"
             "  byok enable|disable   Enable or disable BYOK for current provider\n"
             "  byok key <value>      Set BYOK API key\n"
@@ -422,7 +801,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
     }
     else if (subcmd == "version")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
 
         if (rest == "prompt")
         {
@@ -445,9 +824,144 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
             control->Output(DEBUG_OUTPUT_NORMAL, "\nUse '!agent version prompt' to see the injected system prompt.\n");
         }
     }
+    else if (subcmd == "status")
+    {
+        auto settings = *windbg_agent::GetSettingsStore().Get();
+        const AgentSession& session = GetAgentSession();
+        const char* agent_state = "not running";
+        if (session.agent)
+            agent_state = session.primed ? "running, primed" : "running";
+        else if (GetAgentPool().IsReady(settings))
+            agent_state = "warmed up";
+        control->Output(DEBUG_OUTPUT_NORMAL,
+                        "Agent:\n"
+                        "  Provider:      %s (%s)\n"
+                        "  Target:        %s\n",
+                        libagents::provider_type_name(settings.default_provider), agent_state,
+                        session.target.empty() ? "(none yet)" : session.target.c_str());
+
+        auto symbols = windbg_agent::GetSymbolPrefetcher().GetStats();
+        control->Output(DEBUG_OUTPUT_NORMAL, "Symbol warm-up:\n");
+        if (symbols.workers == 0)
+        {
+            control->Output(DEBUG_OUTPUT_NORMAL, "  %s\n",
+                            settings.symbol_prefetch > 0 ? "Starts with the first agent session"
+                                                         : "Off (symbol_prefetch is 0)");
+        }
+        else
+        {
+            std::string state = symbols.running ? "running" : "done";
+            if (!symbols.stopped.empty())
+                state = "stopped: " + symbols.stopped;
+            std::string loading;
+            for (const auto& module : symbols.loading)
+                loading += (loading.empty() ? "" : ", ") + module;
+            control->Output(
+                DEBUG_OUTPUT_NORMAL,
+                "  State:         %s (%zu workers, %s)\n"
+                "  Modules:       %zu / %zu loaded, %zu failed (%zu on the faulting stack)\n",
+                state.c_str(), symbols.workers,
+                FormatDuration(static_cast<int>(symbols.elapsed_ms)).c_str(), symbols.loaded,
+                symbols.total, symbols.failed, symbols.priority);
+            if (!loading.empty())
+                control->Output(DEBUG_OUTPUT_NORMAL, "  Loading:       %s\n", loading.c_str());
+        }
+    }
+    else if (subcmd == "stats")
+    {
+        auto stats = windbg_agent::GetResultCache().GetStats();
+        uint64_t lookups = stats.hits + stats.misses;
+        double hit_rate = lookups ? 100.0 * static_cast<double>(stats.hits) / lookups : 0.0;
+        control->Output(DEBUG_OUTPUT_NORMAL,
+                        "Command result cache:\n"
+                        "  Entries:       %zu (%.1f KB)\n"
+                        "  Hits/misses:   %llu / %llu (%.1f%% hit rate)\n"
+                        "  Time saved:    %s\n"
+                        "  Invalidations: %llu (state epoch %llu)\n",
+                        stats.entries, static_cast<double>(stats.bytes) / 1024.0,
+                        static_cast<unsigned long long>(stats.hits),
+                        static_cast<unsigned long long>(stats.misses), hit_rate,
+                        FormatDuration(static_cast<int>(stats.saved_ms)).c_str(),
+                        static_cast<unsigned long long>(stats.invalidations),
+                        static_cast<unsigned long long>(stats.epoch));
+
+        const auto& ring = windbg_agent::GetOutputRing();
+        control->Output(DEBUG_OUTPUT_NORMAL,
+                        "Output ring:\n"
+                        "  Published:     %llu chunks (%.1f KB), %zu slots\n",
+                        static_cast<unsigned long long>(ring.published_slots()),
+                        static_cast<double>(ring.published_bytes()) / 1024.0, ring.capacity());
+
+        auto memory = windbg_agent::GetMemoryCache().GetStats();
+        uint64_t page_lookups = memory.page_hits + memory.page_misses;
+        control->Output(DEBUG_OUTPUT_NORMAL,
+                        "Memory page cache:\n"
+                        "  Pages:         %zu (%.1f KB)\n"
+                        "  Hits/misses:   %llu / %llu pages (%.1f%% hit rate)\n"
+                        "  Ranges:        %llu in %llu spans, %llu reads (%.1f KB)\n"
+                        "  Invalidations: %llu\n",
+                        memory.pages,
+                        static_cast<double>(memory.pages * windbg_agent::MemoryPageCache::kPageSize) /
+                            1024.0,
+                        static_cast<unsigned long long>(memory.page_hits),
+                        static_cast<unsigned long long>(memory.page_misses),
+                        page_lookups ? 100.0 * static_cast<double>(memory.page_hits) / page_lookups
+                                     : 0.0,
+                        static_cast<unsigned long long>(memory.ranges),
+                        static_cast<unsigned long long>(memory.spans),
+                        static_cast<unsigned long long>(memory.backend_reads),
+                        static_cast<double>(memory.bytes_read) / 1024.0,
+                        static_cast<unsigned long long>(memory.invalidations));
+
+        auto index = windbg_agent::GetAddressIndex().GetStats();
+        control->Output(DEBUG_OUTPUT_NORMAL,
+                        "Address index:\n"
+                        "  Entries:       %zu modules, %zu regions, %zu symbols\n"
+                        "  Lookups:       %llu (symbol hits/misses %llu / %llu)\n"
+                        "  Builds:        %llu (last %.1f ms)\n",
+                        index.modules, index.regions, index.symbols,
+                        static_cast<unsigned long long>(index.lookups),
+                        static_cast<unsigned long long>(index.symbol_hits),
+                        static_cast<unsigned long long>(index.symbol_misses),
+                        static_cast<unsigned long long>(index.builds), index.build_ms);
+    }
+    else if (subcmd == "transcript")
+    {
+        auto settings = *windbg_agent::GetSettingsStore().Get();
+        if (rest == "on" || rest == "off")
+        {
+            settings.record_transcript = rest == "on";
+            windbg_agent::GetSettingsStore().Set(settings);
+            windbg_agent::WinDbgClient dbg_client(Client);
+            SyncTranscript(dbg_client, settings);
+        }
+        else if (!rest.empty())
+        {
+            control->Output(DEBUG_OUTPUT_ERROR, "Usage: !agent transcript [on|off]\n");
+            control->Release();
+            return E_INVALIDARG;
+        }
+
+        auto& recorder = windbg_agent::GetTranscriptRecorder();
+        control->Output(DEBUG_OUTPUT_NORMAL, "Transcript recording: %s\n",
+                        settings.record_transcript ? "on" : "off");
+        if (recorder.IsRecording())
+        {
+            control->Output(DEBUG_OUTPUT_NORMAL,
+                            "  File:    %s\n"
+                            "  Records: %llu (%.1f KB)\n",
+                            recorder.path().c_str(),
+                            static_cast<unsigned long long>(recorder.records()),
+                            static_cast<double>(recorder.bytes()) / 1024.0);
+        }
+        else if (!recorder.error().empty())
+        {
+            control->Output(DEBUG_OUTPUT_WARNING, "  %s\n", recorder.error().c_str());
+        }
+    }
     else if (subcmd == "provider")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
 
         if (rest.empty())
         {
@@ -467,8 +981,10 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
                 if (type != settings.default_provider)
                 {
                     settings.default_provider = type;
-                    windbg_agent::SaveSettings(settings);
+                    windbg_agent::GetSettingsStore().Set(settings);
                     ResetAgentSession(GetAgentSession());
+                    if (settings.agent_prewarm)
+                        GetAgentPool().Warm(settings);
                 }
                 control->Output(DEBUG_OUTPUT_NORMAL, "Provider set to: %s (saved to settings)\n",
                                 libagents::provider_type_name(type));
@@ -482,24 +998,22 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
     }
     else if (subcmd == "clear")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
         windbg_agent::WinDbgClient dbg_client(Client);
         std::string target = dbg_client.GetTargetName();
         std::string provider_name = libagents::provider_type_name(settings.default_provider);
 
-        auto& session = GetAgentSession();
-        if (session.agent)
-        {
-            session.agent->clear_session();
-            session.session_id.clear();
-        }
+        // Swap in a fresh agent (usually already warm) instead of restarting this one
         windbg_agent::GetSessionStore().ClearSession(target, provider_name);
+        ResetAgentSession(GetAgentSession());
+        if (settings.agent_prewarm)
+            GetAgentPool().Warm(settings);
         control->Output(DEBUG_OUTPUT_NORMAL,
                         "Conversation history cleared (new session for this target).\n");
     }
     else if (subcmd == "prompt")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
 
         if (rest.empty())
         {
@@ -516,31 +1030,21 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         else if (rest == "clear")
         {
             settings.custom_prompt.clear();
-            windbg_agent::SaveSettings(settings);
-            auto& session = GetAgentSession();
-            if (session.agent)
-            {
-                session.system_prompt = windbg_agent::GetFullSystemPrompt(settings.custom_prompt);
-                session.primed = false; // re-prime next turn
-            }
+            windbg_agent::GetSettingsStore().Set(settings);
+            // The prompt fingerprint covers the custom prompt, so the next turn re-primes
             control->Output(DEBUG_OUTPUT_NORMAL, "Custom prompt cleared.\n");
         }
         else
         {
             settings.custom_prompt = rest;
-            windbg_agent::SaveSettings(settings);
-            auto& session = GetAgentSession();
-            if (session.agent)
-            {
-                session.system_prompt = windbg_agent::GetFullSystemPrompt(settings.custom_prompt);
-                session.primed = false; // re-prime next turn
-            }
+            windbg_agent::GetSettingsStore().Set(settings);
+            // The prompt fingerprint covers the custom prompt, so the next turn re-primes
             control->Output(DEBUG_OUTPUT_NORMAL, "Custom prompt set (saved to settings).\n");
         }
     }
     else if (subcmd == "timeout")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
 
         if (rest.empty())
         {
@@ -560,7 +1064,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
                 else
                 {
                     settings.response_timeout_ms = ms;
-                    windbg_agent::SaveSettings(settings);
+                    windbg_agent::GetSettingsStore().Set(settings);
                     auto& session = GetAgentSession();
                     if (session.agent)
                         session.agent->set_response_timeout(std::chrono::milliseconds(ms));
@@ -576,7 +1080,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
     }
     else if (subcmd == "byok")
     {
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
         std::string provider_name = libagents::provider_type_name(settings.default_provider);
 
         // Parse BYOK subcommand
@@ -635,7 +1139,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         {
             auto& byok = settings.get_or_create_byok();
             byok.enabled = true;
-            windbg_agent::SaveSettings(settings);
+            windbg_agent::GetSettingsStore().Set(settings);
             ResetAgentSession(GetAgentSession());
             control->Output(DEBUG_OUTPUT_NORMAL, "BYOK enabled for provider '%s'.\n",
                             provider_name.c_str());
@@ -650,7 +1154,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         {
             auto& byok = settings.get_or_create_byok();
             byok.enabled = false;
-            windbg_agent::SaveSettings(settings);
+            windbg_agent::GetSettingsStore().Set(settings);
             ResetAgentSession(GetAgentSession());
             control->Output(DEBUG_OUTPUT_NORMAL, "BYOK disabled for provider '%s'.\n",
                             provider_name.c_str());
@@ -666,7 +1170,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
             {
                 auto& byok = settings.get_or_create_byok();
                 byok.api_key = byok_value;
-                windbg_agent::SaveSettings(settings);
+                windbg_agent::GetSettingsStore().Set(settings);
                 ResetAgentSession(GetAgentSession());
                 control->Output(DEBUG_OUTPUT_NORMAL, "BYOK API key set for provider '%s'.\n",
                                 provider_name.c_str());
@@ -676,7 +1180,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         {
             auto& byok = settings.get_or_create_byok();
             byok.base_url = byok_value; // Empty clears it
-            windbg_agent::SaveSettings(settings);
+            windbg_agent::GetSettingsStore().Set(settings);
             ResetAgentSession(GetAgentSession());
             if (byok_value.empty())
             {
@@ -692,7 +1196,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         {
             auto& byok = settings.get_or_create_byok();
             byok.model = byok_value; // Empty clears it
-            windbg_agent::SaveSettings(settings);
+            windbg_agent::GetSettingsStore().Set(settings);
             ResetAgentSession(GetAgentSession());
             if (byok_value.empty())
                 control->Output(DEBUG_OUTPUT_NORMAL, "BYOK model cleared (using default).\n");
@@ -703,7 +1207,7 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         {
             auto& byok = settings.get_or_create_byok();
             byok.provider_type = byok_value; // Empty clears it
-            windbg_agent::SaveSettings(settings);
+            windbg_agent::GetSettingsStore().Set(settings);
             ResetAgentSession(GetAgentSession());
             if (byok_value.empty())
                 control->Output(DEBUG_OUTPUT_NORMAL, "BYOK type cleared (using default).\n");
@@ -717,15 +1221,19 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
             control->Output(DEBUG_OUTPUT_NORMAL, "Use '!agent byok' to see available commands.\n");
         }
     }
-    else if (subcmd == "http")
+    else if (subcmd == "http" || subcmd == "mcp" || subcmd == "serve")
     {
-        // Start HTTP server for external tool integration
-        // Usage: !agent http [bind_addr]
+        // Start HTTP and/or MCP servers for external tool integration
+        // Usage: !agent http|mcp|serve [bind_addr]
+        // "serve" starts both; all servers share one command broker, so clients of either
+        // transport drive the same debugger session concurrently.
         // bind_addr: "127.0.0.1" (default, localhost only) or "0.0.0.0" (all interfaces)
         windbg_agent::WinDbgClient dbg_client(Client);
-        auto settings = windbg_agent::LoadSettings();
+        auto settings = *windbg_agent::GetSettingsStore().Get();
         auto& session = GetAgentSession();
         std::string target = dbg_client.GetTargetName();
+        bool want_http = subcmd != "mcp";
+        bool want_mcp = subcmd != "http";
 
         // Parse optional bind address
         std::string bind_addr = "127.0.0.1";
@@ -746,229 +1254,149 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
                 "The server has no authentication.\n", bind_addr.c_str());
         }
 
+        // Remote clients read output from the response; echoing it is optional
+        dbg_client.SetEchoOutput(settings.server_echo);
+        SyncTranscript(dbg_client, settings);
+
         // Get target state
         std::string state = dbg_client.GetTargetState();
         ULONG pid = dbg_client.GetProcessId();
 
-        // Create exec callback - executes debugger commands
-        windbg_agent::ExecCallback exec_cb = [&dbg_client](const std::string& command) -> std::string
+        // Create exec callbacks - executes debugger commands, tagged with the server they
+        // came from (all run on this thread, so setting the source per call is safe)
+        auto make_exec_cb = [&dbg_client](std::string source) -> windbg_agent::ExecCallback
         {
-            return dbg_client.ExecuteCommand(command);
+            return [&dbg_client, source](const std::string& command) -> std::string
+            {
+                dbg_client.SetSource(source);
+                return dbg_client.ExecuteCommand(command);
+            };
         };
 
-        // Create ask callback - routes through same AI path as !agent ask
-        windbg_agent::AskCallback ask_cb = [Client, &settings, &session, &dbg_client,
-                                              &target](const std::string& query) -> std::string
+        // Create batch callbacks - runs a list of commands in one main-thread slot
+        auto make_exec_batch_cb =
+            [&dbg_client](std::string source) -> windbg_agent::ExecBatchCallback
         {
-            auto runtime_ctx = GatherRuntimeContext(dbg_client);
-            std::string error;
-            bool created = false;
-            if (!EnsureAgent(session, dbg_client, settings, target, runtime_ctx, &error, &created))
-            {
-                return error.empty() ? "Failed to initialize agent" : error;
-            }
-
-            try
+            return [&dbg_client, source](const std::vector<std::string>& commands)
             {
-                std::string message =
-                    session.primed || session.system_prompt.empty()
-                        ? query
-                        : (session.system_prompt + "\n\n---\n\n" + query);
-
-                std::string response = session.agent->query_hosted(message, session.host);
-                session.primed = true;
-
-#if !WINDBG_AGENT_DISABLE_SESSIONS
-                const auto* byok_save = settings.get_byok();
-                if (!(byok_save && byok_save->is_usable()))
-                {
-                    std::string new_session_id = session.agent->get_session_id();
-                    std::string provider_name =
-                        libagents::provider_type_name(settings.default_provider);
-                    if (!new_session_id.empty() && new_session_id != session.session_id)
-                    {
-                        windbg_agent::GetSessionStore().SetSessionId(target, provider_name,
-                                                                       new_session_id);
-                        session.session_id = new_session_id;
-                    }
-                }
-#endif
-                return response;
-            }
-            catch (const std::exception& e)
-            {
-                return std::string("Error: ") + e.what();
-            }
+                dbg_client.SetSource(source);
+                return ExecuteBatch(dbg_client, commands);
+            };
         };
 
-        // Start the HTTP server (OS assigns port)
-        static windbg_agent::HttpServer http_server;
-        if (http_server.is_running())
-        {
-            control->Output(DEBUG_OUTPUT_ERROR,
-                            "HTTP server already running. Stop it before starting a new one.\n");
-            control->Release();
-            return E_FAIL;
-        }
-        int actual_port = http_server.start(exec_cb, ask_cb, bind_addr);
-        if (actual_port <= 0)
+        // Create streaming callback - forwards output chunks while the command runs
+        windbg_agent::ExecStreamCallback exec_stream_cb =
+            [&dbg_client](const std::string& command,
+                          const windbg_agent::OutputChunkHandler& on_chunk)
         {
-            control->Output(DEBUG_OUTPUT_ERROR,
-                            "Failed to start HTTP server.\n");
-            control->Release();
-            return E_FAIL;
-        }
-        std::string url = "http://" + http_server.bind_addr() + ":" + std::to_string(http_server.port());
-
-        // Format and output HTTP server info
-        std::string http_info =
-            windbg_agent::format_http_info(target, pid, state, url);
-        control->Output(DEBUG_OUTPUT_NORMAL, "%s\n", http_info.c_str());
+            dbg_client.SetSource("http");
+            return ExecuteStreaming(dbg_client, command, on_chunk);
+        };
 
-        // Copy to clipboard
-        if (windbg_agent::copy_to_clipboard(http_info))
-        {
-            control->Output(DEBUG_OUTPUT_NORMAL, "[Copied to clipboard]\n");
-        }
+        // Create query callback - structured JSON read straight from the engine
+        windbg_agent::QueryCallback query_cb =
+            [&dbg_client](const windbg_agent::QueryRequest& request)
+        { return windbg_agent::RunQuery(dbg_client, request); };
 
-        control->Output(DEBUG_OUTPUT_NORMAL, "Press Ctrl+C to stop HTTP server.\n");
+        // Create memory callback - raw bytes through the page cache
+        windbg_agent::MemoryReadCallback memory_cb =
+            [&dbg_client](const std::vector<windbg_agent::MemoryRangeRequest>& ranges)
+        { return dbg_client.ReadMemory(ranges); };
 
-        // Set up interrupt check - stop server when user presses Ctrl+C
-        http_server.set_interrupt_check([&dbg_client]() {
-            return dbg_client.IsInterrupted();
-        });
+        // Create symbolize callback - batch address lookups through the address index
+        windbg_agent::SymbolizeCallback symbolize_cb =
+            [&dbg_client](const windbg_agent::SymbolizeRequest& request)
+        { return dbg_client.Symbolize(request); };
 
-        // Block until server stops (user presses Ctrl+C or sends /shutdown)
-        http_server.wait();
-        control->Output(DEBUG_OUTPUT_NORMAL, "HTTP server stopped.\n");
-    }
-    else if (subcmd == "mcp")
-    {
-        // Start MCP server for MCP-compatible clients
-        // Usage: !agent mcp [bind_addr]
-        // bind_addr: "127.0.0.1" (default, localhost only) or "0.0.0.0" (all interfaces)
-        windbg_agent::WinDbgClient dbg_client(Client);
-        auto settings = windbg_agent::LoadSettings();
-        auto& session = GetAgentSession();
-        std::string target = dbg_client.GetTargetName();
+        // Create scan callback - native pattern search, hits streamed as they are found
+        windbg_agent::MemoryScanCallback scan_cb =
+            [&dbg_client](const windbg_agent::MemoryScanRequest& request,
+                          const windbg_agent::ScanHitHandler& on_hits)
+        { return dbg_client.SearchMemory(request, on_hits); };
 
-        // Parse optional bind address
-        std::string bind_addr = "127.0.0.1";
-        if (!rest.empty())
-        {
-            bind_addr = rest;
-            size_t start = bind_addr.find_first_not_of(" \t");
-            size_t end = bind_addr.find_last_not_of(" \t");
-            if (start != std::string::npos)
-                bind_addr = bind_addr.substr(start, end - start + 1);
-        }
-
-        if (bind_addr != "127.0.0.1")
+        static windbg_agent::HttpServer http_server;
+        static windbg_agent::MCPServer mcp_server;
+        if ((want_http && http_server.is_running()) || (want_mcp && mcp_server.is_running()))
         {
-            control->Output(DEBUG_OUTPUT_WARNING,
-                "WARNING: Binding to non-loopback address '%s'. "
-                "The server has no authentication.\n", bind_addr.c_str());
+            control->Output(DEBUG_OUTPUT_ERROR,
+                            "Server already running. Stop it before starting a new one.\n");
+            control->Release();
+            return E_FAIL;
         }
 
-        // Port 0 lets the MCP server pick a free port
-        int port = 0;
-        std::string url;
+        auto& broker = windbg_agent::GetCommandBroker();
+        std::string server_info;
 
-        // Get target state
-        std::string state = dbg_client.GetTargetState();
-        ULONG pid = dbg_client.GetProcessId();
-
-        // Create exec callback - executes debugger commands
-        windbg_agent::ExecCallback exec_cb = [&dbg_client](const std::string& command) -> std::string
+        if (want_http)
         {
-            return dbg_client.ExecuteCommand(command);
-        };
-
-        // Create ask callback - routes through same AI path as !agent ask
-        windbg_agent::AskCallback ask_cb = [Client, &settings, &session, &dbg_client,
-                                              &target](const std::string& query) -> std::string
-        {
-            auto runtime_ctx = GatherRuntimeContext(dbg_client);
-            std::string error;
-            bool created = false;
-            if (!EnsureAgent(session, dbg_client, settings, target, runtime_ctx, &error, &created))
+            http_server.set_query_callback(query_cb);
+            http_server.set_memory_callback(memory_cb);
+            http_server.set_symbolize_callback(symbolize_cb);
+            http_server.set_scan_callback(scan_cb);
+
+            // Start the HTTP server (OS assigns port)
+            int actual_port = http_server.start(broker, make_exec_cb("http"),
+                                                MakeAskCallback(session, dbg_client, settings,
+                                                                target, "http"),
+                                                make_exec_batch_cb("http"), exec_stream_cb,
+                                                bind_addr);
+            if (actual_port <= 0)
             {
-                return error.empty() ? "Failed to initialize agent" : error;
+                control->Output(DEBUG_OUTPUT_ERROR, "Failed to start HTTP server.\n");
+                control->Release();
+                return E_FAIL;
             }
+            std::string url =
+                "http://" + http_server.bind_addr() + ":" + std::to_string(http_server.port());
+            server_info += windbg_agent::format_http_info(target, pid, state, url);
+        }
 
-            try
-            {
-                std::string message =
-                    session.primed || session.system_prompt.empty()
-                        ? query
-                        : (session.system_prompt + "\n\n---\n\n" + query);
-
-                std::string response = session.agent->query_hosted(message, session.host);
-                session.primed = true;
-
-#if !WINDBG_AGENT_DISABLE_SESSIONS
-                const auto* byok_save = settings.get_byok();
-                if (!(byok_save && byok_save->is_usable()))
-                {
-                    std::string new_session_id = session.agent->get_session_id();
-                    std::string provider_name =
-                        libagents::provider_type_name(settings.default_provider);
-                    if (!new_session_id.empty() && new_session_id != session.session_id)
-                    {
-                        windbg_agent::GetSessionStore().SetSessionId(target, provider_name,
-                                                                       new_session_id);
-                        session.session_id = new_session_id;
-                    }
-                }
-#endif
-                return response;
-            }
-            catch (const std::exception& e)
+        if (want_mcp)
+        {
+            mcp_server.set_query_callback(query_cb);
+            mcp_server.set_memory_callback(memory_cb);
+            mcp_server.set_symbolize_callback(symbolize_cb);
+            mcp_server.set_scan_callback(scan_cb);
+
+            // Port 0 lets the MCP server pick a free port
+            int actual_port = mcp_server.start(0, broker, make_exec_cb("mcp"),
+                                               MakeAskCallback(session, dbg_client, settings,
+                                                               target, "mcp"),
+                                               make_exec_batch_cb("mcp"), bind_addr);
+            if (actual_port <= 0)
             {
-                return std::string("Error: ") + e.what();
+                control->Output(DEBUG_OUTPUT_ERROR, "Failed to start MCP server.\n");
+                http_server.stop();
+                control->Release();
+                return E_FAIL;
             }
-        };
-
-        // Start the MCP server
-        static windbg_agent::MCPServer mcp_server;
-        if (mcp_server.is_running())
-        {
-            control->Output(DEBUG_OUTPUT_ERROR,
-                            "MCP server already running. Stop it before starting a new one.\n");
-            control->Release();
-            return E_FAIL;
-        }
-        int actual_port = mcp_server.start(port, exec_cb, ask_cb, bind_addr);
-        if (actual_port <= 0)
-        {
-            control->Output(DEBUG_OUTPUT_ERROR,
-                            "Failed to start MCP server.\n");
-            control->Release();
-            return E_FAIL;
+            std::string url = "http://" + bind_addr + ":" + std::to_string(actual_port);
+            if (!server_info.empty())
+                server_info += "\n";
+            server_info += windbg_agent::format_mcp_info(target, pid, state, url);
         }
-        url = "http://" + bind_addr + ":" + std::to_string(actual_port);
 
-        // Format and output MCP server info
-        std::string mcp_info =
-            windbg_agent::format_mcp_info(target, pid, state, url);
-        control->Output(DEBUG_OUTPUT_NORMAL, "%s\n", mcp_info.c_str());
+        // Format and output server info
+        control->Output(DEBUG_OUTPUT_NORMAL, "%s\n", server_info.c_str());
 
         // Copy to clipboard
-        if (windbg_agent::copy_to_clipboard(mcp_info))
+        if (windbg_agent::copy_to_clipboard(server_info))
         {
             control->Output(DEBUG_OUTPUT_NORMAL, "[Copied to clipboard]\n");
         }
 
-        control->Output(DEBUG_OUTPUT_NORMAL, "Press Ctrl+C to stop MCP server.\n");
-
-        // Set up interrupt check - stop MCP server when user presses Ctrl+C
-        mcp_server.set_interrupt_check([&dbg_client]() {
-            return dbg_client.IsInterrupted();
-        });
-
-        // Block until server stops (user presses Ctrl+C)
-        mcp_server.wait();
-        control->Output(DEBUG_OUTPUT_NORMAL, "MCP server stopped.\n");
+        control->Output(DEBUG_OUTPUT_NORMAL, "Press Ctrl+C to stop %s.\n",
+                        subcmd == "serve" ? "servers" : (want_http ? "HTTP server" : "MCP server"));
+
+        // Process commands from all servers on this thread until Ctrl+C or every server
+        // has stopped (e.g. HTTP /shutdown)
+        broker.Run([&dbg_client]() { return dbg_client.IsInterrupted(); });
+        auto stats = broker.GetStats();
+        http_server.stop();
+        mcp_server.stop();
+        control->Output(DEBUG_OUTPUT_NORMAL, "%s stopped (%s).\n",
+                        subcmd == "serve" ? "Servers" : (want_http ? "HTTP server" : "MCP server"),
+                        FormatBrokerStats(stats).c_str());
     }
     else if (subcmd == "ask")
     {
@@ -980,10 +1408,20 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
         else
         {
             windbg_agent::WinDbgClient dbg_client(Client);
-            auto settings = windbg_agent::LoadSettings();
+            auto settings = *windbg_agent::GetSettingsStore().Get();
             auto& session = GetAgentSession();
             std::string target = dbg_client.GetTargetName();
             auto runtime_ctx = GatherRuntimeContext(dbg_client);
+            SyncTranscript(dbg_client, settings);
+
+            // Only a provider that is still starting makes the user wait here
+            if ((!session.agent || session.provider != settings.default_provider) &&
+                !GetAgentPool().IsReady(settings))
+            {
+                dbg_client.OutputThinking(std::string("Waiting for ") +
+                                          libagents::provider_type_name(settings.default_provider) +
+                                          " to start...");
+            }
 
             std::string error;
             bool created = false;
@@ -1001,13 +1439,11 @@ HRESULT CALLBACK agent_impl(PDEBUG_CLIENT Client, PCSTR Args)
 
             try
             {
-                std::string message =
-                    session.primed || session.system_prompt.empty()
-                        ? rest
-                        : (session.system_prompt + "\n\n---\n\n" + rest);
+                std::string message = ComposeMessage(session, rest);
 
+                BeginQuery(session, rest, "console");
                 std::string response = session.agent->query_hosted(message, session.host);
-                session.primed = true;
+                MarkPrimed(session);
                 if (response == "(Aborted)")
                     dbg_client.OutputWarning("Aborted.");
 
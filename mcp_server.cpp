@@ -1,4 +1,5 @@
 #include "mcp_server.hpp"
+#include "debug_query.hpp"
 
 #include <fastmcpp/mcp/handler.hpp>
 #include <fastmcpp/server/sse_server.hpp>
@@ -6,6 +7,7 @@
 #include <fastmcpp/tools/tool.hpp>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 
@@ -26,46 +28,107 @@ MCPServer::~MCPServer() {
 }
 
 MCPQueueResult MCPServer::queue_and_wait(MCPPendingCommand::Type type, const std::string& input) {
-    if (!running_.load()) {
-        return {false, "Error: MCP server is not running"};
-    }
-
     MCPPendingCommand cmd;
     cmd.type = type;
     cmd.input = input;
-    cmd.completed = false;
+    return enqueue_and_wait(cmd);
+}
 
-    std::mutex done_mutex;
-    std::condition_variable done_cv;
-    cmd.done_mutex = &done_mutex;
-    cmd.done_cv = &done_cv;
+MCPQueueResult MCPServer::queue_batch_and_wait(const std::vector<std::string>& commands,
+                                               std::vector<ExecResult>& results) {
+    MCPPendingCommand cmd;
+    cmd.type = MCPPendingCommand::Type::ExecBatch;
+    cmd.batch_input = commands;
+    MCPQueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.batch_result);
+    return result;
+}
 
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        pending_commands_.push(&cmd);
-    }
-    queue_cv_.notify_one();
+MCPQueueResult MCPServer::queue_query_and_wait(const QueryRequest& request) {
+    MCPPendingCommand cmd;
+    cmd.type = MCPPendingCommand::Type::Query;
+    cmd.query = request;
+    return enqueue_and_wait(cmd);
+}
+
+MCPQueueResult MCPServer::queue_memory_and_wait(const std::vector<MemoryRangeRequest>& ranges,
+                                                std::vector<MemoryRangeResult>& results) {
+    MCPPendingCommand cmd;
+    cmd.type = MCPPendingCommand::Type::Memory;
+    cmd.memory_input = ranges;
+    MCPQueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.memory_result);
+    return result;
+}
+
+MCPQueueResult MCPServer::queue_symbolize_and_wait(const SymbolizeRequest& request,
+                                                   std::vector<SymbolizeResult>& results) {
+    MCPPendingCommand cmd;
+    cmd.type = MCPPendingCommand::Type::Symbolize;
+    cmd.symbolize_input = request;
+    MCPQueueResult result = enqueue_and_wait(cmd);
+    results = std::move(cmd.symbolize_result);
+    return result;
+}
+
+MCPQueueResult MCPServer::queue_scan_and_wait(const MemoryScanRequest& request,
+                                              ScanHitHandler on_hits, MemoryScanResult& result) {
+    MCPPendingCommand cmd;
+    cmd.type = MCPPendingCommand::Type::Scan;
+    cmd.scan_input = request;
+    cmd.on_hits = std::move(on_hits);
+    MCPQueueResult queue_result = enqueue_and_wait(cmd);
+    result = std::move(cmd.scan_result);
+    return queue_result;
+}
 
-    {
-        std::unique_lock<std::mutex> lock(done_mutex);
-        done_cv.wait(lock, [&]() { return cmd.completed || !running_.load(); });
+MCPQueueResult MCPServer::enqueue_and_wait(MCPPendingCommand& cmd) {
+    if (!running_.load()) {
+        return {false, "Error: MCP server is not running"};
     }
 
-    if (!cmd.completed) {
+    if (!broker_->Dispatch(source_.load(), [this, &cmd]() { execute_command(cmd); })) {
         return {false, "Error: MCP server stopped"};
     }
 
-    return {true, cmd.result};
+    return {!cmd.failed, cmd.result};
 }
 
-int MCPServer::start(int port, ExecCallback exec_cb, AskCallback ask_cb,
-                     const std::string& bind_addr) {
+void MCPServer::execute_command(MCPPendingCommand& cmd) {
+    try {
+        if (cmd.type == MCPPendingCommand::Type::Exec && exec_cb_) {
+            cmd.result = exec_cb_(cmd.input);
+        } else if (cmd.type == MCPPendingCommand::Type::ExecBatch && exec_batch_cb_) {
+            cmd.batch_result = exec_batch_cb_(cmd.batch_input);
+        } else if (cmd.type == MCPPendingCommand::Type::Ask && ask_cb_) {
+            cmd.result = ask_cb_(cmd.input, nullptr);
+        } else if (cmd.type == MCPPendingCommand::Type::Query && query_cb_) {
+            cmd.result = query_cb_(cmd.query);
+        } else if (cmd.type == MCPPendingCommand::Type::Memory && memory_cb_) {
+            cmd.memory_result = memory_cb_(cmd.memory_input);
+        } else if (cmd.type == MCPPendingCommand::Type::Symbolize && symbolize_cb_) {
+            cmd.symbolize_result = symbolize_cb_(cmd.symbolize_input);
+        } else if (cmd.type == MCPPendingCommand::Type::Scan && scan_cb_) {
+            cmd.scan_result = scan_cb_(cmd.scan_input, cmd.on_hits);
+        } else {
+            cmd.result = "Error: No handler for command type";
+            cmd.failed = true;
+        }
+    } catch (const std::exception& e) {
+        cmd.result = std::string("Error: ") + e.what();
+        cmd.failed = true;
+    }
+}
+
+int MCPServer::start(int port, CommandBroker& broker, ExecCallback exec_cb, AskCallback ask_cb,
+                     ExecBatchCallback exec_batch_cb, const std::string& bind_addr) {
     if (running_.load()) {
         return port_;
     }
 
     exec_cb_ = exec_cb;
     ask_cb_ = ask_cb;
+    exec_batch_cb_ = exec_batch_cb;
     bind_addr_ = bind_addr;
 
     impl_ = std::make_unique<Impl>();
@@ -119,6 +182,85 @@ int MCPServer::start(int port, ExecCallback exec_cb, AskCallback ask_cb,
     dbg_exec_tool.set_description("Execute a WinDbg/CDB debugger command and return its output");
     impl_->tool_manager.register_tool(dbg_exec_tool);
 
+    // Register dbg_exec_batch tool
+    Json batch_input_schema = {
+        {"type", "object"},
+        {"properties", {
+            {"commands", {
+                {"type", "array"},
+                {"items", {{"type", "string"}}},
+                {"description", "Ordered list of debugger commands to run back-to-back (e.g., ['k', 'r', 'lm'])"}
+            }}
+        }},
+        {"required", Json::array({"commands"})}
+    };
+
+    Json batch_output_schema = {
+        {"type", "object"},
+        {"properties", {
+            {"results", {{"type", "array"}}},
+            {"success", {{"type", "boolean"}}}
+        }}
+    };
+
+    fastmcpp::tools::Tool dbg_exec_batch_tool{
+        "dbg_exec_batch",
+        batch_input_schema,
+        batch_output_schema,
+        [this](const Json& args) -> Json {
+            std::vector<std::string> commands;
+            size_t items = 0;
+            if (args.contains("commands") && args["commands"].is_array()) {
+                items = args["commands"].size();
+                for (const auto& item : args["commands"]) {
+                    if (item.is_string() && !item.get<std::string>().empty()) {
+                        commands.push_back(item.get<std::string>());
+                    }
+                }
+            }
+
+            // Reject the whole batch on a bad item, as /exec_batch does
+            if (commands.empty() || commands.size() != items || commands.size() > kMaxBatchCommands) {
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", "Error: commands must be a non-empty array of up to " +
+                                                            std::to_string(kMaxBatchCommands) + " strings"}}
+                    })},
+                    {"isError", true}
+                };
+            }
+
+            std::vector<ExecResult> results;
+            auto result = queue_batch_and_wait(commands, results);
+            if (!result.success) {
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", result.payload}}
+                    })},
+                    {"isError", true}
+                };
+            }
+
+            Json results_json = Json::array();
+            for (const auto& r : results) {
+                results_json.push_back({{"command", r.command},
+                                        {"output", r.output},
+                                        {"hresult", FormatHResult(r.status)},
+                                        {"elapsed_ms", r.elapsed_ms},
+                                        {"success", r.succeeded()}});
+            }
+
+            return Json{
+                {"content", Json::array({
+                    Json{{"type", "text"}, {"text", Json{{"results", results_json}}.dump()}}
+                })},
+                {"isError", false}
+            };
+        }
+    };
+    dbg_exec_batch_tool.set_description("Execute a list of WinDbg/CDB commands in one call and return per-command output, HRESULT and timing");
+    impl_->tool_manager.register_tool(dbg_exec_batch_tool);
+
     // Register dbg_ask tool
     Json ask_input_schema = {
         {"type", "object"},
@@ -170,9 +312,306 @@ int MCPServer::start(int port, ExecCallback exec_cb, AskCallback ask_cb,
     // Create MCP handler
     std::unordered_map<std::string, std::string> descriptions = {
         {"dbg_exec", "Execute a WinDbg/CDB debugger command and return its output"},
+        {"dbg_exec_batch", "Execute a list of WinDbg/CDB commands in one call and return per-command output, HRESULT and timing"},
         {"dbg_ask", "Ask the AI debugging assistant a question about the current debug session"}
     };
 
+    // Register structured query tools (JSON read straight from the engine, no text parsing)
+    struct QueryTool {
+        const char* name;
+        const char* kind;
+        const char* description;
+        Json properties;
+        Json required;
+    };
+    const QueryTool query_tools[] = {
+        {"dbg_stack", "stack",
+         "Current thread's call stack as JSON frames (ip, return address, sp, fp, symbol)",
+         {{"max_frames", {{"type", "integer"}, {"description", "Most frames to return (default 64)"}}}},
+         Json::array()},
+        {"dbg_registers", "registers",
+         "Integer registers of the current thread as JSON (name -> hex value)",
+         Json::object(), Json::array()},
+        {"dbg_modules", "modules",
+         "Loaded modules as JSON (name, base, size, image path, timestamp, symbol type)",
+         Json::object(), Json::array()},
+        {"dbg_threads", "threads",
+         "Threads of the current process as JSON (engine id, system thread id, current)",
+         Json::object(), Json::array()},
+        {"dbg_unique_stacks", "unique_stacks",
+         "Call stacks of all threads grouped into distinct stacks with thread counts and ids "
+         "(a compact ~*k)",
+         {{"max_frames", {{"type", "integer"}, {"description", "Frames walked per thread (default 64)"}}}},
+         Json::array()},
+    };
+
+    for (const auto& query_tool : query_tools) {
+        if (!query_cb_) {
+            break;
+        }
+
+        Json input_schema = {{"type", "object"}, {"properties", query_tool.properties}};
+        if (!query_tool.required.empty()) {
+            input_schema["required"] = query_tool.required;
+        }
+        Json output_schema = {
+            {"type", "object"},
+            {"properties", {{"success", {{"type", "boolean"}}}}}
+        };
+
+        std::string kind = query_tool.kind;
+        fastmcpp::tools::Tool tool{
+            query_tool.name,
+            input_schema,
+            output_schema,
+            [this, kind](const Json& args) -> Json {
+                auto result = queue_query_and_wait(QueryRequestFromJson(kind, args));
+                bool is_error = !result.success ||
+                                result.payload.find("\"success\":true") == std::string::npos;
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", result.payload}}
+                    })},
+                    {"isError", is_error}
+                };
+            }
+        };
+        tool.set_description(query_tool.description);
+        impl_->tool_manager.register_tool(tool);
+        descriptions[query_tool.name] = query_tool.description;
+    }
+
+    // Register dbg_read_memory tool (raw bytes through the page cache, ranges coalesced)
+    if (memory_cb_) {
+        Json range_properties = {
+            {"address", {{"type", "string"},
+                         {"description", "Address or expression (e.g., '0x7ff6a0001000', '@rsp', 'ntdll!LdrpLoaderLock')"}}},
+            {"size", {{"type", "integer"}, {"description", "Number of bytes to read"}}}
+        };
+        Json memory_input_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"address", range_properties["address"]},
+                {"size", range_properties["size"]},
+                {"ranges", {
+                    {"type", "array"},
+                    {"items", {{"type", "object"}, {"properties", range_properties}}},
+                    {"description", "Several {address, size} ranges to read in one call (instead of address/size)"}
+                }},
+                {"encoding", {
+                    {"type", "string"},
+                    {"enum", Json::array({"base64", "hex"})},
+                    {"description", "Encoding of the returned bytes (default base64)"}
+                }}
+            }}
+        };
+
+        Json memory_output_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"ranges", {{"type", "array"}}},
+                {"success", {{"type", "boolean"}}}
+            }}
+        };
+
+        const char* memory_description =
+            "Read target memory as base64 or hex; several ranges per call, unreadable memory ends a range early";
+        fastmcpp::tools::Tool dbg_read_memory_tool{
+            "dbg_read_memory",
+            memory_input_schema,
+            memory_output_schema,
+            [this](const Json& args) -> Json {
+                std::vector<MemoryRangeRequest> ranges;
+                std::string error;
+                if (!ParseMemoryRanges(args, &ranges, &error)) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", "Error: " + error}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                std::vector<MemoryRangeResult> results;
+                auto result = queue_memory_and_wait(ranges, results);
+                if (!result.success || results.size() != ranges.size()) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", result.payload.empty() ? "Error: no result" : result.payload}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                Json response = MemoryResultsJson(results, args.value("encoding", ""));
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", response.dump(-1, ' ', false, Json::error_handler_t::replace)}}
+                    })},
+                    {"isError", false}
+                };
+            }
+        };
+        dbg_read_memory_tool.set_description(memory_description);
+        impl_->tool_manager.register_tool(dbg_read_memory_tool);
+        descriptions["dbg_read_memory"] = memory_description;
+    }
+
+    // Register dbg_symbolize tool (address index: module, symbol and region per address)
+    if (symbolize_cb_) {
+        Json symbolize_input_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"addresses", {
+                    {"type", "array"},
+                    {"items", {{"type", {"string", "integer"}}}},
+                    {"description", "Addresses or expressions to resolve (e.g., '0x7ffb1c2d1234', '@rip')"}
+                }},
+                {"symbols", {
+                    {"type", "boolean"},
+                    {"description", "Also return the nearest symbol (default true)"}
+                }}
+            }},
+            {"required", Json::array({"addresses"})}
+        };
+
+        Json symbolize_output_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"results", {{"type", "array"}}},
+                {"success", {{"type", "boolean"}}}
+            }}
+        };
+
+        const char* symbolize_description =
+            "Resolve many addresses at once to containing module+offset, nearest symbol and memory region (state, protection, type)";
+        fastmcpp::tools::Tool dbg_symbolize_tool{
+            "dbg_symbolize",
+            symbolize_input_schema,
+            symbolize_output_schema,
+            [this](const Json& args) -> Json {
+                SymbolizeRequest request;
+                std::string error;
+                if (!ParseSymbolizeRequest(args, &request, &error)) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", "Error: " + error}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                std::vector<SymbolizeResult> results;
+                auto result = queue_symbolize_and_wait(request, results);
+                if (!result.success || results.size() != request.addresses.size()) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", result.payload.empty() ? "Error: no result" : result.payload}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                Json response = SymbolizeResultsJson(results);
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", response.dump(-1, ' ', false, Json::error_handler_t::replace)}}
+                    })},
+                    {"isError", false}
+                };
+            }
+        };
+        dbg_symbolize_tool.set_description(symbolize_description);
+        impl_->tool_manager.register_tool(dbg_symbolize_tool);
+        descriptions["dbg_symbolize"] = symbolize_description;
+    }
+
+    // Register dbg_search_memory tool (native pattern scan over committed memory)
+    if (scan_cb_) {
+        Json pattern_properties = {
+            {"bytes", {{"type", "string"}, {"description", "Hex bytes, '?' for a wildcard nibble (e.g., '48 8b 05 ?? ?? ?? ??')"}}},
+            {"ascii", {{"type", "string"}, {"description", "Text as single-byte characters"}}},
+            {"utf16", {{"type", "string"}, {"description", "Text as UTF-16LE (wide strings)"}}},
+            {"word", {{"type", "string"}, {"description", "16-bit value"}}},
+            {"dword", {{"type", "string"}, {"description", "32-bit value"}}},
+            {"qword", {{"type", "string"}, {"description", "64-bit value, e.g. a pointer"}}}
+        };
+        Json scan_input_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"patterns", {
+                    {"type", "array"},
+                    {"items", {{"type", "object"}, {"properties", pattern_properties}}},
+                    {"description", "Patterns to find, each with one of bytes, ascii, utf16, word, dword, qword"}
+                }},
+                {"address", {{"type", "string"}, {"description", "Start of the range to search (default: all committed memory)"}}},
+                {"size", {{"type", "integer"}, {"description", "Length of the range to search"}}},
+                {"max_hits", {{"type", "integer"}, {"description", "Stop after this many matches (default 1000)"}}}
+            }},
+            {"required", Json::array({"patterns"})}
+        };
+
+        Json scan_output_schema = {
+            {"type", "object"},
+            {"properties", {
+                {"matches", {{"type", "array"}}},
+                {"truncated", {{"type", "boolean"}}},
+                {"success", {{"type", "boolean"}}}
+            }}
+        };
+
+        const char* scan_description =
+            "Search target memory for byte signatures (with wildcards), strings or pointer values; much faster than the s command";
+        fastmcpp::tools::Tool dbg_search_memory_tool{
+            "dbg_search_memory",
+            scan_input_schema,
+            scan_output_schema,
+            [this](const Json& args) -> Json {
+                MemoryScanRequest request;
+                std::string error;
+                if (!ParseScanRequest(args, &request, &error)) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", "Error: " + error}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                std::vector<ScanHit> hits;
+                ScanHitHandler collect = [&hits](const std::vector<ScanHit>& batch) {
+                    hits.insert(hits.end(), batch.begin(), batch.end());
+                    return true;
+                };
+                MemoryScanResult scan;
+                auto result = queue_scan_and_wait(request, collect, scan);
+                if (!result.success) {
+                    return Json{
+                        {"content", Json::array({
+                            Json{{"type", "text"}, {"text", result.payload}}
+                        })},
+                        {"isError", true}
+                    };
+                }
+
+                std::sort(hits.begin(), hits.end(), [](const ScanHit& a, const ScanHit& b) {
+                    return a.address < b.address || (a.address == b.address && a.pattern < b.pattern);
+                });
+                Json response = ScanResultJson(scan);
+                response["matches"] = ScanHitsJson(hits);
+                return Json{
+                    {"content", Json::array({
+                        Json{{"type", "text"}, {"text", response.dump(-1, ' ', false, Json::error_handler_t::replace)}}
+                    })},
+                    {"isError", !scan.succeeded()}
+                };
+            }
+        };
+        dbg_search_memory_tool.set_description(scan_description);
+        impl_->tool_manager.register_tool(dbg_search_memory_tool);
+        descriptions["dbg_search_memory"] = scan_description;
+    }
+
     auto handler = fastmcpp::mcp::make_mcp_handler(
         "windbg-agent",
         "1.0.0",
@@ -195,91 +634,27 @@ int MCPServer::start(int port, ExecCallback exec_cb, AskCallback ask_cb,
     }
 
     port_ = port;
+    broker_ = &broker;
+    source_.store(broker.Attach("mcp"));
     running_.store(true);
 
     return port_;
 }
 
-void MCPServer::set_interrupt_check(std::function<bool()> check) {
-    interrupt_check_ = check;
-}
-
-void MCPServer::wait() {
-    while (running_.load()) {
-        if (interrupt_check_ && interrupt_check_()) {
-            stop();
-            break;
-        }
-
-        MCPPendingCommand* cmd = nullptr;
-
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (queue_cv_.wait_for(lock, std::chrono::milliseconds(100),
-                                   [this]() { return !pending_commands_.empty() || !running_.load(); })) {
-                if (!pending_commands_.empty()) {
-                    cmd = pending_commands_.front();
-                    pending_commands_.pop();
-                }
-            }
-        }
-
-        if (cmd) {
-            try {
-                if (cmd->type == MCPPendingCommand::Type::Exec && exec_cb_) {
-                    cmd->result = exec_cb_(cmd->input);
-                } else if (cmd->type == MCPPendingCommand::Type::Ask && ask_cb_) {
-                    cmd->result = ask_cb_(cmd->input);
-                } else {
-                    cmd->result = "Error: No handler for command type";
-                }
-            } catch (const std::exception& e) {
-                cmd->result = std::string("Error: ") + e.what();
-            }
-
-            if (cmd->done_mutex && cmd->done_cv) {
-                {
-                    std::lock_guard<std::mutex> lock(*cmd->done_mutex);
-                    cmd->completed = true;
-                }
-                cmd->done_cv->notify_one();
-            }
-        }
-    }
-}
-
 void MCPServer::stop() {
     running_.store(false);
-    queue_cv_.notify_all();
-    complete_pending_commands("Error: MCP server stopped");
+    detach_from_broker();
 
     if (impl_ && impl_->server) {
         impl_->server->stop();
     }
 }
 
-void MCPServer::complete_pending_commands(const std::string& result) {
-    std::queue<MCPPendingCommand*> pending;
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        std::swap(pending, pending_commands_);
-    }
-
-    while (!pending.empty()) {
-        MCPPendingCommand* cmd = pending.front();
-        pending.pop();
-        if (!cmd || !cmd->done_mutex || !cmd->done_cv) {
-            continue;
-        }
-
-        {
-            std::lock_guard<std::mutex> lock(*cmd->done_mutex);
-            if (!cmd->completed) {
-                cmd->result = result;
-                cmd->completed = true;
-            }
-        }
-        cmd->done_cv->notify_one();
+void MCPServer::detach_from_broker() {
+    // Fails commands still queued by this server; the last detach ends CommandBroker::Run()
+    CommandBroker::SourceId source = source_.exchange(0);
+    if (broker_ && source != 0) {
+        broker_->Detach(source);
     }
 }
 
@@ -298,7 +673,11 @@ std::string format_mcp_info(
 
     ss << "AVAILABLE TOOLS:\n";
     ss << "  dbg_exec  - Execute a debugger command\n";
-    ss << "  dbg_ask   - Ask the AI assistant a question\n\n";
+    ss << "  dbg_exec_batch - Execute a list of debugger commands in one call\n";
+    ss << "  dbg_ask   - Ask the AI assistant a question\n";
+    ss << "  dbg_stack, dbg_registers, dbg_modules, dbg_threads, dbg_read_memory,\n";
+    ss << "  dbg_unique_stacks, dbg_symbolize, dbg_search_memory\n";
+    ss << "            - Debugger state as structured JSON\n\n";
 
     ss << "MCP CLIENT CONFIGURATION:\n";
     ss << "Add to your MCP client (e.g., Claude Desktop):\n";
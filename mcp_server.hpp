@@ -5,25 +5,31 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 #include <memory>
+#include <vector>
 
-namespace windbg_agent {
+#include "command_types.hpp"
+#include "command_broker.hpp"
 
-// Callbacks for handling requests (same as http_server)
-using ExecCallback = std::function<std::string(const std::string& command)>;
-using AskCallback = std::function<std::string(const std::string& query)>;
+namespace windbg_agent {
 
 // Internal command structure for cross-thread execution
 struct MCPPendingCommand {
-    enum class Type { Exec, Ask };
+    enum class Type { Exec, Ask, ExecBatch, Query, Memory, Symbolize, Scan };
     Type type;
     std::string input;
     std::string result;
-    bool completed = false;
-    std::mutex* done_mutex = nullptr;
-    std::condition_variable* done_cv = nullptr;
+    std::vector<std::string> batch_input;
+    std::vector<ExecResult> batch_result;
+    QueryRequest query;
+    std::vector<MemoryRangeRequest> memory_input;
+    std::vector<MemoryRangeResult> memory_result;
+    SymbolizeRequest symbolize_input;
+    std::vector<SymbolizeResult> symbolize_result;
+    MemoryScanRequest scan_input;
+    ScanHitHandler on_hits;
+    MemoryScanResult scan_result;
+    bool failed = false; // The handler threw (result holds the message) or there was none
 };
 
 struct MCPQueueResult {
@@ -42,14 +48,32 @@ public:
 
     // Start MCP server on given port with callbacks
     // Returns actual port used (may differ if auto-assigned)
-    // Callbacks will be called on the main thread (in wait())
+    // The server attaches to broker as a source; callbacks are called on the main thread
+    // while it runs CommandBroker::Run()
     // bind_addr: "127.0.0.1" for localhost only, "0.0.0.0" for all interfaces
-    int start(int port, ExecCallback exec_cb, AskCallback ask_cb,
-              const std::string& bind_addr = "127.0.0.1");
-
-    // Block until server stops, processing commands on the calling thread
-    // This is where exec_cb and ask_cb get called
-    void wait();
+    int start(int port, CommandBroker& broker, ExecCallback exec_cb, AskCallback ask_cb,
+              ExecBatchCallback exec_batch_cb, const std::string& bind_addr = "127.0.0.1");
+
+    // Answers the structured query tools (dbg_stack, dbg_registers, ...) with JSON on the
+    // main thread. Set before start(); the tools are only registered when it is set.
+    void set_query_callback(QueryCallback query_cb) {
+        query_cb_ = std::move(query_cb);
+    }
+
+    // Answers dbg_read_memory on the main thread. Set before start().
+    void set_memory_callback(MemoryReadCallback memory_cb) {
+        memory_cb_ = std::move(memory_cb);
+    }
+
+    // Answers dbg_symbolize on the main thread. Set before start().
+    void set_symbolize_callback(SymbolizeCallback symbolize_cb) {
+        symbolize_cb_ = std::move(symbolize_cb);
+    }
+
+    // Answers dbg_search_memory on the main thread. Set before start().
+    void set_scan_callback(MemoryScanCallback scan_cb) {
+        scan_cb_ = std::move(scan_cb);
+    }
 
     // Stop the server
     void stop();
@@ -60,32 +84,54 @@ public:
     // Get the port the server is listening on
     int port() const { return port_; }
 
-    // Set interrupt check function (called during wait loop)
-    void set_interrupt_check(std::function<bool()> check);
 
     // Queue a command for execution on the main thread (called by MCP tool handlers)
     MCPQueueResult queue_and_wait(MCPPendingCommand::Type type, const std::string& input);
 
+    // Queue an ordered batch of commands to run back-to-back in one main-thread slot
+    MCPQueueResult queue_batch_and_wait(const std::vector<std::string>& commands,
+                                        std::vector<ExecResult>& results);
+
+    // Queue a structured query; payload is its JSON answer
+    MCPQueueResult queue_query_and_wait(const QueryRequest& request);
+
+    // Queue a binary memory read of several ranges in one main-thread slot
+    MCPQueueResult queue_memory_and_wait(const std::vector<MemoryRangeRequest>& ranges,
+                                         std::vector<MemoryRangeResult>& results);
+
+    // Queue an address batch for the address index in one main-thread slot
+    MCPQueueResult queue_symbolize_and_wait(const SymbolizeRequest& request,
+                                            std::vector<SymbolizeResult>& results);
+
+    // Queue a memory search; hits are passed to on_hits (on the main thread) as they are found
+    MCPQueueResult queue_scan_and_wait(const MemoryScanRequest& request, ScanHitHandler on_hits,
+                                       MemoryScanResult& result);
+
 private:
-    std::function<bool()> interrupt_check_;
     std::atomic<bool> running_{false};
     std::string bind_addr_{"127.0.0.1"};
     int port_{0};
 
-    // Command queue for cross-thread execution
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
-    std::queue<MCPPendingCommand*> pending_commands_;
+    // Main-thread queue shared with other transports
+    CommandBroker* broker_ = nullptr;
+    std::atomic<CommandBroker::SourceId> source_{0};
 
     // Callbacks stored for main thread execution
     ExecCallback exec_cb_;
     AskCallback ask_cb_;
+    ExecBatchCallback exec_batch_cb_;
+    QueryCallback query_cb_;
+    MemoryReadCallback memory_cb_;
+    SymbolizeCallback symbolize_cb_;
+    MemoryScanCallback scan_cb_;
 
     // Forward declaration - impl hides fastmcpp
     class Impl;
     std::unique_ptr<Impl> impl_;
 
-    void complete_pending_commands(const std::string& result);
+    MCPQueueResult enqueue_and_wait(MCPPendingCommand& cmd);
+    void execute_command(MCPPendingCommand& cmd);
+    void detach_from_broker();
 };
 
 // Format MCP server info for display
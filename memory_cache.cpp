@@ -0,0 +1,289 @@
+#include "memory_cache.hpp"
+#include "debugger_backend.hpp"
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+constexpr uint64_t kPageSize = MemoryPageCache::kPageSize;
+
+// Start of the last page of the address space; ranges are clipped before it so page
+// arithmetic never wraps
+constexpr uint64_t kAddressLimit = ~uint64_t(0) & ~(kPageSize - 1);
+
+MemoryRange Clip(MemoryRange range)
+{
+    if (range.address >= kAddressLimit)
+        range.size = 0;
+    else if (range.size > kAddressLimit - range.address)
+        range.size = static_cast<size_t>(kAddressLimit - range.address);
+    return range;
+}
+
+uint64_t PageFloor(uint64_t address)
+{
+    return address & ~(kPageSize - 1);
+}
+
+uint64_t PageCeil(uint64_t address)
+{
+    return (address + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+} // namespace
+
+std::vector<MemoryRange> CoalesceRanges(std::vector<MemoryRange> ranges)
+{
+    for (auto& range : ranges)
+        range = Clip(range);
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+                                [](const MemoryRange& range) { return range.size == 0; }),
+                 ranges.end());
+    std::sort(ranges.begin(), ranges.end(),
+              [](const MemoryRange& a, const MemoryRange& b) { return a.address < b.address; });
+
+    std::vector<MemoryRange> merged;
+    for (const auto& range : ranges)
+    {
+        if (!merged.empty() && range.address <= merged.back().address + merged.back().size)
+        {
+            uint64_t end = std::max(merged.back().address + merged.back().size,
+                                    range.address + range.size);
+            merged.back().size = static_cast<size_t>(end - merged.back().address);
+        }
+        else
+        {
+            merged.push_back(range);
+        }
+    }
+    return merged;
+}
+
+std::vector<MemoryRangeResult> MemoryPageCache::Read(IDebuggerBackend& backend,
+                                                     const std::vector<MemoryRange>& ranges)
+{
+    std::vector<MemoryRangeResult> results(ranges.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The target may have run (or the process changed) since the pages were read
+    uint64_t epoch = GetResultCache().epoch();
+    uint32_t process_id = backend.GetProcessId();
+    if (epoch != epoch_ || process_id != process_id_)
+    {
+        if (!lru_.empty())
+        {
+            Clear();
+            stats_.invalidations++;
+        }
+        epoch_ = epoch;
+        process_id_ = process_id;
+    }
+    stats_.ranges += ranges.size();
+
+    // Coalesce at page granularity so ranges sharing a page are one span
+    std::vector<MemoryRange> pages;
+    pages.reserve(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        MemoryRange range = Clip(ranges[i]);
+        results[i].address = ranges[i].address;
+        if (range.size == 0)
+            continue;
+        uint64_t start = PageFloor(range.address);
+        pages.push_back({start, static_cast<size_t>(PageCeil(range.address + range.size) - start)});
+    }
+    std::vector<MemoryRange> spans = CoalesceRanges(std::move(pages));
+    stats_.spans += spans.size();
+
+    // Group the requests by the span holding them
+    std::vector<std::vector<size_t>> members(spans.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        if (Clip(ranges[i]).size == 0)
+            continue;
+        auto it = std::upper_bound(
+            spans.begin(), spans.end(), ranges[i].address,
+            [](uint64_t address, const MemoryRange& span) { return address < span.address; });
+        members[(it - spans.begin()) - 1].push_back(i);
+    }
+
+    std::vector<char> span_bytes;
+    std::vector<size_t> valid;
+    unsupported_ = false;
+    for (size_t s = 0; s < spans.size(); s++)
+    {
+        Fill(backend, spans[s].address / kPageSize, spans[s].size / kPageSize, &span_bytes,
+             &valid);
+
+        for (size_t i : members[s])
+        {
+            MemoryRange range = Clip(ranges[i]);
+            MemoryRangeResult& result = results[i];
+            if (unsupported_)
+            {
+                result.status = kStatusNotImpl;
+                continue;
+            }
+
+            // Copy the readable prefix of the range out of the span
+            size_t offset = static_cast<size_t>(range.address - spans[s].address);
+            size_t end = offset + range.size;
+            size_t readable = offset;
+            while (readable < end)
+            {
+                size_t page = readable / kPageSize;
+                size_t page_end = page * kPageSize + valid[page];
+                if (page_end <= readable)
+                    break;
+                readable = std::min(end, page_end);
+                if (valid[page] < kPageSize)
+                    break;
+            }
+            result.data.assign(span_bytes.data() + offset, readable - offset);
+
+            // Pages only record their readable prefix, but memory can resume inside a page
+            // (dump ranges need not be page aligned): read what follows a hole directly
+            if (readable < end)
+            {
+                size_t rest = end - readable;
+                size_t length = result.data.size();
+                result.data.resize(length + rest);
+                size_t read = 0;
+                backend.ReadMemory(range.address + length, &result.data[length], rest, &read);
+                stats_.backend_reads++;
+                stats_.bytes_read += std::min(read, rest);
+                result.data.resize(length + std::min(read, rest));
+                readable += std::min(read, rest);
+            }
+            result.status = readable == end && range.size == ranges[i].size ? kStatusOk
+                                                                            : kStatusPartialCopy;
+        }
+    }
+    return results;
+}
+
+void MemoryPageCache::Fill(IDebuggerBackend& backend, uint64_t first, size_t count,
+                           std::vector<char>* span, std::vector<size_t>* valid)
+{
+    span->assign(count * kPageSize, 0);
+    valid->assign(count, 0);
+
+    size_t i = 0;
+    while (i < count && !unsupported_)
+    {
+        auto it = index_.find(first + i);
+        if (it != index_.end())
+        {
+            const Page& page = *it->second;
+            std::memcpy(span->data() + i * kPageSize, page.bytes.data(), page.bytes.size());
+            (*valid)[i] = page.bytes.size();
+            lru_.splice(lru_.begin(), lru_, it->second);
+            stats_.page_hits++;
+            i++;
+            continue;
+        }
+
+        // Fetch the whole run of missing pages with as few reads as possible
+        size_t run = i + 1;
+        while (run < count && index_.find(first + run) == index_.end())
+            run++;
+        Fetch(backend, first + i, run - i, i * kPageSize, span, valid);
+        i = run;
+    }
+}
+
+void MemoryPageCache::Fetch(IDebuggerBackend& backend, uint64_t first, size_t count,
+                            size_t offset, std::vector<char>* span, std::vector<size_t>* valid)
+{
+    const size_t max_pages = kMaxReadBytes / kPageSize;
+    size_t done = 0;
+    while (done < count && !unsupported_)
+    {
+        size_t pages = std::min(count - done, max_pages);
+        size_t bytes = pages * kPageSize;
+        char* buffer = span->data() + offset + done * kPageSize;
+
+        size_t read = 0;
+        long status = backend.ReadMemory((first + done) * kPageSize, buffer, bytes, &read);
+        stats_.backend_reads++;
+        if (status == kStatusNotImpl)
+        {
+            unsupported_ = true;
+            return;
+        }
+        read = std::min(read, bytes);
+        stats_.bytes_read += read;
+
+        // Whole pages read, then the partial page where the read stopped (a hole). The
+        // next read resumes after the hole, so readable memory beyond it is still found.
+        size_t whole = read / kPageSize;
+        size_t stored = std::min(pages, whole + 1);
+        for (size_t p = 0; p < stored; p++)
+        {
+            size_t length = p < whole ? kPageSize : read % kPageSize;
+            (*valid)[done + (offset / kPageSize) + p] = length;
+            Store(first + done + p, buffer + p * kPageSize, length);
+        }
+        stats_.page_misses += stored;
+        done += stored;
+    }
+}
+
+void MemoryPageCache::Store(uint64_t index, const char* bytes, size_t length)
+{
+    auto it = index_.find(index);
+    if (it != index_.end())
+    {
+        it->second->bytes.assign(bytes, length);
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+
+    while (lru_.size() >= kMaxPages)
+    {
+        index_.erase(lru_.back().index);
+        lru_.pop_back();
+    }
+
+    Page page;
+    page.index = index;
+    page.bytes.assign(bytes, length);
+    lru_.push_front(std::move(page));
+    index_.emplace(index, lru_.begin());
+}
+
+void MemoryPageCache::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clear();
+    stats_.invalidations++;
+}
+
+void MemoryPageCache::Clear()
+{
+    lru_.clear();
+    index_.clear();
+}
+
+MemoryCacheStats MemoryPageCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryCacheStats stats = stats_;
+    stats.pages = lru_.size();
+    return stats;
+}
+
+MemoryPageCache& GetMemoryCache()
+{
+    static MemoryPageCache cache;
+    return cache;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "command_types.hpp"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace windbg_agent
+{
+
+class IDebuggerBackend;
+
+// A resolved range of target memory
+struct MemoryRange
+{
+    uint64_t address = 0;
+    size_t size = 0;
+};
+
+// Merge overlapping or adjacent ranges; the result is sorted by address. Empty ranges are
+// dropped and ranges running past the end of the address space are clipped.
+std::vector<MemoryRange> CoalesceRanges(std::vector<MemoryRange> ranges);
+
+// Snapshot of memory cache counters
+struct MemoryCacheStats
+{
+    uint64_t page_hits = 0;     // Pages served from the cache
+    uint64_t page_misses = 0;   // Pages fetched from the target
+    uint64_t backend_reads = 0; // Reads issued to the backend
+    uint64_t bytes_read = 0;    // Bytes fetched from the target
+    uint64_t ranges = 0;        // Ranges requested
+    uint64_t spans = 0;         // Contiguous spans they coalesced into
+    uint64_t invalidations = 0;
+    size_t pages = 0;
+};
+
+// Page-granular cache of target memory. Requested ranges are coalesced into contiguous
+// page spans; pages missing from the cache are fetched with one backend read per run of
+// missing pages. Unreadable pages are cached too, so probing holes stays cheap.
+// Everything is dropped when the debugger state epoch (see ResultCache) or the current
+// process changes, i.e. whenever the target may have run.
+class MemoryPageCache
+{
+  public:
+    static constexpr size_t kPageSize = 4096;
+    static constexpr size_t kMaxPages = 16384;            // 64 MB
+    static constexpr size_t kMaxReadBytes = 1024 * 1024; // Largest single backend read
+
+    // Read each range; results are in request order. Call on the engine thread.
+    std::vector<MemoryRangeResult> Read(IDebuggerBackend& backend,
+                                        const std::vector<MemoryRange>& ranges);
+
+    // Drop every page
+    void Invalidate();
+
+    MemoryCacheStats GetStats() const;
+
+  private:
+    struct Page
+    {
+        uint64_t index = 0;
+        std::string bytes; // Readable prefix of the page; shorter than kPageSize at a hole
+    };
+
+    // Bring pages [first, first + count) into span (count * kPageSize bytes); valid[i]
+    // receives the readable length of page i. mutex_ held.
+    void Fill(IDebuggerBackend& backend, uint64_t first, size_t count, std::vector<char>* span,
+              std::vector<size_t>* valid);
+
+    // Fetch uncached pages from the target into span. mutex_ held.
+    void Fetch(IDebuggerBackend& backend, uint64_t first, size_t count, size_t offset,
+               std::vector<char>* span, std::vector<size_t>* valid);
+
+    void Store(uint64_t index, const char* bytes, size_t length); // mutex_ held
+    void Clear();                                                   // mutex_ held
+
+    mutable std::mutex mutex_;
+    std::list<Page> lru_; // Most recently used first
+    std::unordered_map<uint64_t, std::list<Page>::iterator> index_;
+
+    // State the cached pages belong to
+    uint64_t epoch_ = 0;
+    uint32_t process_id_ = 0;
+
+    bool unsupported_ = false; // The backend cannot read memory (set during Read)
+
+    MemoryCacheStats stats_;
+};
+
+// Global memory cache shared by every WinDbgClient in this debugger session
+MemoryPageCache& GetMemoryCache();
+
+} // namespace windbg_agent
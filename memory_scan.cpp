@@ -0,0 +1,682 @@
+#include "memory_scan.hpp"
+#include "debugger_backend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) ||        \
+    (defined(__i386__) && defined(__SSE2__))
+#define WINDBG_AGENT_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC emits AVX2 intrinsics anywhere; GCC and Clang need the function to opt in
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WINDBG_AGENT_TARGET_AVX2
+#else
+#define WINDBG_AGENT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+enum class ScanIsa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+ScanIsa DetectIsa()
+{
+#ifdef WINDBG_AGENT_SCAN_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {0};
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                        (_xgetbv(0) & 0x6) == 0x6; // OSXSAVE, AVX, XMM and YMM state
+    bool avx2 = false;
+    if (max_leaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 && os_saves_ymm ? ScanIsa::Avx2 : ScanIsa::Sse2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? ScanIsa::Avx2 : ScanIsa::Sse2;
+#endif
+#else
+    return ScanIsa::Scalar;
+#endif
+}
+
+ScanIsa DetectedIsa()
+{
+    static const ScanIsa isa = DetectIsa();
+    return isa;
+}
+
+// The detected instruction set unless PatternMatcher::ForceIsa picked another
+std::atomic<ScanIsa>& SelectedIsa()
+{
+    static std::atomic<ScanIsa> isa{DetectedIsa()};
+    return isa;
+}
+
+ScanIsa GetIsa()
+{
+    return SelectedIsa().load(std::memory_order_relaxed);
+}
+
+#ifdef WINDBG_AGENT_SCAN_X86
+unsigned LowestBit(uint32_t bits)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+}
+
+// The kernels test positions [i, i + width) by comparing the anchor bytes at i + first and
+// i + last for all of them at once; on_candidate gets each position where both match.
+// They return the first position left for the scalar tail.
+template <typename OnCandidate>
+size_t AnchorScanSse2(const uint8_t* data, size_t size, size_t limit, size_t first, size_t last,
+                      uint8_t first_byte, uint8_t last_byte, OnCandidate& on_candidate)
+{
+    const __m128i want_first = _mm_set1_epi8(static_cast<char>(first_byte));
+    const __m128i want_last = _mm_set1_epi8(static_cast<char>(last_byte));
+    size_t i = 0;
+    for (; i + 16 <= limit && i + last + 16 <= size; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + first));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + last));
+        uint32_t bits = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, want_first),
+                                            _mm_cmpeq_epi8(b, want_last))));
+        while (bits)
+        {
+            if (!on_candidate(i + LowestBit(bits)))
+                return limit;
+            bits &= bits - 1;
+        }
+    }
+    return i;
+}
+
+template <typename OnCandidate>
+WINDBG_AGENT_TARGET_AVX2 size_t AnchorScanAvx2(const uint8_t* data, size_t size, size_t limit,
+                                               size_t first, size_t last, uint8_t first_byte,
+                                               uint8_t last_byte, OnCandidate& on_candidate)
+{
+    const __m256i want_first = _mm256_set1_epi8(static_cast<char>(first_byte));
+    const __m256i want_last = _mm256_set1_epi8(static_cast<char>(last_byte));
+    size_t i = 0;
+    for (; i + 32 <= limit && i + last + 32 <= size; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + first));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + last));
+        uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, want_first), _mm256_cmpeq_epi8(b, want_last))));
+        while (bits)
+        {
+            if (!on_candidate(i + LowestBit(bits)))
+                return limit;
+            bits &= bits - 1;
+        }
+    }
+    return i;
+}
+#endif
+
+int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Append code point as UTF-16LE
+void AppendUtf16(uint32_t code, std::string* out)
+{
+    auto unit = [out](uint32_t value)
+    {
+        out->push_back(static_cast<char>(value & 0xFF));
+        out->push_back(static_cast<char>(value >> 8));
+    };
+    if (code >= 0x10000)
+    {
+        code -= 0x10000;
+        unit(0xD800 | (code >> 10));
+        unit(0xDC00 | (code & 0x3FF));
+    }
+    else
+    {
+        unit(code);
+    }
+}
+
+bool Utf8ToUtf16(const std::string& text, std::string* out)
+{
+    size_t i = 0;
+    while (i < text.size())
+    {
+        auto lead = static_cast<unsigned char>(text[i]);
+        size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3
+                                      : (lead >> 3) == 0x1E ? 4
+                                                            : 0;
+        if (length == 0 || i + length > text.size())
+            return false;
+        uint32_t code = length == 1 ? lead : lead & (0xFF >> (length + 1));
+        for (size_t k = 1; k < length; k++)
+        {
+            auto next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80)
+                return false;
+            code = (code << 6) | (next & 0x3F);
+        }
+        AppendUtf16(code, out);
+        i += length;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ParseScanPattern(const std::string& kind, const std::string& text, ScanPattern* pattern,
+                      std::string* error)
+{
+    pattern->bytes.clear();
+    pattern->mask.clear();
+
+    if (kind == "bytes")
+    {
+        // Digits pair up into bytes; whitespace may separate bytes but not split one
+        std::string digits;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            char c = text[i];
+            if (c == ' ' || c == '\t' || c == ',')
+            {
+                if (digits.size() % 2)
+                {
+                    *error = "odd number of hex digits in a byte of: " + text;
+                    return false;
+                }
+                continue;
+            }
+            if (c != '?' && HexDigit(c) < 0)
+            {
+                *error = "bytes pattern must be hex digits and '?' wildcards: " + text;
+                return false;
+            }
+            digits += c;
+        }
+        if (digits.size() % 2)
+        {
+            *error = "odd number of hex digits in: " + text;
+            return false;
+        }
+        for (size_t i = 0; i < digits.size(); i += 2)
+        {
+            int high = HexDigit(digits[i]);
+            int low = HexDigit(digits[i + 1]);
+            int mask = (high < 0 ? 0 : 0xF0) | (low < 0 ? 0 : 0x0F);
+            int value = ((high < 0 ? 0 : high) << 4) | (low < 0 ? 0 : low);
+            pattern->bytes += static_cast<char>(value);
+            pattern->mask += static_cast<char>(mask);
+        }
+    }
+    else if (kind == "ascii")
+    {
+        pattern->bytes = text;
+    }
+    else if (kind == "utf16")
+    {
+        if (!Utf8ToUtf16(text, &pattern->bytes))
+        {
+            *error = "utf16 pattern is not valid UTF-8: " + text;
+            return false;
+        }
+    }
+    else if (kind == "word" || kind == "dword" || kind == "qword")
+    {
+        size_t width = kind == "word" ? 2 : kind == "dword" ? 4 : 8;
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(text.c_str(), &end, 0);
+        if (text.empty() || *end != '\0' || text[0] == '-' ||
+            (width < 8 && (value >> (width * 8)) != 0))
+        {
+            *error = kind + " pattern must be a number that fits in " + std::to_string(width) +
+                     " bytes: " + text;
+            return false;
+        }
+        for (size_t i = 0; i < width; i++)
+            pattern->bytes += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    else
+    {
+        *error = "unknown pattern kind: " + kind + " (expected bytes, ascii, utf16, word, dword "
+                 "or qword)";
+        return false;
+    }
+
+    if (pattern->mask.empty())
+        pattern->mask.assign(pattern->bytes.size(), static_cast<char>(0xFF));
+
+    if (pattern->bytes.empty() || pattern->bytes.size() > kMaxScanPatternBytes)
+    {
+        *error = "pattern must be 1.." + std::to_string(kMaxScanPatternBytes) + " bytes";
+        return false;
+    }
+    if (pattern->mask.find(static_cast<char>(0xFF)) == std::string::npos)
+    {
+        *error = "pattern needs at least one byte without wildcards: " + text;
+        return false;
+    }
+    return true;
+}
+
+PatternMatcher::PatternMatcher(const std::vector<ScanPattern>& patterns)
+{
+    patterns_.reserve(patterns.size());
+    for (const auto& pattern : patterns)
+    {
+        Compiled compiled;
+        compiled.mask = pattern.mask;
+        compiled.mask.resize(pattern.bytes.size(), static_cast<char>(0xFF));
+        compiled.bytes = pattern.bytes;
+        for (size_t i = 0; i < compiled.bytes.size(); i++)
+            compiled.bytes[i] = static_cast<char>(compiled.bytes[i] & compiled.mask[i]);
+
+        // Anchor on the first and last fully fixed bytes; a pattern without one can only
+        // match everywhere and is left out (ParseScanPattern rejects it)
+        size_t first = compiled.mask.find(static_cast<char>(0xFF));
+        if (first == std::string::npos)
+            continue;
+        compiled.first = first;
+        compiled.last = compiled.mask.rfind(static_cast<char>(0xFF));
+        compiled.exact =
+            compiled.mask.find_first_not_of(static_cast<char>(0xFF)) == std::string::npos;
+        max_length_ = std::max(max_length_, compiled.bytes.size());
+        patterns_.push_back(std::move(compiled));
+    }
+}
+
+bool PatternMatcher::Verify(const Compiled& pattern, const uint8_t* at) const
+{
+    if (pattern.exact)
+        return std::memcmp(at, pattern.bytes.data(), pattern.bytes.size()) == 0;
+    for (size_t i = 0; i < pattern.bytes.size(); i++)
+    {
+        if ((at[i] & static_cast<uint8_t>(pattern.mask[i])) !=
+            static_cast<uint8_t>(pattern.bytes[i]))
+            return false;
+    }
+    return true;
+}
+
+void PatternMatcher::Match(const uint8_t* data, size_t size, size_t limit, uint64_t base,
+                           size_t max_hits, std::vector<ScanHit>* hits) const
+{
+    for (size_t p = 0; p < patterns_.size() && hits->size() < max_hits; p++)
+    {
+        const Compiled& pattern = patterns_[p];
+        size_t length = pattern.bytes.size();
+        if (size < length)
+            continue;
+        size_t end = std::min(limit, size - length + 1); // Last start position + 1
+
+        auto first_byte = static_cast<uint8_t>(pattern.bytes[pattern.first]);
+        auto last_byte = static_cast<uint8_t>(pattern.bytes[pattern.last]);
+        auto on_candidate = [&](size_t position)
+        {
+            if (Verify(pattern, data + position))
+            {
+                hits->push_back({base + position, static_cast<uint32_t>(p)});
+                if (hits->size() >= max_hits)
+                    return false;
+            }
+            return true;
+        };
+
+        size_t i = 0;
+#ifdef WINDBG_AGENT_SCAN_X86
+        if (GetIsa() == ScanIsa::Avx2)
+            i = AnchorScanAvx2(data, size, end, pattern.first, pattern.last, first_byte,
+                               last_byte, on_candidate);
+        else
+            i = AnchorScanSse2(data, size, end, pattern.first, pattern.last, first_byte,
+                               last_byte, on_candidate);
+#endif
+
+        // Scalar tail (and the whole buffer without SIMD): memchr finds the first anchor
+        while (i < end)
+        {
+            const void* found = std::memchr(data + i + pattern.first, first_byte, end - i);
+            if (!found)
+                break;
+            size_t position =
+                static_cast<size_t>(static_cast<const uint8_t*>(found) - data) - pattern.first;
+            if (data[position + pattern.last] == last_byte && !on_candidate(position))
+                break;
+            i = position + 1;
+        }
+    }
+}
+
+const char* PatternMatcher::Isa()
+{
+    switch (GetIsa())
+    {
+    case ScanIsa::Avx2:
+        return "avx2";
+    case ScanIsa::Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+bool PatternMatcher::ForceIsa(const char* isa)
+{
+    ScanIsa wanted = DetectedIsa();
+    if (isa)
+    {
+        std::string name = isa;
+        if (name == "avx2")
+            wanted = ScanIsa::Avx2;
+        else if (name == "sse2")
+            wanted = ScanIsa::Sse2;
+        else if (name == "scalar")
+            wanted = ScanIsa::Scalar;
+        else
+            return false;
+    }
+    if (wanted > DetectedIsa())
+        return false;
+    SelectedIsa().store(wanted, std::memory_order_relaxed);
+    return true;
+}
+
+namespace
+{
+
+constexpr size_t kScanChunkBytes = 1024 * 1024;
+constexpr uint64_t kScanPageSize = 4096;
+constexpr size_t kMaxScanWorkers = 16;
+
+// Region attributes (MEMORY_BASIC_INFORMATION values)
+constexpr uint32_t kMemCommit = 0x1000;
+constexpr uint32_t kPageNoAccess = 0x01;
+constexpr uint32_t kPageGuard = 0x100;
+
+// A chunk of target memory on its way from the engine thread to a worker
+struct ScanChunk
+{
+    uint64_t address = 0;
+    std::vector<uint8_t> data;
+    size_t size = 0;  // Bytes read
+    size_t limit = 0; // Matches must start before this offset (the rest is overlap)
+};
+
+// Chunks read but not yet matched, recycled chunk buffers, and hits not yet delivered
+struct ScanQueue
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<ScanChunk*> pending;
+    std::vector<ScanChunk*> free;
+    std::vector<ScanHit> hits;
+    bool done = false; // No more chunks coming
+    bool stop = false; // Abandon the scan
+};
+
+// Committed, accessible ranges within [start, end), sorted and merged where adjacent so
+// patterns spanning two regions are found
+std::vector<std::pair<uint64_t, uint64_t>> ScanRanges(std::vector<MemoryRegionInfo> regions,
+                                                      uint64_t start, uint64_t end)
+{
+    std::sort(regions.begin(), regions.end(),
+              [](const MemoryRegionInfo& a, const MemoryRegionInfo& b) { return a.base < b.base; });
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (const auto& region : regions)
+    {
+        if (region.state != kMemCommit || (region.protect & 0xFF) == kPageNoAccess ||
+            (region.protect & kPageGuard))
+            continue;
+        uint64_t region_end =
+            region.base + region.size < region.base ? ~uint64_t(0) : region.base + region.size;
+        uint64_t from = std::max(region.base, start);
+        uint64_t to = std::min(region_end, end);
+        if (from >= to)
+            continue;
+        if (!ranges.empty() && ranges.back().second >= from)
+            ranges.back().second = std::max(ranges.back().second, to);
+        else
+            ranges.push_back({from, to});
+    }
+    return ranges;
+}
+
+} // namespace
+
+MemoryScanResult ScanMemory(IDebuggerBackend& backend, uint64_t start, uint64_t size,
+                            const std::vector<ScanPattern>& patterns, size_t max_hits,
+                            const ScanHitHandler& on_hits)
+{
+    auto started = std::chrono::steady_clock::now();
+    MemoryScanResult result;
+    result.isa = PatternMatcher::Isa();
+
+    PatternMatcher matcher(patterns);
+    if (matcher.max_length() == 0)
+    {
+        result.status = kStatusFail;
+        result.error = "no usable patterns";
+        return result;
+    }
+    if (max_hits == 0)
+        max_hits = kDefaultScanHits;
+
+    uint64_t end = size == 0 || start + size < start ? ~uint64_t(0) : start + size;
+
+    // Where to look: committed regions, or the requested range itself without a region list
+    std::vector<MemoryRegionInfo> regions;
+    long status = backend.GetMemoryRegions(&regions);
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    if (StatusSucceeded(status) && !regions.empty())
+    {
+        ranges = ScanRanges(std::move(regions), start, end);
+    }
+    else if (size != 0)
+    {
+        ranges.push_back({start, end});
+    }
+    else
+    {
+        result.status = StatusSucceeded(status) ? kStatusNotFound : status;
+        result.error = "memory regions unavailable; give an address and size to search";
+        return result;
+    }
+    result.regions = ranges.size();
+
+    // The engine thread reads while workers match; two buffers per worker keep both busy
+    size_t workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    workers = std::min(workers > 1 ? workers - 1 : 1, kMaxScanWorkers);
+    size_t overlap = matcher.max_length() - 1;
+
+    ScanQueue queue;
+    std::vector<std::unique_ptr<ScanChunk>> chunks;
+    for (size_t i = 0; i < 2 * workers; i++)
+    {
+        chunks.push_back(std::make_unique<ScanChunk>());
+        chunks.back()->data.resize(kScanChunkBytes + overlap);
+        queue.free.push_back(chunks.back().get());
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; w++)
+    {
+        threads.emplace_back(
+            [&queue, &matcher, max_hits]()
+            {
+                std::vector<ScanHit> found;
+                for (;;)
+                {
+                    ScanChunk* chunk = nullptr;
+                    {
+                        std::unique_lock<std::mutex> lock(queue.mutex);
+                        queue.cv.wait(lock,
+                                      [&queue]() {
+                                          return !queue.pending.empty() || queue.done ||
+                                                 queue.stop;
+                                      });
+                        if (queue.stop || queue.pending.empty())
+                            return;
+                        chunk = queue.pending.front();
+                        queue.pending.pop_front();
+                    }
+
+                    found.clear();
+                    matcher.Match(chunk->data.data(), chunk->size, chunk->limit, chunk->address,
+                                  max_hits, &found);
+                    {
+                        std::lock_guard<std::mutex> lock(queue.mutex);
+                        queue.hits.insert(queue.hits.end(), found.begin(), found.end());
+                        queue.free.push_back(chunk);
+                    }
+                    queue.cv.notify_all();
+                }
+            });
+    }
+
+    // Hand collected hits to the caller; false once the scan should stop
+    std::vector<ScanHit> batch;
+    auto deliver = [&]() -> bool
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            batch.swap(queue.hits);
+        }
+        if (batch.empty())
+            return true;
+        bool keep_going = true;
+        if (result.hits + batch.size() >= max_hits)
+        {
+            batch.resize(static_cast<size_t>(max_hits - result.hits));
+            keep_going = false;
+        }
+        result.hits += batch.size();
+        if (!batch.empty() && !on_hits(batch))
+            keep_going = false;
+        batch.clear();
+        if (!keep_going)
+            result.truncated = true;
+        return keep_going;
+    };
+
+    bool stopped = false;
+    for (size_t r = 0; r < ranges.size() && !stopped; r++)
+    {
+        uint64_t address = ranges[r].first;
+        uint64_t range_end = ranges[r].second;
+        while (address < range_end && !stopped)
+        {
+            if (backend.IsInterrupted())
+            {
+                result.truncated = true;
+                stopped = true;
+                break;
+            }
+
+            ScanChunk* chunk = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                queue.cv.wait(lock, [&queue]() { return !queue.free.empty(); });
+                chunk = queue.free.back();
+                queue.free.pop_back();
+            }
+
+            uint64_t remaining = range_end - address;
+            size_t limit = static_cast<size_t>(std::min<uint64_t>(kScanChunkBytes, remaining));
+            size_t want =
+                limit + static_cast<size_t>(std::min<uint64_t>(overlap, remaining - limit));
+            size_t read = 0;
+            backend.ReadMemory(address, chunk->data.data(), want, &read);
+            read = std::min(read, want);
+
+            chunk->address = address;
+            chunk->size = read;
+            chunk->limit = std::min(limit, read);
+            result.bytes_scanned += chunk->limit;
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (read != 0)
+                    queue.pending.push_back(chunk);
+                else
+                    queue.free.push_back(chunk);
+            }
+            queue.cv.notify_all();
+
+            if (read >= limit)
+            {
+                address += limit;
+            }
+            else
+            {
+                // Unreadable memory: skip the page the read stopped in and carry on after it
+                uint64_t next = (address + read + kScanPageSize) & ~(kScanPageSize - 1);
+                if (next <= address)
+                    break;
+                address = next;
+            }
+
+            stopped = !deliver();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.done = true;
+        queue.stop = stopped;
+    }
+    queue.cv.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+    if (!stopped)
+        deliver();
+
+    result.status = kStatusOk;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - started)
+                            .count();
+    return result;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "command_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+class IDebuggerBackend;
+
+// Build a pattern from its text form. kind is one of:
+//   "bytes"  hex bytes, spaces optional, '?' for a wildcard nibble ("48 8b ?? 24 1?")
+//   "ascii"  the literal text
+//   "utf16"  the text (UTF-8) encoded as UTF-16LE
+//   "word", "dword", "qword"  a number (decimal or 0x hex) as a little-endian integer
+// False with *error if the text does not parse or has no fixed byte to anchor on.
+bool ParseScanPattern(const std::string& kind, const std::string& text, ScanPattern* pattern,
+                      std::string* error);
+
+// Finds every occurrence of a set of masked patterns in a buffer. Each pattern is anchored
+// on its first and last fixed byte: both are compared 32 (AVX2) or 16 (SSE2) positions at
+// a time, and only positions where both match are verified in full. The instruction set is
+// picked at run time; other CPUs use a memchr-driven scalar loop.
+class PatternMatcher
+{
+  public:
+    explicit PatternMatcher(const std::vector<ScanPattern>& patterns);
+
+    // Longest pattern; chunks of a contiguous range must overlap by max_length() - 1
+    size_t max_length() const { return max_length_; }
+
+    // Append every match starting in data[0, limit) to *hits (address = base + offset),
+    // stopping once *hits holds max_hits entries. A match may extend past limit up to size.
+    void Match(const uint8_t* data, size_t size, size_t limit, uint64_t base, size_t max_hits,
+               std::vector<ScanHit>* hits) const;
+
+    // Instruction set the matcher uses on this CPU
+    static const char* Isa();
+
+    // Use "avx2", "sse2" or "scalar" instead of the detected instruction set (for tests
+    // and benchmarks; nullptr restores detection). False if this CPU cannot run it.
+    static bool ForceIsa(const char* isa);
+
+  private:
+    struct Compiled
+    {
+        std::string bytes;
+        std::string mask;
+        bool exact = false; // No wildcards: verify with memcmp
+        size_t first = 0;   // Offsets of the anchor bytes
+        size_t last = 0;
+    };
+
+    bool Verify(const Compiled& pattern, const uint8_t* at) const;
+
+    std::vector<Compiled> patterns_;
+    size_t max_length_ = 0;
+};
+
+// Search committed target memory in [start, start + size) (size 0 = to the end of the
+// address space) for any of the patterns. Regions come from the backend and are read on the
+// calling (engine) thread in large chunks while a pool of workers matches the chunks already
+// read; hits are handed to on_hits on the calling thread as they come in. Without a region
+// list the range itself is read, which then needs a size.
+MemoryScanResult ScanMemory(IDebuggerBackend& backend, uint64_t start, uint64_t size,
+                            const std::vector<ScanPattern>& patterns, size_t max_hits,
+                            const ScanHitHandler& on_hits);
+
+} // namespace windbg_agent
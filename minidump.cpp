@@ -0,0 +1,511 @@
+#include "minidump.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+constexpr uint32_t kSignature = 0x504D444D; // "MDMP"
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kDirectoryEntrySize = 12;
+constexpr size_t kThreadSize = 48;
+constexpr size_t kModuleSize = 108;
+constexpr size_t kMemoryDescriptorSize = 16;
+constexpr size_t kExceptionStreamSize = 168;
+constexpr size_t kMemoryInfoSize = 48;
+constexpr uint32_t kMiscProcessId = 0x1;
+constexpr uint32_t kMiscProcessTimes = 0x2;
+
+// Dumps are little-endian, as are all hosts this builds for
+template <typename T> T Load(const uint8_t* p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+void AppendUtf8(uint32_t code, std::string* out)
+{
+    if (code < 0x80)
+    {
+        out->push_back(static_cast<char>(code));
+    }
+    else if (code < 0x800)
+    {
+        out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000)
+    {
+        out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else
+    {
+        out->push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+} // namespace
+
+// The mapped dump file
+struct MinidumpFile::Mapping
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    ~Mapping()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (data)
+            munmap(const_cast<uint8_t*>(data), size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool Open(const std::string& path, std::string* error)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            *error = "cannot open " + path;
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+        {
+            *error = "empty or unreadable file: " + path;
+            return false;
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+            data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            *error = "cannot open " + path;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            *error = "empty or unreadable file: " + path;
+            return false;
+        }
+        size = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+            data = static_cast<const uint8_t*>(mapped);
+#endif
+        if (!data)
+        {
+            *error = "cannot map " + path;
+            return false;
+        }
+        return true;
+    }
+};
+
+std::unique_ptr<MinidumpFile> MinidumpFile::Open(const std::string& path, std::string* error)
+{
+    auto mapping = std::make_unique<Mapping>();
+    if (!mapping->Open(path, error))
+        return nullptr;
+
+    std::unique_ptr<MinidumpFile> file(new MinidumpFile());
+    file->data_ = mapping->data;
+    file->size_ = mapping->size;
+    file->path_ = path;
+    file->mapping_ = std::move(mapping);
+    if (!file->Parse(error))
+        return nullptr;
+    return file;
+}
+
+std::unique_ptr<MinidumpFile> MinidumpFile::FromMemory(const uint8_t* data, size_t size,
+                                                       std::string* error)
+{
+    std::unique_ptr<MinidumpFile> file(new MinidumpFile());
+    file->data_ = data;
+    file->size_ = size;
+    if (!file->Parse(error))
+        return nullptr;
+    return file;
+}
+
+MinidumpFile::~MinidumpFile() = default;
+
+MinidumpView MinidumpFile::At(uint64_t rva, uint64_t size) const
+{
+    if (rva > size_ || size > size_ - rva)
+        return {};
+    return {data_ + rva, static_cast<size_t>(size)};
+}
+
+std::string MinidumpFile::ReadString(uint32_t rva) const
+{
+    MinidumpView header = At(rva, 4);
+    if (header.empty())
+        return "";
+    MinidumpView text = At(uint64_t(rva) + 4, Load<uint32_t>(header.data) & ~1u);
+
+    std::string out;
+    out.reserve(text.size / 2);
+    for (size_t i = 0; i + 1 < text.size; i += 2)
+    {
+        uint32_t code = Load<uint16_t>(text.data + i);
+        if (code >= 0xD800 && code < 0xDC00 && i + 3 < text.size)
+        {
+            uint32_t low = Load<uint16_t>(text.data + i + 2);
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        AppendUtf8(code, &out);
+    }
+    return out;
+}
+
+bool MinidumpFile::Parse(std::string* error)
+{
+    if (size_ < kHeaderSize || Load<uint32_t>(data_) != kSignature)
+    {
+        *error = "not a user-mode minidump (missing MDMP signature)";
+        return false;
+    }
+
+    uint32_t stream_count = Load<uint32_t>(data_ + 8);
+    uint32_t directory_rva = Load<uint32_t>(data_ + 12);
+    timestamp_ = Load<uint32_t>(data_ + 20);
+    flags_ = Load<uint64_t>(data_ + 24);
+
+    MinidumpView directory = At(directory_rva, uint64_t(stream_count) * kDirectoryEntrySize);
+    if (directory.empty() && stream_count != 0)
+    {
+        *error = "stream directory lies outside the file (truncated dump?)";
+        return false;
+    }
+
+    streams_.reserve(stream_count);
+    for (uint32_t i = 0; i < stream_count; i++)
+    {
+        const uint8_t* entry = directory.data + i * kDirectoryEntrySize;
+        MinidumpStream stream;
+        stream.type = Load<uint32_t>(entry);
+        stream.view = At(Load<uint32_t>(entry + 8), Load<uint32_t>(entry + 4));
+        streams_.push_back(stream);
+    }
+
+    ParseSystemInfo(Stream(kSystemInfoStream));
+    ParseMiscInfo(Stream(kMiscInfoStream));
+    ParseThreads(Stream(kThreadListStream));
+    ParseModules(Stream(kModuleListStream));
+    ParseException(Stream(kExceptionStream));
+    ParseMemory(Stream(kMemoryListStream));
+    ParseMemory64(Stream(kMemory64ListStream));
+    ParseMemoryInfo(Stream(kMemoryInfoListStream));
+
+    // Sort captured memory and trim overlaps (full dumps may carry both memory lists)
+    std::sort(memory_.begin(), memory_.end(),
+              [](const MinidumpMemoryRange& a, const MinidumpMemoryRange& b)
+              { return a.address < b.address; });
+    std::vector<MinidumpMemoryRange> ranges;
+    ranges.reserve(memory_.size());
+    memory_bytes_ = 0;
+    for (auto range : memory_)
+    {
+        if (!ranges.empty())
+        {
+            uint64_t end = ranges.back().address + ranges.back().size;
+            if (range.address + range.size <= end)
+                continue;
+            if (range.address < end)
+            {
+                uint64_t overlap = end - range.address;
+                range.address += overlap;
+                range.offset += overlap;
+                range.size -= overlap;
+            }
+        }
+        memory_bytes_ += range.size;
+        ranges.push_back(range);
+    }
+    memory_ = std::move(ranges);
+    return true;
+}
+
+MinidumpView MinidumpFile::Stream(uint32_t type) const
+{
+    for (const auto& stream : streams_)
+    {
+        if (stream.type == type)
+            return stream.view;
+    }
+    return {};
+}
+
+void MinidumpFile::ParseThreads(MinidumpView stream)
+{
+    if (stream.size < 4)
+        return;
+    size_t count = std::min<size_t>(Load<uint32_t>(stream.data), (stream.size - 4) / kThreadSize);
+
+    threads_.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* entry = stream.data + 4 + i * kThreadSize;
+        MinidumpThread thread;
+        thread.id = Load<uint32_t>(entry);
+        thread.suspend_count = Load<uint32_t>(entry + 4);
+        thread.priority_class = Load<uint32_t>(entry + 8);
+        thread.priority = Load<uint32_t>(entry + 12);
+        thread.teb = Load<uint64_t>(entry + 16);
+        thread.stack_start = Load<uint64_t>(entry + 24);
+        thread.stack = At(Load<uint32_t>(entry + 36), Load<uint32_t>(entry + 32));
+        thread.context = At(Load<uint32_t>(entry + 44), Load<uint32_t>(entry + 40));
+        threads_.push_back(thread);
+    }
+}
+
+void MinidumpFile::ParseModules(MinidumpView stream)
+{
+    if (stream.size < 4)
+        return;
+    size_t count = std::min<size_t>(Load<uint32_t>(stream.data), (stream.size - 4) / kModuleSize);
+
+    modules_.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* entry = stream.data + 4 + i * kModuleSize;
+        MinidumpModule module;
+        module.base = Load<uint64_t>(entry);
+        module.size = Load<uint32_t>(entry + 8);
+        module.checksum = Load<uint32_t>(entry + 12);
+        module.timestamp = Load<uint32_t>(entry + 16);
+        module.path = ReadString(Load<uint32_t>(entry + 20));
+        module.cv_record = At(Load<uint32_t>(entry + 80), Load<uint32_t>(entry + 76));
+        modules_.push_back(std::move(module));
+    }
+}
+
+void MinidumpFile::ParseMemory(MinidumpView stream)
+{
+    if (stream.size < 4)
+        return;
+    size_t count = std::min<size_t>(Load<uint32_t>(stream.data),
+                                    (stream.size - 4) / kMemoryDescriptorSize);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* entry = stream.data + 4 + i * kMemoryDescriptorSize;
+        MinidumpMemoryRange range;
+        range.address = Load<uint64_t>(entry);
+        range.size = Load<uint32_t>(entry + 8);
+        range.offset = Load<uint32_t>(entry + 12);
+        if (range.size != 0 && !At(range.offset, range.size).empty() &&
+            range.address + range.size > range.address)
+            memory_.push_back(range);
+    }
+}
+
+void MinidumpFile::ParseMemory64(MinidumpView stream)
+{
+    if (stream.size < 16)
+        return;
+    uint64_t count = std::min<uint64_t>(Load<uint64_t>(stream.data),
+                                        (stream.size - 16) / kMemoryDescriptorSize);
+    uint64_t offset = Load<uint64_t>(stream.data + 8);
+
+    // Range data is stored back to back from BaseRva, in descriptor order
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const uint8_t* entry = stream.data + 16 + i * kMemoryDescriptorSize;
+        MinidumpMemoryRange range;
+        range.address = Load<uint64_t>(entry);
+        range.size = Load<uint64_t>(entry + 8);
+        range.offset = offset;
+
+        // A truncated dump keeps whatever part of the data made it to disk
+        if (offset >= size_)
+            break;
+        range.size = std::min<uint64_t>(range.size, size_ - offset);
+        if (range.address + range.size < range.address)
+            break;
+        if (range.size != 0)
+            memory_.push_back(range);
+        offset += Load<uint64_t>(entry + 8);
+    }
+}
+
+void MinidumpFile::ParseMemoryInfo(MinidumpView stream)
+{
+    if (stream.size < 16)
+        return;
+    uint32_t header_size = Load<uint32_t>(stream.data);
+    uint32_t entry_size = Load<uint32_t>(stream.data + 4);
+    if (header_size < 16 || header_size > stream.size || entry_size < kMemoryInfoSize)
+        return;
+    uint64_t count = std::min<uint64_t>(Load<uint64_t>(stream.data + 8),
+                                        (stream.size - header_size) / entry_size);
+
+    regions_.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const uint8_t* entry = stream.data + header_size + i * entry_size;
+        MinidumpRegion region;
+        region.address = Load<uint64_t>(entry);
+        region.allocation_base = Load<uint64_t>(entry + 8);
+        region.allocation_protect = Load<uint32_t>(entry + 16);
+        region.size = Load<uint64_t>(entry + 24);
+        region.state = Load<uint32_t>(entry + 32);
+        region.protect = Load<uint32_t>(entry + 36);
+        region.type = Load<uint32_t>(entry + 40);
+        if (region.size != 0 && region.address + region.size >= region.address)
+            regions_.push_back(region);
+    }
+    std::sort(regions_.begin(), regions_.end(),
+              [](const MinidumpRegion& a, const MinidumpRegion& b)
+              { return a.address < b.address; });
+}
+
+void MinidumpFile::ParseException(MinidumpView stream)
+{
+    if (stream.size < kExceptionStreamSize)
+        return;
+
+    exception_.thread_id = Load<uint32_t>(stream.data);
+    exception_.code = Load<uint32_t>(stream.data + 8);
+    exception_.flags = Load<uint32_t>(stream.data + 12);
+    exception_.record = Load<uint64_t>(stream.data + 16);
+    exception_.address = Load<uint64_t>(stream.data + 24);
+    uint32_t parameters = std::min<uint32_t>(Load<uint32_t>(stream.data + 32), 15);
+    for (uint32_t i = 0; i < parameters; i++)
+        exception_.parameters.push_back(Load<uint64_t>(stream.data + 40 + i * 8));
+    exception_.context = At(Load<uint32_t>(stream.data + 164), Load<uint32_t>(stream.data + 160));
+    has_exception_ = true;
+}
+
+void MinidumpFile::ParseSystemInfo(MinidumpView stream)
+{
+    if (stream.size < 24)
+        return;
+
+    system_info_.architecture = Load<uint16_t>(stream.data);
+    system_info_.processors = stream.data[6];
+    system_info_.product_type = stream.data[7];
+    system_info_.major_version = Load<uint32_t>(stream.data + 8);
+    system_info_.minor_version = Load<uint32_t>(stream.data + 12);
+    system_info_.build_number = Load<uint32_t>(stream.data + 16);
+}
+
+void MinidumpFile::ParseMiscInfo(MinidumpView stream)
+{
+    if (stream.size < 24)
+        return;
+
+    uint32_t flags = Load<uint32_t>(stream.data + 4);
+    misc_info_.has_process_id = (flags & kMiscProcessId) != 0;
+    misc_info_.process_id = Load<uint32_t>(stream.data + 8);
+    misc_info_.has_process_times = (flags & kMiscProcessTimes) != 0;
+    misc_info_.process_create_time = Load<uint32_t>(stream.data + 12);
+    misc_info_.process_user_time = Load<uint32_t>(stream.data + 16);
+    misc_info_.process_kernel_time = Load<uint32_t>(stream.data + 20);
+}
+
+size_t MinidumpFile::ReadMemory(uint64_t address, void* buffer, size_t size) const
+{
+    auto* out = static_cast<uint8_t*>(buffer);
+    size_t copied = 0;
+    while (copied < size)
+    {
+        MinidumpView view = MemoryAt(address + copied, size - copied);
+        if (view.empty())
+            break;
+        std::memcpy(out + copied, view.data, view.size);
+        copied += view.size;
+    }
+    return copied;
+}
+
+MinidumpView MinidumpFile::MemoryAt(uint64_t address, size_t size) const
+{
+    auto it = std::upper_bound(memory_.begin(), memory_.end(), address,
+                               [](uint64_t value, const MinidumpMemoryRange& range)
+                               { return value < range.address; });
+    if (it == memory_.begin())
+        return {};
+    --it;
+    uint64_t skip = address - it->address;
+    if (skip >= it->size)
+        return {};
+    return {data_ + it->offset + skip, static_cast<size_t>(std::min<uint64_t>(size, it->size - skip))};
+}
+
+const MinidumpModule* MinidumpFile::ModuleAt(uint64_t address) const
+{
+    for (const auto& module : modules_)
+    {
+        if (address >= module.base && address - module.base < module.size)
+            return &module;
+    }
+    return nullptr;
+}
+
+std::string MinidumpArchitectureName(uint16_t architecture)
+{
+    switch (architecture)
+    {
+    case kArchX86:
+        return "x86";
+    case kArchAmd64:
+        return "x64";
+    case kArchArm64:
+        return "ARM64";
+    case kArchArm:
+        return "ARM";
+    default:
+        return "Unknown (" + std::to_string(architecture) + ")";
+    }
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Stream types used by the reader (MINIDUMP_STREAM_TYPE)
+enum MinidumpStreamType : uint32_t
+{
+    kThreadListStream = 3,
+    kModuleListStream = 4,
+    kMemoryListStream = 5,
+    kExceptionStream = 6,
+    kSystemInfoStream = 7,
+    kMemory64ListStream = 9,
+    kMiscInfoStream = 15,
+    kMemoryInfoListStream = 16,
+};
+
+// Processor architectures (MINIDUMP_SYSTEM_INFO::ProcessorArchitecture)
+enum MinidumpArchitecture : uint16_t
+{
+    kArchX86 = 0,
+    kArchArm = 5,
+    kArchAmd64 = 9,
+    kArchArm64 = 12,
+    kArchUnknown = 0xFFFF,
+};
+
+// A byte range inside the mapped file
+struct MinidumpView
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return size == 0; }
+};
+
+struct MinidumpStream
+{
+    uint32_t type = 0;
+    MinidumpView view;
+};
+
+struct MinidumpThread
+{
+    uint32_t id = 0;
+    uint32_t suspend_count = 0;
+    uint32_t priority_class = 0;
+    uint32_t priority = 0;
+    uint64_t teb = 0;
+    uint64_t stack_start = 0;
+    MinidumpView stack;   // Stack memory captured for the thread
+    MinidumpView context; // Raw CONTEXT record of the thread's architecture
+};
+
+struct MinidumpModule
+{
+    uint64_t base = 0;
+    uint32_t size = 0;
+    uint32_t checksum = 0;
+    uint32_t timestamp = 0;
+    std::string path;      // Full image path as recorded (UTF-8)
+    MinidumpView cv_record; // CodeView record (RSDS: GUID, age, PDB name)
+};
+
+struct MinidumpException
+{
+    uint32_t thread_id = 0;
+    uint32_t code = 0;
+    uint32_t flags = 0;
+    uint64_t record = 0;
+    uint64_t address = 0;
+    std::vector<uint64_t> parameters;
+    MinidumpView context; // CONTEXT at the time of the exception
+};
+
+struct MinidumpSystemInfo
+{
+    uint16_t architecture = kArchUnknown;
+    uint8_t processors = 0;
+    uint8_t product_type = 0;
+    uint32_t major_version = 0;
+    uint32_t minor_version = 0;
+    uint32_t build_number = 0;
+};
+
+struct MinidumpMiscInfo
+{
+    bool has_process_id = false;
+    uint32_t process_id = 0;
+    bool has_process_times = false;
+    uint32_t process_create_time = 0; // time_t
+    uint32_t process_user_time = 0;   // Seconds
+    uint32_t process_kernel_time = 0; // Seconds
+};
+
+// Captured target memory: [address, address + size) lives at file offset `offset`
+struct MinidumpMemoryRange
+{
+    uint64_t address = 0;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+};
+
+// A region of the target address space as VirtualQuery reported it (MINIDUMP_MEMORY_INFO);
+// state, protect and type hold the MEM_* / PAGE_* values
+struct MinidumpRegion
+{
+    uint64_t address = 0;
+    uint64_t size = 0;
+    uint64_t allocation_base = 0;
+    uint32_t allocation_protect = 0;
+    uint32_t state = 0;
+    uint32_t protect = 0;
+    uint32_t type = 0;
+};
+
+// Read-only, memory-mapped user-mode minidump (MDMP). Open() maps the file and indexes
+// the stream directory once; thread stacks, contexts, CodeView records and memory are
+// served as views into the mapping without copying. Every RVA and size is bounds-checked
+// against the file, so a truncated or corrupt dump yields fewer entries, never a crash.
+// Runs anywhere (no dbgeng); the file stays mapped for the object's lifetime.
+class MinidumpFile
+{
+  public:
+    // Map and index a dump; returns nullptr and sets error on failure
+    static std::unique_ptr<MinidumpFile> Open(const std::string& path, std::string* error);
+
+    // Index a dump already in memory (data must outlive the object)
+    static std::unique_ptr<MinidumpFile> FromMemory(const uint8_t* data, size_t size,
+                                                    std::string* error);
+
+    ~MinidumpFile();
+    MinidumpFile(const MinidumpFile&) = delete;
+    MinidumpFile& operator=(const MinidumpFile&) = delete;
+
+    const std::string& path() const { return path_; }
+    size_t file_size() const { return size_; }
+    uint32_t timestamp() const { return timestamp_; }
+    uint64_t flags() const { return flags_; }
+
+    // Stream directory in file order, and the first stream of a type (empty if absent)
+    const std::vector<MinidumpStream>& streams() const { return streams_; }
+    MinidumpView Stream(uint32_t type) const;
+
+    const std::vector<MinidumpThread>& threads() const { return threads_; }
+    const std::vector<MinidumpModule>& modules() const { return modules_; }
+    const MinidumpSystemInfo& system_info() const { return system_info_; }
+    const MinidumpMiscInfo& misc_info() const { return misc_info_; }
+
+    // Exception that caused the dump; nullptr if the dump has none
+    const MinidumpException* exception() const { return has_exception_ ? &exception_ : nullptr; }
+
+    // Captured memory ranges sorted by address (memory list and memory64 list combined)
+    const std::vector<MinidumpMemoryRange>& memory() const { return memory_; }
+    uint64_t memory_bytes() const { return memory_bytes_; }
+
+    // Address space layout sorted by address (empty if the dump has no memory info list)
+    const std::vector<MinidumpRegion>& regions() const { return regions_; }
+
+    // Copy target memory at address into buffer; returns the length of the captured
+    // prefix (reading continues across adjacent ranges and stops at the first gap)
+    size_t ReadMemory(uint64_t address, void* buffer, size_t size) const;
+
+    // Zero-copy view of captured memory at address, up to the end of its range
+    MinidumpView MemoryAt(uint64_t address, size_t size) const;
+
+    // Module containing address; nullptr if none
+    const MinidumpModule* ModuleAt(uint64_t address) const;
+
+  private:
+    struct Mapping;
+
+    MinidumpFile() = default;
+
+    bool Parse(std::string* error);
+    MinidumpView At(uint64_t rva, uint64_t size) const; // Empty if out of bounds
+    std::string ReadString(uint32_t rva) const;       // MINIDUMP_STRING (UTF-16) to UTF-8
+
+    void ParseThreads(MinidumpView stream);
+    void ParseModules(MinidumpView stream);
+    void ParseMemory(MinidumpView stream);
+    void ParseMemory64(MinidumpView stream);
+    void ParseMemoryInfo(MinidumpView stream);
+    void ParseException(MinidumpView stream);
+    void ParseSystemInfo(MinidumpView stream);
+    void ParseMiscInfo(MinidumpView stream);
+
+    std::unique_ptr<Mapping> mapping_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string path_;
+
+    uint32_t timestamp_ = 0;
+    uint64_t flags_ = 0;
+    std::vector<MinidumpStream> streams_;
+    std::vector<MinidumpThread> threads_;
+    std::vector<MinidumpModule> modules_;
+    std::vector<MinidumpMemoryRange> memory_;
+    uint64_t memory_bytes_ = 0;
+    std::vector<MinidumpRegion> regions_;
+    MinidumpSystemInfo system_info_;
+    MinidumpMiscInfo misc_info_;
+    MinidumpException exception_;
+    bool has_exception_ = false;
+};
+
+// Name of a minidump processor architecture as reported by backends ("x64", "x86", ...)
+std::string MinidumpArchitectureName(uint16_t architecture);
+
+} // namespace windbg_agent
@@ -0,0 +1,380 @@
+#include "minidump_backend.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+// A register in a CONTEXT record
+struct RegisterSlot
+{
+    const char* name;
+    uint16_t offset;
+    uint8_t width;
+};
+
+// Integer registers by CONTEXT layout, in the order the engine lists them
+const RegisterSlot kAmd64Registers[] = {
+    {"rax", 0x78, 8},   {"rcx", 0x80, 8},   {"rdx", 0x88, 8},   {"rbx", 0x90, 8},
+    {"rsp", 0x98, 8},   {"rbp", 0xa0, 8},   {"rsi", 0xa8, 8},   {"rdi", 0xb0, 8},
+    {"r8", 0xb8, 8},    {"r9", 0xc0, 8},    {"r10", 0xc8, 8},   {"r11", 0xd0, 8},
+    {"r12", 0xd8, 8},   {"r13", 0xe0, 8},   {"r14", 0xe8, 8},   {"r15", 0xf0, 8},
+    {"rip", 0xf8, 8},   {"efl", 0x44, 4},   {"cs", 0x38, 2},    {"ds", 0x3a, 2},
+    {"es", 0x3c, 2},    {"fs", 0x3e, 2},    {"gs", 0x40, 2},    {"ss", 0x42, 2},
+    {"dr0", 0x48, 8},   {"dr1", 0x50, 8},   {"dr2", 0x58, 8},   {"dr3", 0x60, 8},
+    {"dr6", 0x68, 8},   {"dr7", 0x70, 8},   {"mxcsr", 0x34, 4},
+};
+
+const RegisterSlot kX86Registers[] = {
+    {"eax", 0xb0, 4}, {"ebx", 0xa4, 4}, {"ecx", 0xac, 4}, {"edx", 0xa8, 4}, {"esi", 0xa0, 4},
+    {"edi", 0x9c, 4}, {"eip", 0xb8, 4}, {"esp", 0xc4, 4}, {"ebp", 0xb4, 4}, {"efl", 0xc0, 4},
+    {"cs", 0xbc, 4},  {"ss", 0xc8, 4},  {"ds", 0x98, 4},  {"es", 0x94, 4},  {"fs", 0x90, 4},
+    {"gs", 0x8c, 4},  {"dr0", 0x04, 4}, {"dr1", 0x08, 4}, {"dr2", 0x0c, 4}, {"dr3", 0x10, 4},
+    {"dr6", 0x14, 4}, {"dr7", 0x18, 4},
+};
+
+const RegisterSlot kArm64Registers[] = {
+    {"x0", 0x08, 8},  {"x1", 0x10, 8},  {"x2", 0x18, 8},  {"x3", 0x20, 8},   {"x4", 0x28, 8},
+    {"x5", 0x30, 8},  {"x6", 0x38, 8},  {"x7", 0x40, 8},  {"x8", 0x48, 8},   {"x9", 0x50, 8},
+    {"x10", 0x58, 8}, {"x11", 0x60, 8}, {"x12", 0x68, 8}, {"x13", 0x70, 8},  {"x14", 0x78, 8},
+    {"x15", 0x80, 8}, {"x16", 0x88, 8}, {"x17", 0x90, 8}, {"x18", 0x98, 8},  {"x19", 0xa0, 8},
+    {"x20", 0xa8, 8}, {"x21", 0xb0, 8}, {"x22", 0xb8, 8}, {"x23", 0xc0, 8},  {"x24", 0xc8, 8},
+    {"x25", 0xd0, 8}, {"x26", 0xd8, 8}, {"x27", 0xe0, 8}, {"x28", 0xe8, 8},  {"fp", 0xf0, 8},
+    {"lr", 0xf8, 8},  {"sp", 0x100, 8}, {"pc", 0x108, 8}, {"cpsr", 0x04, 4},
+};
+
+const RegisterSlot kArmRegisters[] = {
+    {"r0", 0x04, 4},  {"r1", 0x08, 4},  {"r2", 0x0c, 4},  {"r3", 0x10, 4},  {"r4", 0x14, 4},
+    {"r5", 0x18, 4},  {"r6", 0x1c, 4},  {"r7", 0x20, 4},  {"r8", 0x24, 4},  {"r9", 0x28, 4},
+    {"r10", 0x2c, 4}, {"r11", 0x30, 4}, {"r12", 0x34, 4}, {"sp", 0x38, 4},  {"lr", 0x3c, 4},
+    {"pc", 0x40, 4},  {"cpsr", 0x44, 4},
+};
+
+std::string ToLower(std::string s)
+{
+    for (auto& c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string Trim(const std::string& s)
+{
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(start, end - start + 1);
+}
+
+// MASM-style number: hex by default ("7ff6`a0001000", "0x10", "10h"), 0n for decimal
+bool ParseNumber(std::string text, uint64_t* value)
+{
+    text.erase(std::remove(text.begin(), text.end(), '`'), text.end());
+    int base = 16;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+        text = text.substr(2);
+    else if (text.size() > 2 && text[0] == '0' && (text[1] == 'n' || text[1] == 'N'))
+        text = text.substr(2), base = 10;
+    else if (text.size() > 1 && (text.back() == 'h' || text.back() == 'H'))
+        text.pop_back();
+    if (text.empty() || text.size() > (base == 16 ? 16u : 20u))
+        return false;
+
+    uint64_t result = 0;
+    for (char c : text)
+    {
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (base == 16 && c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (base == 16 && c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return false;
+        result = result * base + digit;
+    }
+    *value = result;
+    return true;
+}
+
+} // namespace
+
+std::string ModuleNameFromPath(const std::string& path)
+{
+    size_t slash = path.find_last_of("\\/");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+        name.resize(dot);
+    return name;
+}
+
+MinidumpBackend::MinidumpBackend(std::unique_ptr<MinidumpFile> dump) : dump_(std::move(dump))
+{
+    // Start on the faulting thread, as the engine does for a dump with an exception
+    if (const MinidumpException* exception = dump_->exception())
+    {
+        const auto& threads = dump_->threads();
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            if (threads[i].id == exception->thread_id)
+                current_thread_ = i;
+        }
+    }
+}
+
+std::unique_ptr<MinidumpBackend> MinidumpBackend::Open(const std::string& path,
+                                                       std::string* error)
+{
+    auto dump = MinidumpFile::Open(path, error);
+    if (!dump)
+        return nullptr;
+    return std::make_unique<MinidumpBackend>(std::move(dump));
+}
+
+bool MinidumpBackend::SetCurrentThread(size_t index)
+{
+    if (index >= dump_->threads().size())
+        return false;
+    current_thread_ = index;
+    registers_loaded_ = false;
+    return true;
+}
+
+long MinidumpBackend::Execute(const std::string& /*command*/, bool /*echo*/, OutputView* /*output*/)
+{
+    return kStatusNotImpl;
+}
+
+long MinidumpBackend::ExecuteStreaming(const std::string& /*command*/, bool /*echo*/,
+                                       const OutputChunkHandler& /*on_chunk*/)
+{
+    return kStatusNotImpl;
+}
+
+void MinidumpBackend::Display(DisplayStyle style, const std::string& text)
+{
+    if (display_)
+        display_(style, text);
+}
+
+std::string MinidumpBackend::GetTargetArchitecture() const
+{
+    return MinidumpArchitectureName(dump_->system_info().architecture);
+}
+
+uint32_t MinidumpBackend::GetProcessId() const
+{
+    return dump_->misc_info().has_process_id ? dump_->misc_info().process_id : 0;
+}
+
+std::string MinidumpBackend::GetContextKey() const
+{
+    return "minidump|" + dump_->path() + "|" + std::to_string(current_thread_);
+}
+
+MinidumpView MinidumpBackend::CurrentContext() const
+{
+    const auto& threads = dump_->threads();
+    if (current_thread_ >= threads.size())
+        return {};
+
+    const MinidumpException* exception = dump_->exception();
+    if (exception && exception->thread_id == threads[current_thread_].id &&
+        !exception->context.empty())
+        return exception->context;
+    return threads[current_thread_].context;
+}
+
+long MinidumpBackend::GetRegisters(std::vector<RegisterInfo>* registers)
+{
+    if (registers_loaded_)
+    {
+        *registers = registers_;
+        return registers_.empty() ? kStatusNotFound : kStatusOk;
+    }
+
+    const RegisterSlot* slots = nullptr;
+    size_t count = 0;
+    switch (dump_->system_info().architecture)
+    {
+    case kArchAmd64:
+        slots = kAmd64Registers;
+        count = sizeof(kAmd64Registers) / sizeof(kAmd64Registers[0]);
+        break;
+    case kArchX86:
+        slots = kX86Registers;
+        count = sizeof(kX86Registers) / sizeof(kX86Registers[0]);
+        break;
+    case kArchArm64:
+        slots = kArm64Registers;
+        count = sizeof(kArm64Registers) / sizeof(kArm64Registers[0]);
+        break;
+    case kArchArm:
+        slots = kArmRegisters;
+        count = sizeof(kArmRegisters) / sizeof(kArmRegisters[0]);
+        break;
+    default:
+        registers->clear();
+        return kStatusNotImpl;
+    }
+
+    MinidumpView context = CurrentContext();
+    registers_.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (slots[i].offset + slots[i].width > context.size)
+            continue;
+        uint64_t value = 0;
+        std::memcpy(&value, context.data + slots[i].offset, slots[i].width);
+        registers_.push_back({slots[i].name, value});
+    }
+    registers_loaded_ = true;
+
+    *registers = registers_;
+    return registers_.empty() ? kStatusNotFound : kStatusOk;
+}
+
+long MinidumpBackend::GetModules(std::vector<ModuleInfo>* modules)
+{
+    modules->clear();
+    modules->reserve(dump_->modules().size());
+    for (const auto& module : dump_->modules())
+    {
+        ModuleInfo info;
+        info.name = ModuleNameFromPath(module.path);
+        info.image = module.path;
+        info.base = module.base;
+        info.size = module.size;
+        info.timestamp = module.timestamp;
+        info.checksum = module.checksum;
+        info.symbols = "none";
+        modules->push_back(std::move(info));
+    }
+    return kStatusOk;
+}
+
+long MinidumpBackend::GetMemoryRegions(std::vector<MemoryRegionInfo>* regions)
+{
+    constexpr uint32_t kMemCommit = 0x1000;
+    constexpr uint32_t kMemFree = 0x10000;
+
+    regions->clear();
+    for (const auto& region : dump_->regions())
+    {
+        if (region.state != kMemFree)
+            regions->push_back({region.address, region.size, region.state, region.protect,
+                                region.type});
+    }
+
+    // Without a memory info list, the captured ranges are all that is known to be mapped
+    if (dump_->regions().empty())
+    {
+        for (const auto& range : dump_->memory())
+            regions->push_back({range.address, range.size, kMemCommit, 0, 0});
+    }
+    return kStatusOk;
+}
+
+long MinidumpBackend::GetThreads(std::vector<ThreadInfo>* threads)
+{
+    threads->clear();
+    const auto& list = dump_->threads();
+    threads->reserve(list.size());
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        ThreadInfo thread;
+        thread.id = static_cast<uint32_t>(i);
+        thread.system_id = list[i].id;
+        thread.current = i == current_thread_;
+        threads->push_back(thread);
+    }
+    return kStatusOk;
+}
+
+bool MinidumpBackend::EvaluateTerm(const std::string& term, uint64_t* value)
+{
+    if (term.empty())
+        return false;
+
+    if (term[0] == '@')
+    {
+        std::string name = ToLower(term.substr(1));
+        std::vector<RegisterInfo> registers;
+        GetRegisters(&registers);
+        for (const auto& reg : registers)
+        {
+            if (reg.name == name)
+            {
+                *value = reg.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (ParseNumber(term, value))
+        return true;
+
+    // Module name with or without extension
+    std::string name = ToLower(term);
+    for (const auto& module : dump_->modules())
+    {
+        std::string file_name = ToLower(module.path.substr(module.path.find_last_of("\\/") + 1));
+        if (name == file_name || name == ModuleNameFromPath(file_name))
+        {
+            *value = module.base;
+            return true;
+        }
+    }
+    return false;
+}
+
+long MinidumpBackend::Evaluate(const std::string& expression, uint64_t* value)
+{
+    std::string text = Trim(expression);
+    if (text.empty())
+        return kStatusFail;
+
+    uint64_t result = 0;
+    bool negate = false;
+    size_t pos = 0;
+    if (text[0] == '+' || text[0] == '-')
+    {
+        negate = text[0] == '-';
+        pos = 1;
+    }
+
+    while (true)
+    {
+        size_t next = text.find_first_of("+-", pos);
+        std::string term =
+            Trim(text.substr(pos, next == std::string::npos ? std::string::npos : next - pos));
+        uint64_t term_value = 0;
+        if (!EvaluateTerm(term, &term_value))
+            return kStatusNotFound;
+        result = negate ? result - term_value : result + term_value;
+
+        if (next == std::string::npos)
+            break;
+        negate = text[next] == '-';
+        pos = next + 1;
+    }
+
+    *value = result;
+    return kStatusOk;
+}
+
+long MinidumpBackend::ReadMemory(uint64_t address, void* buffer, size_t size, size_t* bytes_read)
+{
+    *bytes_read = dump_->ReadMemory(address, buffer, size);
+    return *bytes_read == size ? kStatusOk : kStatusPartialCopy;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "debugger_backend.hpp"
+#include "minidump.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Backend over a memory-mapped minidump, without a debugger engine. Answers the
+// structured accessors (threads, modules, registers, memory, address expressions) straight
+// from the dump in microseconds; debugger commands and stack walks need symbols and an
+// engine, so Execute and GetStack report kStatusNotImpl. Registers come from the current
+// thread's context, or from the exception context for the faulting thread (like .ecxr).
+//
+// Address expressions: terms joined by '+' or '-', each a number (hex by default, with
+// optional 0x prefix and ` separators; 0n for decimal), a register ("@rsp") or a module
+// name ("ntdll", "ntdll.dll") standing for its base address. Memory regions come from the
+// memory info list, or from the captured ranges when the dump has none.
+class MinidumpBackend : public IDebuggerBackend
+{
+  public:
+    using DisplayHandler = std::function<void(DisplayStyle style, const std::string& text)>;
+
+    explicit MinidumpBackend(std::unique_ptr<MinidumpFile> dump);
+
+    // Map a dump file; returns nullptr and sets error on failure
+    static std::unique_ptr<MinidumpBackend> Open(const std::string& path, std::string* error);
+
+    const MinidumpFile& dump() const { return *dump_; }
+
+    // Switch the current thread (index into the thread list); false if out of range
+    bool SetCurrentThread(size_t index);
+    size_t current_thread() const { return current_thread_; }
+
+    // Receive messages the client displays (discarded by default)
+    void SetDisplayHandler(DisplayHandler handler) { display_ = std::move(handler); }
+
+    bool IsAvailable() const override { return true; }
+    long Execute(const std::string& command, bool echo, OutputView* output) override;
+    long ExecuteStreaming(const std::string& command, bool echo,
+                          const OutputChunkHandler& on_chunk) override;
+
+    void Display(DisplayStyle style, const std::string& text) override;
+    bool SupportsColor() const override { return false; }
+
+    std::string GetTargetName() const override { return dump_->path(); }
+    std::string GetTargetArchitecture() const override;
+    std::string GetDebuggerType() const override { return "Minidump reader"; }
+    std::string GetTargetState() const override { return "Break"; }
+    uint32_t GetProcessId() const override;
+    std::string GetContextKey() const override;
+    bool IsInterrupted() const override { return false; }
+
+    long GetRegisters(std::vector<RegisterInfo>* registers) override;
+    long GetModules(std::vector<ModuleInfo>* modules) override;
+    long GetThreads(std::vector<ThreadInfo>* threads) override;
+    long Evaluate(const std::string& expression, uint64_t* value) override;
+    long GetMemoryRegions(std::vector<MemoryRegionInfo>* regions) override;
+    long ReadMemory(uint64_t address, void* buffer, size_t size, size_t* bytes_read) override;
+
+  private:
+    // CONTEXT record registers are read from for the current thread
+    MinidumpView CurrentContext() const;
+
+    // Value of one expression term; false if it is not a number, register or module
+    bool EvaluateTerm(const std::string& term, uint64_t* value);
+
+    std::unique_ptr<MinidumpFile> dump_;
+    size_t current_thread_ = 0;
+    std::vector<RegisterInfo> registers_; // Registers of the current thread, decoded lazily
+    bool registers_loaded_ = false;
+    DisplayHandler display_;
+};
+
+// Module name as the engine shows it: file name without directory and extension
+std::string ModuleNameFromPath(const std::string& path);
+
+} // namespace windbg_agent
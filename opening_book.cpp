@@ -0,0 +1,76 @@
+#include "opening_book.hpp"
+#include "output_shaper.hpp"
+#include "result_cache.hpp"
+#include "windbg_client.hpp"
+
+#include <chrono>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+// Per-command window: enough for a stack or register dump, not a full module list
+OutputShapingOptions BookShaping()
+{
+    OutputShapingOptions options;
+    options.max_lines = 48;
+    options.head_lines = 32;
+    options.tail_lines = 8;
+    options.max_bytes = 4 * 1024;
+    return options;
+}
+
+} // namespace
+
+const std::vector<std::string>& DefaultOpeningBook()
+{
+    static const std::vector<std::string> book = {"|", "~", ".lastevent", "r", "k", "lm"};
+    return book;
+}
+
+OpeningBookResult RunOpeningBook(WinDbgClient& client, const std::vector<std::string>& commands,
+                                 size_t max_bytes)
+{
+    OpeningBookResult result;
+    auto start = std::chrono::steady_clock::now();
+    OutputShapingOptions shaping = BookShaping();
+
+    std::string body;
+    for (const auto& command : commands)
+    {
+        // Same rule as the result cache: only commands it would cache run unasked
+        if (ClassifyCommand(command) != CommandEffect::ReadOnly || body.size() >= max_bytes)
+        {
+            result.skipped++;
+            continue;
+        }
+
+        std::string output = client.ExecuteCommand(command);
+        result.executed++;
+
+        std::string section = "> " + command + "\n" + ShapeOutput(std::move(output), shaping).text;
+        if (!section.empty() && section.back() != '\n')
+            section += '\n';
+        if (body.size() + section.size() > max_bytes)
+        {
+            result.skipped++;
+            continue;
+        }
+        body += section + "\n";
+    }
+
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+    if (!body.empty())
+    {
+        result.text = "[Opening context: these commands were already run on the target; use "
+                      "their results instead of running them again]\n" +
+                      body;
+    }
+    return result;
+}
+
+} // namespace windbg_agent
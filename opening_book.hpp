@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+class WinDbgClient;
+
+// Commands the agent asks for first on nearly every target
+const std::vector<std::string>& DefaultOpeningBook();
+
+// Compact results of an opening book, ready to be put in the first prime message
+struct OpeningBookResult
+{
+    std::string text;     // Empty if nothing ran
+    size_t executed = 0;
+    size_t skipped = 0;   // Not read-only (ClassifyCommand) or over the byte budget
+    double elapsed_ms = 0.0;
+};
+
+// Run an opening book on the debugger thread. Each output is cut to a small window (the
+// full text stays pageable via dbg_output_page) and the whole block to max_bytes.
+// Results also land in the result cache, so repeated calls by the agent are free.
+OpeningBookResult RunOpeningBook(WinDbgClient& client, const std::vector<std::string>& commands,
+                                 size_t max_bytes = 16 * 1024);
+
+} // namespace windbg_agent
@@ -1,60 +1,119 @@
 #include "output_capture.hpp"
+#include "output_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
 namespace windbg_agent
 {
 
-OutputCapture::OutputCapture() : ref_count_(1), client_(nullptr), original_callbacks_(nullptr) {}
-
-OutputCapture::~OutputCapture()
+namespace
 {
-    if (client_)
-        Uninstall();
-}
 
-HRESULT OutputCapture::Install(IDebugClient* client)
-{
-    if (client_)
-        return E_FAIL; // Already installed
+// Installed hubs, one per client. All clients the extension is handed belong to the
+// engine thread, which keeps the output ring single-producer.
+std::mutex g_hubs_mutex;
+std::vector<OutputHub*> g_hubs;
 
-    client_ = client;
-    client_->AddRef();
+} // namespace
 
-    // Save original callbacks
-    client_->GetOutputCallbacks(&original_callbacks_);
+OutputHub* OutputHub::Get(IDebugClient* client)
+{
+    if (!client)
+        return nullptr;
 
-    // Install ourselves
-    return client_->SetOutputCallbacks(this);
+    std::lock_guard<std::mutex> lock(g_hubs_mutex);
+    auto it = std::find_if(g_hubs.begin(), g_hubs.end(),
+                           [client](const OutputHub* hub) { return hub->client_ == client; });
+    if (it != g_hubs.end())
+    {
+        // Someone may have replaced the callbacks since; chain in front of them again
+        IDebugOutputCallbacks* current = nullptr;
+        client->GetOutputCallbacks(&current);
+        if (current)
+            current->Release();
+        if (current == *it || SUCCEEDED((*it)->Install()))
+            return *it;
+        return nullptr;
+    }
+
+    auto* hub = new OutputHub(client);
+    if (FAILED(hub->Install()))
+    {
+        hub->Release();
+        return nullptr;
+    }
+    g_hubs.push_back(hub);
+    return hub;
 }
 
-HRESULT OutputCapture::Uninstall()
+void OutputHub::DetachAll()
 {
-    if (!client_)
-        return E_FAIL;
+    std::vector<OutputHub*> hubs;
+    {
+        std::lock_guard<std::mutex> lock(g_hubs_mutex);
+        hubs.swap(g_hubs);
+    }
+    for (auto* hub : hubs)
+    {
+        hub->Uninstall();
+        hub->Release();
+    }
+}
 
-    // Restore original callbacks
-    HRESULT hr = client_->SetOutputCallbacks(original_callbacks_);
+OutputHub::OutputHub(IDebugClient* client)
+    : ref_count_(1), client_(client), original_callbacks_(nullptr)
+{
+    client_->AddRef();
+}
 
+OutputHub::~OutputHub()
+{
     if (original_callbacks_)
-    {
         original_callbacks_->Release();
-        original_callbacks_ = nullptr;
-    }
-
     client_->Release();
-    client_ = nullptr;
+}
+
+HRESULT OutputHub::Install()
+{
+    // Save the callbacks we forward to (the console), then put ourselves in front
+    IDebugOutputCallbacks* original = nullptr;
+    client_->GetOutputCallbacks(&original);
+    HRESULT hr = client_->SetOutputCallbacks(this);
+    if (FAILED(hr))
+    {
+        if (original)
+            original->Release();
+        return hr;
+    }
 
+    if (original_callbacks_)
+        original_callbacks_->Release();
+    original_callbacks_ = original;
     return hr;
 }
 
-std::string OutputCapture::GetAndClear()
+void OutputHub::Uninstall()
 {
-    std::string result = std::move(captured_output_);
-    captured_output_.clear();
-    return result;
+    // Only restore if still in front; otherwise whoever replaced us restores their own
+    IDebugOutputCallbacks* current = nullptr;
+    client_->GetOutputCallbacks(&current);
+    if (current == this)
+        client_->SetOutputCallbacks(original_callbacks_);
+    if (current)
+        current->Release();
+
+    if (original_callbacks_)
+    {
+        original_callbacks_->Release();
+        original_callbacks_ = nullptr;
+    }
 }
 
 // IUnknown implementation
-STDMETHODIMP OutputCapture::QueryInterface(REFIID InterfaceId, PVOID* Interface)
+STDMETHODIMP OutputHub::QueryInterface(REFIID InterfaceId, PVOID* Interface)
 {
     if (InterfaceId == __uuidof(IUnknown) || InterfaceId == __uuidof(IDebugOutputCallbacks))
     {
@@ -66,12 +125,12 @@ STDMETHODIMP OutputCapture::QueryInterface(REFIID InterfaceId, PVOID* Interface)
     return E_NOINTERFACE;
 }
 
-STDMETHODIMP_(ULONG) OutputCapture::AddRef()
+STDMETHODIMP_(ULONG) OutputHub::AddRef()
 {
     return InterlockedIncrement(&ref_count_);
 }
 
-STDMETHODIMP_(ULONG) OutputCapture::Release()
+STDMETHODIMP_(ULONG) OutputHub::Release()
 {
     ULONG count = InterlockedDecrement(&ref_count_);
     if (count == 0)
@@ -80,48 +139,91 @@ STDMETHODIMP_(ULONG) OutputCapture::Release()
 }
 
 // IDebugOutputCallbacks implementation
-STDMETHODIMP OutputCapture::Output(ULONG Mask, PCSTR Text)
+STDMETHODIMP OutputHub::Output(ULONG Mask, PCSTR Text)
 {
-    // Stack-friendly capture: accumulate nested output and flush once at the outermost call.
-    struct StackState
+    if (!Text)
+        return S_OK;
+
+    size_t length = strlen(Text);
+    GetOutputRing().Publish(Mask, Text, length);
+
+    // Output outside any command (or of an echoing one) goes to the console as before
+    bool echo = true;
+    if (capture_)
     {
-        int depth = 0;
-        std::string buffer;
-        bool mask_set = false;
-        ULONG mask = 0;
-    };
-    thread_local StackState state;
-    state.depth++;
-
-    // Capture the output
-    if (Text)
+        capture_->Append(Text, length);
+        echo = capture_->echo_;
+    }
+
+    if (!echo || !original_callbacks_)
+        return S_OK;
+
+    // Re-entrant call (output produced while the original callbacks run): park it in the
+    // bounded pending buffer; the outer call forwards it once the callbacks return.
+    if (forwarding_)
     {
-        captured_output_ += Text;
-        state.buffer += Text;
+        if (pending_.empty())
+            pending_mask_ = Mask;
+        if (pending_.size() + length <= kMaxPendingEcho)
+            pending_.append(Text, length);
+        else
+            pending_dropped_ += length;
+        return S_OK;
     }
-    if (!state.mask_set)
+
+    // Tee the chunk straight through without copying it
+    forwarding_ = true;
+    HRESULT hr = original_callbacks_->Output(Mask, Text);
+
+    while (!pending_.empty() || pending_dropped_ > 0)
     {
-        state.mask = Mask;
-        state.mask_set = true;
+        std::string chunk;
+        chunk.swap(pending_);
+        if (pending_dropped_ > 0)
+        {
+            chunk += "\n[" + std::to_string(pending_dropped_) + " bytes of output not echoed]\n";
+            pending_dropped_ = 0;
+        }
+        original_callbacks_->Output(pending_mask_, chunk.c_str());
     }
+    forwarding_ = false;
 
-    // Nested call: just accumulate and return.
-    if (state.depth > 1)
+    return hr;
+}
+
+OutputCapture::OutputCapture(IDebugClient* client, bool echo, OutputChunkHandler handler)
+    : hub_(OutputHub::Get(client)), handler_(std::move(handler)), echo_(echo)
+{
+    if (hub_)
     {
-        state.depth--;
-        return S_OK;
+        previous_ = hub_->capture_;
+        hub_->capture_ = this;
     }
+}
 
-    // Outermost call: flush accumulated buffer to original callbacks.
-    HRESULT hr = S_OK;
-    if (original_callbacks_)
-        hr = original_callbacks_->Output(state.mask_set ? state.mask : Mask, state.buffer.c_str());
+OutputCapture::~OutputCapture()
+{
+    if (hub_)
+        hub_->capture_ = previous_;
+}
 
-    state.buffer.clear();
-    state.mask_set = false;
-    state.depth--;
+bool OutputCapture::Take(OutputView* view)
+{
+    return sink_.Take(view);
+}
 
-    return hr;
+void OutputCapture::Append(const char* text, size_t length)
+{
+    if (handler_)
+    {
+        // Streaming consumer gone - stop forwarding but keep echoing to the console
+        if (!handler_(text, length))
+            handler_ = nullptr;
+    }
+    else
+    {
+        sink_.Append(text, length);
+    }
 }
 
 } // namespace windbg_agent
@@ -4,24 +4,27 @@
 #include <string>
 #include <windows.h>
 
+#include "command_types.hpp"
+#include "output_sink.hpp"
+
 namespace windbg_agent
 {
 
-// Captures debugger output while optionally forwarding to original callbacks
-class OutputCapture : public IDebugOutputCallbacks
+class OutputCapture;
+
+// Output callbacks installed once per debugger client and left in place, so commands no
+// longer swap callbacks in and out. Every chunk is published to the output ring for
+// asynchronous observers (live output streams, metrics). While a command runs, the
+// innermost OutputCapture also receives each chunk synchronously, so a command's own
+// output is never lost to ring overflow, and decides whether it is echoed to the console.
+class OutputHub : public IDebugOutputCallbacks
 {
   public:
-    OutputCapture();
-    ~OutputCapture();
-
-    // Install this capture on the given client, saving the original callbacks
-    HRESULT Install(IDebugClient* client);
-
-    // Uninstall and restore original callbacks
-    HRESULT Uninstall();
+    // Hub of a client, installing it on first use; nullptr if it cannot be installed
+    static OutputHub* Get(IDebugClient* client);
 
-    // Get the captured output and clear the buffer
-    std::string GetAndClear();
+    // Restore the original callbacks of every client (extension unload)
+    static void DetachAll();
 
     // IUnknown
     STDMETHOD(QueryInterface)(REFIID InterfaceId, PVOID* Interface) override;
@@ -32,10 +35,55 @@ class OutputCapture : public IDebugOutputCallbacks
     STDMETHOD(Output)(ULONG Mask, PCSTR Text) override;
 
   private:
+    friend class OutputCapture;
+
+    explicit OutputHub(IDebugClient* client);
+    ~OutputHub();
+
+    HRESULT Install();
+    void Uninstall();
+
+    // Most output re-entered while forwarding that is held for the console at once
+    static constexpr size_t kMaxPendingEcho = 64 * 1024;
+
     LONG ref_count_;
     IDebugClient* client_;
     IDebugOutputCallbacks* original_callbacks_;
-    std::string captured_output_;
+    OutputCapture* capture_ = nullptr; // Innermost active capture
+    bool forwarding_ = false;          // Inside original_callbacks_->Output
+    std::string pending_;              // Output re-entered while forwarding
+    ULONG pending_mask_ = 0;
+    size_t pending_dropped_ = 0;
+};
+
+// Captures the output of one command through the client's hub for its lifetime.
+// Captures nest; output goes to the innermost one.
+class OutputCapture
+{
+  public:
+    // Without a handler output is buffered (see Take); with one, each chunk is forwarded
+    // as it arrives. echo mirrors the output to the debugger console.
+    OutputCapture(IDebugClient* client, bool echo, OutputChunkHandler handler = nullptr);
+    ~OutputCapture();
+    OutputCapture(const OutputCapture&) = delete;
+    OutputCapture& operator=(const OutputCapture&) = delete;
+
+    // Take the captured output as a view and clear the buffer
+    // (large outputs are spilled to a memory-mapped temp file instead of the heap).
+    // Returns false if output was lost; see OutputSink::Take.
+    bool Take(OutputView* view);
+
+  private:
+    friend class OutputHub;
+
+    // Called by the hub for each chunk
+    void Append(const char* text, size_t length);
+
+    OutputHub* hub_;
+    OutputCapture* previous_ = nullptr;
+    OutputSink sink_;
+    OutputChunkHandler handler_;
+    bool echo_;
 };
 
 } // namespace windbg_agent
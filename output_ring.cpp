@@ -0,0 +1,135 @@
+#include "output_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+size_t RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+} // namespace
+
+OutputRing::OutputRing(size_t slots)
+    : slot_count_(RoundUpToPowerOfTwo(std::max<size_t>(slots, 2))),
+      slots_(new Slot[slot_count_])
+{
+}
+
+OutputRing::~OutputRing() = default;
+
+void OutputRing::Publish(uint32_t mask, const char* text, size_t length)
+{
+    uint64_t n = head_.load(std::memory_order_relaxed);
+    uint64_t offset = bytes_.load(std::memory_order_relaxed);
+
+    while (length > 0)
+    {
+        size_t part = std::min(length, kSlotBytes);
+        Slot& slot = slots_[n & (slot_count_ - 1)];
+
+        slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.offset.store(offset, std::memory_order_relaxed);
+        slot.mask.store(mask, std::memory_order_relaxed);
+        slot.length.store(static_cast<uint32_t>(part), std::memory_order_relaxed);
+        for (size_t i = 0; i * sizeof(uint64_t) < part; i++)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, text + i * sizeof(uint64_t),
+                        std::min(sizeof(uint64_t), part - i * sizeof(uint64_t)));
+            slot.words[i].store(word, std::memory_order_relaxed);
+        }
+
+        slot.seq.store(2 * n + 2, std::memory_order_release);
+
+        n++;
+        offset += part;
+        text += part;
+        length -= part;
+        bytes_.store(offset, std::memory_order_release);
+        head_.store(n, std::memory_order_release);
+    }
+}
+
+OutputRing::Cursor OutputRing::Tail() const
+{
+    Cursor cursor;
+    cursor.slot = head_.load(std::memory_order_acquire);
+    // May already include bytes of a slot published after the head was read; that only
+    // makes the first overflow report smaller
+    cursor.offset = bytes_.load(std::memory_order_acquire);
+    return cursor;
+}
+
+size_t OutputRing::Read(Cursor* cursor, const Handler& handler, uint64_t* dropped_bytes,
+                        size_t max_slots) const
+{
+    char text[kSlotBytes];
+    size_t delivered = 0;
+    uint64_t head = head_.load(std::memory_order_acquire);
+
+    while (cursor->slot < head && delivered < max_slots)
+    {
+        // Lapped: everything older than one ring behind the head is gone
+        if (head - cursor->slot > slot_count_)
+            cursor->slot = head - slot_count_;
+
+        uint64_t n = cursor->slot;
+        const Slot& slot = slots_[n & (slot_count_ - 1)];
+
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != 2 * n + 2)
+        {
+            // Being overwritten by a later lap; the gap is counted at the next good slot
+            cursor->slot++;
+            head = head_.load(std::memory_order_acquire);
+            continue;
+        }
+
+        uint64_t offset = slot.offset.load(std::memory_order_relaxed);
+        uint32_t mask = slot.mask.load(std::memory_order_relaxed);
+        size_t length = std::min<size_t>(slot.length.load(std::memory_order_relaxed), kSlotBytes);
+        for (size_t i = 0; i * sizeof(uint64_t) < length; i++)
+        {
+            uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+            std::memcpy(text + i * sizeof(uint64_t), &word,
+                        std::min(sizeof(uint64_t), length - i * sizeof(uint64_t)));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before)
+        {
+            cursor->slot++;
+            head = head_.load(std::memory_order_acquire);
+            continue;
+        }
+
+        if (cursor->offset != UINT64_MAX && offset > cursor->offset && dropped_bytes)
+            *dropped_bytes += offset - cursor->offset;
+        cursor->offset = offset + length;
+        cursor->slot = n + 1;
+
+        handler(mask, text, length);
+        delivered++;
+    }
+    return delivered;
+}
+
+OutputRing& GetOutputRing()
+{
+    static OutputRing ring;
+    return ring;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace windbg_agent
+{
+
+// Broadcast ring of debugger output: one producer (the engine thread, from the output
+// callbacks) and any number of consumers, each reading at its own pace through its own
+// cursor. Neither side takes a lock and the producer never waits: a consumer that falls
+// more than a ring behind loses the oldest output and is told how many bytes it missed.
+//
+// Each slot is guarded by a sequence number (a seqlock): the producer marks the slot odd
+// while writing it, and a consumer keeps a copy only if the number was the same, even
+// value before and after reading. Slot contents are atomics, so lapping is a detected
+// race rather than undefined behavior.
+class OutputRing
+{
+  public:
+    static constexpr size_t kSlotBytes = 480;     // Text per slot; longer chunks span slots
+    static constexpr size_t kDefaultSlots = 4096; // About 2 MB
+
+    // Where a consumer is; start one with Tail() to see only output published afterwards
+    struct Cursor
+    {
+        uint64_t slot = 0;
+        uint64_t offset = UINT64_MAX; // Byte position expected next (unknown until first read)
+    };
+
+    using Handler = std::function<void(uint32_t mask, const char* text, size_t length)>;
+
+    // slots is rounded up to a power of two
+    explicit OutputRing(size_t slots = kDefaultSlots);
+    ~OutputRing();
+    OutputRing(const OutputRing&) = delete;
+    OutputRing& operator=(const OutputRing&) = delete;
+
+    // Producer side (one thread at a time)
+    void Publish(uint32_t mask, const char* text, size_t length);
+
+    // Cursor positioned after the newest output
+    Cursor Tail() const;
+
+    // Deliver output after *cursor (at most max_slots slots) and advance it. Bytes that
+    // were overwritten before they could be read are added to *dropped_bytes.
+    // Returns the number of slots delivered.
+    size_t Read(Cursor* cursor, const Handler& handler, uint64_t* dropped_bytes,
+                size_t max_slots = SIZE_MAX) const;
+
+    size_t capacity() const { return slot_count_; }
+    uint64_t published_slots() const { return head_.load(std::memory_order_acquire); }
+    uint64_t published_bytes() const { return bytes_.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr size_t kSlotWords = kSlotBytes / sizeof(uint64_t);
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> seq{0};    // 2n+1 while slot n is written, 2n+2 once complete
+        std::atomic<uint64_t> offset{0}; // Byte position of the slot's first byte
+        std::atomic<uint32_t> mask{0};
+        std::atomic<uint32_t> length{0};
+        std::atomic<uint64_t> words[kSlotWords];
+    };
+
+    size_t slot_count_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_{0};  // Slots published
+    std::atomic<uint64_t> bytes_{0}; // Bytes published
+};
+
+// Global ring fed by the debugger output callbacks
+OutputRing& GetOutputRing();
+
+} // namespace windbg_agent
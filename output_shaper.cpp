@@ -0,0 +1,289 @@
+#include "output_shaper.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <string_view>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+// Lines of the raw output (without the newline or a trailing '\r'), as views into it
+std::vector<std::string_view> SplitLines(std::string_view text)
+{
+    std::vector<std::string_view> lines;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos)
+            end = text.size();
+        size_t length = end - pos;
+        if (length > 0 && text[end - 1] == '\r')
+            length--;
+        lines.push_back(text.substr(pos, length));
+        pos = end + 1;
+    }
+    return lines;
+}
+
+// Append whole lines from [first, last) until the byte budget runs out
+// Returns the number of lines appended
+size_t AppendLines(std::string& out, const std::vector<std::string_view>& lines, size_t first,
+                   size_t last, size_t budget)
+{
+    size_t used = 0;
+    size_t count = 0;
+    for (size_t i = first; i < last; i++)
+    {
+        size_t needed = lines[i].size() + 1;
+        if (used + needed > budget)
+        {
+            // Always show something of the first line, even if it alone is over budget
+            if (count == 0 && budget > 0)
+            {
+                out += lines[i].substr(0, budget);
+                out += " [line cut]\n";
+                count++;
+            }
+            break;
+        }
+        out += lines[i];
+        out += '\n';
+        used += needed;
+        count++;
+    }
+    return count;
+}
+
+// Same as AppendLines, but takes lines from the end of the range backwards
+size_t AppendTailLines(std::string& out, const std::vector<std::string_view>& lines,
+                       size_t first, size_t last, size_t budget)
+{
+    size_t used = 0;
+    size_t start = last;
+    while (start > first && used + lines[start - 1].size() + 1 <= budget)
+    {
+        start--;
+        used += lines[start].size() + 1;
+    }
+    for (size_t i = start; i < last; i++)
+    {
+        out += lines[i];
+        out += '\n';
+    }
+    return last - start;
+}
+
+} // namespace
+
+ShapedOutput ShapeOutput(std::string raw, const OutputShapingOptions& options)
+{
+    ShapedOutput shaped;
+    shaped.total_bytes = raw.size();
+
+    // Lines are views into raw; nothing is copied until the shaped text is built
+    auto raw_lines = SplitLines(raw);
+    shaped.total_lines = raw_lines.size();
+    if (!options.enabled)
+    {
+        shaped.text = std::move(raw);
+        return shaped;
+    }
+
+    // Dedup pass: runs of identical lines become one line plus a repeat marker (kept in a
+    // deque so the views into it stay valid)
+    std::vector<std::string_view> lines;
+    lines.reserve(raw_lines.size());
+    std::deque<std::string> markers;
+    bool deduped = false;
+    for (size_t i = 0; i < raw_lines.size();)
+    {
+        size_t run = 1;
+        if (options.dedup)
+        {
+            while (i + run < raw_lines.size() && raw_lines[i + run] == raw_lines[i])
+                run++;
+        }
+        lines.push_back(raw_lines[i]);
+        if (run > 2)
+        {
+            markers.push_back("    [previous line repeated " + std::to_string(run - 1) +
+                              " more times]");
+            lines.push_back(markers.back());
+            deduped = true;
+        }
+        else if (run == 2)
+        {
+            lines.push_back(raw_lines[i + 1]);
+        }
+        i += run;
+    }
+
+    size_t bytes = 0;
+    for (const auto& line : lines)
+        bytes += line.size() + 1;
+
+    bool cut = lines.size() > options.max_lines || bytes > options.max_bytes;
+    if (!deduped && !cut)
+    {
+        shaped.text = std::move(raw);
+        return shaped;
+    }
+
+    std::string text;
+    if (!cut)
+    {
+        text.reserve(bytes);
+        for (const auto& line : lines)
+        {
+            text += line;
+            text += '\n';
+        }
+    }
+    else
+    {
+        // Split the line and byte budgets between the head and tail windows
+        size_t head_max = std::min(options.head_lines, lines.size());
+        size_t tail_max = std::min(options.tail_lines, lines.size() - head_max);
+        size_t windows = std::max<size_t>(head_max + tail_max, 1);
+        size_t head_budget = options.max_bytes * head_max / windows;
+        size_t tail_budget = options.max_bytes - head_budget;
+
+        size_t head = AppendLines(text, lines, 0, head_max, head_budget);
+        std::string tail;
+        size_t tail_count = AppendTailLines(
+            tail, lines, std::max(head, lines.size() - tail_max), lines.size(), tail_budget);
+        size_t omitted = lines.size() - head - tail_count;
+
+        if (omitted > 0)
+            text += "\n... [" + std::to_string(omitted) + " of " + std::to_string(lines.size()) +
+                    " lines omitted] ...\n\n";
+        else
+            text += "\n... [cut to " + std::to_string(options.max_bytes) + " bytes] ...\n\n";
+        text += tail;
+    }
+
+    // The views into raw are not used past this point: the full output moves to the store
+    shaped.shaped = true;
+    shaped.output_id = GetSpillStore().Put(std::move(raw), std::max<size_t>(options.page_lines, 1),
+                                           std::max<size_t>(options.max_bytes, 1), &shaped.pages);
+
+    text += "\n[Output #" + std::to_string(shaped.output_id) + " shaped: " +
+            std::to_string(shaped.total_lines) + " lines, " + std::to_string(shaped.total_bytes) +
+            " bytes in " + std::to_string(shaped.pages) + " page(s). Call dbg_output_page with " +
+            "output_id=" + std::to_string(shaped.output_id) +
+            " and page=1.." + std::to_string(shaped.pages) + " to read the full output.]";
+
+    shaped.text = std::move(text);
+    return shaped;
+}
+
+SpillStore& GetSpillStore()
+{
+    static SpillStore store;
+    return store;
+}
+
+uint64_t SpillStore::Put(std::string text, size_t page_lines, size_t page_bytes, size_t* pages)
+{
+    // An output larger than the whole store keeps its first kMaxBytes (cut at a line end)
+    if (text.size() > kMaxBytes)
+    {
+        static const char kCut[] = "\n[output cut: larger than the spill store]\n";
+        size_t keep = kMaxBytes - (sizeof(kCut) - 1);
+        size_t line_end = text.rfind('\n', keep - 1);
+        text.resize(line_end == std::string::npos ? keep : line_end);
+        text += kCut;
+        text.shrink_to_fit();
+    }
+
+    Entry entry;
+
+    // Page boundaries: page_lines lines, or fewer if that would exceed page_bytes
+    // (a single line longer than page_bytes is split across pages)
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        entry.page_starts.push_back(pos);
+        size_t page_end = pos;
+        size_t count = 0;
+        while (page_end < text.size() && count < page_lines)
+        {
+            size_t line_end = text.find('\n', page_end);
+            line_end = line_end == std::string::npos ? text.size() : line_end + 1;
+            if (line_end - pos > page_bytes)
+            {
+                if (count == 0)
+                    page_end = pos + page_bytes;
+                break;
+            }
+            page_end = line_end;
+            count++;
+        }
+        pos = page_end;
+    }
+    if (entry.page_starts.empty())
+        entry.page_starts.push_back(0);
+
+    if (pages)
+        *pages = entry.page_starts.size();
+
+    entry.text = std::move(text);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.id = next_id_++;
+    uint64_t id = entry.id;
+    bytes_ += entry.text.size();
+    entries_.push_front(std::move(entry));
+
+    // Never evicts the new entry: it alone is at most kMaxBytes
+    while (entries_.size() > 1 && (entries_.size() > kMaxOutputs || bytes_ > kMaxBytes))
+    {
+        bytes_ -= entries_.back().text.size();
+        entries_.pop_back();
+    }
+
+    return id;
+}
+
+bool SpillStore::GetPage(uint64_t id, size_t page, std::string* text, size_t* pages) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [id](const Entry& e) { return e.id == id; });
+    if (it == entries_.end())
+        return false;
+
+    *pages = it->page_starts.size();
+    if (page == 0 || page > it->page_starts.size())
+    {
+        text->clear();
+        return true;
+    }
+
+    size_t start = it->page_starts[page - 1];
+    size_t end = page < it->page_starts.size() ? it->page_starts[page] : it->text.size();
+    text->assign(it->text, start, end - start);
+    return true;
+}
+
+std::string FormatOutputPage(uint64_t id, size_t page)
+{
+    std::string text;
+    size_t pages = 0;
+    if (!GetSpillStore().GetPage(id, page, &text, &pages))
+        return "Error: Output #" + std::to_string(id) +
+               " is not available (unknown id or evicted). Re-run the command.";
+
+    if (page == 0 || page > pages)
+        return "Error: Output #" + std::to_string(id) + " has " + std::to_string(pages) +
+               " page(s); requested page " + std::to_string(page) + ".";
+
+    return "[Output #" + std::to_string(id) + " page " + std::to_string(page) + " of " +
+           std::to_string(pages) + "]\n" + text;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Limits applied to command output before it is returned to the model
+struct OutputShapingOptions
+{
+    bool enabled = true;
+    bool dedup = true;             // Collapse runs of identical consecutive lines
+    size_t max_lines = 400;        // Outputs with more lines are cut to head + tail windows
+    size_t head_lines = 150;       // Lines kept from the start of a cut output
+    size_t tail_lines = 100;       // Lines kept from the end of a cut output
+    size_t max_bytes = 48 * 1024;  // Byte budget for the shaped text (and for each page)
+    size_t page_lines = 400;       // Lines per page when fetching the full output
+};
+
+// Result of shaping a command output
+struct ShapedOutput
+{
+    std::string text;      // What the model sees
+    bool shaped = false;   // True if text differs from the raw output
+    uint64_t output_id = 0; // Spill store id of the full output (0 if not shaped)
+    size_t total_lines = 0;
+    size_t total_bytes = 0;
+    size_t pages = 0;
+};
+
+// Shape raw output according to options. Outputs that are deduplicated or cut are moved
+// whole into the spill store so the model can page through them on demand; pass raw as an
+// rvalue to avoid copying a large output.
+ShapedOutput ShapeOutput(std::string raw, const OutputShapingOptions& options);
+
+// Keeps recent full outputs server-side, split into pages of bounded size
+class SpillStore
+{
+  public:
+    static constexpr size_t kMaxOutputs = 32;
+    static constexpr size_t kMaxBytes = 128 * 1024 * 1024; // Oldest outputs are evicted first
+
+    // Store an output; returns its id (never 0). An output over kMaxBytes is cut to fit.
+    uint64_t Put(std::string text, size_t page_lines, size_t page_bytes, size_t* pages);
+
+    // Fetch one page (1-based). Returns false if the id is unknown or evicted.
+    bool GetPage(uint64_t id, size_t page, std::string* text, size_t* pages) const;
+
+  private:
+    struct Entry
+    {
+        uint64_t id = 0;
+        std::string text;
+        std::vector<size_t> page_starts; // Byte offset of each page
+    };
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_; // Newest first
+    size_t bytes_ = 0;
+    uint64_t next_id_ = 1;
+};
+
+// Global spill store shared by the agent tools in this debugger session
+SpillStore& GetSpillStore();
+
+// Render a page of a spilled output for the model, including a position header
+std::string FormatOutputPage(uint64_t id, size_t page);
+
+} // namespace windbg_agent
@@ -0,0 +1,279 @@
+#include "output_sink.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace windbg_agent
+{
+
+// A mapped spill file; unmapping and closing happen when the owning view goes away
+struct OutputView::Mapping
+{
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE; // Opened with FILE_FLAG_DELETE_ON_CLOSE
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1; // Already unlinked
+#endif
+
+    ~Mapping()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (data)
+            munmap(const_cast<char*>(data), size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+};
+
+OutputView::OutputView() = default;
+OutputView::OutputView(OutputView&& other) noexcept = default;
+OutputView& OutputView::operator=(OutputView&& other) noexcept = default;
+OutputView::~OutputView() = default;
+
+const char* OutputView::data() const
+{
+    return mapping_ ? mapping_->data : memory_.data();
+}
+
+size_t OutputView::size() const
+{
+    return mapping_ ? mapping_->size : memory_.size();
+}
+
+// Anonymous temporary file that is deleted when its last handle closes
+class OutputSink::SpillFile
+{
+  public:
+    ~SpillFile()
+    {
+#ifdef _WIN32
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+#else
+        if (fd_ >= 0)
+            close(fd_);
+#endif
+    }
+
+    bool Open()
+    {
+#ifdef _WIN32
+        char dir[MAX_PATH] = {0};
+        char path[MAX_PATH] = {0};
+        if (!GetTempPathA(MAX_PATH, dir) || !GetTempFileNameA(dir, "wda", 0, path))
+            return false;
+        file_ = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        return file_ != INVALID_HANDLE_VALUE;
+#else
+        const char* dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir && *dir ? dir : "/tmp") + "/windbg_agent_XXXXXX";
+        fd_ = mkstemp(&path[0]);
+        if (fd_ < 0)
+            return false;
+        unlink(path.c_str());
+        return true;
+#endif
+    }
+
+    bool Write(const char* data, size_t length)
+    {
+        while (length > 0)
+        {
+#ifdef _WIN32
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 1u << 30));
+            DWORD written = 0;
+            if (!WriteFile(file_, data, chunk, &written, nullptr) || written == 0)
+                return false;
+#else
+            ssize_t written = write(fd_, data, length);
+            if (written <= 0)
+                return false;
+#endif
+            data += written;
+            length -= static_cast<size_t>(written);
+            size_ += static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // Map the whole file read-only, handing the file over to the mapping
+    std::unique_ptr<OutputView::Mapping> Map()
+    {
+        auto mapping = std::make_unique<OutputView::Mapping>();
+        mapping->size = size_;
+#ifdef _WIN32
+        mapping->file = file_;
+        file_ = INVALID_HANDLE_VALUE;
+        ULARGE_INTEGER size;
+        size.QuadPart = size_;
+        mapping->mapping = CreateFileMappingA(mapping->file, nullptr, PAGE_READONLY,
+                                              size.HighPart, size.LowPart, nullptr);
+        if (!mapping->mapping)
+            return nullptr;
+        mapping->data =
+            static_cast<const char*>(MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!mapping->data)
+            return nullptr;
+#else
+        mapping->fd = fd_;
+        fd_ = -1;
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, mapping->fd, 0);
+        if (data == MAP_FAILED)
+            return nullptr;
+        mapping->data = static_cast<const char*>(data);
+#endif
+        return mapping;
+    }
+
+  private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+    size_t size_ = 0;
+};
+
+OutputSink::OutputSink(size_t spill_threshold) : spill_threshold_(spill_threshold) {}
+
+OutputSink::~OutputSink() = default;
+
+void OutputSink::Append(const char* data, size_t length)
+{
+    if (length == 0)
+        return;
+
+    size_ += length;
+    if (!spill_ && !spill_failed_ && size_ > spill_threshold_)
+        StartSpill();
+
+    while (length > 0)
+    {
+        if (chunks_.empty())
+        {
+            chunks_.push_back(std::make_unique<char[]>(kChunkSize));
+            last_used_ = 0;
+        }
+        else if (last_used_ == kChunkSize)
+        {
+            if (spill_)
+            {
+                FlushChunk(); // Reuse the single staging chunk
+            }
+            else
+            {
+                chunks_.push_back(std::make_unique<char[]>(kChunkSize));
+                last_used_ = 0;
+            }
+        }
+
+        size_t n = std::min(length, kChunkSize - last_used_);
+        std::memcpy(chunks_.back().get() + last_used_, data, n);
+        last_used_ += n;
+        data += n;
+        length -= n;
+    }
+}
+
+bool OutputSink::StartSpill()
+{
+    auto spill = std::make_unique<SpillFile>();
+    if (!spill->Open())
+    {
+        spill_failed_ = true;
+        return false;
+    }
+
+    // Move everything buffered so far into the file, keeping one chunk for staging
+    for (size_t i = 0; i < chunks_.size(); i++)
+    {
+        size_t used = i + 1 == chunks_.size() ? last_used_ : kChunkSize;
+        if (!spill->Write(chunks_[i].get(), used))
+        {
+            spill_failed_ = true;
+            return false;
+        }
+    }
+    if (chunks_.size() > 1)
+        chunks_.resize(1);
+    last_used_ = 0;
+    spill_ = std::move(spill);
+    return true;
+}
+
+void OutputSink::FlushChunk()
+{
+    if (chunks_.empty() || last_used_ == 0)
+        return;
+    if (!spill_->Write(chunks_.back().get(), last_used_))
+    {
+        // Disk full or similar: drop the rest rather than grow the heap without bound
+        spill_failed_ = true;
+        lost_ = true;
+    }
+    last_used_ = 0;
+}
+
+bool OutputSink::Take(OutputView* view)
+{
+    *view = OutputView();
+
+    if (spill_)
+    {
+        FlushChunk();
+        view->mapping_ = spill_->Map();
+        if (!view->mapping_)
+            lost_ = true;
+        spill_.reset();
+    }
+    else if (!chunks_.empty())
+    {
+        // Coalesce into one block, freeing chunks as they are copied
+        view->memory_.reserve(size_);
+        for (size_t i = 0; i < chunks_.size(); i++)
+        {
+            size_t used = i + 1 == chunks_.size() ? last_used_ : kChunkSize;
+            view->memory_.append(chunks_[i].get(), used);
+            chunks_[i].reset();
+        }
+    }
+
+    bool kept = !lost_;
+    Clear();
+    return kept;
+}
+
+void OutputSink::Clear()
+{
+    chunks_.clear();
+    last_used_ = 0;
+    size_ = 0;
+    spill_failed_ = false;
+    lost_ = false;
+    spill_.reset();
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Read-only view of captured output. The view owns its storage (a single in-memory block
+// or a memory-mapped spill file), so the text stays valid for the lifetime of the view.
+class OutputView
+{
+  public:
+    OutputView();
+    OutputView(OutputView&& other) noexcept;
+    OutputView& operator=(OutputView&& other) noexcept;
+    OutputView(const OutputView&) = delete;
+    OutputView& operator=(const OutputView&) = delete;
+    ~OutputView();
+
+    const char* data() const;
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    std::string_view text() const { return std::string_view(data(), size()); }
+
+    // Copy into a std::string (for APIs that need one)
+    std::string str() const { return std::string(data(), size()); }
+
+    // True if the text lives in a mapped spill file rather than process heap
+    bool spilled() const { return mapping_ != nullptr; }
+
+  private:
+    friend class OutputSink;
+    struct Mapping;
+
+    std::string memory_;
+    std::unique_ptr<Mapping> mapping_;
+};
+
+// Append-only output buffer. Small outputs accumulate in fixed-size arena chunks (no
+// reallocation or copying as output grows); past the spill threshold the content moves
+// to a temporary file that is memory-mapped when taken, so huge outputs do not sit in
+// the debugger's heap.
+class OutputSink
+{
+  public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kSpillThreshold = 16 * 1024 * 1024;
+
+    explicit OutputSink(size_t spill_threshold = kSpillThreshold);
+    ~OutputSink();
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    void Append(const char* data, size_t length);
+
+    // Total bytes appended since the last Take/Clear
+    size_t size() const { return size_; }
+
+    // Move the content into *view and reset the sink. Returns false if output was lost (a
+    // spill file write or the final mapping failed); *view then holds only what was kept.
+    bool Take(OutputView* view);
+
+    // Discard the content
+    void Clear();
+
+  private:
+    class SpillFile;
+
+    // Move chunked content into a spill file; returns false if no file could be created
+    bool StartSpill();
+    void FlushChunk();
+
+    size_t spill_threshold_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t last_used_ = 0; // Bytes used in chunks_.back()
+    size_t size_ = 0;
+    bool spill_failed_ = false;
+    bool lost_ = false; // A spill write failed and output was dropped
+    std::unique_ptr<SpillFile> spill_;
+};
+
+} // namespace windbg_agent
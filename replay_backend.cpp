@@ -0,0 +1,250 @@
+#include "replay_backend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+std::string Trim(const std::string& s)
+{
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+// Output is streamed in up to this many pieces of at least kMinStreamChunk bytes,
+// spread over the recorded duration
+constexpr size_t kStreamChunks = 16;
+constexpr size_t kMinStreamChunk = 4096;
+
+} // namespace
+
+bool ParseTextTranscript(const std::string& text, ReplayTarget* target,
+                         std::vector<TranscriptEntry>* entries, std::string* error)
+{
+    std::istringstream in(text);
+    std::string line;
+    size_t line_number = 0;
+    TranscriptEntry* current = nullptr;
+
+    while (std::getline(in, line))
+    {
+        line_number++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (line.compare(0, 4, "=== ") == 0)
+        {
+            // === <elapsed_ms> <status hex> <command>
+            std::istringstream header(line.substr(4));
+            std::string elapsed, status;
+            header >> elapsed >> status;
+            std::string command;
+            std::getline(header, command);
+            command = Trim(command);
+            if (elapsed.empty() || status.empty() || command.empty())
+            {
+                if (error)
+                    *error = "line " + std::to_string(line_number) +
+                             ": expected '=== <elapsed_ms> <status> <command>'";
+                return false;
+            }
+
+            TranscriptEntry entry;
+            entry.command = command;
+            entry.elapsed_ms = std::strtod(elapsed.c_str(), nullptr);
+            entry.status =
+                ToStatus(static_cast<uint32_t>(std::strtoul(status.c_str(), nullptr, 16)));
+            entries->push_back(std::move(entry));
+            current = &entries->back();
+            continue;
+        }
+
+        if (current)
+        {
+            if (!line.empty() && line[0] == '\\')
+                line.erase(0, 1);
+            current->output += line;
+            current->output += '\n';
+            continue;
+        }
+
+        // Header section: comments and "key: value" target fields
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            if (error)
+                *error = "line " + std::to_string(line_number) + ": expected 'key: value'";
+            return false;
+        }
+        std::string key = Trim(line.substr(0, colon));
+        std::string value = Trim(line.substr(colon + 1));
+        if (key == "target")
+            target->name = value;
+        else if (key == "architecture")
+            target->architecture = value;
+        else if (key == "debugger")
+            target->debugger = value;
+        else if (key == "state")
+            target->state = value;
+        else if (key == "pid")
+            target->pid = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    }
+
+    return true;
+}
+
+ReplayBackend::ReplayBackend(ReplayTarget target, std::vector<TranscriptEntry> entries)
+    : target_(std::move(target)), entries_(std::move(entries))
+{
+    for (size_t i = 0; i < entries_.size(); i++)
+        by_command_[Trim(entries_[i].command)].push_back(i);
+}
+
+std::unique_ptr<ReplayBackend> ReplayBackend::Load(const std::string& path, std::string* error)
+{
+    if (IsBinaryTranscript(path))
+    {
+        TranscriptReader reader;
+        if (!reader.Open(path, error))
+            return nullptr;
+
+        ReplayTarget target;
+        target.name = reader.header().target;
+        target.architecture = reader.header().architecture;
+        target.debugger = reader.header().debugger;
+        target.pid = reader.header().pid;
+
+        // Streamed records carry no output and cache hits no latency; replay only the rest
+        std::vector<TranscriptEntry> entries;
+        for (uint64_t seq = 0; seq < reader.size(); seq++)
+        {
+            TranscriptEntry entry;
+            if (!reader.Read(seq, &entry))
+            {
+                if (error)
+                    *error = path + ": cannot read record " + std::to_string(seq);
+                return nullptr;
+            }
+            if (!entry.streamed && !entry.cached)
+                entries.push_back(std::move(entry));
+        }
+        return std::make_unique<ReplayBackend>(std::move(target), std::move(entries));
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        if (error)
+            *error = "cannot open " + path;
+        return nullptr;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+
+    ReplayTarget target;
+    target.name = path;
+    std::vector<TranscriptEntry> entries;
+    std::string parse_error;
+    if (!ParseTextTranscript(contents.str(), &target, &entries, &parse_error))
+    {
+        if (error)
+            *error = path + ": " + parse_error;
+        return nullptr;
+    }
+
+    return std::make_unique<ReplayBackend>(std::move(target), std::move(entries));
+}
+
+const TranscriptEntry* ReplayBackend::Next(const std::string& command)
+{
+    auto it = by_command_.find(Trim(command));
+    if (it == by_command_.end())
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t& cursor = cursor_[it->first];
+    const TranscriptEntry* entry = &entries_[it->second[cursor]];
+    if (cursor + 1 < it->second.size())
+        cursor++;
+    return entry;
+}
+
+void ReplayBackend::Sleep(double ms) const
+{
+    double scaled = ms * latency_scale_;
+    if (scaled > 0.0)
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(scaled));
+}
+
+long ReplayBackend::Execute(const std::string& command, bool echo, OutputView* output)
+{
+    const TranscriptEntry* entry = Next(command);
+    if (!entry)
+    {
+        misses_++;
+        return kStatusNotFound;
+    }
+
+    Sleep(entry->elapsed_ms);
+
+    OutputSink sink;
+    sink.Append(entry->output.data(), entry->output.size());
+    if (!sink.Take(output))
+        return kStatusOutputLost;
+
+    if (echo)
+        Display(DisplayStyle::Raw, entry->output);
+    return entry->status;
+}
+
+long ReplayBackend::ExecuteStreaming(const std::string& command, bool echo,
+                                     const OutputChunkHandler& on_chunk)
+{
+    const TranscriptEntry* entry = Next(command);
+    if (!entry)
+    {
+        misses_++;
+        return kStatusNotFound;
+    }
+
+    const std::string& text = entry->output;
+    size_t chunk = std::max(text.size() / kStreamChunks, kMinStreamChunk);
+    size_t pieces = text.empty() ? 1 : (text.size() + chunk - 1) / chunk;
+    double delay = entry->elapsed_ms / static_cast<double>(pieces);
+
+    bool receiving = true;
+    for (size_t pos = 0; pos < text.size(); pos += chunk)
+    {
+        Sleep(delay);
+        size_t length = std::min(chunk, text.size() - pos);
+        if (receiving)
+            receiving = on_chunk(text.data() + pos, length);
+        if (echo)
+            Display(DisplayStyle::Raw, text.substr(pos, length));
+    }
+    if (text.empty())
+        Sleep(delay);
+
+    return entry->status;
+}
+
+void ReplayBackend::Display(DisplayStyle style, const std::string& text)
+{
+    if (display_)
+        display_(style, text);
+}
+
+} // namespace windbg_agent
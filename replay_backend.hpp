@@ -0,0 +1,106 @@
+#pragma once
+
+#include "debugger_backend.hpp"
+#include "transcript.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Target description reported by a replay session
+struct ReplayTarget
+{
+    std::string name;
+    std::string architecture;
+    std::string debugger = "Replay";
+    std::string state = "Break";
+    uint32_t pid = 0;
+};
+
+// Backend that answers commands from a recorded transcript instead of a debugger engine,
+// so the client, caches, servers and agent loop can run (and be load-tested) anywhere.
+// Accepts binary transcripts written by TranscriptRecorder and text fixtures.
+//
+// Text transcript format (hand-editable fixtures):
+//
+//   # comment
+//   target: crash.dmp
+//   architecture: x64
+//   debugger: CDB
+//   state: Break
+//   pid: 4242
+//   === <elapsed_ms> <status hex> <command>
+//   <output lines>
+//   === ...
+//
+// Output lines starting with '\' have that character removed (to escape "=== ").
+class ReplayBackend : public IDebuggerBackend
+{
+  public:
+    using DisplayHandler = std::function<void(DisplayStyle style, const std::string& text)>;
+
+    ReplayBackend(ReplayTarget target, std::vector<TranscriptEntry> entries);
+
+    // Load a transcript file (binary or text); returns nullptr and sets error on failure
+    static std::unique_ptr<ReplayBackend> Load(const std::string& path, std::string* error);
+
+    // Scale recorded latencies (1.0 = as recorded, 0 = instant)
+    void SetLatencyScale(double scale) { latency_scale_ = scale; }
+
+    // Receive messages the client displays (discarded by default)
+    void SetDisplayHandler(DisplayHandler handler) { display_ = std::move(handler); }
+
+    // Simulate Ctrl+C; IsInterrupted() reports it once
+    void Interrupt() { interrupted_ = true; }
+
+    // Commands requested that have no recording
+    uint64_t misses() const { return misses_.load(); }
+
+    bool IsAvailable() const override { return true; }
+    long Execute(const std::string& command, bool echo, OutputView* output) override;
+    long ExecuteStreaming(const std::string& command, bool echo,
+                          const OutputChunkHandler& on_chunk) override;
+
+    void Display(DisplayStyle style, const std::string& text) override;
+    bool SupportsColor() const override { return false; }
+
+    std::string GetTargetName() const override { return target_.name; }
+    std::string GetTargetArchitecture() const override { return target_.architecture; }
+    std::string GetDebuggerType() const override { return target_.debugger; }
+    std::string GetTargetState() const override { return target_.state; }
+    uint32_t GetProcessId() const override { return target_.pid; }
+    std::string GetContextKey() const override { return "replay|" + target_.name; }
+    bool IsInterrupted() const override { return interrupted_.exchange(false); }
+
+  private:
+    // Next recording for a command (recordings of the same command are served in order,
+    // the last one repeats); nullptr if the command was never recorded
+    const TranscriptEntry* Next(const std::string& command);
+
+    void Sleep(double ms) const;
+
+    ReplayTarget target_;
+    std::vector<TranscriptEntry> entries_;
+    std::unordered_map<std::string, std::vector<size_t>> by_command_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, size_t> cursor_; // guarded by mutex_
+
+    double latency_scale_ = 1.0;
+    DisplayHandler display_;
+    mutable std::atomic<bool> interrupted_{false};
+    std::atomic<uint64_t> misses_{0};
+};
+
+// Parse a text transcript (see ReplayBackend); returns false and sets error on failure
+bool ParseTextTranscript(const std::string& text, ReplayTarget* target,
+                         std::vector<TranscriptEntry>* entries, std::string* error);
+
+} // namespace windbg_agent
@@ -0,0 +1,281 @@
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+#include <vector>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+std::string Trim(const std::string& s)
+{
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+std::string ToLower(std::string s)
+{
+    for (auto& c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// Split a command line on ';' separators outside of quoted strings
+std::vector<std::string> SplitCommands(const std::string& command)
+{
+    std::vector<std::string> parts;
+    std::string current;
+    bool quoted = false;
+    for (char c : command)
+    {
+        if (c == '"')
+            quoted = !quoted;
+        if (c == ';' && !quoted)
+        {
+            parts.push_back(Trim(current));
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    parts.push_back(Trim(current));
+    return parts;
+}
+
+// Extension commands (!name or !module.name) that only display state
+bool IsReadOnlyExtension(const std::string& name)
+{
+    static const char* const kReadOnly[] = {
+        "analyze", "peb",     "teb",  "address", "heap",   "handle", "locks", "cs",
+        "gle",     "error",   "dh",   "lmi",     "vprot",  "runaway", "uniqstack",
+        "exchain", "process", "thread", "object", "pte",   "pool",   "vm",    "irp",
+        "devobj",  "drvobj",  "dlls", "findstack", "token", "mapped_file",
+    };
+    return std::find(std::begin(kReadOnly), std::end(kReadOnly), name) != std::end(kReadOnly);
+}
+
+// Switches that make an otherwise read-only extension change state: !heap -p enables or
+// disables page heap (its -a lookups just go uncached) and !heap -flt sets a filter that
+// outlives the command
+bool HasMutatingSwitch(const std::string& name, const std::string& args)
+{
+    static const std::pair<const char*, const char*> kMutating[] = {
+        {"heap", "p"},
+        {"heap", "flt"},
+    };
+    size_t pos = 0;
+    while ((pos = args.find_first_not_of(" \t", pos)) != std::string::npos)
+    {
+        size_t end = args.find_first_of(" \t", pos);
+        if (end == std::string::npos)
+            end = args.size();
+        if (args[pos] == '-' || args[pos] == '/')
+        {
+            std::string option = ToLower(args.substr(pos + 1, end - pos - 1));
+            for (const auto& entry : kMutating)
+            {
+                if (name == entry.first && option == entry.second)
+                    return true;
+            }
+        }
+        pos = end;
+    }
+    return false;
+}
+
+// Dot commands that only display state (.ecxr, .frame N, .cxr etc. change context; .time
+// shows the wall clock in live sessions)
+bool IsReadOnlyDotCommand(const std::string& name)
+{
+    static const char* const kReadOnly[] = {
+        "lastevent", "exr", "formats", "fnent", "chain",
+    };
+    return std::find(std::begin(kReadOnly), std::end(kReadOnly), name) != std::end(kReadOnly);
+}
+
+bool IsReadOnlySingle(const std::string& part)
+{
+    if (part.empty())
+        return true;
+
+    // Alias expansion and script invocation make output depend on more than target state
+    if (part.find("${") != std::string::npos || part.find("$$") != std::string::npos)
+        return false;
+
+    // Leading identifier (letters/digits/underscore) after an optional prefix character
+    auto read_name = [&part](size_t pos)
+    {
+        size_t end = pos;
+        while (end < part.size() &&
+               (std::isalnum(static_cast<unsigned char>(part[end])) || part[end] == '_' ||
+                part[end] == '.'))
+            end++;
+        return ToLower(part.substr(pos, end - pos));
+    };
+
+    char first = part[0];
+    if (first == '!')
+    {
+        std::string name = read_name(1);
+        std::string args = part.substr(1 + name.size());
+        size_t dot = name.rfind('.');
+        if (dot != std::string::npos)
+            name = name.substr(dot + 1);
+        return IsReadOnlyExtension(name) && !HasMutatingSwitch(name, args);
+    }
+    if (first == '.')
+        return IsReadOnlyDotCommand(read_name(1));
+    if (first == '~' || first == '|')
+        return part.size() == 1; // Bare listing; ~Ns / |Ns switch context
+    if (first == '?')
+        return part.find('=') == std::string::npos; // ?? can assign through C++ expressions
+
+    // Regular commands: the name token ends at the first non-letter
+    size_t end = 0;
+    while (end < part.size() && std::isalpha(static_cast<unsigned char>(part[end])))
+        end++;
+    std::string name = part.substr(0, end);
+    if (name.empty())
+        return false;
+    std::string lower = ToLower(name);
+
+    if (lower.compare(0, 2, "lm") == 0) // lm, lmv, lmvm, lmf, ...
+        return true;
+    if (lower[0] == 'k') // k, kb, kp, kP, kv, kn, kc, kf, ...
+        return true;
+    if (lower[0] == 'd') // da, db, dd, dq, dps, dt, dv, ... (dx can assign or call)
+        return lower.compare(0, 2, "dx") != 0;
+    if (lower == "u" || lower == "ub" || lower == "uf")
+        return true;
+    if (lower == "x" || lower == "ln" || lower == "s" || lower == "vertarget")
+        return true;
+    if (lower == "r") // Register display only; r reg=value assigns
+        return part.find('=') == std::string::npos;
+
+    return false;
+}
+
+} // namespace
+
+CommandEffect ClassifyCommand(const std::string& command)
+{
+    std::string trimmed = Trim(command);
+    if (trimmed.empty())
+        return CommandEffect::Mutating;
+
+    for (const auto& part : SplitCommands(trimmed))
+    {
+        if (!IsReadOnlySingle(part))
+            return CommandEffect::Mutating;
+    }
+    return CommandEffect::ReadOnly;
+}
+
+ResultCache& GetResultCache()
+{
+    static ResultCache cache;
+    return cache;
+}
+
+std::string ResultCache::MakeKey(const std::string& context, const std::string& command)
+{
+    return context + '\n' + Trim(command);
+}
+
+bool ResultCache::Lookup(const std::string& context, const std::string& command,
+                         std::string* output)
+{
+    std::string key = MakeKey(context, command);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end())
+    {
+        misses_++;
+        return false;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_++;
+    saved_ms_ += it->second->elapsed_ms;
+    *output = it->second->output;
+    return true;
+}
+
+void ResultCache::Store(const std::string& context, const std::string& command,
+                        const std::string& output, double elapsed_ms)
+{
+    if (output.size() > kMaxEntryBytes)
+        return;
+
+    std::string key = MakeKey(context, command);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end())
+    {
+        bytes_ -= it->second->key.size() + it->second->output.size();
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    EvictToFit(key.size() + output.size());
+
+    Entry entry;
+    entry.key = key;
+    entry.output = output;
+    entry.elapsed_ms = elapsed_ms;
+    bytes_ += key.size() + output.size();
+    lru_.push_front(std::move(entry));
+    index_.emplace(std::move(key), lru_.begin());
+}
+
+void ResultCache::EvictToFit(size_t incoming)
+{
+    while (!lru_.empty() && (lru_.size() >= kMaxEntries || bytes_ + incoming > kMaxBytes))
+    {
+        const Entry& victim = lru_.back();
+        bytes_ -= victim.key.size() + victim.output.size();
+        index_.erase(victim.key);
+        lru_.pop_back();
+    }
+}
+
+void ResultCache::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    invalidations_++;
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+uint64_t ResultCache::epoch() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+}
+
+ResultCacheStats ResultCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats stats;
+    stats.epoch = epoch_;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.invalidations = invalidations_;
+    stats.entries = lru_.size();
+    stats.bytes = bytes_;
+    stats.saved_ms = saved_ms_;
+    return stats;
+}
+
+} // namespace windbg_agent
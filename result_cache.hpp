@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace windbg_agent
+{
+
+// How executing a debugger command affects engine or target state
+enum class CommandEffect
+{
+    ReadOnly, // Display-only; output depends only on target state and engine context
+    Mutating  // Anything else, including commands not recognized as read-only
+};
+
+// Classify a command line (including ';'-separated sequences) against a conservative
+// allow-list of display commands. Unrecognized commands are treated as mutating.
+CommandEffect ClassifyCommand(const std::string& command);
+
+// Snapshot of result cache counters
+struct ResultCacheStats
+{
+    uint64_t epoch = 0;         // Debugger state epoch (bumped on every invalidation)
+    uint64_t hits = 0;          // Lookups answered from the cache
+    uint64_t misses = 0;        // Lookups of read-only commands not in the cache
+    uint64_t invalidations = 0; // Epoch bumps (state changes and mutating commands)
+    size_t entries = 0;
+    size_t bytes = 0;
+    double saved_ms = 0.0; // Execution time avoided by hits
+};
+
+// Memoizes output of read-only commands while the debugger state is unchanged.
+// Entries are keyed by engine context (target, process, thread, frame) plus the command
+// text and are dropped wholesale whenever the state epoch is bumped.
+class ResultCache
+{
+  public:
+    static constexpr size_t kMaxEntries = 512;
+    static constexpr size_t kMaxBytes = 32 * 1024 * 1024;
+    static constexpr size_t kMaxEntryBytes = 4 * 1024 * 1024; // Larger outputs are not cached
+
+    // Look up cached output; context identifies the engine context the command runs in
+    bool Lookup(const std::string& context, const std::string& command, std::string* output);
+
+    // Remember the output of a successful read-only command
+    void Store(const std::string& context, const std::string& command, const std::string& output,
+               double elapsed_ms);
+
+    // Bump the state epoch and drop every entry
+    void Invalidate();
+
+    // Current debugger state epoch; other caches of target state compare against it
+    uint64_t epoch() const;
+
+    ResultCacheStats GetStats() const;
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        std::string output;
+        double elapsed_ms = 0.0;
+    };
+
+    static std::string MakeKey(const std::string& context, const std::string& command);
+    void EvictToFit(size_t incoming); // mutex_ held
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+
+    // Counters (guarded by mutex_)
+    uint64_t epoch_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t invalidations_ = 0;
+    double saved_ms_ = 0.0;
+};
+
+// Global result cache shared by every WinDbgClient in this debugger session
+ResultCache& GetResultCache();
+
+} // namespace windbg_agent
@@ -74,17 +74,17 @@ void SessionStore::ClearSession(const std::string& target_name, const std::strin
 
 void SessionStore::Load()
 {
-    // Load from settings
-    Settings settings = LoadSettings();
-    sessions_ = settings.sessions;
+    // Load from cached settings
+    sessions_ = GetSettingsStore().Get()->sessions;
 }
 
 void SessionStore::Save() const
 {
-    // Load current settings, update sessions, save back
-    Settings settings = LoadSettings();
+    // Update sessions in the cached settings (written on the next settings flush)
+    auto& store = GetSettingsStore();
+    Settings settings = *store.Get();
     settings.sessions = sessions_;
-    SaveSettings(settings);
+    store.Set(std::move(settings));
 }
 
 } // namespace windbg_agent
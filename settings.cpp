@@ -84,6 +84,34 @@ Settings LoadSettings()
                 if (j.contains("response_timeout_ms"))
                     settings.response_timeout_ms = j["response_timeout_ms"].get<int>();
 
+                if (j.contains("output_shaping"))
+                {
+                    const auto& shaping_json = j["output_shaping"];
+                    auto& shaping = settings.output_shaping;
+                    shaping.enabled = shaping_json.value("enabled", shaping.enabled);
+                    shaping.dedup = shaping_json.value("dedup", shaping.dedup);
+                    shaping.max_lines = shaping_json.value("max_lines", shaping.max_lines);
+                    shaping.head_lines = shaping_json.value("head_lines", shaping.head_lines);
+                    shaping.tail_lines = shaping_json.value("tail_lines", shaping.tail_lines);
+                    shaping.max_bytes = shaping_json.value("max_bytes", shaping.max_bytes);
+                    shaping.page_lines = shaping_json.value("page_lines", shaping.page_lines);
+                }
+
+                if (j.contains("server_echo"))
+                    settings.server_echo = j["server_echo"].get<bool>();
+
+                if (j.contains("record_transcript"))
+                    settings.record_transcript = j["record_transcript"].get<bool>();
+                if (j.contains("transcript_compress"))
+                    settings.transcript_compress = j["transcript_compress"].get<bool>();
+
+                if (j.contains("agent_prewarm"))
+                    settings.agent_prewarm = j["agent_prewarm"].get<bool>();
+                if (j.contains("opening_book"))
+                    settings.opening_book = j["opening_book"].get<std::vector<std::string>>();
+                if (j.contains("symbol_prefetch"))
+                    settings.symbol_prefetch = j["symbol_prefetch"].get<int>();
+
                 if (j.contains("sessions"))
                     for (auto& [key, value] : j["sessions"].items())
                         settings.sessions[key] = value.get<std::string>();
@@ -138,6 +166,19 @@ void SaveSettings(const Settings& settings)
         j["custom_prompt"] = settings.custom_prompt;
     if (settings.response_timeout_ms > 0)
         j["response_timeout_ms"] = settings.response_timeout_ms;
+    j["server_echo"] = settings.server_echo;
+    j["record_transcript"] = settings.record_transcript;
+    j["transcript_compress"] = settings.transcript_compress;
+    j["agent_prewarm"] = settings.agent_prewarm;
+    j["opening_book"] = settings.opening_book;
+    j["symbol_prefetch"] = settings.symbol_prefetch;
+
+    const auto& shaping = settings.output_shaping;
+    j["output_shaping"] = {{"enabled", shaping.enabled},       {"dedup", shaping.dedup},
+                           {"max_lines", shaping.max_lines},   {"head_lines", shaping.head_lines},
+                           {"tail_lines", shaping.tail_lines}, {"max_bytes", shaping.max_bytes},
+                           {"page_lines", shaping.page_lines}};
+
     if (!settings.sessions.empty())
     {
         json sessions_json;
@@ -174,4 +215,63 @@ void SaveSettings(const Settings& settings)
         file << j.dump(2);
 }
 
+SettingsStore& GetSettingsStore()
+{
+    static SettingsStore store;
+    return store;
+}
+
+std::shared_ptr<const Settings> SettingsStore::Get()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Unflushed local changes win over the file on disk
+    if (snapshot_ && (dirty_ || !FileChanged()))
+        return snapshot_;
+
+    snapshot_ = std::make_shared<const Settings>(LoadSettings());
+    Stamp();
+    return snapshot_;
+}
+
+void SettingsStore::Set(Settings settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot_ = std::make_shared<const Settings>(std::move(settings));
+    dirty_ = true;
+}
+
+void SettingsStore::Flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ || !snapshot_)
+        return;
+
+    SaveSettings(*snapshot_);
+    Stamp();
+    dirty_ = false;
+}
+
+bool SettingsStore::FileChanged() const
+{
+    std::error_code ec;
+    auto mtime = fs::last_write_time(path_, ec);
+    if (ec)
+        return true;
+    auto size = fs::file_size(path_, ec);
+    if (ec)
+        return true;
+    return mtime != mtime_ || size != size_;
+}
+
+void SettingsStore::Stamp()
+{
+    if (path_.empty())
+        path_ = GetSettingsPath();
+
+    std::error_code ec;
+    mtime_ = fs::last_write_time(path_, ec);
+    size_ = ec ? 0 : fs::file_size(path_, ec);
+}
+
 } // namespace windbg_agent
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "opening_book.hpp"
+#include "output_shaper.hpp"
 #include <libagents/config.hpp>
 #include <libagents/provider.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace windbg_agent
 {
@@ -46,6 +53,29 @@ struct Settings
     // Response timeout in milliseconds (0 = use default 60s)
     int response_timeout_ms = 120000; // 2 minutes default
 
+    // Limits applied to command output returned to the AI (head/tail windows, dedup, paging)
+    OutputShapingOptions output_shaping;
+
+    // Echo output of commands run by HTTP/MCP clients to the debugger console
+    bool server_echo = true;
+
+    // Record every executed command into ~/.windbg_agent/transcripts (binary, indexed)
+    bool record_transcript = false;
+
+    // LZ-compress recorded command output
+    bool transcript_compress = true;
+
+    // Start the AI provider in the background at load, and keep a spare agent ready so
+    // provider switches and !agent clear are instant
+    bool agent_prewarm = true;
+
+    // Read-only commands run while the agent starts, their results sent with the first
+    // message on a target (empty = off)
+    std::vector<std::string> opening_book = DefaultOpeningBook();
+
+    // Background threads loading module symbols when an agent session starts (0 = off)
+    int symbol_prefetch = 2;
+
     // Session ID mappings (target_path|provider -> session_id)
     std::unordered_map<std::string, std::string> sessions;
 
@@ -86,4 +116,38 @@ void SaveSettings(const Settings& settings);
 // Parse provider type from string (e.g., "claude", "copilot")
 libagents::ProviderType ParseProviderType(const std::string& name);
 
+// Process-wide settings cache used by the extension.
+// Parses settings.json once and serves immutable snapshots; the file is only re-parsed
+// when its size or modification time changes. Writes replace the cached snapshot
+// immediately and are coalesced into a single disk write on Flush().
+class SettingsStore
+{
+  public:
+    // Get the current snapshot (cheap unless settings.json changed on disk)
+    std::shared_ptr<const Settings> Get();
+
+    // Replace the cached settings (written to disk on the next Flush)
+    void Set(Settings settings);
+
+    // Write pending changes to disk (no-op if nothing changed)
+    void Flush();
+
+  private:
+    // Check whether settings.json differs from the last loaded/saved version
+    bool FileChanged() const;
+
+    // Remember size and modification time of settings.json
+    void Stamp();
+
+    std::mutex mutex_;
+    std::shared_ptr<const Settings> snapshot_;
+    bool dirty_ = false;
+    std::string path_;
+    std::filesystem::file_time_type mtime_{};
+    std::uintmax_t size_ = 0;
+};
+
+// Global settings store
+SettingsStore& GetSettingsStore();
+
 } // namespace windbg_agent
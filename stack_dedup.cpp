@@ -0,0 +1,141 @@
+#include "stack_dedup.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+// Below this many stacks a single thread is faster than starting workers
+constexpr size_t kParallelThreshold = 2048;
+constexpr size_t kMaxWorkers = 16;
+
+uint64_t HashFrames(const std::vector<uint64_t>& frames)
+{
+    // splitmix64 finalizer over each frame, chained; frame count seeds the hash so prefixes
+    // of a stack do not collide with it
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ frames.size();
+    for (uint64_t frame : frames)
+    {
+        uint64_t x = hash ^ frame;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        hash = x ^ (x >> 31);
+    }
+    return hash;
+}
+
+// Run body(begin, end) over [0, count) split across workers
+template <typename Body> void ParallelFor(size_t count, size_t workers, const Body& body)
+{
+    if (workers <= 1)
+    {
+        body(size_t(0), count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    size_t step = (count + workers - 1) / workers;
+    for (size_t begin = step; begin < count; begin += step)
+        threads.emplace_back([&body, begin, step, count]()
+                             { body(begin, std::min(count, begin + step)); });
+    body(size_t(0), std::min(count, step));
+    for (auto& thread : threads)
+        thread.join();
+}
+
+struct HashedStack
+{
+    uint64_t hash;
+    uint32_t index;
+};
+
+// Group the stacks of one bucket: sort by hash, then split each run of equal hashes by
+// frames (a true collision starts a new group)
+void GroupBucket(const std::vector<ThreadStack>& stacks, std::vector<HashedStack>* entries,
+                 std::vector<StackGroup>* groups)
+{
+    std::sort(entries->begin(), entries->end(),
+              [](const HashedStack& a, const HashedStack& b)
+              { return a.hash < b.hash || (a.hash == b.hash && a.index < b.index); });
+
+    size_t run = 0;
+    while (run < entries->size())
+    {
+        size_t run_end = run;
+        while (run_end < entries->size() && (*entries)[run_end].hash == (*entries)[run].hash)
+            run_end++;
+
+        size_t first_group = groups->size();
+        for (size_t e = run; e < run_end; e++)
+        {
+            uint32_t index = (*entries)[e].index;
+            size_t g = first_group;
+            while (g < groups->size() && (*groups)[g].frames != stacks[index].frames)
+                g++;
+            if (g == groups->size())
+            {
+                groups->emplace_back();
+                groups->back().frames = stacks[index].frames;
+            }
+            (*groups)[g].threads.push_back(index);
+        }
+        run = run_end;
+    }
+}
+
+} // namespace
+
+std::vector<StackGroup> GroupStacks(const std::vector<ThreadStack>& stacks)
+{
+    size_t count = stacks.size();
+    size_t workers = 1;
+    if (count >= kParallelThreshold)
+    {
+        workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                   kMaxWorkers);
+    }
+
+    // Phase 1: hash every stack
+    std::vector<uint64_t> hashes(count);
+    ParallelFor(count, workers,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                        hashes[i] = HashFrames(stacks[i].frames);
+                });
+
+    // Phase 2: partition (hash, index) pairs by hash so equal stacks share a bucket
+    std::vector<std::vector<HashedStack>> buckets(workers);
+    for (size_t i = 0; i < count; i++)
+        buckets[hashes[i] % workers].push_back({hashes[i], static_cast<uint32_t>(i)});
+
+    // Phase 3: sort and group each bucket independently
+    std::vector<std::vector<StackGroup>> bucket_groups(workers);
+    ParallelFor(workers, workers,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t b = begin; b < end; b++)
+                        GroupBucket(stacks, &buckets[b], &bucket_groups[b]);
+                });
+
+    std::vector<StackGroup> groups;
+    for (auto& bucket : bucket_groups)
+    {
+        for (auto& group : bucket)
+            groups.push_back(std::move(group));
+    }
+    std::sort(groups.begin(), groups.end(),
+              [](const StackGroup& a, const StackGroup& b)
+              {
+                  if (a.threads.size() != b.threads.size())
+                      return a.threads.size() > b.threads.size();
+                  return a.threads.front() < b.threads.front();
+              });
+    return groups;
+}
+
+} // namespace windbg_agent
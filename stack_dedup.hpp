@@ -0,0 +1,25 @@
+#pragma once
+
+#include "debugger_backend.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Threads sharing one call stack
+struct StackGroup
+{
+    std::vector<uint64_t> frames;  // Instruction offsets, innermost first
+    std::vector<uint32_t> threads; // Indices into the input stacks, ascending
+};
+
+// Group identical stacks (same frames in the same order). Each stack is hashed once; the
+// hashes are then partitioned into buckets that are sorted and grouped independently, so
+// both phases run on all cores for large thread counts and only stacks whose hashes match
+// are ever compared frame by frame. Groups are ordered by thread count (largest first),
+// then by their first thread.
+std::vector<StackGroup> GroupStacks(const std::vector<ThreadStack>& stacks);
+
+} // namespace windbg_agent
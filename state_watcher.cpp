@@ -0,0 +1,116 @@
+#include "state_watcher.hpp"
+#include "result_cache.hpp"
+
+#include <mutex>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+std::mutex g_watcher_mutex;
+StateWatcher* g_watcher = nullptr;
+
+} // namespace
+
+void StateWatcher::Install(IDebugClient* client)
+{
+    if (!client)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_watcher_mutex);
+    if (g_watcher)
+        return;
+
+    IDebugClient* own = nullptr;
+    if (FAILED(client->CreateClient(&own)))
+        return;
+
+    auto* watcher = new StateWatcher(own);
+    own->Release(); // The watcher holds its own reference
+    if (FAILED(own->SetEventCallbacks(watcher)))
+    {
+        watcher->Release();
+        return;
+    }
+    g_watcher = watcher;
+}
+
+void StateWatcher::Uninstall()
+{
+    StateWatcher* watcher = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_watcher_mutex);
+        watcher = g_watcher;
+        g_watcher = nullptr;
+    }
+    if (!watcher)
+        return;
+
+    watcher->client_->SetEventCallbacks(nullptr);
+    watcher->Release();
+}
+
+StateWatcher::StateWatcher(IDebugClient* client) : ref_count_(1), client_(client)
+{
+    client_->AddRef();
+}
+
+StateWatcher::~StateWatcher()
+{
+    client_->Release();
+}
+
+STDMETHODIMP_(ULONG) StateWatcher::AddRef()
+{
+    return InterlockedIncrement(&ref_count_);
+}
+
+STDMETHODIMP_(ULONG) StateWatcher::Release()
+{
+    ULONG count = InterlockedDecrement(&ref_count_);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+STDMETHODIMP StateWatcher::GetInterestMask(PULONG Mask)
+{
+    *Mask = DEBUG_EVENT_CHANGE_DEBUGGEE_STATE | DEBUG_EVENT_CHANGE_SYMBOL_STATE |
+            DEBUG_EVENT_LOAD_MODULE | DEBUG_EVENT_UNLOAD_MODULE;
+    return S_OK;
+}
+
+// Memory (DEBUG_CDS_DATA) or registers (DEBUG_CDS_REGISTERS) were written, or everything
+// may have changed (DEBUG_CDS_ALL, DEBUG_CDS_REFRESH)
+STDMETHODIMP StateWatcher::ChangeDebuggeeState(ULONG /*Flags*/, ULONG64 /*Argument*/)
+{
+    GetResultCache().Invalidate();
+    return S_OK;
+}
+
+// Symbols loaded or unloaded (stacks and ln resolve differently), scope or type options
+// changed (.ecxr, .cxr, .frame and display options change r, k and dv output)
+STDMETHODIMP StateWatcher::ChangeSymbolState(ULONG /*Flags*/, ULONG64 /*Argument*/)
+{
+    GetResultCache().Invalidate();
+    return S_OK;
+}
+
+STDMETHODIMP StateWatcher::LoadModule(ULONG64 /*ImageFileHandle*/, ULONG64 /*BaseOffset*/,
+                                      ULONG /*ModuleSize*/, PCSTR /*ModuleName*/,
+                                      PCSTR /*ImageName*/, ULONG /*CheckSum*/,
+                                      ULONG /*TimeDateStamp*/)
+{
+    GetResultCache().Invalidate();
+    return DEBUG_STATUS_NO_CHANGE;
+}
+
+STDMETHODIMP StateWatcher::UnloadModule(PCSTR /*ImageBaseName*/, ULONG64 /*BaseOffset*/)
+{
+    GetResultCache().Invalidate();
+    return DEBUG_STATUS_NO_CHANGE;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <dbgeng.h>
+#include <windows.h>
+
+namespace windbg_agent
+{
+
+// Engine event callbacks that bump the result cache epoch when target or symbol state
+// changes behind the extension's back: memory or register writes, symbol loads and scope
+// changes, module loads and unloads - including those made by commands the user types in
+// the debugger, which never pass through WinDbgClient. The memory page cache and address
+// index compare against the same epoch, so they are rebuilt as well.
+//
+// The callbacks sit on a client of their own, so the debugger's event callbacks stay
+// untouched; like every client, it must be created on the engine thread.
+class StateWatcher : public DebugBaseEventCallbacks
+{
+  public:
+    // Start watching the engine that client belongs to (no-op if already watching)
+    static void Install(IDebugClient* client);
+
+    // Stop watching and release the client (extension unload)
+    static void Uninstall();
+
+    // IUnknown (QueryInterface comes from DebugBaseEventCallbacks)
+    STDMETHOD_(ULONG, AddRef)() override;
+    STDMETHOD_(ULONG, Release)() override;
+
+    // IDebugEventCallbacks
+    STDMETHOD(GetInterestMask)(PULONG Mask) override;
+    STDMETHOD(ChangeDebuggeeState)(ULONG Flags, ULONG64 Argument) override;
+    STDMETHOD(ChangeSymbolState)(ULONG Flags, ULONG64 Argument) override;
+    STDMETHOD(LoadModule)(ULONG64 ImageFileHandle, ULONG64 BaseOffset, ULONG ModuleSize,
+                          PCSTR ModuleName, PCSTR ImageName, ULONG CheckSum,
+                          ULONG TimeDateStamp) override;
+    STDMETHOD(UnloadModule)(PCSTR ImageBaseName, ULONG64 BaseOffset) override;
+
+  private:
+    explicit StateWatcher(IDebugClient* client);
+    ~StateWatcher();
+
+    LONG ref_count_;
+    IDebugClient* client_; // Private client the callbacks are registered on
+};
+
+} // namespace windbg_agent
@@ -0,0 +1,233 @@
+#include "symbol_prefetch.hpp"
+#include "address_index.hpp"
+
+#include <algorithm>
+
+namespace windbg_agent
+{
+
+std::vector<std::string> OrderSymbolPrefetch(const std::vector<ModuleInfo>& modules,
+                                             const std::vector<uint64_t>& hot, size_t* priority)
+{
+    AddressRangeTable table;
+    for (size_t i = 0; i < modules.size(); i++)
+        table.Add(modules[i].base, modules[i].base + modules[i].size, static_cast<uint32_t>(i));
+    table.Finish();
+
+    std::vector<std::string> order;
+    std::vector<bool> seen(modules.size());
+    auto take = [&](size_t i)
+    {
+        if (!seen[i] && modules[i].symbols == "deferred")
+            order.push_back(modules[i].name);
+        seen[i] = true;
+    };
+
+    for (uint64_t address : hot)
+    {
+        uint32_t module = table.Find(address);
+        if (module != AddressRangeTable::npos)
+            take(module);
+    }
+    *priority = order.size();
+
+    for (size_t i = 0; i < modules.size(); i++)
+        take(i);
+    return order;
+}
+
+SymbolPrefetcher::~SymbolPrefetcher()
+{
+    Stop();
+}
+
+void SymbolPrefetcher::Start(const std::string& target, BackendFactory factory, size_t workers)
+{
+    workers = std::min(workers, kMaxWorkers);
+    if (workers == 0 || !factory)
+        return;
+
+    std::vector<std::thread> exited;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReapExited(&exited);
+        if (target != target_ || cancelled_)
+            Launch(target, std::move(factory), workers);
+    }
+
+    // These have returned or are about to; joining them does not wait on a load
+    for (auto& thread : exited)
+        thread.join();
+}
+
+void SymbolPrefetcher::ReapExited(std::vector<std::thread>* exited)
+{
+    for (auto it = threads_.begin(); it != threads_.end();)
+    {
+        if (std::find(exited_.begin(), exited_.end(), it->get_id()) == exited_.end())
+        {
+            ++it;
+            continue;
+        }
+        exited->push_back(std::move(*it));
+        it = threads_.erase(it);
+    }
+    exited_.clear();
+}
+
+void SymbolPrefetcher::Launch(const std::string& target, BackendFactory factory, size_t workers)
+{
+    generation_++;
+    planned_ = false;
+    cancelled_ = false;
+    target_ = target;
+    queue_.clear();
+    next_ = 0;
+    active_ = workers;
+    loading_.assign(workers, std::string());
+    stats_ = SymbolPrefetchStats();
+    stats_.running = true;
+    stats_.workers = workers;
+    started_ = std::chrono::steady_clock::now();
+    planned_cv_.notify_all();
+
+    for (size_t slot = 0; slot < workers; slot++)
+        threads_.emplace_back(&SymbolPrefetcher::Worker, this, generation_, slot, factory);
+}
+
+void SymbolPrefetcher::Cancel(const std::string& reason)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stats_.running || cancelled_)
+        return;
+    cancelled_ = true;
+    stats_.stopped = reason;
+}
+
+void SymbolPrefetcher::Stop()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stats_.running)
+        {
+            stats_.running = false;
+            stats_.stopped = "stopped";
+            finished_ = std::chrono::steady_clock::now();
+        }
+        generation_++;
+        cancelled_ = true;
+        threads.swap(threads_);
+        exited_.clear();
+    }
+    planned_cv_.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void SymbolPrefetcher::Worker(uint64_t generation, size_t slot, BackendFactory factory)
+{
+    std::unique_ptr<IDebuggerBackend> backend = factory();
+    if (backend && !backend->IsAvailable())
+        backend.reset();
+
+    if (slot == 0)
+    {
+        // The exception address first, then the faulting thread's stack (the event thread's,
+        // even after ~Ns). The stack is walked without symbol lookups, which would load
+        // symbols right here.
+        std::vector<uint64_t> hot;
+        std::vector<std::string> order;
+        size_t priority = 0;
+        if (backend)
+        {
+            uint64_t address = 0;
+            if (StatusSucceeded(backend->GetExceptionAddress(&address)))
+                hot.push_back(address);
+            std::vector<uint64_t> frames;
+            if (StatusSucceeded(backend->GetEventStackOffsets(kStackFrames, &frames)))
+                hot.insert(hot.end(), frames.begin(), frames.end());
+
+            std::vector<ModuleInfo> modules;
+            if (StatusSucceeded(backend->GetModules(&modules)))
+                order = OrderSymbolPrefetch(modules, hot, &priority);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation == generation_)
+        {
+            queue_ = std::move(order);
+            stats_.total = queue_.size();
+            stats_.priority = priority;
+            if (!backend)
+                stats_.stopped = "no engine client";
+            planned_ = true;
+        }
+        planned_cv_.notify_all();
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        planned_cv_.wait(lock, [&]() { return planned_ || generation != generation_; });
+    }
+
+    while (backend)
+    {
+        std::string module;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (generation != generation_ || cancelled_ || next_ >= queue_.size())
+                break;
+            module = queue_[next_++];
+            loading_[slot] = module;
+        }
+
+        long status = backend->LoadSymbols(module);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation != generation_)
+            break;
+        loading_[slot].clear();
+        if (StatusSucceeded(status))
+            stats_.loaded++;
+        else
+            stats_.failed++;
+    }
+
+    // The backend belongs to this thread; release it here
+    backend.reset();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation == generation_ && --active_ == 0)
+    {
+        stats_.running = false;
+        finished_ = std::chrono::steady_clock::now();
+    }
+    exited_.push_back(std::this_thread::get_id());
+}
+
+SymbolPrefetchStats SymbolPrefetcher::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolPrefetchStats stats = stats_;
+    for (const auto& module : loading_)
+    {
+        if (!module.empty())
+            stats.loading.push_back(module);
+    }
+    if (!target_.empty())
+    {
+        auto end = stats.running ? std::chrono::steady_clock::now() : finished_;
+        stats.elapsed_ms = std::chrono::duration<double, std::milli>(end - started_).count();
+    }
+    return stats;
+}
+
+SymbolPrefetcher& GetSymbolPrefetcher()
+{
+    static SymbolPrefetcher prefetcher;
+    return prefetcher;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "debugger_backend.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// Progress of the symbol warm-up
+struct SymbolPrefetchStats
+{
+    bool running = false;
+    size_t workers = 0;
+    size_t total = 0;    // Modules with deferred symbols when the warm-up was planned
+    size_t priority = 0; // Of those, modules on the faulting stack or exception address
+    size_t loaded = 0;
+    size_t failed = 0;
+    std::vector<std::string> loading; // Modules being loaded right now
+    std::string stopped;              // Why the warm-up ended early, empty otherwise
+    double elapsed_ms = 0.0;
+};
+
+// Names of the modules whose symbols are still deferred, in the order to load them: the
+// module holding hot[0] (the exception address) first, then those holding the other hot
+// addresses (stack frames, innermost first), then the rest in load order. *priority
+// receives how many came from hot addresses.
+std::vector<std::string> OrderSymbolPrefetch(const std::vector<ModuleInfo>& modules,
+                                             const std::vector<uint64_t>& hot, size_t* priority);
+
+// Loads module symbols in the background, so that the first stack or !analyze of a session
+// finds them ready instead of stalling on symbol server downloads. Each worker runs on its
+// own thread with its own backend (a separate engine client); the first one plans the
+// order, the others wait for it. Restarting or stopping never waits on a worker that is in
+// the middle of a load: workers of a replaced warm-up notice the new generation and exit.
+// Start() joins the workers that have exited by then, and Stop() all of them.
+class SymbolPrefetcher
+{
+  public:
+    // Creates a backend for the calling worker thread; nullptr if none is available
+    using BackendFactory = std::function<std::unique_ptr<IDebuggerBackend>()>;
+
+    static constexpr size_t kMaxWorkers = 4;
+    static constexpr size_t kStackFrames = 64; // Frames of the faulting stack prioritized
+
+    ~SymbolPrefetcher();
+
+    // Start warming symbols for target (an identity such as name and process id) with up to
+    // workers threads. Does nothing if this target was already warmed or is warming; a
+    // warm-up for another target, or one that was cancelled, is replaced.
+    void Start(const std::string& target, BackendFactory factory, size_t workers);
+
+    // Ask the workers to stop after their current module (does not wait for them)
+    void Cancel(const std::string& reason);
+
+    // Cancel and wait for the workers to exit
+    void Stop();
+
+    SymbolPrefetchStats GetStats() const;
+
+  private:
+    void Worker(uint64_t generation, size_t slot, BackendFactory factory);
+    // Both with mutex_ held
+    void ReapExited(std::vector<std::thread>* exited);
+    void Launch(const std::string& target, BackendFactory factory, size_t workers);
+
+    std::vector<std::thread> threads_;    // Workers not yet joined, of any generation
+    std::vector<std::thread::id> exited_; // Workers in threads_ that have returned
+
+    mutable std::mutex mutex_;
+    std::condition_variable planned_cv_;
+    uint64_t generation_ = 0; // Bumped by each Start() and Stop(); older workers exit
+    bool planned_ = false;
+    bool cancelled_ = false;
+    std::string target_;
+    std::vector<std::string> queue_;
+    size_t next_ = 0;
+    size_t active_ = 0;                // Workers of this generation still running
+    std::vector<std::string> loading_; // Per worker slot
+    SymbolPrefetchStats stats_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point finished_;
+};
+
+// Process-wide prefetcher
+SymbolPrefetcher& GetSymbolPrefetcher();
+
+} // namespace windbg_agent
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace windbg_agent
@@ -12,6 +13,8 @@ You are already connected to a debug target (live or crash dump) - this could be
 
 IMPORTANT: Always use dbg_exec to investigate. Never guess or speculate - run debugger commands to get actual state. Based on the user's question, determine what information you need and query the debugger accordingly.
 
+Very large dbg_exec output is shortened to its first and last lines, with a note giving an output_id and page count. Call dbg_output_page only for the pages you actually need; prefer narrower commands (smaller ranges, filters) over paging through everything.
+
 ## Expression Evaluation
 Use the debugger's built-in evaluators for calculations - don't compute manually:
 - ? <expr> - MASM expression evaluator (default). Example: ? @rax + @rbx
@@ -243,7 +246,7 @@ struct RuntimeContext
     std::string target_arch;   // x86, x64, ARM64
     std::string debugger_type; // WinDbg, CDB, etc.
     std::string cwd;           // Current working directory
-    std::string timestamp;     // Session start time (ISO 8601)
+    std::string timestamp;     // Current time (ISO 8601)
     std::string platform;      // OS info
 
     bool has_content() const
@@ -253,9 +256,13 @@ struct RuntimeContext
     }
 };
 
-// Format runtime context as a prompt section
+// Format the stable part of the runtime context (fields that only change with the target)
 inline std::string FormatRuntimeContext(const RuntimeContext& ctx)
 {
+    if (ctx.target_name.empty() && ctx.target_arch.empty() && ctx.debugger_type.empty() &&
+        ctx.platform.empty())
+        return "";
+
     std::string result = "\n\n## Session Context\n";
 
     if (!ctx.target_name.empty())
@@ -264,29 +271,67 @@ inline std::string FormatRuntimeContext(const RuntimeContext& ctx)
         result += "- Architecture: " + ctx.target_arch + "\n";
     if (!ctx.debugger_type.empty())
         result += "- Debugger: " + ctx.debugger_type + "\n";
+    if (!ctx.platform.empty())
+        result += "- Platform: " + ctx.platform + "\n";
+
+    return result;
+}
+
+// Format the volatile part of the runtime context (fields that may change every turn)
+inline std::string FormatVolatileContext(const RuntimeContext& ctx)
+{
+    std::string result;
+
     if (!ctx.cwd.empty())
         result += "- Working Directory: " + ctx.cwd + "\n";
     if (!ctx.timestamp.empty())
-        result += "- Session Started: " + ctx.timestamp + "\n";
-    if (!ctx.platform.empty())
-        result += "- Platform: " + ctx.platform + "\n";
+        result += "- Current Time: " + ctx.timestamp + "\n";
 
     return result;
 }
 
+// 64-bit FNV-1a hash used to detect prompt body changes between turns
+inline uint64_t FingerprintPrompt(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Versioned system prompt: the stable body is fingerprinted and sent once per session,
+// the volatile context is re-sent as a small delta only when it changes. The time changes
+// every second, so it rides along with a delta but does not trigger one.
+struct PromptVersion
+{
+    std::string body;             // kSystemPrompt + stable context + custom prompt
+    std::string volatile_context; // Working directory, current time
+    std::string volatile_key;     // volatile_context without the time (compared for changes)
+    uint64_t fingerprint = 0;     // FingerprintPrompt(body)
+};
+
 // Combine system prompt with runtime context and user's custom prompt
-inline std::string GetFullSystemPrompt(const std::string& custom_prompt,
-                                       const RuntimeContext& ctx = {})
+inline PromptVersion BuildPromptVersion(const std::string& custom_prompt,
+                                        const RuntimeContext& ctx = {})
 {
-    std::string result = kSystemPrompt;
+    PromptVersion version;
+    version.body = kSystemPrompt;
 
     if (ctx.has_content())
-        result += FormatRuntimeContext(ctx);
+        version.body += FormatRuntimeContext(ctx);
 
     if (!custom_prompt.empty())
-        result += "\n\n" + custom_prompt;
-
-    return result;
+        version.body += "\n\n" + custom_prompt;
+
+    version.volatile_context = FormatVolatileContext(ctx);
+    RuntimeContext untimed = ctx;
+    untimed.timestamp.clear();
+    version.volatile_key = FormatVolatileContext(untimed);
+    version.fingerprint = FingerprintPrompt(version.body);
+    return version;
 }
 
 } // namespace windbg_agent
@@ -0,0 +1,93 @@
+// Address range table: disjoint, overlapping and nested intervals resolve to the interval
+// that started last, and an outer interval resumes once a nested one ends.
+
+#include "address_index.hpp"
+#include "test_util.hpp"
+
+#include <cstdint>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+const uint32_t npos = AddressRangeTable::npos;
+
+void TestDisjoint()
+{
+    AddressRangeTable table;
+    table.Add(0x3000, 0x4000, 2);
+    table.Add(0x1000, 0x2000, 1);
+    table.Add(0x5000, 0x5000, 9); // Empty: ignored
+    table.Finish();
+    CHECK_EQ(table.size(), 2u);
+    CHECK_EQ(table.Find(0x0fff), npos);
+    CHECK_EQ(table.Find(0x1000), 1u);
+    CHECK_EQ(table.Find(0x1fff), 1u);
+    CHECK_EQ(table.Find(0x2000), npos);
+    CHECK_EQ(table.Find(0x3800), 2u);
+    CHECK_EQ(table.Find(0x4000), npos);
+}
+
+void TestOverlap()
+{
+    // The later start wins from its start on
+    AddressRangeTable table;
+    table.Add(0x1000, 0x3000, 1);
+    table.Add(0x2000, 0x4000, 2);
+    table.Finish();
+    CHECK_EQ(table.Find(0x1fff), 1u);
+    CHECK_EQ(table.Find(0x2000), 2u);
+    CHECK_EQ(table.Find(0x3fff), 2u);
+    CHECK_EQ(table.Find(0x4000), npos);
+}
+
+void TestNested()
+{
+    // 1 holds 2, which holds 3; 4 starts inside 1 after 2 ended
+    AddressRangeTable table;
+    table.Add(0x1000, 0x9000, 1);
+    table.Add(0x2000, 0x5000, 2);
+    table.Add(0x3000, 0x4000, 3);
+    table.Add(0x6000, 0x7000, 4);
+    table.Finish();
+    CHECK_EQ(table.Find(0x1000), 1u);
+    CHECK_EQ(table.Find(0x2000), 2u);
+    CHECK_EQ(table.Find(0x3000), 3u);
+    CHECK_EQ(table.Find(0x4000), 2u); // Back in 2 after 3
+    CHECK_EQ(table.Find(0x5000), 1u); // Back in 1 after 2
+    CHECK_EQ(table.Find(0x6800), 4u);
+    CHECK_EQ(table.Find(0x7000), 1u);
+    CHECK_EQ(table.Find(0x8fff), 1u);
+    CHECK_EQ(table.Find(0x9000), npos);
+
+    // Same start: the one added later wins, the longer one resumes after it
+    AddressRangeTable same;
+    same.Add(0x1000, 0x3000, 1);
+    same.Add(0x1000, 0x2000, 2);
+    same.Finish();
+    CHECK_EQ(same.Find(0x1000), 2u);
+    CHECK_EQ(same.Find(0x2000), 1u);
+
+    // A later interval reaching past the outer one's end hides the rest of it
+    AddressRangeTable past;
+    past.Add(0x1000, 0x4000, 1);
+    past.Add(0x2000, 0x2800, 2);
+    past.Add(0x2400, 0x6000, 3);
+    past.Finish();
+    CHECK_EQ(past.Find(0x2000), 2u);
+    CHECK_EQ(past.Find(0x2400), 3u);
+    CHECK_EQ(past.Find(0x3000), 3u);
+    CHECK_EQ(past.Find(0x5fff), 3u);
+    CHECK_EQ(past.Find(0x6000), npos);
+}
+
+} // namespace
+
+int main()
+{
+    TestDisjoint();
+    TestOverlap();
+    TestNested();
+    return windbg_test::TestResult();
+}
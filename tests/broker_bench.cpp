@@ -0,0 +1,228 @@
+// Main-thread dispatch latency: the 100 ms polling loop the HTTP and MCP servers used in
+// wait() (before) against CommandBroker (after). Work items run a command on a replay
+// backend standing in for dbgeng; interrupts come from its simulated Ctrl+C.
+//
+//   broker_bench [items_per_client]
+
+#include "command_broker.hpp"
+#include "replay_backend.hpp"
+#include "test_util.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+constexpr int kClients = 4;
+
+// The pre-broker design: one queue per server, drained by wait() with a 100 ms timed wait
+// that also polls for interrupts
+class PollingQueue
+{
+  public:
+    void Enqueue(std::function<void()> work)
+    {
+        bool done = false;
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back([&]()
+                             {
+                                 work();
+                                 std::lock_guard<std::mutex> done_lock(done_mutex);
+                                 done = true;
+                                 done_cv.notify_one();
+                             });
+        }
+        queue_cv_.notify_one();
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cv.wait(lock, [&]() { return done; });
+    }
+
+    // Returns true if stopped by an interrupt
+    bool Wait(const std::function<bool()>& interrupt_check, uint64_t* checks)
+    {
+        while (running_.load())
+        {
+            ++*checks;
+            if (interrupt_check())
+                return true;
+
+            std::function<void()> work;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (queue_cv_.wait_for(lock, std::chrono::milliseconds(100),
+                                       [this]() { return !queue_.empty() || !running_; }) &&
+                    !queue_.empty())
+                {
+                    work = std::move(queue_.front());
+                    queue_.pop_front();
+                }
+            }
+            if (work)
+                work();
+        }
+        return false;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::function<void()>> queue_;
+    std::atomic<bool> running_{true}; // The servers cleared this in stop()
+};
+
+std::unique_ptr<ReplayBackend> MakeBackend()
+{
+    TranscriptEntry entry;
+    entry.command = "r";
+    entry.output = "rax=0000000000000000 rbx=0000000000000001\n";
+    auto backend = std::make_unique<ReplayBackend>(ReplayTarget{"bench.dmp", "x64"},
+                                                   std::vector<TranscriptEntry>{entry});
+    backend->SetLatencyScale(0);
+    return backend;
+}
+
+struct Result
+{
+    std::vector<double> waits; // Enqueue-to-execute, ms
+    double interrupt_ms = 0.0; // Interrupt raised to loop exit
+    uint64_t checks = 0;       // Interrupt polls
+    double elapsed_ms = 0.0;
+};
+
+// Clients submit items with random think time between them (bursts and idle gaps), then
+// the main thread is interrupted after a quiet period
+template <typename Submit>
+void RunClients(int items, ReplayBackend& backend, std::mutex& waits_mutex,
+                std::vector<double>& waits, const Submit& submit)
+{
+    std::vector<std::thread> clients;
+    for (int c = 0; c < kClients; c++)
+    {
+        clients.emplace_back(
+            [&, c]()
+            {
+                std::mt19937 rng(c);
+                std::uniform_int_distribution<int> gap_us(0, 3000);
+                for (int i = 0; i < items; i++)
+                {
+                    double enqueued = windbg_test::NowMs();
+                    submit([&, enqueued]()
+                           {
+                               double wait = windbg_test::NowMs() - enqueued;
+                               OutputView output;
+                               backend.Execute("r", false, &output);
+                               std::lock_guard<std::mutex> lock(waits_mutex);
+                               waits.push_back(wait);
+                           });
+                    std::this_thread::sleep_for(std::chrono::microseconds(gap_us(rng)));
+                }
+            });
+    }
+    for (auto& client : clients)
+        client.join();
+}
+
+// Interrupt once the loop has been idle for idle_ms; the caller times how long it takes
+// to notice
+void InterruptAfterIdle(ReplayBackend& backend, int idle_ms, std::atomic<double>& raised)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+    raised = windbg_test::NowMs();
+    backend.Interrupt();
+}
+
+Result Before(int items, int idle_ms)
+{
+    auto backend = MakeBackend();
+    PollingQueue queue;
+    Result result;
+    std::mutex waits_mutex;
+    std::atomic<double> raised{0.0};
+
+    double start = windbg_test::NowMs();
+    std::thread driver(
+        [&]()
+        {
+            RunClients(items, *backend, waits_mutex, result.waits,
+                       [&](std::function<void()> work) { queue.Enqueue(std::move(work)); });
+            InterruptAfterIdle(*backend, idle_ms, raised);
+        });
+    queue.Wait([&]() { return backend->IsInterrupted(); }, &result.checks);
+    result.interrupt_ms = windbg_test::NowMs() - raised;
+    result.elapsed_ms = windbg_test::NowMs() - start;
+    driver.join();
+    return result;
+}
+
+Result After(int items, int idle_ms)
+{
+    auto backend = MakeBackend();
+    CommandBroker broker;
+    Result result;
+    std::mutex waits_mutex;
+    std::atomic<double> raised{0.0};
+
+    CommandBroker::SourceId source = broker.Attach("bench");
+    double start = windbg_test::NowMs();
+    std::thread driver(
+        [&]()
+        {
+            RunClients(items, *backend, waits_mutex, result.waits,
+                       [&](std::function<void()> work)
+                       { broker.Dispatch(source, std::move(work)); });
+            InterruptAfterIdle(*backend, idle_ms, raised);
+        });
+    broker.Run([&]() { return backend->IsInterrupted(); });
+    result.interrupt_ms = windbg_test::NowMs() - raised;
+    result.elapsed_ms = windbg_test::NowMs() - start;
+    driver.join();
+    result.checks = broker.GetStats().interrupt_checks;
+    broker.Detach(source);
+    return result;
+}
+
+void Report(const char* name, Result& result)
+{
+    double p50 = windbg_test::Percentile(result.waits, 50);
+    double p99 = windbg_test::Percentile(result.waits, 99);
+    double max = result.waits.empty() ? 0.0 : result.waits.back();
+    std::printf("  %-22s p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms  | interrupt %6.1f ms  "
+                "| %llu interrupt polls in %.0f ms\n",
+                name, p50, p99, max, result.interrupt_ms,
+                static_cast<unsigned long long>(result.checks), result.elapsed_ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int items = argc > 1 ? std::atoi(argv[1]) : 500;
+    if (items <= 0)
+        items = 500;
+
+    // Interrupts right after activity, and after the loop has settled into idle polling
+    for (int idle_ms : {5, 350})
+    {
+        std::printf("enqueue-to-execute latency, %d clients x %d items, interrupt after %d ms "
+                    "idle\n",
+                    kClients, items, idle_ms);
+        Result before = Before(items, idle_ms);
+        Report("100 ms polling wait()", before);
+        Result after = After(items, idle_ms);
+        Report("CommandBroker", after);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Job table lifecycle as the HTTP job runner drives it: jobs stay cancellable until their
+// handler starts, cancellation reaches the job's own token, and outcomes (a failed agent
+// query, a failing batch command) finish jobs in the right state.
+
+#include "job_table.hpp"
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+// HRESULTs as a 32-bit long holds them on Windows
+const long kEFail = static_cast<int32_t>(0x80004005);
+const long kEInvalidArg = static_cast<int32_t>(0x80070057);
+
+JobSnapshot Snapshot(JobTable& jobs, const std::string& id)
+{
+    JobSnapshot snapshot;
+    CHECK(jobs.Get(id, &snapshot));
+    return snapshot;
+}
+
+ExecResult Result(const char* command, long status)
+{
+    ExecResult result;
+    result.command = command;
+    result.output = "output of " + result.command + "\n";
+    result.status = status;
+    return result;
+}
+
+void TestAskOutcome()
+{
+    JobTable jobs;
+    JobWork work;
+
+    // The ask callback threw (no agent): the job fails with the handler's message
+    std::string failed = jobs.Create(JobKind::Ask, "why did it crash?");
+    CHECK(jobs.Take(&work));
+    CHECK(work.id == failed);
+    CHECK(jobs.Start(failed));
+    jobs.FinishAsk(failed, true, "Error: Failed to initialize agent");
+    JobSnapshot job = Snapshot(jobs, failed);
+    CHECK(job.state == JobState::Failed);
+    CHECK(job.error == "Error: Failed to initialize agent");
+    CHECK(job.result.empty());
+
+    std::string answered = jobs.Create(JobKind::Ask, "why did it crash?");
+    CHECK(jobs.Take(&work));
+    CHECK(jobs.Start(answered));
+    jobs.FinishAsk(answered, false, "A null pointer was dereferenced.");
+    job = Snapshot(jobs, answered);
+    CHECK(job.state == JobState::Succeeded);
+    CHECK(job.error.empty());
+    CHECK(job.result == "A null pointer was dereferenced.");
+}
+
+void TestCancelBeforeStart()
+{
+    JobTable jobs;
+    std::string id = jobs.Create(JobKind::Ask, "query");
+    JobWork work;
+    CHECK(jobs.Take(&work));
+
+    // Taken but still waiting for the main thread: still Queued, cancelled at once
+    CHECK(Snapshot(jobs, id).state == JobState::Queued);
+    JobState previous = JobState::Running;
+    CHECK(jobs.Cancel(id, &previous));
+    CHECK(previous == JobState::Queued);
+    CHECK(work.cancel && work.cancel->load());
+    CHECK(Snapshot(jobs, id).state == JobState::Cancelled);
+
+    // The handler never runs, and a late finish does not revive the job
+    CHECK(!jobs.Start(id));
+    jobs.FinishAsk(id, false, "answer");
+    JobSnapshot job = Snapshot(jobs, id);
+    CHECK(job.state == JobState::Cancelled);
+    CHECK(job.result.empty());
+}
+
+void TestCancelRunning()
+{
+    JobTable jobs;
+    std::string other = jobs.Create(JobKind::Ask, "someone else's query");
+    std::string id = jobs.Create(JobKind::ExecBatch, "", {"lm", "k", "r"});
+    JobWork other_work;
+    JobWork work;
+    CHECK(jobs.Take(&other_work));
+    CHECK(jobs.Take(&work));
+    CHECK(work.batch.size() == 3);
+    CHECK(jobs.Start(id));
+    CHECK(Snapshot(jobs, id).state == JobState::Running);
+
+    // Only this job's token is set; the runner stops after the command in progress
+    JobState previous = JobState::Queued;
+    CHECK(jobs.Cancel(id, &previous));
+    CHECK(previous == JobState::Running);
+    CHECK(work.cancel->load());
+    CHECK(!other_work.cancel->load());
+    CHECK(Snapshot(jobs, id).state == JobState::Running);
+    CHECK(!jobs.AppendOutput(id, "x", 1));
+
+    jobs.FinishBatch(id, false, "", {Result("lm", 0)});
+    JobSnapshot job = Snapshot(jobs, id);
+    CHECK(job.state == JobState::Cancelled);
+    CHECK_EQ(job.batch_results.size(), 1u);
+    CHECK(Snapshot(jobs, other).state == JobState::Queued);
+
+    // Cancelling a finished job deletes it
+    CHECK(jobs.Cancel(id, &previous));
+    CHECK(previous == JobState::Cancelled);
+    JobSnapshot gone;
+    CHECK(!jobs.Get(id, &gone));
+}
+
+void TestCommandOutcomes()
+{
+    JobTable jobs;
+    JobWork work;
+
+    // The first failing command of a batch names the error and gives the status
+    std::string batch = jobs.Create(JobKind::ExecBatch, "", {"lm", "dd 0", "bogus"});
+    CHECK(jobs.Take(&work));
+    CHECK(jobs.Start(batch));
+    jobs.FinishBatch(batch, false, "",
+                     {Result("lm", 0), Result("dd 0", kEFail),
+                      Result("bogus", kEInvalidArg)});
+    JobSnapshot job = Snapshot(jobs, batch);
+    CHECK(job.state == JobState::Failed);
+    CHECK_EQ(job.status, kEFail);
+    CHECK(job.error == "command failed: dd 0: hr=0x80004005");
+    CHECK_EQ(job.batch_results.size(), 3u);
+
+    std::string exec = jobs.Create(JobKind::Exec, "dd 0");
+    CHECK(jobs.Take(&work));
+    CHECK(jobs.Start(exec));
+    jobs.FinishExec(exec, false, "", Result("dd 0", kEFail));
+    job = Snapshot(jobs, exec);
+    CHECK(job.state == JobState::Failed);
+    CHECK(job.error == "command failed: hr=0x80004005");
+
+    // A handler failure wins over the (default) command status
+    std::string threw = jobs.Create(JobKind::Exec, "k");
+    CHECK(jobs.Take(&work));
+    CHECK(jobs.Start(threw));
+    jobs.FinishExec(threw, true, "Error: No handler for command type", ExecResult());
+    job = Snapshot(jobs, threw);
+    CHECK(job.state == JobState::Failed);
+    CHECK(job.error == "Error: No handler for command type");
+
+    std::string ok = jobs.Create(JobKind::Exec, "k");
+    CHECK(jobs.Take(&work));
+    CHECK(jobs.Start(ok));
+    CHECK(jobs.AppendOutput(ok, "frame\n", 6));
+    jobs.FinishExec(ok, false, "", Result("k", 0));
+    job = Snapshot(jobs, ok);
+    CHECK(job.state == JobState::Succeeded);
+    CHECK(job.result == "frame\n");
+}
+
+} // namespace
+
+int main()
+{
+    TestAskOutcome();
+    TestCancelBeforeStart();
+    TestCancelRunning();
+    TestCommandOutcomes();
+    return windbg_test::TestResult();
+}
@@ -0,0 +1,293 @@
+// Pattern matcher and memory scan against a naive matcher: every instruction set this CPU
+// can run (AVX2, SSE2, scalar) must report exactly the naive hits, on random buffers and
+// patterns with wildcards, at buffer tails, across chunk and region boundaries.
+
+#include "memory_scan.hpp"
+#include "replay_backend.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+const char* const kIsas[] = {"avx2", "sse2", "scalar"};
+
+// Every match starting in data[0, limit), pattern by pattern and in address order, as
+// PatternMatcher::Match reports them
+std::vector<ScanHit> NaiveMatch(const std::vector<ScanPattern>& patterns, const uint8_t* data,
+                                size_t size, size_t limit, uint64_t base, size_t max_hits)
+{
+    std::vector<ScanHit> hits;
+    for (size_t p = 0; p < patterns.size(); p++)
+    {
+        const ScanPattern& pattern = patterns[p];
+        size_t length = pattern.bytes.size();
+        for (size_t i = 0; i < limit && i + length <= size; i++)
+        {
+            bool match = true;
+            for (size_t k = 0; k < length && match; k++)
+            {
+                auto mask = static_cast<uint8_t>(pattern.mask[k]);
+                match = (data[i + k] & mask) == (static_cast<uint8_t>(pattern.bytes[k]) & mask);
+            }
+            if (!match)
+                continue;
+            if (hits.size() >= max_hits)
+                return hits;
+            hits.push_back({base + i, static_cast<uint32_t>(p)});
+        }
+    }
+    return hits;
+}
+
+bool SameHits(const std::vector<ScanHit>& a, const std::vector<ScanHit>& b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const ScanHit& x, const ScanHit& y)
+                      { return x.address == y.address && x.pattern == y.pattern; });
+}
+
+void SortHits(std::vector<ScanHit>* hits)
+{
+    std::sort(hits->begin(), hits->end(), [](const ScanHit& a, const ScanHit& b)
+              { return a.address != b.address ? a.address < b.address : a.pattern < b.pattern; });
+}
+
+// A random pattern over a small alphabet (so anchors match often), with some wildcard
+// bytes and nibbles but always one fixed byte
+ScanPattern RandomPattern(std::mt19937& rng, size_t max_length)
+{
+    std::uniform_int_distribution<size_t> length(1, max_length);
+    std::uniform_int_distribution<int> value(0, 3);
+    std::uniform_int_distribution<int> wildcard(0, 9);
+
+    ScanPattern pattern;
+    size_t n = length(rng);
+    for (size_t i = 0; i < n; i++)
+    {
+        int kind = wildcard(rng);
+        pattern.bytes += static_cast<char>(value(rng) | (value(rng) << 4));
+        pattern.mask += static_cast<char>(kind == 0 ? 0x00 : kind == 1 ? 0x0F : kind == 2 ? 0xF0
+                                                                                          : 0xFF);
+    }
+    pattern.mask[std::uniform_int_distribution<size_t>(0, n - 1)(rng)] = static_cast<char>(0xFF);
+    return pattern;
+}
+
+std::vector<uint8_t> RandomBytes(std::mt19937& rng, size_t size)
+{
+    std::uniform_int_distribution<int> value(0, 3);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data)
+        byte = static_cast<uint8_t>(value(rng) | (value(rng) << 4));
+    return data;
+}
+
+void TestMatcher(const char* isa)
+{
+    std::mt19937 rng(1234);
+    int mismatches = 0;
+    for (int round = 0; round < 3000; round++)
+    {
+        // Sizes around and past the 16- and 32-byte kernel widths, and the odd large one
+        size_t size = round % 100 == 0 ? 70000 : std::uniform_int_distribution<size_t>(0, 300)(rng);
+        std::vector<uint8_t> data = RandomBytes(rng, size);
+        size_t limit = round % 3 == 0 ? size : std::uniform_int_distribution<size_t>(0, size)(rng);
+
+        std::vector<ScanPattern> patterns;
+        size_t count = std::uniform_int_distribution<size_t>(1, 4)(rng);
+        for (size_t p = 0; p < count; p++)
+            patterns.push_back(RandomPattern(rng, round % 2 ? 6 : 40));
+        size_t max_hits = round % 5 == 0 ? 3 : SIZE_MAX;
+
+        PatternMatcher matcher(patterns);
+        std::vector<ScanHit> hits;
+        matcher.Match(data.data(), size, limit, 0x7ff00000, max_hits, &hits);
+        if (!SameHits(hits, NaiveMatch(patterns, data.data(), size, limit, 0x7ff00000, max_hits)))
+            mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // Matches ending on the very last byte, and a pattern anchored on a single byte
+    std::vector<uint8_t> data(100, 0xCC);
+    const uint8_t tail[] = {0x48, 0x8B, 0x05};
+    std::memcpy(&data[97], tail, 3);
+    std::string error;
+    ScanPattern anchored;
+    CHECK(ParseScanPattern("bytes", "48 ?? 05", &anchored, &error));
+    ScanPattern single;
+    CHECK(ParseScanPattern("bytes", "?? ?? 05", &single, &error));
+    PatternMatcher matcher({anchored, single});
+    std::vector<ScanHit> hits;
+    matcher.Match(data.data(), data.size(), data.size(), 0x1000, SIZE_MAX, &hits);
+    CHECK_EQ(hits.size(), 2u);
+    CHECK(SameHits(hits, NaiveMatch({anchored, single}, data.data(), data.size(), data.size(),
+                                    0x1000, SIZE_MAX)));
+    if (hits.size() == 2)
+    {
+        CHECK_EQ(hits[0].address, 0x1000u + 97);
+        CHECK_EQ(hits[1].address, 0x1000u + 97);
+    }
+    std::printf("  %s: matcher agrees with the naive matcher\n", isa);
+}
+
+// Committed memory laid out as regions over sparse readable blocks
+class SparseTarget : public ReplayBackend
+{
+  public:
+    SparseTarget() : ReplayBackend(ReplayTarget{"scan.dmp", "x64"}, {}) {}
+
+    void Region(uint64_t base, uint64_t size, uint32_t protect)
+    {
+        MemoryRegionInfo region;
+        region.base = base;
+        region.size = size;
+        region.state = 0x1000; // MEM_COMMIT
+        region.protect = protect;
+        regions_.push_back(region);
+    }
+
+    void Block(uint64_t base, std::vector<uint8_t> data) { blocks_.push_back({base, data}); }
+
+    long GetMemoryRegions(std::vector<MemoryRegionInfo>* regions) override
+    {
+        *regions = regions_;
+        return kStatusOk;
+    }
+
+    long ReadMemory(uint64_t address, void* buffer, size_t size, size_t* bytes_read) override
+    {
+        *bytes_read = 0;
+        for (const auto& block : blocks_)
+        {
+            if (address < block.first || address >= block.first + block.second.size())
+                continue;
+            size_t offset = static_cast<size_t>(address - block.first);
+            *bytes_read = std::min(size, block.second.size() - offset);
+            std::memcpy(buffer, block.second.data() + offset, *bytes_read);
+            break;
+        }
+        return *bytes_read == size ? kStatusOk : kStatusPartialCopy;
+    }
+
+  private:
+    std::vector<MemoryRegionInfo> regions_;
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> blocks_;
+};
+
+void TestScanMemory(const char* isa)
+{
+    std::mt19937 rng(99);
+    std::string error;
+    std::vector<ScanPattern> patterns(4);
+    CHECK(ParseScanPattern("bytes", "48 8b ?? 24 1?", &patterns[0], &error));
+    CHECK(ParseScanPattern("ascii", "needle", &patterns[1], &error));
+    CHECK(ParseScanPattern("utf16", "Key", &patterns[2], &error));
+    CHECK(ParseScanPattern("qword", "0x00007ff612345678", &patterns[3], &error));
+
+    // Full-range random bytes with the patterns planted throughout, on 1 MB chunk
+    // boundaries and across the seam of two adjacent regions
+    auto image = [&](size_t size, const std::vector<size_t>& seams)
+    {
+        std::vector<uint8_t> data(size);
+        for (auto& byte : data)
+            byte = static_cast<uint8_t>(rng());
+        auto plant = [&](size_t at, size_t p)
+        {
+            const std::string& bytes = patterns[p].bytes;
+            if (at + bytes.size() <= size)
+                std::memcpy(&data[at], bytes.data(), bytes.size());
+        };
+        for (size_t at = 1000; at < size; at += 77777)
+            plant(at, (at / 77777) % patterns.size());
+        for (size_t seam : seams)
+        {
+            for (size_t p = 0; p < patterns.size(); p++)
+                plant(seam - 1 - p, p);
+        }
+        return data;
+    };
+
+    const uint64_t a = 0x10000000;
+    std::vector<uint8_t> first = image(0x301000, {0x100000, 0x200000, 0x300000, 0x301000});
+    const uint64_t b = 0x20000000;
+    std::vector<uint8_t> second = image(0x20000, {0x10000, 0x11000});
+    const uint64_t c = 0x30000000;
+    std::vector<uint8_t> hidden = image(0x10000, {});
+
+    SparseTarget target;
+    target.Region(a, 0x300000, 0x04);          // PAGE_READWRITE
+    target.Region(a + 0x300000, 0x1000, 0x02); // Adjacent PAGE_READONLY: merged with the above
+    target.Region(b, 0x20000, 0x20);           // PAGE_EXECUTE_READ, one page unreadable
+    target.Region(c, 0x10000, 0x01);           // PAGE_NOACCESS: skipped
+    target.Block(a, first);
+    target.Block(b, std::vector<uint8_t>(second.begin(), second.begin() + 0x10000));
+    target.Block(b + 0x11000, std::vector<uint8_t>(second.begin() + 0x11000, second.end()));
+    target.Block(c, hidden);
+
+    std::vector<ScanHit> expected =
+        NaiveMatch(patterns, first.data(), first.size(), first.size(), a, SIZE_MAX);
+    for (auto range : {std::make_pair(0x0, 0x10000), std::make_pair(0x11000, 0x20000)})
+    {
+        std::vector<ScanHit> part =
+            NaiveMatch(patterns, second.data() + range.first, range.second - range.first,
+                       range.second - range.first, b + range.first, SIZE_MAX);
+        expected.insert(expected.end(), part.begin(), part.end());
+    }
+    SortHits(&expected);
+
+    std::vector<ScanHit> hits;
+    MemoryScanResult result = ScanMemory(target, 0, 0, patterns, kMaxScanHits,
+                                         [&](const std::vector<ScanHit>& batch)
+                                         {
+                                             hits.insert(hits.end(), batch.begin(), batch.end());
+                                             return true;
+                                         });
+    SortHits(&hits);
+    CHECK(StatusSucceeded(result.status));
+    CHECK(result.isa == isa);
+    CHECK(!result.truncated);
+    CHECK_EQ(result.regions, 2u);
+    CHECK(expected.size() > 40);
+    CHECK_EQ(hits.size(), expected.size());
+    CHECK(SameHits(hits, expected));
+
+    // Stops at max_hits
+    size_t delivered = 0;
+    result = ScanMemory(target, 0, 0, patterns, 5,
+                        [&](const std::vector<ScanHit>& batch)
+                        {
+                            delivered += batch.size();
+                            return true;
+                        });
+    CHECK(result.truncated);
+    CHECK_EQ(result.hits, 5u);
+    CHECK_EQ(delivered, 5u);
+    std::printf("  %s: memory scan agrees with the naive matcher (%zu hits)\n", isa,
+                expected.size());
+}
+
+} // namespace
+
+int main()
+{
+    for (const char* isa : kIsas)
+    {
+        if (!PatternMatcher::ForceIsa(isa))
+        {
+            std::printf("  %s: not supported on this CPU, skipped\n", isa);
+            continue;
+        }
+        TestMatcher(isa);
+        TestScanMemory(isa);
+    }
+    PatternMatcher::ForceIsa(nullptr);
+    return windbg_test::TestResult();
+}
@@ -0,0 +1,521 @@
+// Minidump reader and backend against hand-built dumps: stream parsing, memory reads across
+// range boundaries, and truncated or corrupt files.
+
+#include "minidump.hpp"
+#include "minidump_backend.hpp"
+#include "test_util.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+// Writes a little-endian MDMP image: header, directory, then each stream appended in turn
+class DumpBuilder
+{
+  public:
+    explicit DumpBuilder(uint32_t stream_count)
+    {
+        Put32(0x504D444D); // "MDMP"
+        Put32(0xA793);
+        Put32(stream_count);
+        Put32(32); // Directory RVA
+        Put32(0);
+        Put32(0x5F000000); // Timestamp
+        Put64(0x2);        // MiniDumpWithFullMemory
+        directory_ = bytes_.size();
+        bytes_.resize(bytes_.size() + stream_count * 12);
+    }
+
+    uint32_t size() const { return static_cast<uint32_t>(bytes_.size()); }
+    std::vector<uint8_t>& bytes() { return bytes_; }
+
+    void Put16(uint16_t v) { Append(&v, 2); }
+    void Put32(uint32_t v) { Append(&v, 4); }
+    void Put64(uint64_t v) { Append(&v, 8); }
+    void Pad(size_t n) { bytes_.resize(bytes_.size() + n); }
+    void Append(const void* data, size_t n)
+    {
+        const auto* p = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), p, p + n);
+    }
+
+    // Synthetic memory contents of target range [address, address + size)
+    void Memory(uint64_t address, uint64_t size);
+
+    void Patch32(size_t offset, uint32_t v) { std::memcpy(&bytes_[offset], &v, 4); }
+    void Patch64(size_t offset, uint64_t v) { std::memcpy(&bytes_[offset], &v, 8); }
+
+    // MINIDUMP_STRING (ASCII text widened to UTF-16); returns its RVA
+    uint32_t String(const std::string& text)
+    {
+        uint32_t rva = size();
+        Put32(static_cast<uint32_t>(text.size() * 2));
+        for (char c : text)
+            Put16(static_cast<uint8_t>(c));
+        Put16(0);
+        return rva;
+    }
+
+    // Start stream number index of a type; finish it with EndStream()
+    void BeginStream(uint32_t index, uint32_t type)
+    {
+        current_ = index;
+        Patch32(directory_ + index * 12, type);
+        Patch32(directory_ + index * 12 + 8, size());
+        stream_start_ = size();
+    }
+    void EndStream() { Patch32(directory_ + current_ * 12 + 4, size() - stream_start_); }
+
+  private:
+    std::vector<uint8_t> bytes_;
+    size_t directory_ = 0;
+    uint32_t current_ = 0;
+    uint32_t stream_start_ = 0;
+};
+
+constexpr uint64_t kStackBase = 0x10000;
+constexpr uint64_t kRangeA = 0x7FF700001000; // Memory64 ranges: A and B adjacent, C after a gap
+constexpr uint64_t kRangeB = 0x7FF700002000;
+constexpr uint64_t kRangeC = 0x7FF700010000;
+constexpr uint64_t kNtdllBase = 0x7FF800000000;
+constexpr uint64_t kAppBase = 0x7FF700000000;
+constexpr uint64_t kFaultIp = kNtdllBase + 0x1234;
+
+// Byte at target address in the synthetic memory image
+uint8_t Pattern(uint64_t address)
+{
+    return static_cast<uint8_t>(address * 7 + (address >> 8));
+}
+
+void DumpBuilder::Memory(uint64_t address, uint64_t size)
+{
+    for (uint64_t a = address; a < address + size; a++)
+        bytes_.push_back(Pattern(a));
+}
+
+// A complete x64 dump: 2 threads, 2 modules, exception on the second thread, memory in
+// both memory lists, memory info, system and misc info. *memory64_data receives the file
+// offset where the memory64 range data starts.
+std::vector<uint8_t> BuildDump(size_t* memory64_data = nullptr)
+{
+    DumpBuilder dump(8);
+
+    // Payloads referenced by RVA: thread stacks, contexts, module names
+    uint32_t stack_rva = dump.size();
+    dump.Memory(kStackBase, 0x100);
+
+    uint32_t context_rva[2];
+    for (int t = 0; t < 2; t++)
+    {
+        context_rva[t] = dump.size();
+        size_t start = dump.bytes().size();
+        dump.Pad(0x4d0); // sizeof(CONTEXT) on x64
+        dump.Patch64(start + 0xf8, 0x1000 + t); // rip
+        dump.Patch64(start + 0x98, 0x2000 + t); // rsp
+        dump.Patch64(start + 0x78, 0xAAAA + t); // rax
+    }
+    uint32_t exception_context_rva = dump.size();
+    {
+        size_t start = dump.bytes().size();
+        dump.Pad(0x4d0);
+        dump.Patch64(start + 0xf8, kFaultIp);
+    }
+    uint32_t ntdll_name = dump.String("C:\\Windows\\System32\\ntdll.dll");
+    uint32_t app_name = dump.String("C:\\app\\app.exe");
+    uint32_t cv_rva = dump.size();
+    dump.Append("RSDS", 4);
+    dump.Pad(20);
+    dump.Append("app.pdb", 8);
+    uint32_t cv_size = dump.size() - cv_rva;
+
+    // Memory list range (overlaps the start of range A; the memory64 copy wins past it)
+    uint32_t list_rva = dump.size();
+    dump.Memory(kRangeA - 0x10, 0x20);
+
+    dump.BeginStream(0, kSystemInfoStream);
+    dump.Put16(kArchAmd64);
+    dump.Put16(6); // Level
+    dump.Put16(0); // Revision
+    dump.Append("\x08\x01", 2); // 8 processors, workstation
+    dump.Put32(10);
+    dump.Put32(0);
+    dump.Put32(19045);
+    dump.Pad(32);
+    dump.EndStream();
+
+    dump.BeginStream(1, kMiscInfoStream);
+    dump.Put32(24);
+    dump.Put32(0x3); // Process id and times
+    dump.Put32(4242);
+    dump.Put32(1600000000);
+    dump.Put32(5);
+    dump.Put32(1);
+    dump.EndStream();
+
+    dump.BeginStream(2, kThreadListStream);
+    dump.Put32(2);
+    for (int t = 0; t < 2; t++)
+    {
+        dump.Put32(100 + t); // Thread id
+        dump.Put32(0);
+        dump.Put32(0x20);
+        dump.Put32(0);
+        dump.Put64(0x5000 + t); // TEB
+        dump.Put64(kStackBase);
+        dump.Put32(t == 0 ? 0x100 : 0);
+        dump.Put32(t == 0 ? stack_rva : 0);
+        dump.Put32(0x4d0);
+        dump.Put32(context_rva[t]);
+    }
+    dump.EndStream();
+
+    dump.BeginStream(3, kModuleListStream);
+    dump.Put32(2);
+    const uint64_t bases[] = {kAppBase, kNtdllBase};
+    const uint32_t names[] = {app_name, ntdll_name};
+    for (int m = 0; m < 2; m++)
+    {
+        dump.Put64(bases[m]);
+        dump.Put32(0x20000);
+        dump.Put32(0xC0DE + m);     // Checksum
+        dump.Put32(0x60000000 + m); // Timestamp
+        dump.Put32(names[m]);
+        dump.Pad(52); // VS_FIXEDFILEINFO
+        dump.Put32(m == 0 ? cv_size : 0);
+        dump.Put32(m == 0 ? cv_rva : 0);
+        dump.Pad(8 + 16); // MiscRecord, reserved
+    }
+    dump.EndStream();
+
+    dump.BeginStream(4, kExceptionStream);
+    dump.Put32(101); // Faulting thread
+    dump.Put32(0);
+    dump.Put32(0xC0000005);
+    dump.Put32(0);
+    dump.Put64(0);
+    dump.Put64(kFaultIp);
+    dump.Put32(2);
+    dump.Put32(0);
+    dump.Put64(1); // Write
+    dump.Put64(0xDEAD);
+    dump.Pad(13 * 8);
+    dump.Put32(0x4d0);
+    dump.Put32(exception_context_rva);
+    dump.EndStream();
+
+    dump.BeginStream(5, kMemoryListStream);
+    dump.Put32(1);
+    dump.Put64(kRangeA - 0x10);
+    dump.Put32(0x20);
+    dump.Put32(list_rva);
+    dump.EndStream();
+
+    dump.BeginStream(6, kMemoryInfoListStream);
+    dump.Put32(16);
+    dump.Put32(48);
+    dump.Put64(3);
+    const struct
+    {
+        uint64_t base, size;
+        uint32_t state, protect, type;
+    } regions[] = {
+        {kRangeC, 0x1000, 0x1000, 0x04, 0x20000},       // Commit, RW, private
+        {kRangeA, 0x2000, 0x1000, 0x20, 0x1000000},     // Commit, RX, image
+        {kRangeB + 0x1000, 0xD000, 0x10000, 0x01, 0}, // Free
+    };
+    for (const auto& r : regions)
+    {
+        dump.Put64(r.base);
+        dump.Put64(r.base);
+        dump.Put32(r.protect);
+        dump.Put32(0);
+        dump.Put64(r.size);
+        dump.Put32(r.state);
+        dump.Put32(r.protect);
+        dump.Put32(r.type);
+        dump.Put32(0);
+    }
+    dump.EndStream();
+
+    // Memory64 last, so its data runs to the end of the file
+    const uint64_t ranges[][2] = {{kRangeA, 0x1000}, {kRangeB, 0x1000}, {kRangeC, 0x800}};
+    dump.BeginStream(7, kMemory64ListStream);
+    dump.Put64(3);
+    size_t base_rva = dump.bytes().size();
+    dump.Put64(0);
+    for (const auto& range : ranges)
+    {
+        dump.Put64(range[0]);
+        dump.Put64(range[1]);
+    }
+    dump.EndStream();
+    dump.Patch64(base_rva, dump.size());
+    if (memory64_data)
+        *memory64_data = dump.size();
+    for (const auto& range : ranges)
+        dump.Memory(range[0], range[1]);
+    return dump.bytes();
+}
+
+bool MatchesPattern(const std::vector<uint8_t>& data, uint64_t address, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != Pattern(address + i))
+            return false;
+    }
+    return true;
+}
+
+void TestStreams()
+{
+    std::vector<uint8_t> bytes = BuildDump();
+    std::string error;
+    auto dump = MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error);
+    CHECK(dump != nullptr);
+    if (!dump)
+        return;
+
+    CHECK_EQ(dump->streams().size(), 8u);
+    CHECK_EQ(dump->timestamp(), 0x5F000000u);
+    CHECK_EQ(dump->system_info().architecture, kArchAmd64);
+    CHECK_EQ(dump->system_info().processors, 8);
+    CHECK_EQ(dump->system_info().build_number, 19045u);
+    CHECK(dump->misc_info().has_process_id);
+    CHECK_EQ(dump->misc_info().process_id, 4242u);
+
+    const auto& threads = dump->threads();
+    CHECK_EQ(threads.size(), 2u);
+    if (threads.size() == 2)
+    {
+        CHECK_EQ(threads[0].id, 100u);
+        CHECK_EQ(threads[1].teb, 0x5001u);
+        CHECK_EQ(threads[0].stack_start, kStackBase);
+        CHECK_EQ(threads[0].stack.size, 0x100u);
+        CHECK_EQ(threads[0].stack.data[0x10], Pattern(kStackBase + 0x10));
+        CHECK(threads[1].stack.empty());
+        CHECK_EQ(threads[1].context.size, 0x4d0u);
+    }
+
+    const auto& modules = dump->modules();
+    CHECK_EQ(modules.size(), 2u);
+    if (modules.size() == 2)
+    {
+        CHECK(modules[0].path == "C:\\app\\app.exe");
+        CHECK(modules[1].path == "C:\\Windows\\System32\\ntdll.dll");
+        CHECK_EQ(modules[1].base, kNtdllBase);
+        CHECK_EQ(modules[0].checksum, 0xC0DEu);
+        CHECK(modules[0].cv_record.size >= 4 &&
+              std::memcmp(modules[0].cv_record.data, "RSDS", 4) == 0);
+        CHECK(modules[1].cv_record.empty());
+    }
+    CHECK(dump->ModuleAt(kFaultIp) == &modules[1]);
+    CHECK(dump->ModuleAt(kNtdllBase + 0x20000) == nullptr);
+
+    const MinidumpException* exception = dump->exception();
+    CHECK(exception != nullptr);
+    if (exception)
+    {
+        CHECK_EQ(exception->thread_id, 101u);
+        CHECK_EQ(exception->code, 0xC0000005u);
+        CHECK_EQ(exception->address, kFaultIp);
+        CHECK_EQ(exception->parameters.size(), 2u);
+        CHECK_EQ(exception->context.size, 0x4d0u);
+    }
+
+    // Regions come back sorted; the memory list range is trimmed where memory64 overlaps it
+    CHECK_EQ(dump->regions().size(), 3u);
+    CHECK_EQ(dump->regions().front().address, kRangeA);
+    CHECK_EQ(dump->memory().size(), 4u);
+    CHECK_EQ(dump->memory_bytes(), 0x10u + 0x1000 + 0x1000 + 0x800);
+}
+
+void TestMemoryReads()
+{
+    std::vector<uint8_t> bytes = BuildDump();
+    std::string error;
+    auto dump = MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error);
+    CHECK(dump != nullptr);
+    if (!dump)
+        return;
+
+    // Within one range
+    std::vector<uint8_t> buffer(0x3000);
+    CHECK_EQ(dump->ReadMemory(kRangeA + 0x100, buffer.data(), 0x80), 0x80u);
+    CHECK(MatchesPattern(buffer, kRangeA + 0x100, 0x80));
+
+    // From the memory list range into memory64 range A, then on into adjacent range B
+    CHECK_EQ(dump->ReadMemory(kRangeA - 0x10, buffer.data(), 0x2010), 0x2010u);
+    CHECK(MatchesPattern(buffer, kRangeA - 0x10, 0x2010));
+
+    // Across the end of B into the gap: only the captured prefix
+    CHECK_EQ(dump->ReadMemory(kRangeB + 0xF00, buffer.data(), 0x200), 0x100u);
+    CHECK(MatchesPattern(buffer, kRangeB + 0xF00, 0x100));
+
+    // In the gap, before the first range, and at the last byte of C
+    CHECK_EQ(dump->ReadMemory(kRangeB + 0x1000, buffer.data(), 0x10), 0u);
+    CHECK_EQ(dump->ReadMemory(0x1000, buffer.data(), 0x10), 0u);
+    CHECK_EQ(dump->ReadMemory(kRangeC + 0x7FF, buffer.data(), 0x10), 1u);
+    CHECK_EQ(buffer[0], Pattern(kRangeC + 0x7FF));
+
+    // Zero-copy views stop at the end of their range
+    MinidumpView view = dump->MemoryAt(kRangeA + 0xFF0, 0x100);
+    CHECK_EQ(view.size, 0x10u);
+    CHECK_EQ(view.data[0], Pattern(kRangeA + 0xFF0));
+}
+
+void TestBackend()
+{
+    std::vector<uint8_t> bytes = BuildDump();
+    std::string error;
+    auto file = MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error);
+    CHECK(file != nullptr);
+    if (!file)
+        return;
+    MinidumpBackend backend(std::move(file));
+
+    CHECK(backend.GetTargetArchitecture() == "x64");
+    CHECK_EQ(backend.GetProcessId(), 4242u);
+
+    // Starts on the faulting thread, with its registers from the exception context
+    CHECK_EQ(backend.current_thread(), 1u);
+    std::vector<ThreadInfo> threads;
+    CHECK(StatusSucceeded(backend.GetThreads(&threads)));
+    CHECK_EQ(threads.size(), 2u);
+    if (threads.size() == 2)
+    {
+        CHECK_EQ(threads[1].system_id, 101u);
+        CHECK(threads[1].current && !threads[0].current);
+    }
+
+    uint64_t value = 0;
+    CHECK(StatusSucceeded(backend.Evaluate("@rip", &value)));
+    CHECK_EQ(value, kFaultIp);
+    CHECK(backend.SetCurrentThread(0));
+    CHECK(StatusSucceeded(backend.Evaluate("@rsp", &value)));
+    CHECK_EQ(value, 0x2000u);
+    CHECK(!backend.SetCurrentThread(2));
+
+    std::vector<ModuleInfo> modules;
+    CHECK(StatusSucceeded(backend.GetModules(&modules)));
+    CHECK_EQ(modules.size(), 2u);
+    if (modules.size() == 2)
+        CHECK(modules[1].name == "ntdll");
+    CHECK(StatusSucceeded(backend.Evaluate("ntdll+0x10", &value)));
+    CHECK_EQ(value, kNtdllBase + 0x10);
+    CHECK(StatusSucceeded(backend.Evaluate("ntdll.dll + 1234 - 0n16", &value)));
+    CHECK_EQ(value, kNtdllBase + 0x1234 - 16);
+    CHECK(!StatusSucceeded(backend.Evaluate("nosuchmodule", &value)));
+
+    // Free regions are left out
+    std::vector<MemoryRegionInfo> regions;
+    CHECK(StatusSucceeded(backend.GetMemoryRegions(&regions)));
+    CHECK_EQ(regions.size(), 2u);
+
+    std::vector<uint8_t> buffer(0x20);
+    size_t read = 0;
+    CHECK(StatusSucceeded(backend.ReadMemory(kRangeB - 0x10, buffer.data(), 0x20, &read)));
+    CHECK_EQ(read, 0x20u);
+    CHECK(MatchesPattern(buffer, kRangeB - 0x10, 0x20));
+    CHECK(!StatusSucceeded(backend.ReadMemory(kRangeB + 0x1000, buffer.data(), 0x20, &read)));
+
+    OutputView output;
+    CHECK_EQ(backend.Execute("k", false, &output), kStatusNotImpl);
+}
+
+void TestCorruptDumps()
+{
+    size_t memory64_data = 0;
+    const std::vector<uint8_t> good = BuildDump(&memory64_data);
+    std::string error;
+
+    // Not a dump at all, or too short for a header
+    std::vector<uint8_t> bytes = good;
+    bytes[0] = 'X';
+    CHECK(MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error) == nullptr);
+    CHECK(!error.empty());
+    CHECK(MinidumpFile::FromMemory(good.data(), 16, &error) == nullptr);
+
+    // Directory RVA or stream count pointing past the end of the file
+    bytes = good;
+    uint32_t far = static_cast<uint32_t>(bytes.size());
+    std::memcpy(&bytes[12], &far, 4);
+    CHECK(MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error) == nullptr);
+    bytes = good;
+    uint32_t huge = 0x10000000;
+    std::memcpy(&bytes[8], &huge, 4);
+    CHECK(MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error) == nullptr);
+
+    // Stream RVAs out of bounds: those streams are dropped, the rest still parse
+    bytes = good;
+    for (size_t i = 0; i < 8; i++)
+    {
+        uint32_t type = 0;
+        std::memcpy(&type, &bytes[32 + i * 12], 4);
+        if (type == kThreadListStream || type == kModuleListStream)
+            std::memcpy(&bytes[32 + i * 12 + 8], &far, 4);
+    }
+    auto dump = MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error);
+    CHECK(dump != nullptr);
+    if (dump)
+    {
+        CHECK(dump->threads().empty());
+        CHECK(dump->modules().empty());
+        CHECK(dump->exception() != nullptr);
+        CHECK_EQ(dump->memory().size(), 4u);
+    }
+
+    // Entry counts larger than their stream: clamped to what fits
+    bytes = good;
+    for (size_t i = 0; i < 8; i++)
+    {
+        uint32_t type = 0, rva = 0;
+        std::memcpy(&type, &bytes[32 + i * 12], 4);
+        std::memcpy(&rva, &bytes[32 + i * 12 + 8], 4);
+        if (type == kThreadListStream)
+            std::memcpy(&bytes[rva], &huge, 4);
+    }
+    dump = MinidumpFile::FromMemory(bytes.data(), bytes.size(), &error);
+    CHECK(dump != nullptr);
+    if (dump)
+        CHECK_EQ(dump->threads().size(), 2u);
+
+    // Truncated in the middle of memory64 range B: A stays whole, B keeps its captured
+    // prefix, C is gone, and reads stop where the file does
+    size_t cut = memory64_data + 0x1000 + 0x400;
+    dump = MinidumpFile::FromMemory(good.data(), cut, &error);
+    CHECK(dump != nullptr);
+    if (dump)
+    {
+        CHECK_EQ(dump->memory().size(), 3u);
+        std::vector<uint8_t> buffer(0x1000);
+        CHECK_EQ(dump->ReadMemory(kRangeB, buffer.data(), 0x1000), 0x400u);
+        CHECK(MatchesPattern(buffer, kRangeB, 0x400));
+        CHECK_EQ(dump->ReadMemory(kRangeC, buffer.data(), 0x10), 0u);
+        CHECK_EQ(dump->threads().size(), 2u);
+    }
+
+    // Truncated inside the stream directory
+    CHECK(MinidumpFile::FromMemory(good.data(), 40, &error) == nullptr);
+
+    // Every prefix of the file either fails cleanly or parses (run under ASan to catch
+    // out-of-bounds reads)
+    for (size_t size = 0; size <= good.size(); size += 7)
+        MinidumpFile::FromMemory(good.data(), size, &error);
+}
+
+} // namespace
+
+int main()
+{
+    TestStreams();
+    TestMemoryReads();
+    TestBackend();
+    TestCorruptDumps();
+    return windbg_test::TestResult();
+}
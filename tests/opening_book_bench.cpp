@@ -0,0 +1,134 @@
+// Time to first useful answer on a new target, replayed: the agent asking for the opening
+// commands one model round trip at a time (before) against the opening book running on
+// the debugger thread while the provider starts, with its results in the prime message
+// (after). Commands are answered by a replay backend at their recorded latencies; the
+// provider start-up and each model round trip are simulated with sleeps.
+//
+//   opening_book_bench [transcript] [round_trip_ms] [provider_start_ms]
+//
+// Without a transcript a built-in one with typical crash-dump latencies is used. The
+// agent is assumed to make one tool call per round trip, then answer in one more.
+
+#include "opening_book.hpp"
+#include "replay_backend.hpp"
+#include "result_cache.hpp"
+#include "test_util.hpp"
+#include "windbg_client.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+TranscriptEntry Entry(const char* command, double elapsed_ms, const std::string& output)
+{
+    TranscriptEntry entry;
+    entry.command = command;
+    entry.elapsed_ms = elapsed_ms;
+    entry.output = output;
+    return entry;
+}
+
+std::string Lines(const char* prefix, int count)
+{
+    std::string text;
+    for (int i = 0; i < count; i++)
+        text += prefix + std::to_string(i) + " 00007ff6`12340000 00007ff6`12350000\n";
+    return text;
+}
+
+// First-contact latencies as seen on a local x64 crash dump with symbols cached
+std::unique_ptr<ReplayBackend> BuiltInSession()
+{
+    std::vector<TranscriptEntry> entries = {
+        Entry("|", 1.0, ".  0\tid: 1f2c\texamine\tname: C:\\app\\app.exe\n"),
+        Entry("~", 1.5, Lines(".  ", 12)),
+        Entry(".lastevent", 2.0,
+              "Last event: 1f2c.2a10: Access violation - code c0000005 (first/second chance "
+              "not available)\n"),
+        Entry("r", 3.0, "rax=0000000000000000 rbx=000000c0ffee0000 rcx=0000000000000001\n"
+                        "rip=00007ff612341234 rsp=000000c0ffeef000 rbp=0000000000000000\n"),
+        Entry("k", 45.0, Lines(" # Child-SP RetAddr Call Site app!frame", 24)),
+        Entry("lm", 18.0, Lines("start end module name m", 90)),
+    };
+    return std::make_unique<ReplayBackend>(ReplayTarget{"crash.dmp", "x64"}, std::move(entries));
+}
+
+std::unique_ptr<ReplayBackend> OpenSession(const char* path)
+{
+    if (!path)
+        return BuiltInSession();
+    std::string error;
+    auto backend = ReplayBackend::Load(path, &error);
+    if (!backend)
+        std::printf("cannot load %s: %s\n", path, error.c_str());
+    return backend;
+}
+
+void Sleep(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 && std::string(argv[1]) != "-" ? argv[1] : nullptr;
+    int round_trip_ms = argc > 2 ? std::atoi(argv[2]) : 400;
+    int provider_start_ms = argc > 3 ? std::atoi(argv[3]) : 600;
+    const std::vector<std::string>& book = DefaultOpeningBook();
+
+    std::printf("time to first answer, %zu opening commands, %d ms round trips, %d ms provider "
+                "start (%s)\n",
+                book.size(), round_trip_ms, provider_start_ms, path ? path : "built-in session");
+
+    // Before: start the provider, then one round trip per command the agent asks for
+    auto backend = OpenSession(path);
+    if (!backend)
+        return 1;
+    GetResultCache().Invalidate();
+    double start = windbg_test::NowMs();
+    {
+        WinDbgClient client(std::move(backend));
+        Sleep(provider_start_ms);
+        for (const auto& command : book)
+        {
+            Sleep(round_trip_ms);
+            client.ExecuteCommand(command);
+        }
+        Sleep(round_trip_ms);
+    }
+    double before_ms = windbg_test::NowMs() - start;
+    std::printf("  %-36s %8.0f ms  (%zu round trips)\n", "agent runs the commands (before)",
+                before_ms, book.size() + 1);
+
+    // After: the book runs while the provider starts; the answer takes one round trip
+    backend = OpenSession(path);
+    GetResultCache().Invalidate();
+    start = windbg_test::NowMs();
+    double book_ms = 0.0;
+    size_t context_bytes = 0;
+    {
+        WinDbgClient client(std::move(backend));
+        std::thread provider([&]() { Sleep(provider_start_ms); });
+        OpeningBookResult result = RunOpeningBook(client, book);
+        provider.join();
+        book_ms = result.elapsed_ms;
+        context_bytes = result.text.size();
+        Sleep(round_trip_ms);
+    }
+    double after_ms = windbg_test::NowMs() - start;
+    std::printf("  %-36s %8.0f ms  (1 round trip; book %.1f ms, %zu bytes of context)\n",
+                "opening book in prime (after)", after_ms, book_ms, context_bytes);
+    std::printf("  saved %.0f ms (%.1fx)\n", before_ms - after_ms,
+                after_ms > 0 ? before_ms / after_ms : 0.0);
+    return 0;
+}
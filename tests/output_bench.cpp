@@ -0,0 +1,198 @@
+// Output capture throughput over a synthetic high-volume stream (short lines with the
+// occasional large block, as from dps/!heap/db): the old double-buffered capture that
+// copied every chunk into a thread_local buffer before forwarding it (before) against
+// the zero-copy tee into OutputSink (after), with and without console echo. Also times
+// OutputRing publishing with a concurrent reader.
+//
+//   output_bench [megabytes]
+
+#include "output_ring.hpp"
+#include "output_sink.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+// NUL-terminated chunks laid out back to back, as the engine hands them to the callbacks
+struct Stream
+{
+    std::vector<char> text;
+    std::vector<size_t> offsets;
+    size_t bytes = 0;
+};
+
+Stream MakeStream(size_t megabytes)
+{
+    Stream stream;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> line_length(40, 120);
+    std::uniform_int_distribution<int> block(0, 999);
+    std::uniform_int_distribution<int> hex(0, 15);
+    const size_t target = megabytes * 1024 * 1024;
+    stream.text.reserve(target + target / 64);
+
+    while (stream.bytes < target)
+    {
+        // One chunk in a thousand is a 64 KB block; the rest are single lines
+        size_t length = block(rng) == 0 ? 64 * 1024 : static_cast<size_t>(line_length(rng));
+        stream.offsets.push_back(stream.text.size());
+        for (size_t i = 0; i + 1 < length; i++)
+            stream.text.push_back("0123456789abcdef"[hex(rng)]);
+        stream.text.push_back('\n');
+        stream.text.push_back('\0');
+        stream.bytes += length;
+    }
+    return stream;
+}
+
+// The original callbacks: WinDbg's console does at least a strlen and a pass over the text
+struct Console
+{
+    size_t calls = 0;
+    size_t bytes = 0;
+    size_t largest = 0;
+    uint64_t checksum = 0;
+
+    void Output(const char* text)
+    {
+        size_t length = std::strlen(text);
+        calls++;
+        bytes += length;
+        largest = std::max(largest, length);
+        checksum += static_cast<unsigned char>(text[length / 2]);
+    }
+};
+
+// The pre-redesign OutputCapture::Output: every chunk went into the sink and into a
+// thread_local buffer, and the buffer was forwarded once the outermost call returned
+struct OldCapture
+{
+    OutputSink sink;
+    Console* console;
+
+    void Output(const char* text)
+    {
+        thread_local std::string buffer;
+        sink.Append(text, std::strlen(text));
+        buffer += text;
+        console->Output(buffer.c_str());
+        buffer.clear();
+    }
+};
+
+struct NewCapture
+{
+    OutputSink sink;
+    Console* console; // Null with echo off
+
+    void Output(const char* text)
+    {
+        sink.Append(text, std::strlen(text));
+        if (console)
+            console->Output(text);
+    }
+};
+
+void Report(const char* name, double ms, const Stream& stream, const Console& console,
+            size_t captured)
+{
+    std::printf("  %-30s %8.1f ms  %8.0f MB/s  captured %zu MB, echoed %zu MB in %zu calls "
+                "(largest %zu bytes)\n",
+                name, ms, stream.bytes / (1024.0 * 1024.0) / (ms / 1000.0), captured >> 20,
+                console.bytes >> 20, console.calls, console.largest);
+}
+
+template <typename Capture>
+double Run(Capture& capture, const Stream& stream)
+{
+    double start = windbg_test::NowMs();
+    for (size_t offset : stream.offsets)
+        capture.Output(stream.text.data() + offset);
+    return windbg_test::NowMs() - start;
+}
+
+// Engine-thread publishing while a reader (an SSE stream, say) drains the ring
+void RunRing(const Stream& stream)
+{
+    OutputRing ring;
+    std::atomic<bool> done{false};
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+
+    OutputRing::Cursor cursor = ring.Tail();
+    std::thread reader(
+        [&]()
+        {
+            auto handler = [&](uint32_t, const char*, size_t length) { received += length; };
+            while (!done.load())
+            {
+                if (ring.Read(&cursor, handler, &dropped) == 0)
+                    std::this_thread::yield();
+            }
+            ring.Read(&cursor, handler, &dropped);
+        });
+
+    double start = windbg_test::NowMs();
+    for (size_t offset : stream.offsets)
+    {
+        const char* text = stream.text.data() + offset;
+        ring.Publish(1, text, std::strlen(text));
+    }
+    double ms = windbg_test::NowMs() - start;
+    done = true;
+    reader.join();
+
+    std::printf("  %-30s %8.1f ms  %8.0f MB/s  %llu slots, reader got %llu MB, dropped %llu "
+                "MB\n",
+                "OutputRing::Publish + reader", ms,
+                stream.bytes / (1024.0 * 1024.0) / (ms / 1000.0),
+                static_cast<unsigned long long>(ring.published_slots()),
+                static_cast<unsigned long long>(received >> 20),
+                static_cast<unsigned long long>(dropped >> 20));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int megabytes = argc > 1 ? std::atoi(argv[1]) : 256;
+    if (megabytes <= 0)
+        megabytes = 256;
+
+    Stream stream = MakeStream(static_cast<size_t>(megabytes));
+    std::printf("capture of %zu MB in %zu chunks\n", stream.bytes >> 20, stream.offsets.size());
+
+    {
+        Console console;
+        OldCapture capture{OutputSink(), &console};
+        double ms = Run(capture, stream);
+        Report("double-buffered (before)", ms, stream, console, capture.sink.size());
+    }
+    {
+        Console console;
+        NewCapture capture{OutputSink(), &console};
+        double ms = Run(capture, stream);
+        Report("zero-copy tee (after)", ms, stream, console, capture.sink.size());
+    }
+    {
+        Console console;
+        NewCapture capture{OutputSink(), nullptr};
+        double ms = Run(capture, stream);
+        Report("zero-copy, echo off", ms, stream, console, capture.sink.size());
+    }
+
+    RunRing(stream);
+    return 0;
+}
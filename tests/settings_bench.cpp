@@ -0,0 +1,102 @@
+// Settings access cost: LoadSettings() parsing settings.json on every call (what each
+// command did before SettingsStore) against cached SettingsStore snapshots, plus coalesced
+// writes. Runs against a scratch settings directory, never the user's own settings.
+//
+//   settings_bench [iterations]
+
+#include "settings.hpp"
+#include "test_util.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+void SetHome(const std::string& dir)
+{
+#ifdef _WIN32
+    _putenv_s("USERPROFILE", dir.c_str());
+#else
+    setenv("USERPROFILE", dir.c_str(), 1);
+#endif
+}
+
+void Report(const char* name, double total_ms, int iterations)
+{
+    std::printf("  %-34s %10.3f us/op  (%d ops, %.1f ms)\n", name,
+                total_ms * 1000.0 / iterations, iterations, total_ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (iterations <= 0)
+        iterations = 2000;
+
+    namespace fs = std::filesystem;
+    fs::path home = fs::temp_directory_path() / "windbg_agent_settings_bench";
+    fs::create_directories(home);
+    SetHome(home.string());
+
+    // A settings file of realistic size: a custom prompt, BYOK entries and session ids
+    Settings seed;
+    seed.custom_prompt = std::string(400, 'p');
+    for (int i = 0; i < 50; i++)
+        seed.sessions["C:\\dumps\\crash" + std::to_string(i) + ".dmp|copilot"] =
+            "session-" + std::to_string(i);
+    seed.get_or_create_byok().api_key = "sk-bench";
+    SaveSettings(seed);
+
+    std::printf("settings access, %d iterations (%s)\n", iterations, GetSettingsPath().c_str());
+
+    // Cold: stat, create_directories check and a full JSON parse per call
+    double start = windbg_test::NowMs();
+    size_t sink = 0;
+    for (int i = 0; i < iterations; i++)
+        sink += LoadSettings().sessions.size();
+    double cold_ms = windbg_test::NowMs() - start;
+    Report("LoadSettings (cold parse)", cold_ms, iterations);
+
+    // Cached: one parse, then an mtime/size check per call
+    SettingsStore store;
+    store.Get();
+    start = windbg_test::NowMs();
+    for (int i = 0; i < iterations; i++)
+        sink += store.Get()->sessions.size();
+    double cached_ms = windbg_test::NowMs() - start;
+    Report("SettingsStore::Get (cached)", cached_ms, iterations);
+
+    // Writes: a save per change against changes coalesced into one Flush
+    start = windbg_test::NowMs();
+    for (int i = 0; i < iterations / 10; i++)
+    {
+        Settings settings = LoadSettings();
+        settings.sessions["bench|copilot"] = std::to_string(i);
+        SaveSettings(settings);
+    }
+    Report("load-modify-save per change", windbg_test::NowMs() - start, iterations / 10);
+
+    start = windbg_test::NowMs();
+    for (int i = 0; i < iterations / 10; i++)
+    {
+        Settings settings = *store.Get();
+        settings.sessions["bench|copilot"] = std::to_string(i);
+        store.Set(std::move(settings));
+    }
+    store.Flush();
+    Report("SettingsStore::Set + one Flush", windbg_test::NowMs() - start, iterations / 10);
+
+    std::printf("  cached/cold speedup: %.1fx (checksum %zu)\n",
+                cached_ms > 0 ? cold_ms / cached_ms : 0.0, sink);
+
+    std::error_code ec;
+    fs::remove_all(home, ec);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Minimal checks and timing for the standalone core tests and benchmarks. Each test is a
+// plain executable: CHECK failures are printed and counted, and main returns
+// TestResult() so ctest sees a non-zero exit code.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace windbg_test
+{
+
+inline int& FailureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline int TestResult()
+{
+    if (FailureCount() == 0)
+        std::printf("all checks passed\n");
+    else
+        std::printf("%d check(s) failed\n", FailureCount());
+    return FailureCount() == 0 ? 0 : 1;
+}
+
+inline double NowMs()
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Percentile (0..100) of a sample set; sorts the samples
+inline double Percentile(std::vector<double>& samples, double percent)
+{
+    if (samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(percent / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+} // namespace windbg_test
+
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);          \
+            windbg_test::FailureCount()++;                                                     \
+        }                                                                                      \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                             \
+    do                                                                                         \
+    {                                                                                          \
+        auto actual_value = (actual);                                                          \
+        auto expected_value = (expected);                                                      \
+        if (!(actual_value == expected_value))                                                 \
+        {                                                                                      \
+            std::printf("%s:%d: CHECK_EQ failed: %s == %s (got 0x%llx, expected 0x%llx)\n",    \
+                        __FILE__, __LINE__, #actual, #expected,                                \
+                        static_cast<unsigned long long>(actual_value),                         \
+                        static_cast<unsigned long long>(expected_value));                      \
+            windbg_test::FailureCount()++;                                                     \
+        }                                                                                      \
+    } while (0)
@@ -0,0 +1,214 @@
+// Transcript codec and files: payload round trips (empty, incompressible, long runs,
+// overlapping matches, corrupt input), and recorder output read back through the index, a
+// rebuilt index and a file cut off mid-record.
+
+#include "test_util.hpp"
+#include "transcript.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace windbg_agent;
+
+namespace
+{
+
+bool RoundTrips(const std::string& raw, size_t* packed_size = nullptr)
+{
+    std::string packed = CompressTranscriptPayload(raw);
+    if (packed_size)
+        *packed_size = packed.size();
+    std::string unpacked = "stale";
+    return DecompressTranscriptPayload(packed, raw.size(), &unpacked) && unpacked == raw;
+}
+
+std::string RandomBytes(std::mt19937& rng, size_t size)
+{
+    std::string bytes(size, '\0');
+    for (auto& byte : bytes)
+        byte = static_cast<char>(rng());
+    return bytes;
+}
+
+void TestCodec()
+{
+    std::mt19937 rng(5);
+
+    CHECK(RoundTrips(""));
+    CHECK(RoundTrips("x"));
+    CHECK(RoundTrips("abc")); // Shorter than a match
+
+    // Incompressible input may grow, but only by its framing
+    std::string noise = RandomBytes(rng, 256 * 1024);
+    size_t packed = 0;
+    CHECK(RoundTrips(noise, &packed));
+    CHECK(packed <= noise.size() + 16);
+
+    // Long runs: one byte, a short period (matches overlap their own output), and runs
+    // longer than the match window
+    std::string run(1024 * 1024, 'A');
+    CHECK(RoundTrips(run, &packed));
+    CHECK(packed < 64);
+    std::string period;
+    while (period.size() < 300000)
+        period += "ab";
+    CHECK(RoundTrips(period));
+    std::string far = RandomBytes(rng, 70000); // Repeats beyond the window: stored as is
+    CHECK(RoundTrips(far + far + far));
+    std::string near = RandomBytes(rng, 30000);
+    CHECK(RoundTrips(near + near + near, &packed));
+    CHECK(packed < 2 * near.size());
+
+    // Debugger-like text, and runs broken up by noise
+    std::string text;
+    for (int i = 0; i < 5000; i++)
+        text += "00000012`3456" + std::to_string(1000 + i % 97) + " 00007ff6`12340000 app!f+0x" +
+                std::to_string(i % 13) + "\n";
+    CHECK(RoundTrips(text, &packed));
+    CHECK(packed < text.size() / 2);
+    std::string mixed;
+    for (int i = 0; i < 50; i++)
+        mixed += std::string(1000 + i, static_cast<char>('a' + i % 26)) + RandomBytes(rng, 100);
+    CHECK(RoundTrips(mixed));
+
+    // Corrupt input fails instead of producing the wrong output
+    std::string compressed = CompressTranscriptPayload(text);
+    std::string out;
+    CHECK(!DecompressTranscriptPayload(compressed, text.size() + 1, &out));
+    CHECK(!DecompressTranscriptPayload(compressed, text.size() - 1, &out));
+    CHECK(!DecompressTranscriptPayload(compressed.substr(0, compressed.size() / 2), text.size(),
+                                       &out));
+    CHECK(!DecompressTranscriptPayload("", 10, &out));
+}
+
+TranscriptEntry Entry(uint64_t i)
+{
+    TranscriptEntry entry;
+    entry.command = i % 3 == 0 ? "lm" : "dd rsp+" + std::to_string(i);
+    // Every other output is large and repetitive enough to be stored compressed
+    entry.output = i % 2 ? std::string(4096 + i, static_cast<char>('a' + i % 26)) + "\n"
+                         : "output " + std::to_string(i) + "\n";
+    entry.status = i == 4 ? -2147467259 : 0; // E_FAIL
+    entry.elapsed_ms = 1.5 * static_cast<double>(i);
+    entry.source = "ai";
+    entry.context = "thread 0";
+    entry.cached = i == 5;
+    return entry;
+}
+
+void CheckRecords(TranscriptReader& reader, size_t count)
+{
+    CHECK_EQ(reader.size(), count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        TranscriptEntry expected = Entry(i);
+        TranscriptEntry entry;
+        CHECK(reader.Read(i, &entry));
+        CHECK_EQ(entry.seq, i);
+        CHECK(entry.command == expected.command);
+        CHECK(entry.output == expected.output);
+        CHECK_EQ(entry.status, expected.status);
+        CHECK(entry.source == expected.source);
+        CHECK(entry.context == expected.context);
+        CHECK(entry.cached == expected.cached);
+    }
+    TranscriptEntry entry;
+    CHECK(!reader.Read(count, &entry));
+}
+
+void TestFiles()
+{
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() /
+                   ("windbg_transcript_test_" +
+                    std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(dir);
+    std::string base = (dir / "session").string();
+
+    const size_t kRecords = 12;
+    TranscriptHeader header;
+    header.target = "crash.dmp";
+    header.architecture = "x64";
+    header.debugger = "test";
+    header.pid = 42;
+    {
+        TranscriptRecorder recorder;
+        std::string error;
+        CHECK(recorder.Start(base, header, true, &error));
+        CHECK(recorder.path() == base + ".wdt");
+        for (uint64_t i = 0; i < kRecords; i++)
+            recorder.Record(Entry(i));
+        CHECK_EQ(recorder.records(), kRecords);
+        CHECK_EQ(recorder.bytes(), fs::file_size(base + ".wdt"));
+        recorder.Stop();
+        CHECK(!recorder.IsRecording());
+        CHECK(recorder.path().empty());
+        CHECK(recorder.error().empty());
+    }
+    CHECK(IsBinaryTranscript(base + ".wdt"));
+
+    // Through the recorded index
+    {
+        TranscriptReader reader;
+        std::string error;
+        CHECK(reader.Open(base, &error));
+        CHECK(reader.header().target == "crash.dmp");
+        CHECK_EQ(reader.header().pid, 42u);
+        CheckRecords(reader, kRecords);
+        CHECK_EQ(reader.Search("lm").size(), (kRecords + 2) / 3);
+    }
+
+    // Index lost: rebuilt from the data file
+    fs::remove(base + ".wdx");
+    {
+        TranscriptReader reader;
+        std::string error;
+        CHECK(reader.Open(base + ".wdt", &error));
+        CHECK(error.empty());
+        CheckRecords(reader, kRecords);
+    }
+
+    // Data file cut mid-record (the index now runs past its end): the torn record is
+    // dropped and the rest rebuilt
+    {
+        TranscriptRecorder recorder;
+        std::string error;
+        CHECK(recorder.Start(base, header, true, &error));
+        for (uint64_t i = 0; i < kRecords; i++)
+            recorder.Record(Entry(i));
+        recorder.Stop();
+    }
+    fs::resize_file(base + ".wdt", fs::file_size(base + ".wdt") - 10);
+    {
+        TranscriptReader reader;
+        std::string error;
+        CHECK(reader.Open(base, &error));
+        CHECK(error == "ignored a truncated final record");
+        CheckRecords(reader, kRecords - 1);
+    }
+
+    // Cut inside the header
+    fs::resize_file(base + ".wdt", 10);
+    {
+        TranscriptReader reader;
+        std::string error;
+        CHECK(!reader.Open(base, &error));
+        CHECK(!error.empty());
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+} // namespace
+
+int main()
+{
+    TestCodec();
+    TestFiles();
+    return windbg_test::TestResult();
+}
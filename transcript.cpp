@@ -0,0 +1,590 @@
+#include "transcript.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace windbg_agent
+{
+
+namespace
+{
+
+constexpr char kDataMagic[4] = {'W', 'D', 'A', 'T'};
+constexpr char kIndexMagic[4] = {'W', 'D', 'A', 'X'};
+constexpr size_t kIndexHeaderSize = 8;
+constexpr size_t kSlotSize = 16;
+constexpr size_t kRecordFixedSize = 56; // Through the four length fields, including length
+constexpr size_t kMinCompressSize = 256;
+
+constexpr uint32_t kFlagCompressed = 1u << 0;
+constexpr uint32_t kFlagStreamed = 1u << 1;
+constexpr uint32_t kFlagCached = 1u << 2;
+
+// --- Little-endian encoding -------------------------------------------------
+
+void PutU32(std::string& out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+void PutU64(std::string& out, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+void PutString(std::string& out, const std::string& s)
+{
+    PutU32(out, static_cast<uint32_t>(s.size()));
+    out += s;
+}
+
+uint32_t GetU32(const char* p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--)
+        v = (v << 8) | static_cast<unsigned char>(p[i]);
+    return v;
+}
+
+uint64_t GetU64(const char* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | static_cast<unsigned char>(p[i]);
+    return v;
+}
+
+// --- File helpers (64-bit offsets) -------------------------------------------
+
+bool SeekTo(std::FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+uint64_t FileSize(std::FILE* file)
+{
+#ifdef _WIN32
+    _fseeki64(file, 0, SEEK_END);
+    return static_cast<uint64_t>(_ftelli64(file));
+#else
+    fseeko(file, 0, SEEK_END);
+    return static_cast<uint64_t>(ftello(file));
+#endif
+}
+
+bool ReadExact(std::FILE* file, void* buffer, size_t length)
+{
+    return std::fread(buffer, 1, length, file) == length;
+}
+
+bool ReadString(std::FILE* file, std::string* s)
+{
+    char len[4];
+    if (!ReadExact(file, len, sizeof(len)))
+        return false;
+    s->resize(GetU32(len));
+    return s->empty() || ReadExact(file, &(*s)[0], s->size());
+}
+
+std::string BasePath(const std::string& path)
+{
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".wdt") == 0)
+        return path.substr(0, path.size() - 4);
+    return path;
+}
+
+// --- LZ codec -----------------------------------------------------------------
+// Sequences of: varint literal count, literals, then (unless the output is complete)
+// varint (match length - kMinMatch), varint match distance.
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kWindow = 65535;
+constexpr int kHashBits = 14;
+
+void PutVarint(std::string& out, size_t v)
+{
+    while (v >= 0x80)
+    {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+bool GetVarint(const std::string& in, size_t& pos, size_t* v)
+{
+    *v = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7)
+    {
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        *v |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+uint32_t Load32(const std::string& s, size_t pos)
+{
+    uint32_t v;
+    std::memcpy(&v, s.data() + pos, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+std::string CompressTranscriptPayload(const std::string& raw)
+{
+    std::string out;
+    out.reserve(raw.size() / 2);
+    std::vector<int64_t> table(size_t(1) << kHashBits, -1);
+
+    size_t n = raw.size();
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + kMinMatch <= n)
+    {
+        uint32_t seq = Load32(raw, i);
+        size_t hash = (seq * 2654435761u) >> (32 - kHashBits);
+        int64_t candidate = table[hash];
+        table[hash] = static_cast<int64_t>(i);
+
+        if (candidate >= 0 && i - static_cast<size_t>(candidate) <= kWindow &&
+            Load32(raw, static_cast<size_t>(candidate)) == seq)
+        {
+            size_t match = static_cast<size_t>(candidate);
+            size_t length = kMinMatch;
+            while (i + length < n && raw[match + length] == raw[i + length])
+                length++;
+
+            PutVarint(out, i - anchor);
+            out.append(raw, anchor, i - anchor);
+            PutVarint(out, length - kMinMatch);
+            PutVarint(out, i - match);
+            i += length;
+            anchor = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    PutVarint(out, n - anchor);
+    out.append(raw, anchor, n - anchor);
+    return out;
+}
+
+bool DecompressTranscriptPayload(const std::string& packed, size_t raw_length, std::string* raw)
+{
+    raw->clear();
+    raw->reserve(raw_length);
+    size_t pos = 0;
+    while (true)
+    {
+        size_t literals = 0;
+        if (!GetVarint(packed, pos, &literals) || literals > packed.size() - pos ||
+            raw->size() + literals > raw_length)
+            return false;
+        raw->append(packed, pos, literals);
+        pos += literals;
+        if (raw->size() == raw_length)
+            return pos == packed.size();
+
+        size_t length = 0, distance = 0;
+        if (!GetVarint(packed, pos, &length) || !GetVarint(packed, pos, &distance))
+            return false;
+        length += kMinMatch;
+        if (distance == 0 || distance > raw->size() || raw->size() + length > raw_length)
+            return false;
+        size_t from = raw->size() - distance;
+        for (size_t k = 0; k < length; k++)
+            raw->push_back((*raw)[from + k]); // Byte-wise: matches may overlap
+    }
+}
+
+// --- Recorder -------------------------------------------------------------------
+
+TranscriptRecorder& GetTranscriptRecorder()
+{
+    static TranscriptRecorder recorder;
+    return recorder;
+}
+
+TranscriptRecorder::~TranscriptRecorder()
+{
+    Stop();
+}
+
+bool TranscriptRecorder::Start(const std::string& path, const TranscriptHeader& header,
+                               bool compress, std::string* error)
+{
+    Stop();
+
+    std::string base = BasePath(path);
+    std::FILE* data = std::fopen((base + ".wdt").c_str(), "wb");
+    std::FILE* index = data ? std::fopen((base + ".wdx").c_str(), "wb") : nullptr;
+    if (!data || !index)
+    {
+        if (data)
+            std::fclose(data);
+        if (error)
+            *error = "cannot create transcript " + base + ".wdt";
+        return false;
+    }
+
+    std::string head(kDataMagic, sizeof(kDataMagic));
+    PutU32(head, kTranscriptVersion);
+    PutString(head, header.target);
+    PutString(head, header.architecture);
+    PutString(head, header.debugger);
+    PutU32(head, header.pid);
+    PutU64(head, static_cast<uint64_t>(header.started_ms));
+    std::fwrite(head.data(), 1, head.size(), data);
+    std::fflush(data);
+
+    std::string index_head(kIndexMagic, sizeof(kIndexMagic));
+    PutU32(index_head, kTranscriptVersion);
+    std::fwrite(index_head.data(), 1, index_head.size(), index);
+    std::fflush(index);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_ = data;
+    index_ = index;
+    path_ = base + ".wdt";
+    error_.clear();
+    header_ = header;
+    compress_ = compress;
+    next_seq_ = 0;
+    offset_ = head.size();
+    return true;
+}
+
+void TranscriptRecorder::Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Close();
+}
+
+void TranscriptRecorder::Close()
+{
+    if (data_)
+        std::fclose(data_);
+    if (index_)
+        std::fclose(index_);
+    data_ = nullptr;
+    index_ = nullptr;
+    path_.clear();
+}
+
+bool TranscriptRecorder::IsRecording() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return data_ != nullptr;
+}
+
+std::string TranscriptRecorder::path() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return path_;
+}
+
+std::string TranscriptRecorder::error() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+uint64_t TranscriptRecorder::records() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_seq_;
+}
+
+uint64_t TranscriptRecorder::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return offset_;
+}
+
+void TranscriptRecorder::Record(TranscriptEntry entry)
+{
+    if (!IsRecording())
+        return;
+
+    if (entry.timestamp_ms == 0)
+        entry.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+
+    // Compress outside the lock; keep the compressed form only if it is smaller
+    uint32_t flags = 0;
+    std::string payload;
+    bool compress = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compress = compress_;
+    }
+    if (compress && entry.output.size() >= kMinCompressSize)
+    {
+        payload = CompressTranscriptPayload(entry.output);
+        if (payload.size() < entry.output.size())
+            flags |= kFlagCompressed;
+        else
+            payload.clear();
+    }
+    const std::string& output = (flags & kFlagCompressed) ? payload : entry.output;
+    if (entry.streamed)
+        flags |= kFlagStreamed;
+    if (entry.cached)
+        flags |= kFlagCached;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!data_)
+        return;
+
+    entry.seq = next_seq_;
+    std::string record;
+    record.reserve(kRecordFixedSize + entry.command.size() + entry.source.size() +
+                   entry.context.size() + output.size());
+    PutU32(record, 0); // Length, patched below
+    PutU32(record, flags);
+    PutU64(record, entry.seq);
+    PutU64(record, static_cast<uint64_t>(entry.timestamp_ms));
+    PutU64(record, static_cast<uint64_t>(entry.elapsed_ms * 1000.0));
+    PutU32(record, static_cast<uint32_t>(entry.status));
+    PutU32(record, static_cast<uint32_t>(entry.output.size()));
+    PutU32(record, static_cast<uint32_t>(entry.command.size()));
+    PutU32(record, static_cast<uint32_t>(entry.source.size()));
+    PutU32(record, static_cast<uint32_t>(entry.context.size()));
+    PutU32(record, static_cast<uint32_t>(output.size()));
+    record += entry.command;
+    record += entry.source;
+    record += entry.context;
+    record += output;
+
+    uint32_t length = static_cast<uint32_t>(record.size() - 4);
+    for (int i = 0; i < 4; i++)
+        record[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+
+    // A short write leaves a torn record at the end of the file (or an index one slot
+    // short); appending after it would put every later slot at the wrong offset, so
+    // recording stops there. The reader drops the torn record and rebuilds the index.
+    if (std::fwrite(record.data(), 1, record.size(), data_) != record.size() ||
+        std::fflush(data_) != 0)
+    {
+        error_ = "write to " + path_ + " failed; recording stopped";
+        Close();
+        return;
+    }
+
+    std::string slot;
+    PutU64(slot, offset_);
+    PutU32(slot, static_cast<uint32_t>(record.size()));
+    PutU32(slot, static_cast<uint32_t>(entry.command.size()));
+    if (std::fwrite(slot.data(), 1, slot.size(), index_) != slot.size() ||
+        std::fflush(index_) != 0)
+    {
+        error_ = "write to the index of " + path_ + " failed; recording stopped";
+        Close();
+        return;
+    }
+
+    offset_ += record.size();
+    next_seq_++;
+}
+
+// --- Reader ---------------------------------------------------------------------
+
+bool IsBinaryTranscript(const std::string& path)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    char magic[4] = {0};
+    bool binary = ReadExact(file, magic, sizeof(magic)) &&
+                  std::memcmp(magic, kDataMagic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return binary;
+}
+
+TranscriptReader::~TranscriptReader()
+{
+    if (data_)
+        std::fclose(data_);
+}
+
+bool TranscriptReader::Open(const std::string& path, std::string* error)
+{
+    std::string base = BasePath(path);
+    data_ = std::fopen((base + ".wdt").c_str(), "rb");
+    if (!data_)
+    {
+        if (error)
+            *error = "cannot open " + base + ".wdt";
+        return false;
+    }
+
+    char head[8];
+    if (!ReadExact(data_, head, sizeof(head)) ||
+        std::memcmp(head, kDataMagic, sizeof(kDataMagic)) != 0 ||
+        GetU32(head + 4) != kTranscriptVersion)
+    {
+        if (error)
+            *error = base + ".wdt is not a version " + std::to_string(kTranscriptVersion) +
+                     " transcript";
+        return false;
+    }
+
+    char fields[12];
+    if (!ReadString(data_, &header_.target) || !ReadString(data_, &header_.architecture) ||
+        !ReadString(data_, &header_.debugger) || !ReadExact(data_, fields, sizeof(fields)))
+    {
+        if (error)
+            *error = base + ".wdt: truncated header";
+        return false;
+    }
+    header_.pid = GetU32(fields);
+    header_.started_ms = static_cast<int64_t>(GetU64(fields + 4));
+    records_offset_ = 8 + 12 + header_.target.size() + header_.architecture.size() +
+                      header_.debugger.size() + sizeof(fields);
+
+    // Load the index; rebuild it if it is missing or does not cover the whole data file
+    // (e.g. the debugger exited between the two appends)
+    uint64_t data_size = FileSize(data_);
+    std::FILE* index = std::fopen((base + ".wdx").c_str(), "rb");
+    if (index)
+    {
+        uint64_t index_size = FileSize(index);
+        SeekTo(index, kIndexHeaderSize);
+        size_t count = index_size > kIndexHeaderSize
+                           ? static_cast<size_t>((index_size - kIndexHeaderSize) / kSlotSize)
+                           : 0;
+        std::vector<char> raw(count * kSlotSize);
+        if (count > 0 && ReadExact(index, raw.data(), raw.size()))
+        {
+            slots_.resize(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const char* p = raw.data() + i * kSlotSize;
+                slots_[i].offset = GetU64(p);
+                slots_[i].length = GetU32(p + 8);
+                slots_[i].command_length = GetU32(p + 12);
+            }
+        }
+        std::fclose(index);
+    }
+
+    uint64_t indexed_end =
+        slots_.empty() ? records_offset_ : slots_.back().offset + slots_.back().length;
+    if (indexed_end != data_size)
+        return RebuildIndex(error);
+    return true;
+}
+
+bool TranscriptReader::RebuildIndex(std::string* error)
+{
+    slots_.clear();
+
+    uint64_t offset = records_offset_;
+    uint64_t data_size = FileSize(data_);
+    while (offset + kRecordFixedSize <= data_size)
+    {
+        char fixed[kRecordFixedSize];
+        if (!SeekTo(data_, offset) || !ReadExact(data_, fixed, sizeof(fixed)))
+            break;
+        uint64_t length = GetU32(fixed) + uint64_t(4);
+        if (offset + length > data_size)
+            break; // Torn final record
+
+        Slot slot;
+        slot.offset = offset;
+        slot.length = static_cast<uint32_t>(length);
+        slot.command_length = GetU32(fixed + 40);
+        slots_.push_back(slot);
+        offset += length;
+    }
+
+    if (offset < data_size && error)
+        *error = "ignored a truncated final record";
+    return true;
+}
+
+bool TranscriptReader::Read(uint64_t seq, TranscriptEntry* entry)
+{
+    if (seq >= slots_.size())
+        return false;
+
+    const Slot& slot = slots_[static_cast<size_t>(seq)];
+    std::string record(slot.length, '\0');
+    if (!SeekTo(data_, slot.offset) || !ReadExact(data_, &record[0], record.size()) ||
+        record.size() < kRecordFixedSize)
+        return false;
+
+    const char* p = record.data();
+    uint32_t flags = GetU32(p + 4);
+    entry->seq = GetU64(p + 8);
+    entry->timestamp_ms = static_cast<int64_t>(GetU64(p + 16));
+    entry->elapsed_ms = static_cast<double>(GetU64(p + 24)) / 1000.0;
+    entry->status = static_cast<int32_t>(GetU32(p + 32));
+    uint32_t raw_output_length = GetU32(p + 36);
+    uint32_t command_length = GetU32(p + 40);
+    uint32_t source_length = GetU32(p + 44);
+    uint32_t context_length = GetU32(p + 48);
+    uint32_t output_length = GetU32(p + 52);
+    entry->streamed = (flags & kFlagStreamed) != 0;
+    entry->cached = (flags & kFlagCached) != 0;
+
+    uint64_t needed = uint64_t(kRecordFixedSize) + command_length + source_length +
+                      context_length + output_length;
+    if (needed > record.size())
+        return false;
+
+    size_t pos = kRecordFixedSize;
+    entry->command.assign(record, pos, command_length);
+    pos += command_length;
+    entry->source.assign(record, pos, source_length);
+    pos += source_length;
+    entry->context.assign(record, pos, context_length);
+    pos += context_length;
+
+    if (flags & kFlagCompressed)
+        return DecompressTranscriptPayload(record.substr(pos, output_length), raw_output_length,
+                                           &entry->output);
+    entry->output.assign(record, pos, output_length);
+    return true;
+}
+
+std::vector<uint64_t> TranscriptReader::Search(const std::string& text)
+{
+    // Commands sit at a fixed offset in each record, so only they are read
+    if (commands_.size() != slots_.size())
+    {
+        commands_.assign(slots_.size(), std::string());
+        for (size_t i = 0; i < slots_.size(); i++)
+        {
+            std::string& command = commands_[i];
+            command.resize(slots_[i].command_length);
+            if (!command.empty() && (!SeekTo(data_, slots_[i].offset + kRecordFixedSize) ||
+                                     !ReadExact(data_, &command[0], command.size())))
+                command.clear();
+        }
+    }
+
+    std::vector<uint64_t> matches;
+    for (size_t i = 0; i < commands_.size(); i++)
+    {
+        if (commands_[i].find(text) != std::string::npos)
+            matches.push_back(i);
+    }
+    return matches;
+}
+
+} // namespace windbg_agent
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace windbg_agent
+{
+
+// One recorded command execution
+struct TranscriptEntry
+{
+    std::string command;
+    std::string output;
+    long status = 0;
+    double elapsed_ms = 0.0;
+
+    // Recorder metadata (empty/zero in hand-written fixtures)
+    uint64_t seq = 0;
+    int64_t timestamp_ms = 0; // Unix time when the command finished
+    std::string source;       // Who ran it: "ai", "http", "mcp", ...
+    std::string context;      // Engine context (target, process, thread, frame)
+    bool streamed = false;    // Output was streamed to the caller and not kept
+    bool cached = false;      // Served from the result cache
+};
+
+// Target described at the start of a transcript
+struct TranscriptHeader
+{
+    std::string target;
+    std::string architecture;
+    std::string debugger;
+    uint32_t pid = 0;
+    int64_t started_ms = 0;
+};
+
+// Binary transcript format (little-endian), designed for append-only recording:
+//
+//   <name>.wdt  "WDAT" u32 version, header strings, then records:
+//               u32 length (of the rest of the record), u32 flags, u64 seq,
+//               i64 timestamp_ms, i64 elapsed_us, i32 status, u32 raw_output_length,
+//               u32 command/source/context/output lengths, then those bytes
+//               (command first, so it can be read without touching the output)
+//   <name>.wdx  "WDAX" u32 version, then one 16-byte slot per record:
+//               u64 record offset, u32 record length, u32 command length
+//
+// Slot N of the index belongs to sequence number N, giving O(1) seeks. Outputs may be
+// LZ-compressed (flag bit 0). The index can be rebuilt from the .wdt file if it is lost.
+constexpr uint32_t kTranscriptVersion = 1;
+
+// Appends command executions to a transcript (thread-safe)
+class TranscriptRecorder
+{
+  public:
+    ~TranscriptRecorder();
+
+    // Start a new transcript at path (without extension); stops any current one
+    bool Start(const std::string& path, const TranscriptHeader& header, bool compress,
+               std::string* error);
+    void Stop();
+
+    bool IsRecording() const;
+    std::string path() const;  // Of the .wdt file; empty when not recording
+    std::string error() const; // Why recording stopped on its own (a failed write)
+    const TranscriptHeader& header() const { return header_; }
+    uint64_t records() const;
+    uint64_t bytes() const; // Bytes written to the .wdt file
+
+    // Append an entry; assigns its sequence number
+    void Record(TranscriptEntry entry);
+
+  private:
+    void Close(); // mutex_ held
+
+    mutable std::mutex mutex_;
+    std::FILE* data_ = nullptr;
+    std::FILE* index_ = nullptr;
+    std::string path_;
+    std::string error_;
+    TranscriptHeader header_;
+    bool compress_ = true;
+    uint64_t next_seq_ = 0;
+    uint64_t offset_ = 0;
+};
+
+// Global recorder used by WinDbgClient
+TranscriptRecorder& GetTranscriptRecorder();
+
+// Random access to a recorded transcript
+class TranscriptReader
+{
+  public:
+    ~TranscriptReader();
+
+    // Open <path>.wdt (path may include the extension); rebuilds the index if missing
+    bool Open(const std::string& path, std::string* error);
+
+    const TranscriptHeader& header() const { return header_; }
+    size_t size() const { return slots_.size(); }
+
+    // Read the record with sequence number seq
+    bool Read(uint64_t seq, TranscriptEntry* entry);
+
+    // Sequence numbers of records whose command contains text
+    std::vector<uint64_t> Search(const std::string& text);
+
+  private:
+    struct Slot
+    {
+        uint64_t offset = 0;
+        uint32_t length = 0;
+        uint32_t command_length = 0;
+    };
+
+    bool RebuildIndex(std::string* error);
+
+    std::FILE* data_ = nullptr;
+    TranscriptHeader header_;
+    uint64_t records_offset_ = 0; // First record, right after the header
+    std::vector<Slot> slots_;
+    std::vector<std::string> commands_; // Loaded on first Search
+};
+
+// True if the file starts with the binary transcript magic
+bool IsBinaryTranscript(const std::string& path);
+
+// LZ-compress/decompress transcript payloads (exposed for tooling)
+std::string CompressTranscriptPayload(const std::string& raw);
+bool DecompressTranscriptPayload(const std::string& packed, size_t raw_length, std::string* raw);
+
+} // namespace windbg_agent
@@ -1,51 +1,80 @@
 #include "windbg_client.hpp"
-#include "output_capture.hpp"
-#include <cctype>
-#include <wrl/client.h>
+#include "address_index.hpp"
+#include "memory_cache.hpp"
+#include "memory_scan.hpp"
+#include "result_cache.hpp"
+#include "transcript.hpp"
+#include <chrono>
+#include <cstdlib>
 
 namespace windbg_agent
 {
 
-WinDbgClient::WinDbgClient(IDebugClient* client) : client_(client), control_(nullptr)
+WinDbgClient::WinDbgClient(std::unique_ptr<IDebuggerBackend> backend)
+    : backend_(std::move(backend))
 {
-    if (client_)
-    {
-        client_->QueryInterface(__uuidof(IDebugControl), (void**)&control_);
-        if (control_)
-            dml_ = std::make_unique<DmlOutput>(control_);
-    }
 }
 
-WinDbgClient::~WinDbgClient()
-{
-    if (control_)
-    {
-        control_->Release();
-        control_ = nullptr;
-    }
-}
+WinDbgClient::~WinDbgClient() = default;
 
-std::string WinDbgClient::ExecuteCommand(const std::string& command)
+std::string WinDbgClient::ExecuteCommand(const std::string& command, long* status)
 {
-    if (!control_ || !client_)
+    if (status)
+        *status = kStatusFail;
+
+    if (!backend_ || !backend_->IsAvailable())
         return "Error: No debugger control available";
 
+    // Read-only commands are answered from the cache while the debugger state is unchanged
+    CommandEffect effect = ClassifyCommand(command);
+    std::string cache_context;
+    if (effect == CommandEffect::ReadOnly)
+    {
+        cache_context = backend_->GetContextKey();
+        std::string cached;
+        if (GetResultCache().Lookup(cache_context, command, &cached))
+        {
+            OutputCommand(command);
+            if (echo_output_)
+                OutputCommandResult(cached);
+            if (status)
+                *status = kStatusOk;
+            Record(command, cached, kStatusOk, 0.0, false, true);
+            return cached;
+        }
+    }
+
     // Show user what command is being executed
     OutputCommand(command);
 
-    // Install output capture
-    OutputCapture capture;
-    capture.Install(client_);
-
     // Execute the command
-    HRESULT hr =
-        control_->Execute(DEBUG_OUTCTL_THIS_CLIENT, command.c_str(), DEBUG_EXECUTE_DEFAULT);
+    OutputView output;
+    auto start = std::chrono::steady_clock::now();
+    long hr = backend_->Execute(command, echo_output_, &output);
+    double elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // One copy out of the capture buffer or spill file
+    std::string result = output.str();
+    output = OutputView();
 
-    // Get captured output
-    std::string result = capture.GetAndClear();
-    capture.Uninstall();
+    if (status)
+        *status = hr;
 
-    if (FAILED(hr))
+    Record(command, result, hr, elapsed_ms, false, false);
+
+    if (effect == CommandEffect::Mutating)
+        GetResultCache().Invalidate();
+    else if (StatusSucceeded(hr) && !result.empty())
+        GetResultCache().Store(cache_context, command, result, elapsed_ms);
+
+    if (hr == kStatusOutputLost)
+    {
+        // The command ran, but its output could not be kept (spill file write or mapping)
+        result = "Error: output of '" + command + "' could not be captured";
+        OutputError(result);
+    }
+    else if (!StatusSucceeded(hr))
     {
         result = "Error executing command: hr=" + std::to_string(hr);
         OutputError(result);
@@ -54,7 +83,7 @@ std::string WinDbgClient::ExecuteCommand(const std::string& command)
     {
         result = "(No output)";
     }
-    else
+    else if (echo_output_)
     {
         // Show the command output to the user
         OutputCommandResult(result);
@@ -63,212 +92,251 @@ std::string WinDbgClient::ExecuteCommand(const std::string& command)
     return result;
 }
 
+long WinDbgClient::ExecuteCommandStreaming(const std::string& command,
+                                           const OutputChunkHandler& on_chunk)
+{
+    if (!backend_ || !backend_->IsAvailable())
+        return kStatusFail;
+
+    // A cached read-only result is delivered as a single chunk
+    CommandEffect effect = ClassifyCommand(command);
+    if (effect == CommandEffect::ReadOnly)
+    {
+        std::string cached;
+        if (GetResultCache().Lookup(backend_->GetContextKey(), command, &cached))
+        {
+            OutputCommand(command);
+            on_chunk(cached.data(), cached.size());
+            Record(command, cached, kStatusOk, 0.0, true, true);
+            return kStatusOk;
+        }
+    }
+
+    // Show user what command is being executed
+    OutputCommand(command);
+
+    auto start = std::chrono::steady_clock::now();
+    long hr = backend_->ExecuteStreaming(command, echo_output_, on_chunk);
+    double elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Streamed output is not retained: only the command and its outcome are recorded, and
+    // there is nothing to store for read-only commands
+    Record(command, std::string(), hr, elapsed_ms, true, false);
+
+    if (effect == CommandEffect::Mutating)
+        GetResultCache().Invalidate();
+
+    if (!StatusSucceeded(hr))
+        OutputError("Error executing command: hr=" + std::to_string(hr));
+
+    return hr;
+}
+
+namespace
+{
+
+// Parse a plain "0x..." literal without a round trip through the expression evaluator
+bool ParseHexAddress(const std::string& text, uint64_t* address)
+{
+    if (text.size() < 3 || text.size() > 18 || text[0] != '0' || (text[1] != 'x' && text[1] != 'X'))
+        return false;
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str() + 2, &end, 16);
+    if (*end != '\0')
+        return false;
+    *address = value;
+    return true;
+}
+
+} // namespace
+
+std::vector<MemoryRangeResult> WinDbgClient::ReadMemory(
+    const std::vector<MemoryRangeRequest>& ranges)
+{
+    std::vector<MemoryRangeResult> results(ranges.size());
+    if (!backend_ || !backend_->IsAvailable())
+    {
+        for (auto& result : results)
+            result.status = kStatusFail;
+        return results;
+    }
+
+    // Resolve addresses; ranges whose address does not evaluate are answered right away
+    std::vector<MemoryRange> resolved;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        uint64_t address = 0;
+        if (!ParseHexAddress(ranges[i].address, &address))
+        {
+            long status = backend_->Evaluate(ranges[i].address, &address);
+            if (!StatusSucceeded(status))
+            {
+                results[i].status = status;
+                results[i].error = "cannot evaluate address: " + ranges[i].address;
+                continue;
+            }
+        }
+        resolved.push_back({address, ranges[i].size});
+        positions.push_back(i);
+    }
+
+    std::vector<MemoryRangeResult> read = GetMemoryCache().Read(*backend_, resolved);
+    for (size_t j = 0; j < read.size(); j++)
+        results[positions[j]] = std::move(read[j]);
+    return results;
+}
+
+std::vector<SymbolizeResult> WinDbgClient::Symbolize(const SymbolizeRequest& request)
+{
+    std::vector<SymbolizeResult> results(request.addresses.size());
+    if (!backend_ || !backend_->IsAvailable())
+    {
+        for (auto& result : results)
+            result.error = "no debugger available";
+        return results;
+    }
+
+    std::vector<uint64_t> resolved;
+    std::vector<size_t> positions;
+    resolved.reserve(request.addresses.size());
+    positions.reserve(request.addresses.size());
+    for (size_t i = 0; i < request.addresses.size(); i++)
+    {
+        const std::string& text = request.addresses[i];
+        uint64_t address = 0;
+        if (!ParseHexAddress(text, &address) &&
+            !StatusSucceeded(backend_->Evaluate(text, &address)))
+        {
+            results[i].error = "cannot evaluate address: " + text;
+            continue;
+        }
+        resolved.push_back(address);
+        positions.push_back(i);
+    }
+
+    std::vector<SymbolizeResult> found =
+        GetAddressIndex().Resolve(*backend_, resolved, request.symbols);
+    for (size_t j = 0; j < found.size(); j++)
+        results[positions[j]] = std::move(found[j]);
+    return results;
+}
+
+MemoryScanResult WinDbgClient::SearchMemory(const MemoryScanRequest& request,
+                                            const ScanHitHandler& on_hits)
+{
+    MemoryScanResult result;
+    if (!backend_ || !backend_->IsAvailable())
+    {
+        result.status = kStatusFail;
+        result.error = "no debugger available";
+        return result;
+    }
+
+    uint64_t start = 0;
+    if (!request.address.empty() && !ParseHexAddress(request.address, &start))
+    {
+        long status = backend_->Evaluate(request.address, &start);
+        if (!StatusSucceeded(status))
+        {
+            result.status = status;
+            result.error = "cannot evaluate address: " + request.address;
+            return result;
+        }
+    }
+
+    return ScanMemory(*backend_, start, request.size, request.patterns, request.max_hits,
+                      on_hits);
+}
+
+void WinDbgClient::Record(const std::string& command, const std::string& output, long status,
+                          double elapsed_ms, bool streamed, bool cached)
+{
+    TranscriptRecorder& recorder = GetTranscriptRecorder();
+    if (!recorder.IsRecording())
+        return;
+
+    TranscriptEntry entry;
+    entry.command = command;
+    entry.output = output;
+    entry.status = status;
+    entry.elapsed_ms = elapsed_ms;
+    entry.source = source_;
+    entry.context = backend_->GetContextKey();
+    entry.streamed = streamed;
+    entry.cached = cached;
+    recorder.Record(std::move(entry));
+}
+
 void WinDbgClient::Output(const std::string& message)
 {
-    if (control_)
-        control_->Output(DEBUG_OUTPUT_NORMAL, "%s", message.c_str());
+    backend_->Display(DisplayStyle::Raw, message);
 }
 
 void WinDbgClient::OutputError(const std::string& message)
 {
-    if (dml_)
-        dml_->OutputError(message.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_ERROR, "%s\n", message.c_str());
+    backend_->Display(DisplayStyle::Error, message);
 }
 
 void WinDbgClient::OutputWarning(const std::string& message)
 {
-    if (dml_)
-        dml_->OutputWarning(message.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_WARNING, "%s\n", message.c_str());
+    backend_->Display(DisplayStyle::Warning, message);
 }
 
 void WinDbgClient::OutputCommand(const std::string& command)
 {
-    if (dml_)
-        dml_->OutputCommand(command.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_NORMAL, "$ %s\n", command.c_str());
+    backend_->Display(DisplayStyle::Command, command);
 }
 
 void WinDbgClient::OutputCommandResult(const std::string& result)
 {
-    if (dml_)
-        dml_->OutputCommandResult(result.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_NORMAL, "%s\n", result.c_str());
+    backend_->Display(DisplayStyle::CommandResult, result);
 }
 
 void WinDbgClient::OutputThinking(const std::string& message)
 {
-    if (dml_)
-        dml_->OutputAgentThinking(message.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_NORMAL, "%s\n", message.c_str());
+    backend_->Display(DisplayStyle::Thinking, message);
 }
 
 void WinDbgClient::OutputResponse(const std::string& response)
 {
-    if (dml_)
-        dml_->OutputAgentResponse(response.c_str());
-    else if (control_)
-        control_->Output(DEBUG_OUTPUT_NORMAL, "%s\n", response.c_str());
+    backend_->Display(DisplayStyle::Response, response);
 }
 
 bool WinDbgClient::SupportsColor() const
 {
-    return dml_ && dml_->IsDmlSupported();
+    return backend_->SupportsColor();
 }
 
 std::string WinDbgClient::GetTargetName() const
 {
-    if (!client_)
-        return "";
-
-    // Try to get dump file name first
-    char dump_file[MAX_PATH] = {0};
-    ULONG dump_file_size = 0;
-
-    Microsoft::WRL::ComPtr<IDebugClient4> client4;
-    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugClient4),
-                                          reinterpret_cast<void**>(client4.GetAddressOf()))))
-    {
-        // GetDumpFile returns the dump file name if debugging a dump
-        // Note: Handle and Type must not be nullptr - the API writes to them
-        ULONG64 handle = 0;
-        ULONG type = 0;
-        HRESULT hr =
-            client4->GetDumpFile(0, dump_file, sizeof(dump_file), &dump_file_size, &handle, &type);
-
-        if (SUCCEEDED(hr) && dump_file[0] != '\0')
-            return dump_file;
-    }
-
-    // Fall back to getting process name via system objects
-    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
-    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSystemObjects),
-                                          reinterpret_cast<void**>(sys.GetAddressOf()))))
-    {
-        char exe_name[MAX_PATH] = {0};
-        ULONG exe_size = 0;
-        HRESULT hr = sys->GetCurrentProcessExecutableName(exe_name, sizeof(exe_name), &exe_size);
-        if (SUCCEEDED(hr) && exe_name[0] != '\0')
-            return exe_name;
-    }
-
-    return "";
+    return backend_->GetTargetName();
 }
 
 std::string WinDbgClient::GetTargetArchitecture() const
 {
-    if (!control_)
-        return "";
-
-    ULONG proc_type = 0;
-    if (SUCCEEDED(control_->GetActualProcessorType(&proc_type)))
-    {
-        switch (proc_type)
-        {
-        case IMAGE_FILE_MACHINE_I386:
-            return "x86";
-        case IMAGE_FILE_MACHINE_AMD64:
-            return "x64";
-        case IMAGE_FILE_MACHINE_ARM64:
-            return "ARM64";
-        case IMAGE_FILE_MACHINE_ARM:
-        case IMAGE_FILE_MACHINE_ARMNT:
-            return "ARM";
-        default:
-            return "Unknown (" + std::to_string(proc_type) + ")";
-        }
-    }
-    return "";
+    return backend_->GetTargetArchitecture();
 }
 
 std::string WinDbgClient::GetDebuggerType() const
 {
-    // Detect debugger by examining host process name
-    char module_path[MAX_PATH] = {0};
-    if (GetModuleFileNameA(nullptr, module_path, MAX_PATH))
-    {
-        std::string path = module_path;
-        // Convert to lowercase for comparison
-        for (auto& c : path)
-            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
-
-        if (path.find("dbgx") != std::string::npos || path.find("windbg") != std::string::npos)
-            return "WinDbg";
-        if (path.find("cdb") != std::string::npos)
-            return "CDB";
-        if (path.find("ntsd") != std::string::npos)
-            return "NTSD";
-        if (path.find("kd") != std::string::npos)
-            return "KD";
-    }
-    return "Windows Debugger";
+    return backend_->GetDebuggerType();
 }
 
-bool WinDbgClient::IsInterrupted() const
+std::string WinDbgClient::GetTargetState() const
 {
-    if (!control_)
-        return false;
-
-    // Check if user pressed Ctrl+C or Ctrl+Break
-    HRESULT hr = control_->GetInterrupt();
-    return hr == S_OK;
+    return backend_->GetTargetState();
 }
 
-std::string WinDbgClient::GetTargetState() const
+uint32_t WinDbgClient::GetProcessId() const
 {
-    if (!control_)
-        return "Unknown";
-
-    ULONG status = 0;
-    HRESULT hr = control_->GetExecutionStatus(&status);
-    if (FAILED(hr))
-        return "Unknown";
-
-    switch (status)
-    {
-    case DEBUG_STATUS_NO_DEBUGGEE:
-        return "No target";
-    case DEBUG_STATUS_STEP_INTO:
-    case DEBUG_STATUS_STEP_OVER:
-    case DEBUG_STATUS_STEP_BRANCH:
-        return "Stepping";
-    case DEBUG_STATUS_GO:
-    case DEBUG_STATUS_GO_HANDLED:
-    case DEBUG_STATUS_GO_NOT_HANDLED:
-        return "Running";
-    case DEBUG_STATUS_BREAK:
-        return "Break";
-    case DEBUG_STATUS_OUT_OF_SYNC:
-        return "Out of sync";
-    case DEBUG_STATUS_WAIT_INPUT:
-        return "Waiting for input";
-    case DEBUG_STATUS_TIMEOUT:
-        return "Timeout";
-    default:
-        return "Unknown";
-    }
+    return backend_->GetProcessId();
 }
 
-ULONG WinDbgClient::GetProcessId() const
+bool WinDbgClient::IsInterrupted() const
 {
-    if (!client_)
-        return 0;
-
-    Microsoft::WRL::ComPtr<IDebugSystemObjects> sys;
-    if (SUCCEEDED(client_->QueryInterface(__uuidof(IDebugSystemObjects),
-                                          reinterpret_cast<void**>(sys.GetAddressOf()))))
-    {
-        ULONG pid = 0;
-        if (SUCCEEDED(sys->GetCurrentProcessSystemId(&pid)))
-            return pid;
-    }
-    return 0;
+    return backend_->IsInterrupted();
 }
 
 } // namespace windbg_agent
@@ -1,24 +1,64 @@
 #pragma once
 
-#include "dml_output.hpp"
-#include <dbgeng.h>
+#include "command_types.hpp"
+#include "debugger_backend.hpp"
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <windows.h>
+#include <vector>
+
+#ifdef _WIN32
+struct IDebugClient;
+#endif
 
 namespace windbg_agent
 {
 
-// WinDbg/CDB debugger client using dbgeng interfaces and DML for colored output
+// Debugger client used by the agent and servers. Adds result caching, echo control and
+// styled output on top of an IDebuggerBackend (dbgeng in WinDbg/CDB, replay elsewhere).
 class WinDbgClient
 {
   public:
-    // Construct with an IDebugClient (typically from extension callback)
+    explicit WinDbgClient(std::unique_ptr<IDebuggerBackend> backend);
+
+#ifdef _WIN32
+    // Construct a dbgeng-backed client from an IDebugClient (typically from extension callback)
     explicit WinDbgClient(IDebugClient* client);
+#endif
+
     ~WinDbgClient();
 
     // Execute a debugger command and return its output
-    std::string ExecuteCommand(const std::string& command);
+    // Read-only commands are served from the result cache while the debugger state is
+    // unchanged; any other command invalidates the cache
+    // status (optional) receives the backend status (the HRESULT from IDebugControl::Execute
+    // for dbgeng)
+    std::string ExecuteCommand(const std::string& command, long* status = nullptr);
+
+    // Execute a debugger command, forwarding output chunks to on_chunk as they arrive
+    // Nothing is buffered, so arbitrarily large output is not held in memory
+    long ExecuteCommandStreaming(const std::string& command, const OutputChunkHandler& on_chunk);
+
+    // Read target memory ranges through the page cache. Addresses are expressions evaluated
+    // by the engine ("0x..." literals are parsed directly); overlapping and adjacent ranges
+    // are fetched together. Results are in request order.
+    std::vector<MemoryRangeResult> ReadMemory(const std::vector<MemoryRangeRequest>& ranges);
+
+    // Resolve addresses to module, memory region and (optionally) symbol through the address
+    // index, without running lm/!address/ln per pointer. Results are in request order.
+    std::vector<SymbolizeResult> Symbolize(const SymbolizeRequest& request);
+
+    // Search target memory for patterns, handing hits to on_hits as they are found (see
+    // ScanMemory). The start address is an expression like the ReadMemory addresses.
+    MemoryScanResult SearchMemory(const MemoryScanRequest& request, const ScanHitHandler& on_hits);
+
+    // Echo command output to the debugger console (default on). Headless callers such as
+    // HTTP/MCP clients can turn it off; the command line itself is still shown.
+    void SetEchoOutput(bool echo) { echo_output_ = echo; }
+
+    // Who is issuing commands ("ai", "http", "mcp", ...), stored in recorded transcripts
+    void SetSource(const std::string& source) { source_ = source; }
+    const std::string& source() const { return source_; }
 
     // Output methods for displaying messages to the user
     void Output(const std::string& message);
@@ -47,15 +87,21 @@ class WinDbgClient
     std::string GetTargetState() const;
 
     // Get the current process ID (0 if not available)
-    ULONG GetProcessId() const;
+    uint32_t GetProcessId() const;
 
     // Check if user requested interrupt (e.g., Ctrl+C)
     bool IsInterrupted() const;
 
+    IDebuggerBackend& backend() { return *backend_; }
+
   private:
-    IDebugClient* client_;
-    IDebugControl* control_;
-    std::unique_ptr<DmlOutput> dml_;
+    // Append an execution to the transcript if recording is on
+    void Record(const std::string& command, const std::string& output, long status,
+                double elapsed_ms, bool streamed, bool cached);
+
+    std::unique_ptr<IDebuggerBackend> backend_;
+    bool echo_output_ = true;
+    std::string source_ = "ai";
 };
 
 } // namespace windbg_agent